@@ -0,0 +1,8 @@
+# Benchmarks of the interpreter core (no widgets required)
+
+TEMPLATE = subdirs
+
+SUBDIRS += load
+SUBDIRS += dispatch
+SUBDIRS += suite
+SUBDIRS += scaling
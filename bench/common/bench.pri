@@ -0,0 +1,12 @@
+# Shared setup of the benchmarks: widget-free core of the interpreter + helpers
+
+include($$PWD/../../src/fsm_core.pri)
+
+QT -= gui
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD
+
+SOURCES += $$files($$PWD/*.cpp)
+HEADERS += $$files($$PWD/*.h)
@@ -0,0 +1,58 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file bench_utils.cpp
+ * @author xcervia00
+ *
+ * @brief Helpers shared by the benchmarks
+ *
+ */
+
+#include "bench_utils.h"
+
+#include <QString>
+
+#include <cstdio>
+
+#ifdef Q_OS_UNIX
+    #include <sys/resource.h>
+#endif
+
+/**
+ * @brief Message handler passing through only warnings and errors
+ * @param type The type of the message
+ * @param context Context of the message
+ * @param msg The message itself
+ */
+static void benchMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    (void)context;
+
+    // Warnings stay visible, a scenario stalled by e.g. inputs of an inactive machine would pass silently otherwise
+    if(type == QtInfoMsg || type == QtDebugMsg)
+        return;
+
+    fprintf(stderr, "%s\n", qUtf8Printable(msg));
+}
+
+void silenceLog()
+{
+    qInstallMessageHandler(benchMessageHandler);
+}
+
+qint64 peakRssKb()
+{
+#ifdef Q_OS_UNIX
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    #ifdef Q_OS_DARWIN
+        return usage.ru_maxrss / 1024; // Bytes
+    #else
+        return usage.ru_maxrss; // Kilobytes
+    #endif
+#else
+    return 0;
+#endif
+}
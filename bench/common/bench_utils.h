@@ -0,0 +1,43 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file bench_utils.h
+ * @author xcervia00
+ *
+ * @brief Helpers shared by the benchmarks (interface)
+ *
+ */
+
+#ifndef BENCH_UTILS_H_
+#define BENCH_UTILS_H_
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+/**
+ * @brief Drops informational messages of the model (logging would dominate the measurements)
+ */
+void silenceLog();
+
+/**
+ * @brief Peak resident set size of the process
+ * @return Peak RSS in kilobytes; 0 if not available
+ */
+qint64 peakRssKb();
+
+/**
+ * @brief Measures duration of given function
+ * @tparam Func Callable without arguments
+ * @param func The function to measure
+ * @return Duration in nanoseconds
+ */
+template<typename Func>
+qint64 measureNs(Func &&func)
+{
+    QElapsedTimer timer;
+    timer.start();
+    func();
+    return timer.nsecsElapsed();
+}
+
+#endif
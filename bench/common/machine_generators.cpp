@@ -0,0 +1,225 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file machine_generators.cpp
+ * @author xcervia00
+ *
+ * @brief Generators of synthetic machines (.fsm text) used by the benchmarks
+ *
+ */
+
+#include "machine_generators.h"
+
+#include <QTextStream>
+
+/**
+ * @brief Position of i-th state in a grid (so the machines can be opened in the editor)
+ * @param out The stream to write to
+ * @param i Index of the state
+ */
+static void writePosition(QTextStream &out, int i)
+{
+    out << " (" << (i % 100) * 150 << "," << (i / 100) * 150 << ")";
+}
+
+QString generateLoadMachine(int stateCount)
+{
+    QString text;
+    QTextStream out(&text);
+
+    out << "Name:\n\tBench" << stateCount << "\n";
+    out << "Comment:\n\tGenerated by bench_load\n";
+    out << "Input:\n\tin\n\treset = 0\n";
+    out << "Output:\n\tout\n";
+    out << "Variables:\n\tint counter = 0\n\tfloat ratio = 0.5\n\tbool enabled = true\n\tstring label = bench\n";
+
+    out << "States:\n";
+    for(int i = 0; i < stateCount; i++)
+    {
+        out << "\tS" << i;
+        writePosition(out, i);
+        out << ": { icp.output(\"out\", " << i << ") }\n";
+    }
+
+    out << "Transitions:\n";
+    for(int i = 0; i < stateCount; i++)
+    {
+        out << "\tS" << i << " -> S" << (i + 1) % stateCount << ": { in [ icp.getInput(\"in\") == \"" << i % 7 << "\" ] }\n";
+        if(i % 10 == 9)
+        {
+            out << "\tS" << i << " -> S0: { reset @ 1000 }\n";
+        }
+    }
+
+    out.flush();
+    return text;
+}
+
+QString generateRing(int stateCount, bool guarded)
+{
+    QString text;
+    QTextStream out(&text);
+
+    out << "Name:\n\tRing" << stateCount << "\n";
+    out << "Input:\n\tin\n\tother\n";
+    out << "Variables:\n\tint limit = 10\n";
+
+    out << "States:\n";
+    for(int i = 0; i < stateCount; i++)
+    {
+        out << "\tS" << i;
+        writePosition(out, i);
+        out << ": { }\n";
+    }
+
+    out << "Transitions:\n";
+    for(int i = 0; i < stateCount; i++)
+    {
+        // Transition that never matches the benchmarked input (has to be skipped by dispatch)
+        out << "\tS" << i << " -> S0: { other @ 100000 }\n";
+
+        if(guarded)
+            out << "\tS" << i << " -> S" << (i + 1) % stateCount << ": { in [ icp.getInput(\"in\") == \"go\" && icp.get(\"limit\") > 0 ] }\n";
+        else
+            out << "\tS" << i << " -> S" << (i + 1) % stateCount << ": { in }\n";
+    }
+
+    out.flush();
+    return text;
+}
+
+QString generateChain(int stateCount)
+{
+    QString text;
+    QTextStream out(&text);
+
+    out << "Name:\n\tChain" << stateCount << "\n";
+    out << "Input:\n\tin\n";
+    out << "Output:\n\tout\n";
+    out << "Variables:\n\tint steps = 0\n";
+
+    out << "States:\n";
+    for(int i = 0; i < stateCount; i++)
+    {
+        out << "\tS" << i;
+        writePosition(out, i);
+        out << ": { icp.set(\"steps\", icp.get(\"steps\") + 1) }\n";
+    }
+
+    out << "Transitions:\n";
+    for(int i = 0; i < stateCount; i++)
+    {
+        out << "\tS" << i << " -> S" << (i + 1) % stateCount << ": { in }\n";
+    }
+
+    out.flush();
+    return text;
+}
+
+QString generateDense(int stateCount)
+{
+    QString text;
+    QTextStream out(&text);
+
+    out << "Name:\n\tDense" << stateCount << "\n";
+    out << "Input:\n\tin\n";
+
+    out << "States:\n";
+    for(int i = 0; i < stateCount; i++)
+    {
+        out << "\tS" << i;
+        writePosition(out, i);
+        out << ": { }\n";
+    }
+
+    out << "Transitions:\n";
+    for(int i = 0; i < stateCount; i++)
+    {
+        for(int j = 0; j < stateCount; j++)
+        {
+            out << "\tS" << i << " -> S" << j << ": { in [ icp.getInput(\"in\") == \"" << j << "\" ] }\n";
+        }
+    }
+
+    out.flush();
+    return text;
+}
+
+QString generateFactorial()
+{
+    QString text;
+    QTextStream out(&text);
+
+    out << "Name:\n\tFactorial\n";
+    out << "Comment:\n\texamples/example_machine_03.fsm without delays\n";
+    out << "Input:\n\tfac = 5\n";
+    out << "Output:\n\tout = 120\n";
+    out << "Variables:\n\tint val = 2\n";
+
+    out << "States:\n";
+    out << "\tFactorial (269,349): {}\n";
+    out << "\tDecrement (1005,491): {icp.set(\"val\", icp.get(\"val\")-1);}\n";
+    out << "\tMultiply (999,157): {var mult = icp.get(\"val\"); mult = icp.valueof(\"out\") * (mult-1); icp.output(\"out\", mult);}\n";
+    out << "\tInit (661,230): {icp.set(\"val\", icp.valueof(\"fac\")); icp.output(\"out\", icp.get(\"val\"));}\n";
+
+    out << "Transitions:\n";
+    out << "\tDecrement -> Multiply: { [icp.get(\"val\") > 2] }\n";
+    out << "\tInit -> Multiply: { }\n";
+    out << "\tDecrement -> Factorial: { [icp.get(\"val\") <= 2] }\n";
+    out << "\tFactorial -> Init: { fac [ icp.valueof(\"fac\") > 1 ] }\n";
+    out << "\tMultiply -> Decrement: { }\n";
+
+    out.flush();
+    return text;
+}
+
+QString generateTimeouts(int timeoutCount)
+{
+    QString text;
+    QTextStream out(&text);
+
+    out << "Name:\n\tTimeouts" << timeoutCount << "\n";
+    out << "Input:\n\tgo\n";
+
+    out << "States:\n";
+    out << "\tIdle (0,0): { }\n";
+    out << "\tDone (150,0): { }\n";
+
+    out << "Transitions:\n";
+    for(int i = 0; i < timeoutCount; i++)
+    {
+        // Shortest timeout comes last ==> all of them have to be armed before the first one elapses
+        out << "\tIdle -> Done: { go @ " << 1 + (timeoutCount - 1 - i) % 50 << " }\n";
+    }
+    out << "\tDone -> Idle: { }\n";
+
+    out.flush();
+    return text;
+}
+
+QString generateWork(int iterations)
+{
+    QString text;
+    QTextStream out(&text);
+
+    out << "Name:\n\tWork" << iterations << "\n";
+    out << "Input:\n\tin\n";
+    out << "Variables:\n\tint steps = 0\n";
+
+    out << "States:\n";
+    for(int i = 0; i < 4; i++)
+    {
+        out << "\tS" << i;
+        writePosition(out, i);
+        out << ": { var sum = 0; for (var i = 0; i < " << iterations << "; i++) sum += i; icp.set(\"steps\", icp.get(\"steps\") + 1) }\n";
+    }
+
+    out << "Transitions:\n";
+    for(int i = 0; i < 4; i++)
+    {
+        out << "\tS" << i << " -> S" << (i + 1) % 4 << ": { in }\n";
+    }
+
+    out.flush();
+    return text;
+}
@@ -0,0 +1,67 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file machine_generators.h
+ * @author xcervia00
+ *
+ * @brief Generators of synthetic machines (.fsm text) used by the benchmarks (interface)
+ *
+ */
+
+#ifndef MACHINE_GENERATORS_H_
+#define MACHINE_GENERATORS_H_
+
+#include <QString>
+
+/**
+ * @brief Large machine exercising every section of the format (a ring with a reset transition every 10 states)
+ * @param stateCount Number of states
+ * @return Contents of the .fsm file
+ */
+QString generateLoadMachine(int stateCount);
+
+/**
+ * @brief Ring of states; input 'in' moves the machine to the next state
+ * @param stateCount Number of states
+ * @param guarded Should the transitions have a guard?
+ * @return Contents of the .fsm file
+ */
+QString generateRing(int stateCount, bool guarded);
+
+/**
+ * @brief Chain of states S0 .. S(n-1); input 'in' moves to the next state, the last one returns to S0
+ * @param stateCount Number of states
+ * @return Contents of the .fsm file
+ */
+QString generateChain(int stateCount);
+
+/**
+ * @brief Complete graph; input 'in' of value j moves from any state to state Sj (every state has n guarded transitions)
+ * @param stateCount Number of states
+ * @return Contents of the .fsm file
+ */
+QString generateDense(int stateCount);
+
+/**
+ * @brief Factorial loop in the style of examples/example_machine_03.fsm (without the delays);
+ * input 'fac' computes its factorial through Init/Multiply/Decrement and returns to state Factorial
+ * @return Contents of the .fsm file
+ */
+QString generateFactorial();
+
+/**
+ * @brief State Idle with many transitions armed by input 'go' with distinct timeouts; the first to elapse
+ * moves to Done (cancelling the rest), which immediately returns to Idle
+ * @param timeoutCount Number of concurrent timeouts
+ * @return Contents of the .fsm file
+ */
+QString generateTimeouts(int timeoutCount);
+
+/**
+ * @brief Chain of 4 states whose actions burn CPU in the script engine; input 'in' moves to the next state
+ * @param iterations Number of loop iterations of every action
+ * @return Contents of the .fsm file
+ */
+QString generateWork(int iterations);
+
+#endif
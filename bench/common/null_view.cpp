@@ -0,0 +1,143 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file null_view.cpp
+ * @author xcervia00
+ *
+ * @brief View that displays nothing; used by benchmarks
+ *
+ */
+
+#include "null_view.h"
+
+#include <QPoint>
+#include <QVariant>
+
+void NullView::registerModel(FsmInterface *model)
+{
+    this->model = model;
+}
+
+bool NullView::interpreting() const
+{
+    return isInterpreting;
+}
+
+// Structural changes are not displayed anywhere
+
+void NullView::updateState(const QString &name, const QPoint &pos) { (void)name; (void)pos; }
+void NullView::updateStateName(const QString &oldName, const QString &newName) { (void)oldName; (void)newName; }
+void NullView::updateAction(const QString &parentState, const QString &action) { (void)parentState; (void)action; }
+void NullView::updateActiveState(const QString &name) { activeState = name; stateChanges++; }
+void NullView::updateCondition(size_t transitionId, const QString &condition) { (void)transitionId; (void)condition; }
+void NullView::updateTransition(size_t transitionId, const QString &srcState, const QString &destState) { (void)transitionId; (void)srcState; (void)destState; }
+void NullView::updateVarInput(const QString &name, const QString &value) { (void)name; (void)value; }
+void NullView::updateVarInputs(const FsmInputBatch &inputs) { (void)inputs; }
+void NullView::updateVarOutput(const QString &name, const QString &value) { (void)name; (void)value; }
+void NullView::updateVarInternal(const QString &name, const QVariant &value) { (void)name; (void)value; }
+
+void NullView::destroyState(const QString &name) { (void)name; }
+void NullView::destroyAction(const QString &parentState) { (void)parentState; }
+void NullView::destroyCondition(size_t transitionId) { (void)transitionId; }
+void NullView::destroyTransition(size_t transitionId) { (void)transitionId; }
+void NullView::destroyVarInput(const QString &name) { (void)name; }
+void NullView::destroyVarOutput(const QString &name) { (void)name; }
+void NullView::destroyVarInternal(const QString &name) { (void)name; }
+
+void NullView::loadFile(const QString &filename) { (void)filename; }
+void NullView::saveFile(const QString &filename) { (void)filename; }
+void NullView::loadStream(QTextStream &stream) { (void)stream; }
+void NullView::saveStream(QTextStream &stream) { (void)stream; }
+
+void NullView::saveChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    this->model->saveChanges(stream, session, version);
+}
+
+bool NullView::loadChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    return this->model->loadChanges(stream, session, version);
+}
+
+void NullView::renameFsm(const QString &name) { (void)name; }
+
+void NullView::log(const QString &time, const QString &state, const QString &varInputs, const QString &varOutputs, const QString &varInternals) const
+{
+    (void)time;
+    (void)state;
+    (void)varInputs;
+    (void)varOutputs;
+    (void)varInternals;
+}
+
+void NullView::log() const
+{
+    // Nop
+}
+
+void NullView::startInterpretation()
+{
+    if(isInterpreting)
+        return;
+
+    isInterpreting = true;
+    this->model->startInterpretation();
+}
+
+void NullView::stopInterpretation()
+{
+    if(!isInterpreting)
+        return;
+
+    isInterpreting = false;
+    this->model->stopInterpretation();
+}
+
+void NullView::restoreInterpretationBackup()
+{
+    // Nop
+}
+
+void NullView::cleanup()
+{
+    // Nop
+}
+
+void NullView::throwError(FsmErrorType errNum)
+{
+    (void)errNum;
+    errors++;
+    this->stopInterpretation();
+}
+
+void NullView::throwError(FsmErrorType errNum, const QString &errMsg)
+{
+    (void)errNum;
+    errors++;
+    lastError = errMsg;
+    this->stopInterpretation();
+}
+
+void NullView::outputEvent(const QString &outName)
+{
+    (void)outName;
+    outputs++;
+}
+
+void NullView::inputEvent(const QString &name, const QString &value)
+{
+    this->model->inputEvent(name, value);
+}
+
+void NullView::inputEvents(const FsmInputBatch &inputs)
+{
+    this->model->inputEvents(inputs);
+}
+
+void NullView::updatesPending()
+{
+    // Benchmarks count every state change ==> nothing is coalesced
+    this->model->flushUpdates();
+}
+
+void NullView::flushUpdates() {}
@@ -0,0 +1,98 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file null_view.h
+ * @author xcervia00
+ *
+ * @brief View that displays nothing; used by benchmarks (interface)
+ *
+ */
+
+#ifndef NULL_VIEW_H_
+#define NULL_VIEW_H_
+
+#include <QString>
+
+#include "mvc_interface.h"
+
+/**
+ * @brief Implementation of the view part of MVC that only forwards control actions to the model
+ * @note Counts outputs and errors so benchmarks can check the machine actually did something
+ */
+class NullView : public FsmInterface
+{
+    protected:
+        FsmInterface *model = nullptr; ///< Reference to model
+        bool isInterpreting = false; ///< Is the fsm being interpreted?
+
+    public:
+        size_t outputs = 0; ///< Number of output events received
+        size_t errors = 0; ///< Number of errors received
+        size_t stateChanges = 0; ///< Number of active state updates received
+        QString activeState; ///< Name of the last active state received
+        QString lastError; ///< Message of the last error
+
+        /**
+         * @brief Related to MVC interface communication; registers a model to use
+         * @param model The model to use
+         */
+        void registerModel(FsmInterface *model);
+
+        /**
+         * @brief Is the fsm being interpreted?
+         * @return True if interpretation is running
+         */
+        bool interpreting() const;
+
+        // ========================
+        //       MVC INTERFACE
+        // ========================
+
+        void updateState(const QString &name, const QPoint &pos) override;
+        void updateStateName(const QString &oldName, const QString &newName) override;
+        void updateAction(const QString &parentState, const QString &action) override;
+        void updateActiveState(const QString &name) override;
+
+        void updateCondition(size_t transitionId, const QString &condition) override;
+        void updateTransition(size_t transitionId, const QString &srcState, const QString &destState) override;
+        void updateVarInput(const QString &name, const QString &value) override;
+        void updateVarInputs(const FsmInputBatch &inputs) override;
+        void updateVarOutput(const QString &name, const QString &value) override;
+        void updateVarInternal(const QString &name, const QVariant &value) override;
+
+        void destroyState(const QString &name) override;
+        void destroyAction(const QString &parentState) override;
+        void destroyCondition(size_t transitionId) override;
+        void destroyTransition(size_t transitionId) override;
+        void destroyVarInput(const QString &name) override;
+        void destroyVarOutput(const QString &name) override;
+        void destroyVarInternal(const QString &name) override;
+
+        void loadFile(const QString &filename) override;
+        void saveFile(const QString &filename) override;
+        void loadStream(QTextStream &stream) override;
+        void saveStream(QTextStream &stream) override;
+        void saveChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
+        bool loadChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
+
+        void renameFsm(const QString &name) override;
+
+        void log(const QString &time, const QString &state, const QString &varInputs, const QString &varOutputs, const QString &varInternals) const override;
+        void log() const override;
+
+        void startInterpretation() override;
+        void stopInterpretation() override;
+        void restoreInterpretationBackup() override;
+
+        void cleanup() override;
+        void throwError(FsmErrorType errNum) override;
+        void throwError(FsmErrorType errNum, const QString &errMsg) override;
+
+        void outputEvent(const QString &outName) override;
+        void inputEvent(const QString &name, const QString &value) override;
+        void inputEvents(const FsmInputBatch &inputs) override;
+        void updatesPending() override;
+        void flushUpdates() override;
+};
+
+#endif
@@ -0,0 +1,8 @@
+# Throughput of input dispatch: QStateMachine vs. compiled flat transition table
+
+include(../common/bench.pri)
+
+TARGET = bench_dispatch
+
+SOURCES += $$files($$PWD/*.cpp)
+HEADERS += $$files($$PWD/*.h)
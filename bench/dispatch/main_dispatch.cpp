@@ -0,0 +1,137 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file main_dispatch.cpp
+ * @author xcervia00
+ *
+ * @brief Benchmark of input dispatch throughput (QStateMachine vs. compiled flat transition table)
+ *
+ */
+
+#include "model.h"
+#include "null_view.h"
+#include "bench_utils.h"
+#include "machine_generators.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QString>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdio>
+
+/**
+ * @brief Processes events until the view received expected number of state changes
+ * @param view The view
+ * @param expected The number of state changes
+ * @return False if the machine got stuck
+ */
+static bool waitForStateChanges(const NullView &view, size_t expected)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    while(view.stateChanges < expected)
+    {
+        QCoreApplication::processEvents(QEventLoop::AllEvents);
+        if(timer.elapsed() > 5000)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Interprets the machine by given engine and reports its throughput
+ * @param name Name of the engine
+ * @param engineType The engine
+ * @param text The machine
+ * @param events Number of input events per repetition
+ * @param repeat Number of repetitions
+ * @return Best throughput in events per second; negative on failure
+ */
+static double runEngine(const char *name, FsmEngineType engineType, const QString &text, int events, int repeat)
+{
+    double best = 0;
+
+    for(int r = 0; r < repeat; r++)
+    {
+        NullView view;
+        FsmModel model;
+        view.registerModel(&model);
+        model.registerView(&view);
+
+        QString copy = text;
+        QTextStream in(&copy);
+        model.loadStream(in);
+
+        // Enter the initial state
+        model.setEngineType(engineType);
+        view.stateChanges = 0;
+        view.startInterpretation();
+        if(!waitForStateChanges(view, 1))
+        {
+            fprintf(stderr, "%s: initial state was not entered\n", name);
+            return -1;
+        }
+
+        bool stuck = false;
+        qint64 elapsed = measureNs([&]() {
+            for(int i = 0; i < events && !stuck; i++)
+            {
+                view.inputEvent("in", "go");
+                stuck = !waitForStateChanges(view, i + 2);
+            }
+        });
+
+        view.stopInterpretation();
+
+        if(stuck || view.errors > 0)
+        {
+            fprintf(stderr, "%s: machine got stuck (%zu errors, last: %s)\n", name, view.errors, qUtf8Printable(view.lastError));
+            return -1;
+        }
+
+        best = std::max(best, events / (elapsed / 1e9));
+    }
+
+    printf("%-12s best of %d: %12.0f events/s\n", name, repeat, best);
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("bench_dispatch");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares input dispatch of QStateMachine against the compiled flat transition table");
+    parser.addHelpOption();
+
+    QCommandLineOption statesOption({"n", "states"}, "Number of states in the ring (default 1000)", "count", "1000");
+    QCommandLineOption eventsOption({"e", "events"}, "Number of input events (default 100000)", "count", "100000");
+    QCommandLineOption repeatOption({"r", "repeat"}, "Number of repetitions (default 3)", "count", "3");
+    QCommandLineOption guardOption({"g", "guard"}, "Guard every transition");
+    parser.addOptions({statesOption, eventsOption, repeatOption, guardOption});
+    parser.process(a);
+
+    silenceLog();
+
+    int states = std::max(1, parser.value(statesOption).toInt());
+    int events = std::max(1, parser.value(eventsOption).toInt());
+    int repeat = std::max(1, parser.value(repeatOption).toInt());
+    QString text = generateRing(states, parser.isSet(guardOption));
+
+    printf("Ring of %d states, %d events%s\n", states, events, parser.isSet(guardOption) ? ", guarded" : "");
+
+    double machine = runEngine("statemachine", ENGINE_STATE_MACHINE, text, events, repeat);
+    double flat = runEngine("flat", ENGINE_FLAT, text, events, repeat);
+
+    if(machine <= 0 || flat <= 0)
+        return 2;
+
+    printf("Speedup: %.2fx\n", flat / machine);
+    return 0;
+}
@@ -0,0 +1,8 @@
+# Compares the .fsm loader against the previous per-line regex implementation
+
+include(../common/bench.pri)
+
+TARGET = bench_load
+
+SOURCES += $$files($$PWD/*.cpp)
+HEADERS += $$files($$PWD/*.h)
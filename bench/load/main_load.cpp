@@ -0,0 +1,134 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file main_load.cpp
+ * @author xcervia00
+ *
+ * @brief Benchmark of loading a large generated .fsm file (streaming parser vs. per-line regex)
+ *
+ */
+
+#include "model.h"
+#include "null_view.h"
+#include "bench_utils.h"
+#include "regex_loader.h"
+#include "machine_generators.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QString>
+#include <QTextStream>
+#include <QFile>
+
+#include <algorithm>
+#include <limits>
+#include <cstdio>
+
+/**
+ * @brief Saves the model to a string (used to check that both loaders produce the same machine)
+ * @param model The model to save
+ * @return The saved file
+ */
+static QString saveToString(FsmModel &model)
+{
+    QString text;
+    QTextStream out(&text);
+    model.saveToStream(out);
+    out.flush();
+    return text;
+}
+
+/**
+ * @brief Loads the text repeatedly and reports the best time
+ * @tparam Loader Callable (FsmModel&, QTextStream&)
+ * @param name Name of the loader
+ * @param text The file to load
+ * @param repeat Number of repetitions
+ * @param loader The loader to use
+ * @param saved The machine saved after the last load
+ * @return Best time in nanoseconds
+ */
+template<typename Loader>
+static qint64 runLoader(const char *name, const QString &text, int repeat, Loader &&loader, QString &saved)
+{
+    qint64 best = std::numeric_limits<qint64>::max();
+
+    for(int i = 0; i < repeat; i++)
+    {
+        NullView view;
+        FsmModel model;
+        view.registerModel(&model);
+        model.registerView(&view);
+
+        QString copy = text;
+        QTextStream in(&copy);
+        best = std::min(best, measureNs([&]() { loader(model, in); }));
+
+        if(view.errors > 0)
+        {
+            fprintf(stderr, "%s: %zu errors, last: %s\n", name, view.errors, qUtf8Printable(view.lastError));
+        }
+
+        if(i == repeat - 1)
+        {
+            saved = saveToString(model);
+        }
+    }
+
+    printf("%-8s best of %d: %10.2f ms\n", name, repeat, best / 1e6);
+    return best;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("bench_load");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compares the streaming .fsm parser against the previous per-line regex loader");
+    parser.addHelpOption();
+
+    QCommandLineOption statesOption({"n", "states"}, "Number of generated states (default 50000)", "count", "50000");
+    QCommandLineOption repeatOption({"r", "repeat"}, "Number of repetitions (default 3)", "count", "3");
+    QCommandLineOption fileOption({"f", "file"}, "Load given file instead of the generated one", "file");
+    parser.addOptions({statesOption, repeatOption, fileOption});
+    parser.process(a);
+
+    silenceLog();
+
+    int repeat = std::max(1, parser.value(repeatOption).toInt());
+    QString text;
+
+    if(parser.isSet(fileOption))
+    {
+        QFile file(parser.value(fileOption));
+        if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        {
+            fprintf(stderr, "Couldn't open %s\n", qUtf8Printable(parser.value(fileOption)));
+            return 1;
+        }
+        text = QString::fromUtf8(file.readAll());
+    }
+    else
+    {
+        text = generateLoadMachine(std::max(1, parser.value(statesOption).toInt()));
+    }
+
+    printf("Input: %d lines, %d characters\n", text.count('\n'), text.size());
+
+    QString savedStream;
+    QString savedRegex;
+
+    qint64 streaming = runLoader("stream", text, repeat, [](FsmModel &model, QTextStream &in) {
+        model.loadFromStream(in);
+    }, savedStream);
+
+    qint64 regex = runLoader("regex", text, repeat, [](FsmModel &model, QTextStream &in) {
+        regexLoadFromStream(model, in);
+    }, savedRegex);
+
+    printf("Speedup: %.2fx\n", streaming > 0 ? static_cast<double>(regex) / streaming : 0.0);
+    printf("Resulting machines %s\n", savedStream == savedRegex ? "match" : "DIFFER");
+
+    return savedStream == savedRegex ? 0 : 2;
+}
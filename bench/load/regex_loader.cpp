@@ -0,0 +1,179 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file regex_loader.cpp
+ * @author xcervia00
+ *
+ * @brief Previous per-line regex .fsm loader, kept as a baseline for the benchmark
+ *
+ */
+
+#include "regex_loader.h"
+
+#include <QRegularExpression>
+#include <QPoint>
+
+/**
+ * @brief Sections of the file format
+ */
+enum Section {
+    NONE,
+    NAME,
+    COMMENT,
+    INPUT,
+    OUTPUT,
+    VARIABLES,
+    STATES,
+    TRANSITIONS
+};
+
+// Generic regex for variables ==> datatype, name and value
+#define REGEX_VARIABLE R"(^\s*(int|float|bool|string)\s+([\w-]+)\s*=\s*(.+)\s*$)"
+// Internal variable regex ==> name and value (datatype is string)
+#define REGEX_VARIABLE_INPUT_OUTPUT R"(^([\w-]+)\s*(=\s*(.+)\s*)?$)"
+
+// Regex for states
+#define REGEX_STATE R"(^\s*([A-Za-z0-9_-]+)\s*\(\s*(\d+)\s*,\s*(\d+)\s*\)\s*:\s*\{\s*(.*)\s*\}\s*$)"
+
+// Regex for transitions
+#define REGEX_TRANSITION R"(^\s*(\w+)\s*->\s*(\w+)\s*:\s*\{\s*(.*)\s*\}\s*$)"
+
+static bool parseInOutVariableLine(FsmModel &model, const QString &line, int type)
+{
+    auto match = QRegularExpression(REGEX_VARIABLE_INPUT_OUTPUT).match(line);
+    if (!match.hasMatch()){
+        return false;
+    }
+
+    QString name = match.captured(1);
+    QString value = match.captured(3);
+
+    if(type == INPUT)
+        model.updateVarInput(name, value);
+    else if(type == OUTPUT)
+        model.updateVarOutput(name, value);
+
+    return true;
+}
+
+static bool parseVariableLine(FsmModel &model, const QString &line)
+{
+    auto match = QRegularExpression(REGEX_VARIABLE).match(line);
+    if (!match.hasMatch()){
+        return false;
+    }
+
+    QString type = match.captured(1);
+    QString name = match.captured(2);
+    QString value = match.captured(3);
+
+    bool ok = true;
+    if (type == "int") {
+        auto t = value.toInt(&ok, 10);
+        if(ok) model.updateVarInternal(name, QVariant(t));
+    }
+    else if (type == "float") {
+        auto t = value.toDouble(&ok);
+        if(ok) model.updateVarInternal(name, QVariant(t));
+    }
+    else if (type == "bool") {
+        ok = value == "true" || value == "false";
+        if(ok) model.updateVarInternal(name, QVariant(value == "true"));
+    }
+    else {
+        model.updateVarInternal(name, QVariant(value));
+    }
+
+    return ok;
+}
+
+static bool parseStateLine(FsmModel &model, const QString &line)
+{
+    auto match = QRegularExpression(REGEX_STATE).match(line);
+    if (!match.hasMatch()) return false;
+
+    QString name = match.captured(1);
+
+    bool ok;
+    int x = match.captured(2).toInt(&ok, 10);
+    if(!ok) return false;
+
+    int y = match.captured(3).toInt(&ok, 10);
+    if(!ok) return false;
+
+    QString action = match.captured(4);
+    model.updateState(name, QPoint(x, y));
+    if(!action.isEmpty())
+        model.updateAction(name, action);
+
+    return true;
+}
+
+static bool parseTransitionLine(FsmModel &model, const QString &line)
+{
+    auto match = QRegularExpression(REGEX_TRANSITION).match(line);
+    if (!match.hasMatch()) return false;
+
+    QString src = match.captured(1);
+    QString dst = match.captured(2);
+    QString condition = match.captured(3);
+
+    // (the original also checked that both states exist; the model reports it on its own)
+    auto id = model.getUniqueTransitionId();
+
+    model.updateTransition(id, src, dst);
+    if(!condition.isEmpty())
+        model.updateCondition(id, condition);
+
+    return true;
+}
+
+bool regexLoadFromStream(FsmModel &model, QTextStream &in)
+{
+    model.cleanup();
+
+    QString line;
+    Section currentSection = NONE;
+
+    while (!in.atEnd()) {
+        line = in.readLine().trimmed();
+        if (line.isEmpty()) continue;
+
+        if (line == "Name:") { currentSection = NAME; continue; }
+        else if (line == "Comment:") { currentSection = COMMENT; continue; }
+        else if (line == "Input:") { currentSection = INPUT; continue; }
+        else if (line == "Output:") { currentSection = OUTPUT; continue; }
+        else if (line == "Variables:") { currentSection = VARIABLES; continue; }
+        else if (line == "States:") { currentSection = STATES; continue; }
+        else if (line == "Transitions:") { currentSection = TRANSITIONS; continue; }
+
+        bool ok = true;
+        switch (currentSection) {
+            case NAME:
+                model.renameFsm(line);
+                break;
+            case INPUT:
+            case OUTPUT:
+                ok = parseInOutVariableLine(model, line, currentSection);
+                break;
+            case VARIABLES:
+                ok = parseVariableLine(model, line);
+                break;
+            case STATES:
+                ok = parseStateLine(model, line);
+                break;
+            case TRANSITIONS:
+                ok = parseTransitionLine(model, line);
+                break;
+            default:
+                break;
+        }
+
+        if(!ok){
+            model.cleanup();
+            return false;
+        }
+    }
+
+    return true;
+}
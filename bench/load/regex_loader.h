@@ -0,0 +1,26 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file regex_loader.h
+ * @author xcervia00
+ *
+ * @brief Previous per-line regex .fsm loader, kept as a baseline for the benchmark (interface)
+ *
+ */
+
+#ifndef REGEX_LOADER_H_
+#define REGEX_LOADER_H_
+
+#include <QTextStream>
+
+#include "model.h"
+
+/**
+ * @brief Loads FSM into the model the way FsmModel::loadFromStream used to (one regex built per line)
+ * @param model The model to load into
+ * @param in The stream to read from
+ * @return False if the file was rejected
+ */
+bool regexLoadFromStream(FsmModel &model, QTextStream &in);
+
+#endif
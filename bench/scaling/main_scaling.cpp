@@ -0,0 +1,211 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file main_scaling.cpp
+ * @author xcervia00
+ *
+ * @brief Benchmark of the work-stealing executor; throughput of many instances on 1 .. N workers as JSON
+ *
+ */
+
+#include "model.h"
+#include "null_view.h"
+#include "bench_utils.h"
+#include "machine_generators.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QString>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cstdio>
+
+/**
+ * @brief Waits until the workers processed everything posted to the instances
+ * @param executor The executor
+ * @return False if the workers got stuck
+ */
+static bool waitForIdle(const FsmExecutor &executor)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    while(executor.pendingEvents() > 0)
+    {
+        QThread::yieldCurrentThread();
+        if(timer.elapsed() > 60000)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Runs all instances on given number of workers and reports the throughput
+ * @param model The model holding the machine
+ * @param workers Number of worker threads
+ * @param instances Number of instances
+ * @param events Number of inputs per instance
+ * @return Results of the run; "completed" is false on failure
+ */
+static QJsonObject runWorkers(FsmModel &model, int workers, int instances, int events)
+{
+    QJsonObject result;
+    result["workers"] = workers;
+
+    FsmExecutor executor(workers);
+    size_t errors = 0;
+    QObject::connect(&executor, &FsmExecutor::instanceError, [&errors](int, const QString &) { errors++; });
+
+    if(!model.defineInstances(executor))
+    {
+        result["completed"] = false;
+        return result;
+    }
+
+    // Initial states are entered before the measurement
+    for(int i = 0; i < instances; i++)
+        executor.spawn();
+
+    bool completed = waitForIdle(executor);
+    executor.resetStats();
+
+    qint64 elapsed = measureNs([&]() {
+        for(int e = 0; e < events && completed; e++)
+        {
+            for(int id = 0; id < instances; id++)
+                executor.inputEvent(id, "in", "go");
+        }
+
+        completed = completed && waitForIdle(executor);
+    });
+
+    // Errors are delivered through the event loop of this thread
+    QCoreApplication::processEvents(QEventLoop::AllEvents);
+    completed = completed && errors == 0;
+
+    double total = static_cast<double>(instances) * events;
+    QJsonArray perWorker;
+    for(int i = 0; i < executor.workerCount(); i++)
+    {
+        FsmWorkerStats stats = executor.stats(i);
+
+        QJsonObject worker;
+        worker["events"] = static_cast<double>(stats.events);
+        worker["runs"] = static_cast<double>(stats.runs);
+        worker["steals"] = static_cast<double>(stats.steals);
+        worker["busy_ms"] = stats.busyNs / 1e6;
+        worker["events_per_sec"] = stats.busyNs > 0 ? stats.events / (stats.busyNs / 1e9) : 0.0;
+        perWorker.append(worker);
+    }
+
+    result["completed"] = completed;
+    result["seconds"] = elapsed / 1e9;
+    result["events_per_sec"] = elapsed > 0 ? total / (elapsed / 1e9) : 0.0;
+    result["errors"] = static_cast<double>(errors);
+    result["per_worker"] = perWorker;
+
+    if(!completed)
+        fprintf(stderr, "%2d workers: instances got stuck (%zu errors)\n", workers, errors);
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("bench_scaling");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs many instances of one machine on the work-stealing executor with 1 .. N workers");
+    parser.addHelpOption();
+
+    QCommandLineOption instancesOption({"i", "instances"}, "Number of instances (default 1000)", "count", "1000");
+    QCommandLineOption eventsOption({"e", "events"}, "Number of inputs per instance (default 100)", "count", "100");
+    QCommandLineOption workOption({"w", "work"}, "Loop iterations of every action (default 2000)", "count", "2000");
+    QCommandLineOption threadsOption({"t", "threads"}, "Maximal number of workers (default: ideal thread count)", "count",
+                                     QString::number(QThread::idealThreadCount()));
+    QCommandLineOption outputOption({"o", "output"}, "Write the JSON report to a file instead of stdout", "file");
+    parser.addOptions({instancesOption, eventsOption, workOption, threadsOption, outputOption});
+    parser.process(a);
+
+    silenceLog();
+
+    int instances = std::max(1, parser.value(instancesOption).toInt());
+    int events = std::max(1, parser.value(eventsOption).toInt());
+    int work = std::max(0, parser.value(workOption).toInt());
+    int threads = std::max(1, parser.value(threadsOption).toInt());
+
+    NullView view;
+    FsmModel model;
+    view.registerModel(&model);
+    model.registerView(&view);
+
+    QString text = generateWork(work);
+    QTextStream in(&text);
+    model.loadStream(in);
+
+    // Powers of two up to the maximum (and the maximum itself)
+    QVector<int> counts;
+    for(int n = 1; n < threads; n *= 2)
+        counts.append(n);
+    counts.append(threads);
+
+    QJsonArray results;
+    bool failed = false;
+    double single = 0;
+    for(int workers : counts)
+    {
+        QJsonObject result = runWorkers(model, workers, instances, events);
+        failed |= !result.value("completed").toBool();
+
+        double throughput = result.value("events_per_sec").toDouble();
+        if(workers == 1)
+            single = throughput;
+
+        double speedup = single > 0 ? throughput / single : 0.0;
+        result["speedup"] = speedup;
+        result["efficiency"] = speedup / workers;
+        results.append(result);
+
+        fprintf(stderr, "%2d workers %12.0f events/s  speedup %5.2fx  efficiency %5.1f %%\n",
+                workers, throughput, speedup, 100 * speedup / workers);
+    }
+
+    QJsonObject report;
+    report["benchmark"] = "bench_scaling";
+    report["qt_version"] = qVersion();
+    report["ideal_threads"] = QThread::idealThreadCount();
+    report["instances"] = instances;
+    report["events_per_instance"] = events;
+    report["work"] = work;
+    report["peak_rss_kb"] = static_cast<double>(peakRssKb());
+    report["results"] = results;
+
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if(parser.isSet(outputOption))
+    {
+        QFile file(parser.value(outputOption));
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            fprintf(stderr, "Cannot write %s\n", qUtf8Printable(parser.value(outputOption)));
+            return 1;
+        }
+        file.write(json);
+    }
+    else
+    {
+        fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    }
+
+    return failed ? 2 : 0;
+}
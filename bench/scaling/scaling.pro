@@ -0,0 +1,8 @@
+# Scaling of the work-stealing executor: many instances of one machine on 1 .. N worker threads
+
+include(../common/bench.pri)
+
+TARGET = bench_scaling
+
+SOURCES += $$files($$PWD/*.cpp)
+HEADERS += $$files($$PWD/*.h)
@@ -0,0 +1,345 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file main_suite.cpp
+ * @author xcervia00
+ *
+ * @brief Interpretation throughput suite; drives generated machines headlessly and reports the results as JSON
+ *
+ */
+
+#include "model.h"
+#include "null_view.h"
+#include "bench_utils.h"
+#include "machine_generators.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QString>
+#include <QTextStream>
+#include <QVector>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <cstdio>
+
+/**
+ * @brief Single scripted input and the state the machine has to settle in
+ */
+struct Step
+{
+    QString input; ///< Name of the input
+    QString value; ///< Value of the input
+    QString state; ///< State the machine has to enter (possibly after passing other states)
+};
+
+/**
+ * @brief Generated machine and the inputs driving it
+ */
+struct Scenario
+{
+    QString name; ///< Name reported in the results
+    QString text; ///< The machine (.fsm)
+    int states = 0; ///< Number of states
+    int transitions = 0; ///< Number of transitions
+    QVector<Step> steps; ///< Scripted inputs
+};
+
+/**
+ * @brief Processes events until the machine entered given state (after at least one state change)
+ * @param view The view
+ * @param before Number of state changes before the input was sent
+ * @param state The state to wait for; empty for any state
+ * @return False if the machine got stuck
+ */
+static bool waitForState(const NullView &view, size_t before, const QString &state)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    while(view.stateChanges <= before || (!state.isEmpty() && view.activeState != state))
+    {
+        QCoreApplication::processEvents(QEventLoop::AllEvents);
+        if(timer.elapsed() > 5000)
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Percentile of sorted samples
+ * @param sorted The samples (ascending)
+ * @param p The percentile (0 - 100)
+ * @return The value; 0 if there are no samples
+ */
+static qint64 percentile(const QVector<qint64> &sorted, double p)
+{
+    if(sorted.isEmpty())
+        return 0;
+
+    int index = static_cast<int>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+/*
+============================
+         SCENARIOS
+============================
+*/
+
+/**
+ * @brief Long chain; every input moves to the next state
+ * @param scale Multiplier of the size
+ * @return The scenario
+ */
+static Scenario chainScenario(int scale)
+{
+    Scenario s;
+    s.name = "chain";
+    s.states = 1000 * scale;
+    s.transitions = s.states;
+    s.text = generateChain(s.states);
+
+    for(int i = 0; i < 20000 * scale; i++)
+        s.steps.append({"in", "1", QString("S%1").arg((i + 1) % s.states)});
+
+    return s;
+}
+
+/**
+ * @brief Complete graph; every input checks all guards of the active state
+ * @param scale Multiplier of the number of inputs
+ * @return The scenario
+ */
+static Scenario denseScenario(int scale)
+{
+    Scenario s;
+    s.name = "dense";
+    s.states = 64;
+    s.transitions = s.states * s.states;
+    s.text = generateDense(s.states);
+
+    // Deterministic pseudo-random walk (the same for both engines)
+    quint32 seed = 12345;
+    for(int i = 0; i < 10000 * scale; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        int target = static_cast<int>((seed >> 16) % s.states);
+        s.steps.append({"in", QString::number(target), QString("S%1").arg(target)});
+    }
+
+    return s;
+}
+
+/**
+ * @brief Factorial loop; every input runs through a chain of guarded empty transitions with actions
+ * @param scale Multiplier of the number of inputs
+ * @return The scenario
+ */
+static Scenario factorialScenario(int scale)
+{
+    Scenario s;
+    s.name = "factorial";
+    s.states = 4;
+    s.transitions = 5;
+    s.text = generateFactorial();
+
+    for(int i = 0; i < 1000 * scale; i++)
+        s.steps.append({"fac", "10", "Factorial"});
+
+    return s;
+}
+
+/**
+ * @brief Many concurrent timeouts; every input arms all of them, the first one to elapse cancels the rest
+ * @param scale Multiplier of the size
+ * @return The scenario
+ */
+static Scenario timeoutsScenario(int scale)
+{
+    Scenario s;
+    s.name = "timeouts";
+    s.states = 2;
+    s.transitions = 1000 * scale + 1;
+    s.text = generateTimeouts(1000 * scale);
+
+    for(int i = 0; i < 100 * scale; i++)
+        s.steps.append({"go", "1", "Idle"});
+
+    return s;
+}
+
+/*
+============================
+           RUNNING
+============================
+*/
+
+/**
+ * @brief Loads and interprets the scenario by given engine
+ * @param scenario The scenario
+ * @param engineName Name of the engine (reported)
+ * @param engineType The engine
+ * @return Results of the run
+ */
+static QJsonObject runScenario(const Scenario &scenario, const QString &engineName, FsmEngineType engineType)
+{
+    QJsonObject result;
+    result["scenario"] = scenario.name;
+    result["engine"] = engineName;
+    result["states"] = scenario.states;
+    result["transitions"] = scenario.transitions;
+
+    NullView view;
+    FsmModel model;
+    view.registerModel(&model);
+    model.registerView(&view);
+
+    QString copy = scenario.text;
+    QTextStream in(&copy);
+    qint64 loadNs = measureNs([&]() { model.loadStream(in); });
+    result["load_ms"] = loadNs / 1e6;
+
+    // Enter the initial state
+    model.setEngineType(engineType);
+    view.startInterpretation();
+    bool completed = waitForState(view, 0, QString());
+
+    QVector<qint64> latencies;
+    latencies.reserve(scenario.steps.size());
+
+    QElapsedTimer total;
+    total.start();
+
+    QElapsedTimer latency;
+    for(const auto &step : scenario.steps)
+    {
+        if(!completed)
+            break;
+
+        size_t before = view.stateChanges;
+        latency.start();
+        view.inputEvent(step.input, step.value);
+        completed = waitForState(view, before, step.state);
+        latencies.append(latency.nsecsElapsed());
+    }
+
+    qint64 totalNs = total.nsecsElapsed();
+    view.stopInterpretation();
+
+    completed = completed && view.errors == 0;
+    std::sort(latencies.begin(), latencies.end());
+
+    result["completed"] = completed;
+    result["events"] = latencies.size();
+    result["events_per_sec"] = totalNs > 0 ? latencies.size() / (totalNs / 1e9) : 0.0;
+    result["latency_p50_us"] = percentile(latencies, 50) / 1e3;
+    result["latency_p99_us"] = percentile(latencies, 99) / 1e3;
+    result["outputs"] = static_cast<double>(view.outputs);
+    result["errors"] = static_cast<double>(view.errors);
+    result["peak_rss_kb"] = static_cast<double>(peakRssKb());
+
+    if(!completed)
+    {
+        fprintf(stderr, "%s/%s: machine got stuck in %s (%zu errors, last: %s)\n",
+                qUtf8Printable(scenario.name), qUtf8Printable(engineName), qUtf8Printable(view.activeState),
+                view.errors, qUtf8Printable(view.lastError));
+    }
+    else
+    {
+        fprintf(stderr, "%-10s %-12s %12.0f events/s  p50 %9.1f us  p99 %9.1f us  load %8.2f ms\n",
+                qUtf8Printable(scenario.name), qUtf8Printable(engineName),
+                result["events_per_sec"].toDouble(), result["latency_p50_us"].toDouble(),
+                result["latency_p99_us"].toDouble(), result["load_ms"].toDouble());
+    }
+
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("bench_suite");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Interprets generated machines (chain, dense graph, factorial loop, concurrent timeouts) and reports throughput as JSON");
+    parser.addHelpOption();
+
+    QCommandLineOption scaleOption({"s", "scale"}, "Multiplier of the machine sizes and input counts (default 1)", "factor", "1");
+    QCommandLineOption engineOption({"e", "engine"}, "Engine to run: all, statemachine or flat (default all)", "engine", "all");
+    QCommandLineOption scenarioOption({"t", "scenario"}, "Run only given scenario: chain, dense, factorial or timeouts", "name");
+    QCommandLineOption outputOption({"o", "output"}, "Write the JSON report to a file instead of stdout", "file");
+    parser.addOptions({scaleOption, engineOption, scenarioOption, outputOption});
+    parser.process(a);
+
+    silenceLog();
+
+    int scale = std::max(1, parser.value(scaleOption).toInt());
+    QString engine = parser.value(engineOption);
+    if(engine != "all" && engine != "statemachine" && engine != "flat")
+    {
+        fprintf(stderr, "Unknown engine: %s\n", qUtf8Printable(engine));
+        return 1;
+    }
+
+    QVector<Scenario> scenarios{chainScenario(scale), denseScenario(scale), factorialScenario(scale), timeoutsScenario(scale)};
+    if(parser.isSet(scenarioOption))
+    {
+        QString only = parser.value(scenarioOption);
+        auto it = std::remove_if(scenarios.begin(), scenarios.end(), [&](const Scenario &s) { return s.name != only; });
+        scenarios.erase(it, scenarios.end());
+
+        if(scenarios.isEmpty())
+        {
+            fprintf(stderr, "Unknown scenario: %s\n", qUtf8Printable(only));
+            return 1;
+        }
+    }
+
+    QJsonArray results;
+    bool failed = false;
+    for(const auto &scenario : scenarios)
+    {
+        if(engine != "flat")
+        {
+            results.append(runScenario(scenario, "statemachine", ENGINE_STATE_MACHINE));
+            failed |= !results.last().toObject().value("completed").toBool();
+        }
+        if(engine != "statemachine")
+        {
+            results.append(runScenario(scenario, "flat", ENGINE_FLAT));
+            failed |= !results.last().toObject().value("completed").toBool();
+        }
+    }
+
+    QJsonObject report;
+    report["benchmark"] = "bench_suite";
+    report["qt_version"] = qVersion();
+    report["scale"] = scale;
+    report["peak_rss_kb"] = static_cast<double>(peakRssKb());
+    report["results"] = results;
+
+    QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+
+    if(parser.isSet(outputOption))
+    {
+        QFile file(parser.value(outputOption));
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            fprintf(stderr, "Cannot write %s\n", qUtf8Printable(parser.value(outputOption)));
+            return 1;
+        }
+        file.write(json);
+    }
+    else
+    {
+        fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    }
+
+    return failed ? 2 : 0;
+}
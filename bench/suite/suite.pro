@@ -0,0 +1,8 @@
+# Interpretation throughput suite over generated machines (JSON report)
+
+include(../common/bench.pri)
+
+TARGET = bench_suite
+
+SOURCES += $$files($$PWD/*.cpp)
+HEADERS += $$files($$PWD/*.h)
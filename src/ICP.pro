@@ -13,6 +13,7 @@ TARGET = icp_fsm_interpreter
 INCLUDEPATH += $$PWD/model
 INCLUDEPATH += $$PWD/interpreter
 INCLUDEPATH += $$PWD/exceptions
+INCLUDEPATH += $$PWD/logging
 INCLUDEPATH += $$PWD/view
 
 SOURCES += $$files($$PWD/*.cpp, true)
@@ -21,6 +22,14 @@ HEADERS += $$files($$PWD/*.h, true)
 
 FORMS += $$files($$PWD/*.ui, true)
 
+# Headless runtime is a separate project (runtime/icp_fsm_runtime.pro)
+SOURCES -= $$files($$PWD/runtime/*.cpp, true)
+HEADERS -= $$files($$PWD/runtime/*.h, true)
+
+# Trace decoder is a separate project (trace_decode/icp_trace_decode.pro)
+SOURCES -= $$files($$PWD/trace_decode/*.cpp, true)
+HEADERS -= $$files($$PWD/trace_decode/*.h, true)
+
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
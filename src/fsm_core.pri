@@ -0,0 +1,24 @@
+# Widget-free core of the interpreter (model, interpreter, network, logging, exceptions)
+# Shared by every project that runs FsmModel without the editor
+
+QT += core qml network
+
+INCLUDEPATH += $$PWD
+INCLUDEPATH += $$PWD/model
+INCLUDEPATH += $$PWD/interpreter
+INCLUDEPATH += $$PWD/exceptions
+INCLUDEPATH += $$PWD/network
+INCLUDEPATH += $$PWD/logging
+
+SOURCES += $$files($$PWD/model/*.cpp, true)
+SOURCES += $$files($$PWD/interpreter/*.cpp, true)
+SOURCES += $$files($$PWD/network/*.cpp, true)
+SOURCES += $$files($$PWD/logging/*.cpp, true)
+SOURCES += $$files($$PWD/exceptions/*.cpp, true)
+
+HEADERS += $$PWD/mvc_interface.h
+HEADERS += $$files($$PWD/model/*.h, true)
+HEADERS += $$files($$PWD/interpreter/*.h, true)
+HEADERS += $$files($$PWD/network/*.h, true)
+HEADERS += $$files($$PWD/logging/*.h, true)
+HEADERS += $$files($$PWD/exceptions/*.h, true)
@@ -15,13 +15,13 @@
 #include "action_state.h"
 #include "combined_transition.h"
 #include "combined_event.h"
+#include "async_logger.h"
+#include "trace_recorder.h"
 
 ActionState::ActionState(const QString &action, const QPoint &position) 
     :
     m_action{action},
-    m_position{position},
-    m_timeVisited{},
-    m_timeSinceEntry{}
+    m_position{position}
 {
     
 }
@@ -30,34 +30,53 @@ void ActionState::onEntry(QEvent *event)
 {
     (void)event;
 
-    // If state was changed, update timer
-    if(this != ActionState::getLastState())
+    this->enterState();
+    if(this->machine()->isRunning()){
+        this->machine()->postEvent(new FsmInputEvent("")); // Upon entry, implicitlly fire 'empty' input
+    }
+}
+
+void ActionState::enterState()
+{
+    // If state was changed, update timer (last state is kept by the run, so separate machines don't interfere)
+    if(m_context == nullptr || m_context->lastState != this)
     {
-        ActionState::setLastState(this);
-        m_timeVisited.start();
+        if(m_context != nullptr)
+            m_context->lastState = this;
+        m_timeVisited = this->clock()->elapsed();
     }
 
     // Always reset this timer on any state entry
-    m_timeSinceEntry.start();
+    m_timeSinceEntry = this->clock()->elapsed();
 
-    qInfo() << "Interpreter: State entered: " << this->objectName();
+    logEvent(LOG_STATE_ENTERED, this->objectName());
+    if(m_context != nullptr && m_context->trace != nullptr && m_context->trace->isRecording())
+        m_context->trace->recordState(this->objectName());
 
     // Trigger action of the state
     this->executeAction();
-    if(this->machine()->isRunning()){
-        this->machine()->postEvent(new FsmInputEvent("")); // Upon entry, implicitlly fire 'empty' input
-    }
 }
 
 void ActionState::executeAction()
 {
+    // Nothing to execute
+    if(this->m_action.isEmpty())
+        return;
+
     // Get the engine for evaluation
     QJSEngine* engine = static_cast<QJSEngine*>(this->machine()->parent());
     
     //auto result = engine->evaluate(QString("with (icp) { %1 }").arg(this->getAction())); // Optionally remove icp. prefix
     
-    // Evaluate the action
-    auto result = engine->evaluate(QStringLiteral("(function(){ %1 })();").arg(this->getAction()));
+    // Compile the action only once (per action and engine)
+    if(m_compiledFor != engine)
+    {
+        m_actionFunc = engine->evaluate(QStringLiteral("(function(){ %1\n })").arg(this->getAction()));
+        m_compiledFor = engine;
+    }
+
+    // Failed to compile ==> the error is reported on every execution, same as before
+    auto result = m_actionFunc.isCallable() ? m_actionFunc.call() : m_actionFunc;
 
     if(result.isError()){
         qCritical() << "Intepreter: Error during execution of state action";
@@ -84,6 +103,10 @@ const QPoint &ActionState::getPosition() const
 bool ActionState::setAction(const QString &action)
 {
     this->m_action = action;
+
+    // Invalidate compiled action
+    this->m_compiledFor = nullptr;
+    this->m_actionFunc = QJSValue();
     return true;
 }
 
@@ -92,26 +115,32 @@ const QString &ActionState::getAction() const
     return this->m_action;
 }
 
-bool ActionState::setLastState(ActionState *state)
+qint64 ActionState::getElapsed() const
 {
-    ActionState::m_lastState = state;
-    return true;
+    return this->clock()->elapsed() - m_timeVisited;
 }
 
-ActionState *ActionState::getLastState()
+qint64 ActionState::getElapsedSinceEntry() const
 {
-    return ActionState::m_lastState;
+    return this->clock()->elapsed() - m_timeSinceEntry;
 }
 
-qint64 ActionState::getElapsed() const
+FsmClock *ActionState::clock() const
 {
-    return m_timeVisited.elapsed();
+    return m_context != nullptr && m_context->clock != nullptr ? m_context->clock : FsmClock::system();
 }
 
-qint64 ActionState::getElapsedSinceEntry() const
+void ActionState::setTimerGroup(int group)
+{
+    this->m_timerGroup = group;
+}
+
+int ActionState::getTimerGroup() const
 {
-    return m_timeSinceEntry.elapsed();
+    return this->m_timerGroup;
 }
 
-// By default, last state is nullptr
-QPointer<ActionState> ActionState::m_lastState = nullptr;
+void ActionState::setContext(InterpreterContext *context)
+{
+    this->m_context = context;
+}
@@ -15,8 +15,11 @@
 #include <QStateMachine>
 #include <QState>
 #include <QPoint>
-#include <QElapsedTimer>
 #include <QJSEngine>
+#include <QJSValue>
+
+#include "interpreter_context.h"
+#include "fsm_clock.h"
 
 /**
  * @brief Class for representing states in ICP FSM
@@ -29,12 +32,22 @@ class ActionState : public QState
         QString m_action; ///< The actions that will be executed when the state is entered; in form of JS script
         QPoint m_position; ///< The current position of the state in editor
 
-        static QPointer<ActionState> m_lastState; ///< Last visited state
-        QElapsedTimer m_timeVisited; ///< Time at which the state was entered without changing to any other state
-        QElapsedTimer m_timeSinceEntry; ///< Time at which the state was entered
+        qint64 m_timeVisited = 0; ///< Time at which the state was entered without changing to any other state (see clock())
+        qint64 m_timeSinceEntry = 0; ///< Time at which the state was entered (see clock())
+
+        QJSEngine *m_compiledFor = nullptr; ///< The engine m_actionFunc was compiled by; nullptr if cache is invalid
+        QJSValue m_actionFunc; ///< The action compiled into callable function
+        int m_timerGroup = -1; ///< Group of timeouts of outgoing transitions (see TimerWheel); -1 if none
+        InterpreterContext *m_context = nullptr; ///< Model services used during interpretation
         
         void onEntry(QEvent *event) override; ///< Method that is executed when state is entered 
 
+        /**
+         * @brief Clock the elapsed times are measured by
+         * @return Clock of the context; FsmClock::system() if there is none
+         */
+        FsmClock *clock() const;
+
     public:
         /**
          * @brief Constructor for action state
@@ -43,6 +56,11 @@ class ActionState : public QState
          */
         ActionState(const QString &action, const QPoint &position);
 
+        /**
+         * @brief Updates the timers and executes the action; everything the entry does except firing the empty input
+         */
+        void enterState();
+
         /**
          * @brief Executes the m_action using QJSEngine
          */
@@ -79,18 +97,6 @@ class ActionState : public QState
          */
         const QString &getAction() const;
 
-        /**
-         * @brief Setter for the last state visited
-         * @param state That is visited now
-         * @return Returns true on success, otherwise false
-         */
-        static bool setLastState(ActionState* state);
-        /**
-         * @brief Getter for last visited state
-         * @return Returns pointer of the state, or nullptr if interpretation hadn't started yet
-         */
-        static ActionState* getLastState();
-
         /**
          * @brief Returns the amount of time spent in this state
          * @return Returns milliseconds spent in this state as qint64
@@ -102,6 +108,24 @@ class ActionState : public QState
          * @return Returns milliseconds spent in this state as qint64
          */
         qint64 getElapsedSinceEntry() const;
+
+        /**
+         * @brief Sets the group of timeouts of outgoing transitions
+         * @param group Id of the group (see TimerWheel::createGroup)
+         */
+        void setTimerGroup(int group);
+
+        /**
+         * @brief Returns the group of timeouts of outgoing transitions
+         * @return Id of the group; -1 if none
+         */
+        int getTimerGroup() const;
+
+        /**
+         * @brief Sets the model services used during interpretation
+         * @param context The context owned by the model
+         */
+        void setContext(InterpreterContext *context);
 };
 
 
@@ -10,12 +10,15 @@
 
 #include "combined_transition.h"
 #include "combined_event.h"
+#include "action_state.h"
 #include <QDebug>
 #include <QObject>
 #include <QStateMachine>
 #include <QJSEngine>
 #include <QRegularExpression>
 #include "fsm_exceptions.h"
+#include "async_logger.h"
+#include "trace_recorder.h"
 
 #include <stdexcept>
 
@@ -34,7 +37,9 @@ CombinedTransition::CombinedTransition(const QString &name, const QString &guard
     m_pending{false},
     m_pending_id{-1},
     m_id{0}
-{}
+{
+    this->invalidateScripts();
+}
 
 CombinedTransition::CombinedTransition(const QString &unparsed_condition)
     :
@@ -54,9 +59,7 @@ bool CombinedTransition::setCondition(const QString &condition)
 
     if(match.hasMatch())
     {
-        this->m_name = match.captured(1);
-        this->m_guard = match.captured(3);
-        this->m_timeout = match.captured(5);
+        this->setConditionParts(match.captured(1), match.captured(3), match.captured(5));
         return true;
     }
     else
@@ -67,22 +70,92 @@ bool CombinedTransition::setCondition(const QString &condition)
     return false;
 }
 
+void CombinedTransition::setConditionParts(const QString &name, const QString &guard, const QString &timeout)
+{
+    this->m_name = name;
+    this->m_guard = guard;
+    this->m_timeout = timeout;
+
+    // Scripts of the old condition are not valid anymore
+    this->invalidateScripts();
+}
+
+void CombinedTransition::invalidateScripts()
+{
+    m_compiled.setScripts(m_guard, m_timeout);
+}
+
+bool CombinedTransition::testCondition(QJSEngine *engine, int &timeoutMs)
+{
+    return m_compiled.test(engine, m_context != nullptr ? m_context->variables : nullptr, timeoutMs);
+}
+
+void CombinedTransition::setContext(InterpreterContext *context)
+{
+    m_context = context;
+}
+
+void CombinedTransition::reportTaken()
+{
+    logEvent(LOG_TRANSITION_FIRED, this->sourceState()->objectName(), this->targetState()->objectName(), static_cast<qint32>(this->m_id));
+
+    if(m_context != nullptr && m_context->trace != nullptr && m_context->trace->isRecording())
+        m_context->trace->recordTransition(static_cast<qint64>(this->m_id), this->sourceState()->objectName(), this->targetState()->objectName());
+}
+
 size_t CombinedTransition::getId() const
 {
     return m_id;
 }
 
+TimerWheel *CombinedTransition::timers() const
+{
+    return m_context != nullptr ? m_context->timers : nullptr;
+}
+
+int CombinedTransition::timerGroup() const
+{
+    auto state = static_cast<ActionState*>(this->sourceState());
+    return state != nullptr ? state->getTimerGroup() : -1;
+}
+
+bool CombinedTransition::isPending() const
+{
+    if(!m_pending)
+        return false;
+
+    // Whole group might have been cancelled since
+    auto wheel = this->timers();
+    return wheel == nullptr || wheel->groupGeneration(this->timerGroup()) == m_pendingGeneration;
+}
+
 void CombinedTransition::stopTimer()
 {
     // Cancel any timed events
-    if(m_pending && m_pending_id != -1)
-        this->machine()->cancelDelayedEvent(this->m_pending_id);
+    if(m_pending)
+    {
+        auto wheel = this->timers();
+        if(wheel != nullptr)
+            wheel->cancel(this->m_timer);
+        else if(m_pending_id != -1)
+            this->machine()->cancelDelayedEvent(this->m_pending_id);
+    }
 
     // Mark transition as not pending
+    this->m_timer = TimerWheel::INVALID_HANDLE;
     this->m_pending_id = -1;
     this->m_pending = false;
 }
 
+void CombinedTransition::timerExpired(quint64 cookie)
+{
+    (void)cookie;
+
+    // Taken the same way as delayed events of the machine
+    if(this->machine() != nullptr && this->machine()->isRunning())
+        this->machine()->postEvent(new FsmTimeoutEvent(this));
+}
+
 bool CombinedTransition::eventTest(QEvent *e)
 {
     if(e == nullptr || !this->machine()->isRunning()) return false;
@@ -90,7 +163,7 @@ bool CombinedTransition::eventTest(QEvent *e)
     if(e->type() == FsmInputEvent::getType()) // Initial input trigger
     {
         // Already waiting for timeout, wait for it instead
-        if(m_pending)
+        if(this->isPending())
             return false;
 
         // Mismatch in the input name
@@ -101,59 +174,32 @@ bool CombinedTransition::eventTest(QEvent *e)
         if(this->machine() == nullptr || this->machine()->parent() == nullptr) 
             return false;
 
-        // Try guard condition here...
-        if(!m_guard.isEmpty())
-        {
-            QJSEngine* engine = static_cast<QJSEngine*>(this->machine()->parent()); // Get the parent of main statemachine --> the QJSEngine 
-            QJSValue guard_result = engine->evaluate(this->m_guard);
-
-            if(guard_result.isError())
-            {
-                qCritical() << "Interpreter: Error during guard condition code evaluation";
-            }
-            
-            // Has to be bool and that is true
-            if(!guard_result.isBool() || !guard_result.toBool())
-                return false;
-        }
+        QJSEngine* engine = static_cast<QJSEngine*>(this->machine()->parent()); // Get the parent of main statemachine --> the QJSEngine 
 
-        // Guard passed... start timeout
-        int timeoutMs = 0;
+        // Check guard and get the timeout
+        int timeoutMs;
+        if(!this->testCondition(engine, timeoutMs))
+            return false;
 
-        // Timeout is not empty - extract its value
-        if(!m_timeout.isEmpty())
+        // Start new timeout
+        auto wheel = this->timers();
+        if(wheel != nullptr)
         {
-            bool ok;
-            timeoutMs = this->m_timeout.toInt(&ok);
-
-            // Timeout is not a number ==> Try to evaluate it as a script and expect integer value as output
-            if(!ok)
-            {
-                auto timeoutResult = (static_cast<QJSEngine*>(this->machine()->parent())->evaluate(this->m_timeout));
-
-                if(timeoutResult.isError())
-                {
-                    qWarning() << "Interpreter: Error during timeout code evaluation";
-                }
-                
-                if(timeoutResult.isNumber())
-                {
-                    timeoutMs = timeoutResult.toInt();
-                }
-            }
-
-            if(timeoutMs < 0){timeoutMs = 0;}
+            int group = this->timerGroup();
+            this->m_pendingGeneration = wheel->groupGeneration(group);
+            this->m_timer = wheel->schedule(timeoutMs, group, this, 0);
+        }
+        else
+        {
+            this->m_pending_id = this->machine()->postDelayedEvent(new FsmTimeoutEvent(this), timeoutMs);
         }
-
-        // Start new timeout
-        this->m_pending_id = this->machine()->postDelayedEvent(new FsmTimeoutEvent(this), timeoutMs);
         this->m_pending = true;
         return false;
 
     } else if(e->type() == FsmTimeoutEvent::getType())  // Something timed-out - was it me?
     {
         // Not even awaiting timeout, exit...
-        if(!m_pending)
+        if(!this->isPending())
             return false;
 
         FsmTimeoutEvent *timeEvent = static_cast<FsmTimeoutEvent*>(e);
@@ -165,9 +211,9 @@ bool CombinedTransition::eventTest(QEvent *e)
         
         m_pending = false;
         m_pending_id = -1;
+        m_timer = TimerWheel::INVALID_HANDLE;
 
-        qInfo() << "Interpreter: Transition of id " << this->m_id << " from state " << this->sourceState()->objectName()
-                << " to " << this->targetState()->objectName() << " had been triggered";
+        this->reportTaken();
 
         return true;
         
@@ -196,7 +242,14 @@ void CombinedTransition::onTransition(QEvent * e)
     // Don't reset timers on transition
     if(this->sourceState() != this->targetState()){
 
-        // Stop any pending timers
+        // Stop any pending timers (all at once if they are in the wheel)
+        auto wheel = this->timers();
+        if(wheel != nullptr)
+        {
+            wheel->cancelGroup(this->timerGroup());
+            return;
+        }
+
         foreach(auto &tr, parentState->transitions())
         {
             auto curr = static_cast<CombinedTransition*>(tr);
@@ -215,4 +268,16 @@ QString CombinedTransition::getGuard() const {
 
 QString CombinedTransition::getTimeout() const {
     return m_timeout;
-}
\ No newline at end of file
+}
+
+QString CombinedTransition::getCondition() const {
+    QString condition;
+    if (!m_name.isEmpty())
+        condition += m_name;
+    if (!m_guard.isEmpty())
+        condition += " [" + m_guard + "]";
+    if (!m_timeout.isEmpty())
+        condition += " @ " + m_timeout;
+
+    return condition;
+}
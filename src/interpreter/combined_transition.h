@@ -14,6 +14,12 @@
 #include <QObject>
 #include <QStateMachine>
 #include <QAbstractTransition>
+#include <QJSEngine>
+#include <QJSValue>
+
+#include "compiled_condition.h"
+#include "interpreter_context.h"
+#include "timer_wheel.h"
 
 // Regex to parse the condition by
 #define REGEX_TRANSITION_CONDITION "^\\s*([a-zA-Z_-]+)?\\s*(\\[([\\x00-\\x7F]+)\\])?\\s*(@\\s*([\\x00-\\x7F]+))?\\s*$"
@@ -21,7 +27,7 @@
 /**
  * @brief Class used for transitions in ICP FSM - it combines two possible input events (initial Input and Timeout)
  */
-class CombinedTransition : public QAbstractTransition
+class CombinedTransition : public QAbstractTransition, public TimerWheelClient
 {
     Q_OBJECT
 
@@ -31,10 +37,39 @@ class CombinedTransition : public QAbstractTransition
         QString m_timeout; ///< Timeout before proceeding with transition; can be empty
 
         bool m_pending; ///< Flags whether a Timeout event spawned by this transition is pending
-        int m_pending_id; ///< The id of delayed Timeout event; -1 if nothing pending 
+        int m_pending_id; ///< The id of delayed Timeout event; -1 if nothing pending (only used without timer wheel)
+        TimerWheel::Handle m_timer = TimerWheel::INVALID_HANDLE; ///< Scheduled timeout (see InterpreterContext::timers)
+        quint32 m_pendingGeneration = 0; ///< Generation of the source state's timer group at the time the timeout was scheduled
 
         size_t m_id; ///< Unique identifier of the transition
 
+        CompiledCondition m_compiled; ///< Guard and timeout compiled for the engine
+        InterpreterContext *m_context = nullptr; ///< Model services used during interpretation
+
+        /**
+         * @brief Returns the scheduler of timeouts
+         * @return The timer wheel, or nullptr if delayed events of the machine are used instead
+         */
+        TimerWheel *timers() const;
+
+        /**
+         * @brief Returns the timer group of the source state
+         * @return Id of the group
+         */
+        int timerGroup() const;
+
+        /**
+         * @brief Checks whether this transition waits for its timeout
+         * @note Timeouts cancelled together with their group (by leaving the state) are not pending anymore
+         * @return True if the timeout is pending
+         */
+        bool isPending() const;
+
+        /**
+         * @brief Drops the compiled guard and timeout (used when condition changes)
+         */
+        void invalidateScripts();
+
     protected:
         /**
          * @brief Tests whether transition should be triggered
@@ -47,6 +82,11 @@ class CombinedTransition : public QAbstractTransition
          * @param e Event that triggered the transition
          */
         void onTransition(QEvent *e) override;
+        /**
+         * @brief Timeout scheduled by the timer wheel expired; posts the Timeout event to the machine
+         * @param cookie Unused
+         */
+        void timerExpired(quint64 cookie) override;
 
     public:
         /**
@@ -75,6 +115,33 @@ class CombinedTransition : public QAbstractTransition
          */
         bool setCondition(const QString &condition);
 
+        /**
+         * @brief Sets already parsed parts of the condition (no parsing needed)
+         * @param name The input that can trigger this transition; can be empty
+         * @param guard The guard condition; can be empty
+         * @param timeout The timeout; can be empty
+         */
+        void setConditionParts(const QString &name, const QString &guard, const QString &timeout);
+
+        /**
+         * @brief Checks the guard and evaluates the timeout (once the input matched)
+         * @param engine The engine to evaluate the scripts by
+         * @param timeoutMs The timeout to wait for before the transition is taken
+         * @return True if the guard passed
+         */
+        bool testCondition(QJSEngine *engine, int &timeoutMs);
+
+        /**
+         * @brief Sets the model services used during interpretation
+         * @param context The context owned by the model
+         */
+        void setContext(InterpreterContext *context);
+
+        /**
+         * @brief Reports that the transition is being taken (logs it and records it into the trace)
+         */
+        void reportTaken();
+
         /**
          * @brief Getter for the unique identifier (m_id) of this state
          * @return Returns size_t being the unique ID of this state
@@ -102,6 +169,11 @@ class CombinedTransition : public QAbstractTransition
          */
         QString getTimeout() const;
 
+        /**
+         * @brief Returns the whole condition in format: INPUT [ GUARD ] @ TIMEOUT
+         */
+        QString getCondition() const;
+
 };
 
 #endif // COMBINEDTRANSITION_H
@@ -0,0 +1,112 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file compiled_condition.cpp
+* @author  xcervia00
+*
+* @brief Guard and timeout of a transition compiled for evaluation by a script engine
+*
+*/
+
+#include "compiled_condition.h"
+
+#include <QDebug>
+
+void CompiledCondition::setScripts(const QString &guard, const QString &timeout)
+{
+    m_guard = guard;
+    m_timeout = timeout;
+
+    m_compiledFor = nullptr;
+    m_guardFunc = QJSValue();
+    m_timeoutFunc = QJSValue();
+
+    // Simple guards don't need the engine at all
+    m_nativeGuard.compile(m_guard);
+
+    // Plain numeric timeouts don't need the engine at all
+    bool ok = true;
+    m_timeoutMs = m_timeout.isEmpty() ? 0 : m_timeout.toInt(&ok);
+    m_timeoutConst = ok;
+    if(!ok){m_timeoutMs = 0;}
+}
+
+void CompiledCondition::compile(QJSEngine *engine)
+{
+    m_guardFunc = QJSValue();
+    m_timeoutFunc = QJSValue();
+
+    // Guard is an expression ==> return its value from a function; newline guards against trailing comments
+    if(!m_guard.isEmpty())
+    {
+        auto compiled = engine->evaluate(QStringLiteral("(function(){ return (%1\n); })").arg(m_guard));
+        if(!compiled.isError() && compiled.isCallable())
+            m_guardFunc = compiled;
+    }
+
+    if(!m_timeoutConst)
+    {
+        auto compiled = engine->evaluate(QStringLiteral("(function(){ return (%1\n); })").arg(m_timeout));
+        if(!compiled.isError() && compiled.isCallable())
+            m_timeoutFunc = compiled;
+    }
+
+    m_compiledFor = engine;
+}
+
+bool CompiledCondition::testGuard(QJSEngine *engine, const GuardVariableSource *variables)
+{
+    // Native fast-path; undecidable cases (e.g. undefined variable) are left to the engine
+    bool passed;
+    if(variables != nullptr && m_nativeGuard.evaluate(*variables, passed))
+        return passed;
+
+    // Use the compiled guard; scripts that could not be compiled as expression are evaluated directly
+    QJSValue guard_result = m_guardFunc.isCallable() ? m_guardFunc.call() : engine->evaluate(this->m_guard);
+
+    if(guard_result.isError())
+    {
+        qCritical() << "Interpreter: Error during guard condition code evaluation";
+    }
+
+    // Has to be bool and that is true
+    return guard_result.isBool() && guard_result.toBool();
+}
+
+bool CompiledCondition::test(QJSEngine *engine, const GuardVariableSource *variables, int &timeoutMs)
+{
+    // Compile scripts only once (per condition and engine)
+    if(m_compiledFor != engine)
+        this->compile(engine);
+
+    // Try guard condition here...
+    if(!m_guard.isEmpty() && !this->testGuard(engine, variables))
+        return false;
+
+    // Guard passed... get the timeout
+    timeoutMs = m_timeoutMs;
+
+    // Timeout is not empty - extract its value
+    if(!m_timeout.isEmpty())
+    {
+        // Timeout is not a number ==> Try to evaluate it as a script and expect integer value as output
+        if(!m_timeoutConst)
+        {
+            auto timeoutResult = m_timeoutFunc.isCallable() ? m_timeoutFunc.call() : engine->evaluate(this->m_timeout);
+
+            if(timeoutResult.isError())
+            {
+                qWarning() << "Interpreter: Error during timeout code evaluation";
+            }
+
+            if(timeoutResult.isNumber())
+            {
+                timeoutMs = timeoutResult.toInt();
+            }
+        }
+
+        if(timeoutMs < 0){timeoutMs = 0;}
+    }
+
+    return true;
+}
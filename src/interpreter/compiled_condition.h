@@ -0,0 +1,72 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file compiled_condition.h
+* @author  xcervia00
+*
+* @brief Guard and timeout of a transition compiled for evaluation by a script engine (interface)
+*
+*/
+
+#ifndef COMPILED_CONDITION_H
+#define COMPILED_CONDITION_H
+
+#include <QString>
+#include <QJSEngine>
+#include <QJSValue>
+
+#include "guard_expression.h"
+
+/**
+ * @brief Guard and timeout compiled into callable functions of a single engine (and natively where possible)
+ * @note Compiled lazily by the first test and again whenever the engine changes. Not thread-safe; every engine
+ * (thread) needs its own copy.
+ */
+class CompiledCondition
+{
+    private:
+        QString m_guard; ///< Guard condition; can be empty
+        QString m_timeout; ///< Timeout expression; can be empty
+
+        QJSEngine *m_compiledFor = nullptr; ///< The engine the cached scripts were compiled by; nullptr if cache is invalid
+        QJSValue m_guardFunc; ///< Guard compiled into callable function; undefined if it has to be evaluated as a script
+        QJSValue m_timeoutFunc; ///< Timeout compiled into callable function; undefined if it has to be evaluated as a script
+        bool m_timeoutConst = true; ///< Flags whether the timeout is a plain number (no script evaluation needed)
+        int m_timeoutMs = 0; ///< The timeout value if m_timeoutConst is set
+
+        GuardExpression m_nativeGuard; ///< Guard compiled to native predicate; invalid if it needs the script engine
+
+        /**
+         * @brief Compiles guard and timeout into callable functions of given engine
+         * @param engine The engine to compile the scripts by
+         * @note Expressions that can't be wrapped into a function are left undefined and evaluated the old way
+         */
+        void compile(QJSEngine *engine);
+
+        /**
+         * @brief Evaluates the guard condition (natively if possible, otherwise by the engine)
+         * @param engine The engine to evaluate the script by
+         * @param variables Native access to variables; nullptr if the engine has to be used
+         * @return True if the guard passed
+         */
+        bool testGuard(QJSEngine *engine, const GuardVariableSource *variables);
+
+    public:
+        /**
+         * @brief Sets the scripts; drops everything compiled from the old ones
+         * @param guard The guard condition; can be empty
+         * @param timeout The timeout; can be empty
+         */
+        void setScripts(const QString &guard, const QString &timeout);
+
+        /**
+         * @brief Checks the guard and evaluates the timeout (once the input matched)
+         * @param engine The engine to evaluate the scripts by
+         * @param variables Native access to variables for the guard fast-path; nullptr if none
+         * @param timeoutMs The timeout to wait for before the transition is taken
+         * @return True if the guard passed
+         */
+        bool test(QJSEngine *engine, const GuardVariableSource *variables, int &timeoutMs);
+};
+
+#endif // COMPILED_CONDITION_H
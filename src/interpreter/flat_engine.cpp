@@ -0,0 +1,248 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file flat_engine.cpp
+* @author  xcervia00
+*
+* @brief Execution engine interpreting the FSM from a compiled flat transition table
+*
+*/
+
+#include "flat_engine.h"
+
+#include <QDebug>
+#include <QMetaObject>
+
+FlatEngine::FlatEngine(QJSEngine *engine, TimerWheel *timers, QObject *parent)
+    :
+    QObject{parent},
+    m_engine{engine},
+    m_timers{timers}
+{
+}
+
+/*
+============================
+        COMPILATION
+============================
+*/
+
+bool FlatEngine::compile(const QHash<QString, ActionState*> &states, ActionState *initial)
+{
+    this->clear();
+
+    if(!m_definition.compile(states, initial))
+        return false;
+
+    m_pending.fill(Pending(), m_definition.edgeCount());
+    m_epochs.fill(1, m_definition.stateCount());
+    return true;
+}
+
+void FlatEngine::clear()
+{
+    this->stop();
+
+    m_definition.clear();
+    m_pending.clear();
+    m_epochs.clear();
+}
+
+/*
+============================
+         LIFECYCLE
+============================
+*/
+
+void FlatEngine::start()
+{
+    if(m_running || m_definition.isEmpty())
+        return;
+
+    m_running = true;
+    this->enter(0);
+}
+
+void FlatEngine::stop()
+{
+    if(!m_running)
+        return;
+
+    m_running = false;
+
+    // Cancel all timeouts
+    for(const auto &pending : m_pending)
+    {
+        if(pending.timer != TimerWheel::INVALID_HANDLE)
+            m_timers->cancel(pending.timer);
+    }
+    m_pending.fill(Pending());
+
+    m_queue.clear();
+    m_queueHead = 0;
+    m_deferred.clear();
+    m_deferredHead = 0;
+    m_current = -1;
+}
+
+bool FlatEngine::isRunning() const
+{
+    return m_running;
+}
+
+/*
+============================
+          DISPATCH
+============================
+*/
+
+void FlatEngine::postInput(const QString &name)
+{
+    if(!m_running)
+        return;
+
+    // No transition reacts to this input at all
+    int input = m_definition.input(name);
+    if(input < 0)
+        return;
+
+    m_queue.append(input);
+    this->schedule();
+}
+
+void FlatEngine::schedule()
+{
+    if(m_scheduled)
+        return;
+
+    // Processed from the event loop, same as events posted to QStateMachine
+    m_scheduled = true;
+    QMetaObject::invokeMethod(this, "process", Qt::QueuedConnection);
+}
+
+void FlatEngine::process()
+{
+    m_scheduled = false;
+
+    // Interpretation may be stopped by any action/guard
+    while(m_running)
+    {
+        if(m_queueHead < m_queue.size())
+        {
+            this->dispatch(m_queue[m_queueHead++]);
+            continue;
+        }
+        m_queue.clear();
+        m_queueHead = 0;
+
+        if(m_deferredHead < m_deferred.size())
+        {
+            Armed armed = m_deferred[m_deferredHead++];
+            this->fire(armed);
+            continue;
+        }
+        m_deferred.clear();
+        m_deferredHead = 0;
+
+        break;
+    }
+}
+
+void FlatEngine::dispatch(int input)
+{
+    const FsmDefinition::Row row = m_definition.row(m_current, input);
+    for(quint32 i = row.begin; i < row.end && m_running; i++)
+    {
+        // Already waiting for timeout, wait for it instead
+        if(this->isArmed(i))
+            continue;
+
+        int timeoutMs;
+        if(m_definition.edge(i).transition->testCondition(m_engine, timeoutMs))
+            this->arm(i, timeoutMs);
+    }
+}
+
+bool FlatEngine::isArmed(quint32 edge) const
+{
+    const Pending &pending = m_pending[edge];
+    return pending.ticket != 0 && pending.epoch == m_epochs[m_definition.edge(edge).source];
+}
+
+void FlatEngine::arm(quint32 edge, int timeoutMs)
+{
+    Armed armed{edge, ++m_nextTicket};
+    if(armed.ticket == 0)
+        armed.ticket = ++m_nextTicket;
+
+    Pending &pending = m_pending[edge];
+    pending.ticket = armed.ticket;
+    pending.epoch = m_epochs[m_definition.edge(edge).source];
+
+    if(timeoutMs == 0)
+    {
+        m_deferred.append(armed);
+        this->schedule();
+        return;
+    }
+
+    int group = m_definition.state(m_definition.edge(edge).source)->getTimerGroup();
+    pending.timer = m_timers->schedule(timeoutMs, group, this, (static_cast<quint64>(armed.edge) << 32) | armed.ticket);
+}
+
+void FlatEngine::disarm(quint32 edge)
+{
+    Pending &pending = m_pending[edge];
+    if(pending.timer != TimerWheel::INVALID_HANDLE)
+        m_timers->cancel(pending.timer);
+
+    pending = Pending();
+}
+
+void FlatEngine::timerExpired(quint64 cookie)
+{
+    this->fire({static_cast<quint32>(cookie >> 32), static_cast<quint32>(cookie)});
+
+    // Inputs fired by the entry are processed right away
+    this->process();
+}
+
+void FlatEngine::fire(const Armed &armed)
+{
+    // Cancelled (or armed again) in the meantime
+    if(!m_running || !this->isArmed(armed.edge) || m_pending[armed.edge].ticket != armed.ticket)
+        return;
+
+    const FsmDefinition::Edge &edge = m_definition.edge(armed.edge);
+    this->disarm(armed.edge);
+
+    edge.transition->reportTaken();
+
+    // Don't reset timers on transition to itself; otherwise disarm all edges of the state at once
+    if(edge.source != edge.target)
+    {
+        if(++m_epochs[edge.source] == 0)
+            m_epochs[edge.source] = 1;
+        m_timers->cancelGroup(m_definition.state(edge.source)->getTimerGroup());
+    }
+
+    this->enter(edge.target);
+}
+
+void FlatEngine::enter(int state)
+{
+    m_current = state;
+
+    ActionState *entered = m_definition.state(state);
+    entered->enterState();
+
+    // Action may have stopped the interpretation
+    if(!m_running)
+        return;
+
+    emit stateEntered(entered->objectName());
+
+    // Upon entry, implicitly fire 'empty' input
+    m_queue.append(0);
+    this->schedule();
+}
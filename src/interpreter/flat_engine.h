@@ -0,0 +1,190 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file flat_engine.h
+* @author  xcervia00
+*
+* @brief Execution engine interpreting the FSM from a compiled flat transition table (interface)
+*
+*/
+
+#ifndef FLAT_ENGINE_H
+#define FLAT_ENGINE_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QJSEngine>
+
+#include "action_state.h"
+#include "combined_transition.h"
+#include "fsm_definition.h"
+#include "timer_wheel.h"
+
+/**
+ * @brief Engines that can interpret the FSM
+ */
+enum FsmEngineType : uint8_t
+{
+    ENGINE_STATE_MACHINE, ///< QStateMachine driven by posted events (default)
+    ENGINE_FLAT, ///< Compiled flat transition table (FlatEngine)
+};
+
+/**
+ * @brief Interprets the FSM without QStateMachine; states and transitions are compiled into CSR adjacency
+ * indexed by (state, input), so dispatching an input is an array lookup followed by the guard check.
+ * @note Semantics are the same as of ActionState/CombinedTransition: matching transitions whose guard passes
+ * are armed with their timeout and the first one to time out is taken; leaving the state cancels the others (in O(1)).
+ * The compiled table is an FsmDefinition; the engine only adds the runtime of a single run on top of it.
+ */
+class FlatEngine : public QObject, public TimerWheelClient
+{
+    Q_OBJECT
+
+    private:
+        /**
+         * @brief Armed transition waiting for its timeout
+         */
+        struct Pending
+        {
+            quint32 ticket = 0; ///< Identifies the arming; 0 if not armed
+            quint32 epoch = 0; ///< Epoch of the source state at arming (stale once the state is left)
+            TimerWheel::Handle timer = TimerWheel::INVALID_HANDLE; ///< Scheduled timeout
+        };
+
+        /**
+         * @brief Reference to an armed transition (in timers and in the zero-delay queue)
+         */
+        struct Armed
+        {
+            quint32 edge; ///< Index of the edge
+            quint32 ticket; ///< Ticket of the arming (stale if it differs)
+        };
+
+        QJSEngine *m_engine; ///< Engine the actions/guards are evaluated by
+        TimerWheel *m_timers; ///< Scheduler of the timeouts
+
+        FsmDefinition m_definition; ///< The compiled machine
+
+        QVector<Pending> m_pending; ///< Arming of each edge
+        QVector<quint32> m_epochs; ///< Epoch of each state; leaving the state disarms all its edges at once
+        quint32 m_nextTicket = 0; ///< Last ticket handed out
+
+        QVector<int> m_queue; ///< Inputs waiting for dispatch
+        int m_queueHead = 0; ///< First unprocessed input in m_queue
+        QVector<Armed> m_deferred; ///< Zero-delay timeouts; fired once the input queue is drained (no timer needed)
+        int m_deferredHead = 0; ///< First unprocessed entry of m_deferred
+
+        int m_current = -1; ///< Index of the active state
+        bool m_running = false; ///< Is the engine interpreting?
+        bool m_scheduled = false; ///< Is processing of the queues already scheduled?
+
+        /**
+         * @brief Checks whether an edge waits for its timeout
+         * @param edge Index of the edge
+         * @return True if armed
+         */
+        bool isArmed(quint32 edge) const;
+
+        /**
+         * @brief Schedules processing of the queues (once)
+         */
+        void schedule();
+
+        /**
+         * @brief Arms all matching transitions of the active state
+         * @param input Id of the input
+         */
+        void dispatch(int input);
+
+        /**
+         * @brief Starts timeout of an edge (zero-delay timeouts are queued instead of using timer)
+         * @param edge Index of the edge
+         * @param timeoutMs The timeout
+         */
+        void arm(quint32 edge, int timeoutMs);
+
+        /**
+         * @brief Cancels timeout of an edge
+         * @param edge Index of the edge
+         */
+        void disarm(quint32 edge);
+
+        /**
+         * @brief Takes the transition whose timeout elapsed
+         * @param armed The elapsed arming
+         */
+        void fire(const Armed &armed);
+
+        /**
+         * @brief Enters a state; executes its action and queues the implicit empty input
+         * @param state Index of the state
+         */
+        void enter(int state);
+
+    private slots:
+        /**
+         * @brief Processes queued inputs, then zero-delay timeouts, until both are empty
+         */
+        void process();
+
+    public:
+        /**
+         * @brief Constructor of the engine
+         * @param engine The engine to evaluate actions/guards by
+         * @param timers The scheduler of timeouts (timer groups of the states are used)
+         * @param parent The parent object
+         */
+        FlatEngine(QJSEngine *engine, TimerWheel *timers, QObject *parent = nullptr);
+
+        /**
+         * @brief Timeout of an armed transition
+         * @param cookie The edge and ticket of the arming
+         */
+        void timerExpired(quint64 cookie) override;
+
+        /**
+         * @brief Compiles the machine into the flat table
+         * @param states All states of the machine
+         * @param initial The initial state
+         * @return False if the initial state is not among the states
+         */
+        bool compile(const QHash<QString, ActionState*> &states, ActionState *initial);
+
+        /**
+         * @brief Drops the compiled table (the machine is about to be destroyed)
+         */
+        void clear();
+
+        /**
+         * @brief Enters the initial state and starts interpreting
+         */
+        void start();
+
+        /**
+         * @brief Stops interpreting; cancels all timeouts and queued inputs
+         */
+        void stop();
+
+        /**
+         * @brief Is the engine interpreting?
+         * @return True if running
+         */
+        bool isRunning() const;
+
+        /**
+         * @brief Queues an input for dispatch (inputs no transition reacts to are dropped right away)
+         * @param name Name of the input
+         */
+        void postInput(const QString &name);
+
+    signals:
+        /**
+         * @brief Emitted after a state was entered (and its action executed)
+         * @param name The name of the state
+         */
+        void stateEntered(const QString &name);
+};
+
+#endif // FLAT_ENGINE_H
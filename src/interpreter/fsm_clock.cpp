@@ -0,0 +1,109 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file fsm_clock.cpp
+* @author  xcervia00
+*
+* @brief Time sources of the interpretation
+*
+*/
+
+#include "fsm_clock.h"
+
+#include <cmath>
+
+bool FsmClock::skip(qint64 msecs)
+{
+    (void)msecs;
+    return false;
+}
+
+bool FsmClock::skipping() const
+{
+    return false;
+}
+
+FsmClock *FsmClock::system()
+{
+    static RealTimeClock clock;
+    return &clock;
+}
+
+/*
+============================
+          REAL TIME
+============================
+*/
+
+RealTimeClock::RealTimeClock(double speed)
+    :
+    m_speed{speed > 0 ? speed : 1.0}
+{
+    m_timer.start();
+}
+
+qint64 RealTimeClock::nsecsElapsed() const
+{
+    if(m_speed == 1.0)
+        return m_timer.nsecsElapsed();
+
+    return static_cast<qint64>(static_cast<double>(m_timer.nsecsElapsed()) * m_speed);
+}
+
+qint64 RealTimeClock::realDelay(qint64 msecs) const
+{
+    return static_cast<qint64>(std::ceil(static_cast<double>(msecs) / m_speed));
+}
+
+double RealTimeClock::speed() const
+{
+    return m_speed;
+}
+
+/*
+============================
+        SIMULATED TIME
+============================
+*/
+
+SimulatedClock::SimulatedClock(bool skipping)
+    :
+    m_skipping{skipping}
+{
+}
+
+qint64 SimulatedClock::nsecsElapsed() const
+{
+    return m_now;
+}
+
+qint64 SimulatedClock::realDelay(qint64 msecs) const
+{
+    // Zero delay passes at once; anything longer only by skipping once the event loop is idle
+    return m_skipping && msecs <= 0 ? 0 : -1;
+}
+
+bool SimulatedClock::skip(qint64 msecs)
+{
+    if(!m_skipping)
+        return false;
+
+    this->advance(msecs);
+    return true;
+}
+
+bool SimulatedClock::skipping() const
+{
+    return m_skipping;
+}
+
+void SimulatedClock::advance(qint64 msecs)
+{
+    if(msecs > 0)
+        m_now += msecs * 1000000;
+}
+
+void SimulatedClock::advanceTo(qint64 msecs)
+{
+    this->advance(msecs - this->elapsed());
+}
@@ -0,0 +1,125 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file fsm_clock.h
+* @author  xcervia00
+*
+* @brief Time sources of the interpretation (interface)
+*
+*/
+
+#ifndef FSM_CLOCK_H
+#define FSM_CLOCK_H
+
+#include <QElapsedTimer>
+
+/**
+ * @brief Monotonic time seen by the interpreted machine (timeouts, icp.elapsed(), trace)
+ */
+class FsmClock
+{
+    public:
+        virtual ~FsmClock() = default;
+
+        /**
+         * @brief Current time
+         * @return Nanoseconds since the clock was created
+         */
+        virtual qint64 nsecsElapsed() const = 0;
+
+        /**
+         * @brief Current time
+         * @return Milliseconds since the clock was created
+         */
+        inline qint64 elapsed() const {return this->nsecsElapsed() / 1000000;}
+
+        /**
+         * @brief How long to wait in the real time until given time passes on this clock
+         * @param msecs Milliseconds of this clock
+         * @return Milliseconds of the real time; -1 if the time never passes by itself
+         */
+        virtual qint64 realDelay(qint64 msecs) const = 0;
+
+        /**
+         * @brief Lets time pass instantly when nothing happens until then (discrete-event time)
+         * @param msecs Milliseconds to skip
+         * @return False if the clock cannot skip (it runs in the real time)
+         */
+        virtual bool skip(qint64 msecs);
+
+        /**
+         * @brief Does the clock skip idle time?
+         * @return True if skip() moves the time
+         */
+        virtual bool skipping() const;
+
+        /**
+         * @brief Shared real-time clock (the default)
+         * @return The clock
+         */
+        static FsmClock *system();
+};
+
+/**
+ * @brief Real time, optionally accelerated (timeouts take 1/speed of their length)
+ */
+class RealTimeClock : public FsmClock
+{
+    private:
+        QElapsedTimer m_timer; ///< Source of the real time
+        double m_speed; ///< Ratio of this clock to the real time
+
+    public:
+        /**
+         * @brief Starts the clock
+         * @param speed Ratio of this clock to the real time (2 = twice as fast)
+         */
+        explicit RealTimeClock(double speed = 1.0);
+
+        qint64 nsecsElapsed() const override;
+        qint64 realDelay(qint64 msecs) const override;
+
+        /**
+         * @brief Ratio of this clock to the real time
+         * @return The speed
+         */
+        double speed() const;
+};
+
+/**
+ * @brief Simulated time that is only moved forward by skipping (or by its owner)
+ * @note With skipping enabled the timer wheel jumps straight to the next timeout once the interpreter is idle,
+ * so runs take only as long as their computation. Otherwise the owner moves the time (see FsmModel::replayTrace).
+ */
+class SimulatedClock : public FsmClock
+{
+    private:
+        qint64 m_now = 0; ///< Current time (nanoseconds)
+        bool m_skipping; ///< Jump to the next timeout once idle?
+
+    public:
+        /**
+         * @brief Creates the clock at time zero
+         * @param skipping Let the timer wheel skip idle time?
+         */
+        explicit SimulatedClock(bool skipping = true);
+
+        qint64 nsecsElapsed() const override;
+        qint64 realDelay(qint64 msecs) const override;
+        bool skip(qint64 msecs) override;
+        bool skipping() const override;
+
+        /**
+         * @brief Moves the time forward
+         * @param msecs Milliseconds to add
+         */
+        void advance(qint64 msecs);
+
+        /**
+         * @brief Moves the time forward to given time
+         * @param msecs Milliseconds since the clock was created (earlier times are ignored)
+         */
+        void advanceTo(qint64 msecs);
+};
+
+#endif // FSM_CLOCK_H
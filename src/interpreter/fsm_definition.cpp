@@ -0,0 +1,115 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file fsm_definition.cpp
+* @author  xcervia00
+*
+* @brief Immutable compiled form of the FSM shared by everything that interprets it
+*
+*/
+
+#include "fsm_definition.h"
+
+#include <QDebug>
+
+#include <algorithm>
+
+bool FsmDefinition::compile(const QHash<QString, ActionState*> &states, ActionState *initial)
+{
+    this->clear();
+
+    if(initial == nullptr || states.value(initial->objectName()) != initial)
+        return false;
+
+    // Index the states; the initial state is always the first one
+    QHash<const QAbstractState*, int> stateIndex;
+    stateIndex.insert(initial, 0);
+    m_states.append(initial);
+
+    for(auto state : states)
+    {
+        if(state != initial)
+        {
+            stateIndex.insert(state, m_states.size());
+            m_states.append(state);
+        }
+    }
+
+    // Intern input names; the empty input (fired on every entry) is always id 0
+    m_inputs.insert(QString(), 0);
+    for(auto state : m_states)
+    {
+        for(auto transition : state->transitions())
+        {
+            auto name = static_cast<CombinedTransition*>(transition)->getName();
+            if(!m_inputs.contains(name))
+                m_inputs.insert(name, m_inputs.size());
+        }
+    }
+
+    // Transitions of every state stably sorted by input (keeps the order of transitions within each row)
+    m_stateEdges.append(0);
+    m_stateRows.append(0);
+    QVector<Edge> edges;
+    QVector<int> edgeInputs;
+
+    for(int i = 0; i < m_states.size(); i++)
+    {
+        edges.clear();
+        edgeInputs.clear();
+
+        for(auto abstractTransition : m_states[i]->transitions())
+        {
+            auto transition = static_cast<CombinedTransition*>(abstractTransition);
+            auto target = stateIndex.constFind(transition->targetState());
+            if(target == stateIndex.constEnd())
+                continue;
+
+            edges.append({static_cast<quint32>(i), static_cast<quint32>(target.value()), transition});
+            edgeInputs.append(m_inputs.value(transition->getName()));
+        }
+
+        QVector<int> order(edges.size());
+        for(int e = 0; e < order.size(); e++)
+            order[e] = e;
+        std::stable_sort(order.begin(), order.end(), [&edgeInputs](int a, int b) {return edgeInputs[a] < edgeInputs[b];});
+
+        for(int e : order)
+        {
+            // First edge of the state, or of another input ==> new row
+            quint32 position = static_cast<quint32>(m_edges.size());
+            if(m_rows.size() == m_stateRows.last() || m_rows.last().input != edgeInputs[e])
+                m_rows.append({edgeInputs[e], position, position});
+            m_rows.last().end++;
+
+            m_edges.append(edges[e]);
+            m_conditions.append({edges[e].transition->getGuard(), edges[e].transition->getTimeout()});
+        }
+
+        m_stateEdges.append(static_cast<quint32>(m_edges.size()));
+        m_stateRows.append(m_rows.size());
+    }
+
+    for(auto state : m_states)
+    {
+        m_names.append(state->objectName());
+        m_actions.append(state->getAction());
+    }
+
+    qInfo() << "Interpreter: Compiled " << m_states.size() << " states, " << m_edges.size() << " transitions and "
+            << m_inputs.size() << " inputs (" << m_rows.size() << " rows) into flat table";
+    return true;
+}
+
+void FsmDefinition::clear()
+{
+    m_states.clear();
+    m_names.clear();
+    m_actions.clear();
+    m_inputs.clear();
+    m_edges.clear();
+    m_conditions.clear();
+    m_stateEdges.clear();
+    m_rows.clear();
+    m_stateRows.clear();
+}
@@ -0,0 +1,213 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file fsm_definition.h
+* @author  xcervia00
+*
+* @brief Immutable compiled form of the FSM shared by everything that interprets it (interface)
+*
+*/
+
+#ifndef FSM_DEFINITION_H
+#define FSM_DEFINITION_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+
+#include <algorithm>
+
+#include "action_state.h"
+#include "combined_transition.h"
+
+/**
+ * @brief States and transitions of the FSM compiled into CSR adjacency: transitions of every state, split into rows
+ * by input (sorted, found by binary search)
+ * @note Size follows the number of transitions, not states times inputs. Holds no runtime data, so any number of runs can interpret the same definition. States and transitions
+ * stay owned by the model (FlatEngine reuses their compiled actions/guards). Names and scripts are copied, so runs
+ * with their own engine (even on other threads) need nothing else than the definition.
+ */
+class FsmDefinition
+{
+    public:
+        /**
+         * @brief Single compiled transition
+         */
+        struct Edge
+        {
+            quint32 source; ///< Index of the source state
+            quint32 target; ///< Index of the destination state
+            CombinedTransition *transition; ///< The transition (evaluates guard/timeout)
+        };
+
+        /**
+         * @brief Scripts of a compiled transition
+         */
+        struct Condition
+        {
+            QString guard; ///< Guard condition; can be empty
+            QString timeout; ///< Timeout; can be empty
+        };
+
+        /**
+         * @brief Transitions of a state reacting to one input
+         */
+        struct Row
+        {
+            int input; ///< Id of the input
+            quint32 begin; ///< Index of the first edge
+            quint32 end; ///< Index past the last edge
+        };
+
+    private:
+        QVector<ActionState*> m_states; ///< States by their index; the initial state is always 0
+        QVector<QString> m_names; ///< Names of the states
+        QVector<QString> m_actions; ///< Actions of the states
+        QHash<QString, int> m_inputs; ///< Input name to its id; id 0 is the empty input
+        QVector<Edge> m_edges; ///< Transitions ordered by (source, input)
+        QVector<Condition> m_conditions; ///< Scripts of the transitions (same order as m_edges)
+        QVector<quint32> m_stateEdges; ///< Edges of a state are m_edges[m_stateEdges[state] .. m_stateEdges[state + 1]]
+        QVector<Row> m_rows; ///< Rows of all states ordered by (state, input)
+        QVector<int> m_stateRows; ///< Rows of a state are m_rows[m_stateRows[state] .. m_stateRows[state + 1]]
+
+    public:
+        /**
+         * @brief Compiles the machine
+         * @param states All states of the machine
+         * @param initial The initial state
+         * @return False if the initial state is not among the states (the definition is left empty)
+         */
+        bool compile(const QHash<QString, ActionState*> &states, ActionState *initial);
+
+        /**
+         * @brief Drops the compiled machine
+         */
+        void clear();
+
+        /**
+         * @brief Was anything compiled?
+         * @return True if there are no states
+         */
+        inline bool isEmpty() const
+        {
+            return m_states.isEmpty();
+        }
+
+        /**
+         * @brief Number of states
+         * @return The count
+         */
+        inline int stateCount() const
+        {
+            return m_states.size();
+        }
+
+        /**
+         * @brief State by its index
+         * @param state Index of the state
+         * @return The state
+         */
+        inline ActionState *state(int state) const
+        {
+            return m_states[state];
+        }
+
+        /**
+         * @brief Name of a state
+         * @param state Index of the state
+         * @return The name
+         */
+        inline const QString &stateName(int state) const
+        {
+            return m_names[state];
+        }
+
+        /**
+         * @brief Action of a state (as it was when compiled)
+         * @param state Index of the state
+         * @return The script; empty if none
+         */
+        inline const QString &action(int state) const
+        {
+            return m_actions[state];
+        }
+
+        /**
+         * @brief Looks up id of an input
+         * @param name Name of the input
+         * @return The id; -1 if no transition reacts to the input
+         */
+        inline int input(const QString &name) const
+        {
+            return m_inputs.value(name, -1);
+        }
+
+        /**
+         * @brief Number of transitions
+         * @return The count
+         */
+        inline int edgeCount() const
+        {
+            return m_edges.size();
+        }
+
+        /**
+         * @brief Transition by its index
+         * @param edge Index of the edge
+         * @return The edge
+         */
+        inline const Edge &edge(quint32 edge) const
+        {
+            return m_edges[edge];
+        }
+
+        /**
+         * @brief Scripts of a transition (as they were when compiled)
+         * @param edge Index of the edge
+         * @return Guard and timeout
+         */
+        inline const Condition &condition(quint32 edge) const
+        {
+            return m_conditions[edge];
+        }
+
+        /**
+         * @brief Transitions of given state reacting to given input
+         * @param state Index of the state
+         * @param input Id of the input
+         * @return The row; empty (begin == end) if the state doesn't react to the input
+         */
+        inline Row row(int state, int input) const
+        {
+            auto first = m_rows.cbegin() + m_stateRows[state];
+            auto last = m_rows.cbegin() + m_stateRows[state + 1];
+            auto found = std::lower_bound(first, last, input, [](const Row &row, int id) {return row.input < id;});
+
+            if(found == last || found->input != input)
+                return {input, 0, 0};
+
+            return *found;
+        }
+
+        /**
+         * @brief First transition leaving given state (any input)
+         * @param state Index of the state
+         * @return Index of the edge
+         */
+        inline quint32 stateBegin(int state) const
+        {
+            return m_stateEdges[state];
+        }
+
+        /**
+         * @brief End of the transitions leaving given state (any input)
+         * @param state Index of the state
+         * @return Index past the last edge of the state
+         */
+        inline quint32 stateEnd(int state) const
+        {
+            return m_stateEdges[state + 1];
+        }
+};
+
+#endif // FSM_DEFINITION_H
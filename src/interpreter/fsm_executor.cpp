@@ -0,0 +1,457 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file fsm_executor.cpp
+* @author  xcervia00
+*
+* @brief Many instances of one FSM interpreted in parallel by work-stealing worker threads
+*
+*/
+
+#include "fsm_executor.h"
+#include "script_helper.h"
+
+#include <QDebug>
+#include <QMetaObject>
+#include <QElapsedTimer>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <QMutexLocker>
+
+/**
+ * @brief Entries a worker runs before returning to its event loop (so its timers are not starved)
+ */
+static const int WORKER_BATCH = 64;
+
+/*
+============================
+           WORKER
+============================
+*/
+
+FsmWorker::FsmWorker(FsmExecutor *executor, int index)
+    :
+    QObject{nullptr},
+    m_executor{executor},
+    m_index{index}
+{
+}
+
+void FsmWorker::initialize()
+{
+    // Engines are thread-affine ==> everything is created on the thread of the worker
+    m_engine = new QJSEngine(this);
+    m_helper = new ScriptHelper(nullptr, m_engine);
+    m_engine->globalObject().setProperty("icp", m_engine->newQObject(m_helper));
+
+    m_timers = new TimerWheel(this);
+    m_runtime = new FsmRuntime(m_engine, m_helper, m_timers, this, this);
+
+    // Delivered on the thread of the executor
+    connect(m_runtime, &FsmRuntime::outputEvent, m_executor, &FsmExecutor::outputEvent);
+    connect(m_runtime, &FsmRuntime::instanceError, m_executor, &FsmExecutor::instanceError);
+}
+
+void FsmWorker::bind()
+{
+    // Timeouts of the old instances would only be ignored
+    m_timers->clear();
+    m_runtime->bind(m_executor->m_definition);
+}
+
+void FsmWorker::wake()
+{
+    if(m_wakePending.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "run", Qt::QueuedConnection);
+}
+
+int FsmWorker::push(const QSharedPointer<FsmExecutorEntry> &entry)
+{
+    QMutexLocker locker(&m_queueLock);
+    m_queue.append(entry);
+    return m_queue.size();
+}
+
+QSharedPointer<FsmExecutorEntry> FsmWorker::pop()
+{
+    QMutexLocker locker(&m_queueLock);
+    return m_queue.isEmpty() ? QSharedPointer<FsmExecutorEntry>() : m_queue.takeLast();
+}
+
+QSharedPointer<FsmExecutorEntry> FsmWorker::steal()
+{
+    QMutexLocker locker(&m_queueLock);
+    return m_queue.isEmpty() ? QSharedPointer<FsmExecutorEntry>() : m_queue.takeFirst();
+}
+
+void FsmWorker::run()
+{
+    // Work pushed from now on wakes the worker again
+    m_wakePending.storeRelease(0);
+
+    QElapsedTimer busy;
+    busy.start();
+
+    int processed = 0;
+    while(processed < WORKER_BATCH)
+    {
+        QSharedPointer<FsmExecutorEntry> entry = this->pop();
+        if(entry.isNull())
+        {
+            entry = m_executor->steal(m_index);
+            if(entry.isNull())
+                break;
+
+            m_steals.fetchAndAddRelaxed(1);
+        }
+
+        this->process(*entry);
+        processed++;
+    }
+
+    m_runs.fetchAndAddRelaxed(processed);
+    m_busyNs.fetchAndAddRelaxed(busy.nsecsElapsed());
+
+    // Batch is full; continue once pending events (timers) were processed
+    if(processed == WORKER_BATCH)
+        this->wake();
+}
+
+void FsmWorker::process(FsmExecutorEntry &entry)
+{
+    QVector<FsmExecutorEntry::Message> mailbox;
+    FsmInstance &instance = entry.instance;
+
+    forever
+    {
+        {
+            QMutexLocker locker(&entry.lock);
+            if(entry.destroyed)
+            {
+                m_executor->m_pending.fetchAndAddRelaxed(-entry.mailbox.size());
+                entry.mailbox.clear();
+            }
+
+            if(entry.mailbox.isEmpty())
+            {
+                entry.queued = false;
+                return;
+            }
+
+            mailbox.swap(entry.mailbox);
+        }
+
+        // Inputs are queued and drained together, same as a single run
+        for(const auto &message : mailbox)
+        {
+            switch(message.kind)
+            {
+                case FsmExecutorEntry::Message::START:
+                    m_runtime->start(instance);
+                    break;
+                case FsmExecutorEntry::Message::INPUT:
+                    m_runtime->queueInput(instance, message.name, message.value);
+                    break;
+                case FsmExecutorEntry::Message::TIMEOUT:
+                    m_runtime->run(instance);
+                    m_runtime->timeout(instance, message.ticket);
+                    break;
+            }
+        }
+        m_runtime->run(instance);
+
+        m_events.fetchAndAddRelaxed(mailbox.size());
+        m_executor->m_pending.fetchAndAddRelaxed(-mailbox.size());
+        mailbox.clear();
+    }
+}
+
+void FsmWorker::timerExpired(quint64 cookie)
+{
+    int id = static_cast<int>(cookie >> 32);
+
+    // Instance may have migrated to another worker meanwhile ==> always through the mailbox
+    QSharedPointer<FsmExecutorEntry> entry = m_executor->find(id);
+    if(!entry.isNull())
+        m_executor->post(entry, {FsmExecutorEntry::Message::TIMEOUT, QString(), QString(), static_cast<quint32>(cookie)});
+}
+
+/*
+============================
+          EXECUTOR
+============================
+*/
+
+FsmExecutor::FsmExecutor(int workers, QObject *parent)
+    :
+    QObject{parent}
+{
+    if(workers <= 0)
+        workers = qMax(1, QThread::idealThreadCount());
+
+    for(int i = 0; i < workers; i++)
+    {
+        auto thread = new QThread(this);
+        auto worker = new FsmWorker(this, i);
+        worker->moveToThread(thread);
+
+        connect(thread, &QThread::started, worker, &FsmWorker::initialize);
+        connect(thread, &QThread::finished, worker, &QObject::deleteLater);
+
+        m_threads.append(thread);
+        m_workers.append(worker);
+        thread->start();
+    }
+
+    qInfo() << "Interpreter: Executor started " << workers << " workers";
+}
+
+FsmExecutor::~FsmExecutor()
+{
+    this->clear();
+
+    for(auto thread : m_threads)
+    {
+        thread->quit();
+        thread->wait();
+    }
+}
+
+/*
+============================
+         DEFINITION
+============================
+*/
+
+bool FsmExecutor::define(const QHash<QString, ActionState*> &states, ActionState *initial, const VariableRegistry &variables)
+{
+    this->clear();
+
+    QSharedPointer<FsmDefinition> definition{new FsmDefinition};
+    if(!definition->compile(states, initial))
+        return false;
+
+    m_definition = definition;
+    m_variables = variables;
+    this->bindWorkers();
+    return true;
+}
+
+void FsmExecutor::clear()
+{
+    {
+        QWriteLocker locker(&m_tableLock);
+
+        // Entries still in run queues are dropped by the workers
+        for(const auto &entry : m_entries)
+        {
+            if(!entry.isNull())
+            {
+                QMutexLocker entryLocker(&entry->lock);
+                entry->destroyed = true;
+            }
+        }
+
+        m_entries.clear();
+        m_free.clear();
+        m_count = 0;
+    }
+
+    if(m_definition.isNull())
+        return;
+
+    m_definition.clear();
+    m_variables.clear();
+    this->bindWorkers();
+}
+
+void FsmExecutor::bindWorkers()
+{
+    // Runs once the worker returns from the current batch, so no script of the old definition is running
+    for(auto worker : m_workers)
+        QMetaObject::invokeMethod(worker, "bind", Qt::BlockingQueuedConnection);
+}
+
+bool FsmExecutor::isDefined() const
+{
+    return !m_definition.isNull();
+}
+
+/*
+============================
+         INSTANCES
+============================
+*/
+
+int FsmExecutor::spawn()
+{
+    if(m_definition.isNull())
+        return -1;
+
+    QSharedPointer<FsmExecutorEntry> entry{new FsmExecutorEntry};
+    entry->instance.vars = m_variables;
+
+    int id;
+    {
+        QWriteLocker locker(&m_tableLock);
+        if(!m_free.isEmpty())
+        {
+            id = m_free.takeLast();
+            m_entries[id] = entry;
+        }
+        else
+        {
+            id = m_entries.size();
+            m_entries.append(entry);
+        }
+        m_count++;
+    }
+
+    entry->instance.id = id;
+    entry->home = id % m_workers.size();
+
+    this->post(entry, {FsmExecutorEntry::Message::START, QString(), QString(), 0});
+    return id;
+}
+
+void FsmExecutor::destroy(int id)
+{
+    QSharedPointer<FsmExecutorEntry> entry;
+    {
+        QWriteLocker locker(&m_tableLock);
+        if(id < 0 || id >= m_entries.size() || m_entries[id].isNull())
+            return;
+
+        entry.swap(m_entries[id]);
+        m_free.append(id);
+        m_count--;
+    }
+
+    // Freed by whoever drops the last reference (possibly a worker running it right now)
+    QMutexLocker locker(&entry->lock);
+    entry->destroyed = true;
+}
+
+QSharedPointer<FsmExecutorEntry> FsmExecutor::find(int id) const
+{
+    QReadLocker locker(&m_tableLock);
+    if(id < 0 || id >= m_entries.size())
+        return QSharedPointer<FsmExecutorEntry>();
+
+    return m_entries[id];
+}
+
+int FsmExecutor::count() const
+{
+    QReadLocker locker(&m_tableLock);
+    return m_count;
+}
+
+/*
+============================
+          DISPATCH
+============================
+*/
+
+void FsmExecutor::inputEvent(int id, const QString &name, const QString &value)
+{
+    QSharedPointer<FsmExecutorEntry> entry = this->find(id);
+    if(!entry.isNull())
+        this->post(entry, {FsmExecutorEntry::Message::INPUT, name, value, 0});
+}
+
+void FsmExecutor::post(const QSharedPointer<FsmExecutorEntry> &entry, const FsmExecutorEntry::Message &message)
+{
+    {
+        QMutexLocker locker(&entry->lock);
+        if(entry->destroyed)
+            return;
+
+        entry->mailbox.append(message);
+        m_pending.fetchAndAddRelaxed(1);
+
+        // Already in a run queue (or being run); the worker picks the message up
+        if(entry->queued)
+            return;
+
+        entry->queued = true;
+    }
+
+    FsmWorker *home = m_workers[entry->home];
+    int queued = home->push(entry);
+    home->wake();
+
+    if(queued > 1)
+        this->wakeThief(entry->home);
+}
+
+void FsmExecutor::wakeThief(int busy)
+{
+    if(m_workers.size() < 2)
+        return;
+
+    // Round-robin over the other workers; an idle one steals, a busy one steals once done with its own queue
+    int thief = static_cast<int>(static_cast<unsigned>(m_nextThief.fetchAndAddRelaxed(1)) % (m_workers.size() - 1));
+    if(thief >= busy)
+        thief++;
+
+    m_workers[thief]->wake();
+}
+
+QSharedPointer<FsmExecutorEntry> FsmExecutor::steal(int thief)
+{
+    for(int i = 1; i < m_workers.size(); i++)
+    {
+        FsmWorker *victim = m_workers[(thief + i) % m_workers.size()];
+        QSharedPointer<FsmExecutorEntry> entry = victim->steal();
+        if(!entry.isNull())
+        {
+            // More work left there ==> let another idle worker help
+            this->wakeThief(thief);
+            return entry;
+        }
+    }
+
+    return QSharedPointer<FsmExecutorEntry>();
+}
+
+int FsmExecutor::pendingEvents() const
+{
+    return m_pending.loadAcquire();
+}
+
+/*
+============================
+         STATISTICS
+============================
+*/
+
+int FsmExecutor::workerCount() const
+{
+    return m_workers.size();
+}
+
+FsmWorkerStats FsmExecutor::stats(int worker) const
+{
+    FsmWorkerStats stats;
+    if(worker < 0 || worker >= m_workers.size())
+        return stats;
+
+    const FsmWorker *source = m_workers[worker];
+    stats.events = source->m_events.loadAcquire();
+    stats.runs = source->m_runs.loadAcquire();
+    stats.steals = source->m_steals.loadAcquire();
+    stats.busyNs = source->m_busyNs.loadAcquire();
+    return stats;
+}
+
+void FsmExecutor::resetStats()
+{
+    for(auto worker : m_workers)
+    {
+        worker->m_events.storeRelease(0);
+        worker->m_runs.storeRelease(0);
+        worker->m_steals.storeRelease(0);
+        worker->m_busyNs.storeRelease(0);
+    }
+}
@@ -0,0 +1,328 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file fsm_executor.h
+* @author  xcervia00
+*
+* @brief Many instances of one FSM interpreted in parallel by work-stealing worker threads (interface)
+*
+*/
+
+#ifndef FSM_EXECUTOR_H
+#define FSM_EXECUTOR_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QList>
+#include <QHash>
+#include <QThread>
+#include <QMutex>
+#include <QReadWriteLock>
+#include <QAtomicInteger>
+#include <QSharedPointer>
+
+#include "fsm_runtime.h"
+
+class FsmExecutor;
+class ScriptHelper;
+
+/**
+ * @brief Per-worker throughput counters
+ */
+struct FsmWorkerStats
+{
+    quint64 events = 0; ///< Messages (inputs, timeouts, starts) processed
+    quint64 runs = 0; ///< Instances taken from a run queue and drained
+    quint64 steals = 0; ///< Instances taken from the run queue of another worker
+    qint64 busyNs = 0; ///< Time spent running instances
+};
+
+/**
+ * @brief Instance of the executor together with its mailbox
+ * @note Whoever sets queued pushes the entry to a run queue; until the mailbox is found empty again, only the worker
+ * that took the entry from a queue touches the instance.
+ */
+struct FsmExecutorEntry
+{
+    /**
+     * @brief Work for the instance posted from any thread
+     */
+    struct Message
+    {
+        /**
+         * @brief Kind of the work
+         */
+        enum Kind
+        {
+            START, ///< Enter the initial state
+            INPUT, ///< Set input variable and fire the input
+            TIMEOUT ///< Timer of an armed transition expired
+        };
+
+        Kind kind; ///< Kind of the work
+        QString name; ///< Name of the input (INPUT)
+        QString value; ///< Value of the input (INPUT)
+        quint32 ticket; ///< Ticket of the arming (TIMEOUT)
+    };
+
+    FsmInstance instance; ///< The instance (owned by the worker running it)
+    int home = 0; ///< Worker whose run queue the entry is pushed to
+
+    QMutex lock; ///< Guards the members below
+    QVector<Message> mailbox; ///< Work waiting for the instance
+    bool queued = false; ///< Is the entry in a run queue (or being run)?
+    bool destroyed = false; ///< Destroyed; remaining work is dropped
+};
+
+/**
+ * @brief Worker thread of the executor; owns its own engine, helper, wheel and runtime
+ * @note Lives on its own thread; everything except wake() and the run queue is used only from that thread.
+ */
+class FsmWorker : public QObject, public TimerWheelClient
+{
+    Q_OBJECT
+
+    friend class FsmExecutor; ///< Executor pushes to the run queue and reads the counters
+
+    private:
+        FsmExecutor *m_executor; ///< The executor the worker belongs to
+        int m_index; ///< Index of the worker in the executor
+
+        QJSEngine *m_engine = nullptr; ///< Engine of the worker (created on its thread)
+        ScriptHelper *m_helper = nullptr; ///< Object the scripts access variables through
+        TimerWheel *m_timers = nullptr; ///< Scheduler of the timeouts of instances run by this worker
+        FsmRuntime *m_runtime = nullptr; ///< Interprets the instances
+
+        QMutex m_queueLock; ///< Guards the run queue
+        QList<QSharedPointer<FsmExecutorEntry>> m_queue; ///< Run queue; the owner pops from the back, thieves from the front
+        QAtomicInt m_wakePending; ///< Is run() already scheduled?
+
+        QAtomicInteger<quint64> m_events; ///< See FsmWorkerStats
+        QAtomicInteger<quint64> m_runs; ///< See FsmWorkerStats
+        QAtomicInteger<quint64> m_steals; ///< See FsmWorkerStats
+        QAtomicInteger<qint64> m_busyNs; ///< See FsmWorkerStats
+
+        /**
+         * @brief Adds an entry to the run queue
+         * @param entry The entry
+         * @return Number of entries in the queue
+         */
+        int push(const QSharedPointer<FsmExecutorEntry> &entry);
+
+        /**
+         * @brief Takes the most recently pushed entry of the own queue
+         * @return The entry; nullptr if the queue is empty
+         */
+        QSharedPointer<FsmExecutorEntry> pop();
+
+        /**
+         * @brief Takes the oldest entry of the queue (called by other workers)
+         * @return The entry; nullptr if the queue is empty
+         */
+        QSharedPointer<FsmExecutorEntry> steal();
+
+        /**
+         * @brief Processes the mailbox of an entry until it is empty
+         * @param entry The entry
+         */
+        void process(FsmExecutorEntry &entry);
+
+    private slots:
+        /**
+         * @brief Creates the engine, helper, wheel and runtime on the thread of the worker
+         */
+        void initialize();
+
+        /**
+         * @brief Compiles the definition of the executor into the engine of the worker
+         */
+        void bind();
+
+        /**
+         * @brief Runs a batch of entries of the own queue, then steals from the others
+         */
+        void run();
+
+    public:
+        /**
+         * @brief Constructor of the worker
+         * @param executor The executor the worker belongs to
+         * @param index Index of the worker in the executor
+         */
+        FsmWorker(FsmExecutor *executor, int index);
+
+        /**
+         * @brief Schedules run() on the thread of the worker (once)
+         */
+        void wake();
+
+        /**
+         * @brief Timeout of an instance run by this worker; posted to the instance
+         * @param cookie The instance and ticket of the arming
+         */
+        void timerExpired(quint64 cookie) override;
+};
+
+/**
+ * @brief Interprets any number of instances of one machine on several threads
+ * @note Every worker owns its own QJSEngine and compiles the scripts of the definition into it (engines are
+ * thread-affine). Inputs and timeouts are posted to the mailbox of the instance; an instance with work is pushed to
+ * the run queue of its home worker, idle workers steal from the queues of the others. An instance is run by one worker
+ * at a time and may migrate between workers (its variables travel with it). Outputs and errors are delivered on the
+ * thread of the executor. Instances use the system clock.
+ */
+class FsmExecutor : public QObject
+{
+    Q_OBJECT
+
+    friend class FsmWorker; ///< Workers read the definition and look up instances
+
+    private:
+        QVector<QThread*> m_threads; ///< Threads of the workers
+        QVector<FsmWorker*> m_workers; ///< The workers
+
+        QSharedPointer<FsmDefinition> m_definition; ///< The shared machine; nullptr if none is defined
+        VariableRegistry m_variables; ///< Initial values of the variables of every instance
+
+        mutable QReadWriteLock m_tableLock; ///< Guards the instance table
+        QVector<QSharedPointer<FsmExecutorEntry>> m_entries; ///< Instances by their id; nullptr for free ids
+        QVector<int> m_free; ///< Ids available for reuse
+        int m_count = 0; ///< Number of existing instances
+
+        QAtomicInt m_pending; ///< Messages posted and not yet processed
+        QAtomicInt m_nextThief; ///< Worker to wake up next when a run queue grows
+
+        /**
+         * @brief Instance by its id
+         * @param id Id of the instance
+         * @return The entry; nullptr if there is none
+         */
+        QSharedPointer<FsmExecutorEntry> find(int id) const;
+
+        /**
+         * @brief Posts work to an instance; pushes it to its home run queue if it was idle
+         * @param entry The entry
+         * @param message The work
+         */
+        void post(const QSharedPointer<FsmExecutorEntry> &entry, const FsmExecutorEntry::Message &message);
+
+        /**
+         * @brief Wakes up a worker to steal from a queue that holds more than one entry
+         * @param busy Index of the worker whose queue has grown
+         */
+        void wakeThief(int busy);
+
+        /**
+         * @brief Takes an entry from the queue of any other worker
+         * @param thief Index of the stealing worker
+         * @return The entry; nullptr if all queues are empty
+         */
+        QSharedPointer<FsmExecutorEntry> steal(int thief);
+
+        /**
+         * @brief Compiles the current definition into the engines of all workers (waits for them)
+         */
+        void bindWorkers();
+
+    public:
+        /**
+         * @brief Constructor of the executor; starts the workers
+         * @param workers Number of worker threads; non-positive for QThread::idealThreadCount()
+         * @param parent The parent object
+         */
+        explicit FsmExecutor(int workers = 0, QObject *parent = nullptr);
+
+        /**
+         * @brief Destructor; destroys all instances and stops the workers
+         */
+        ~FsmExecutor();
+
+        /**
+         * @brief Compiles the machine every instance will run; destroys all existing instances
+         * @param states All states of the machine
+         * @param initial The initial state
+         * @param variables Initial values of the variables
+         * @return False if the initial state is not among the states
+         */
+        bool define(const QHash<QString, ActionState*> &states, ActionState *initial, const VariableRegistry &variables);
+
+        /**
+         * @brief Destroys all instances and drops the definition (the machine is about to change)
+         */
+        void clear();
+
+        /**
+         * @brief Was a machine defined?
+         * @return True if instances can be spawned
+         */
+        bool isDefined() const;
+
+        /**
+         * @brief Creates an instance; its initial state is entered by a worker
+         * @return Id of the instance; -1 if no machine is defined
+         */
+        int spawn();
+
+        /**
+         * @brief Destroys an instance (its id may be reused); work already posted to it is dropped
+         * @param id Id of the instance
+         */
+        void destroy(int id);
+
+        /**
+         * @brief Number of existing instances
+         * @return The count
+         */
+        int count() const;
+
+        /**
+         * @brief Posts value of an input variable to an instance and fires the input
+         * @param id Id of the instance
+         * @param name Name of the input
+         * @param value Value of the input
+         */
+        void inputEvent(int id, const QString &name, const QString &value);
+
+        /**
+         * @brief Number of posted messages not yet processed (armed timeouts are not counted)
+         * @return The count; 0 once all posted work is done
+         */
+        int pendingEvents() const;
+
+        /**
+         * @brief Number of worker threads
+         * @return The count
+         */
+        int workerCount() const;
+
+        /**
+         * @brief Throughput counters of a worker
+         * @param worker Index of the worker
+         * @return The counters
+         */
+        FsmWorkerStats stats(int worker) const;
+
+        /**
+         * @brief Resets throughput counters of all workers
+         */
+        void resetStats();
+
+    signals:
+        /**
+         * @brief Emitted when a script of an instance produced an output
+         * @param id Id of the instance
+         * @param name Name of the output variable
+         * @param value The value
+         */
+        void outputEvent(int id, const QString &name, const QString &value);
+
+        /**
+         * @brief Emitted when an instance was stopped by an error of its script
+         * @param id Id of the instance
+         * @param message Description of the error
+         */
+        void instanceError(int id, const QString &message);
+};
+
+#endif // FSM_EXECUTOR_H
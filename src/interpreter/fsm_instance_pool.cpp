@@ -0,0 +1,261 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file fsm_instance_pool.cpp
+* @author  xcervia00
+*
+* @brief Many concurrent instances of one FSM sharing a single definition, engine and compiled scripts
+*
+*/
+
+#include "fsm_instance_pool.h"
+
+#include <QMetaObject>
+
+FsmInstancePool::FsmInstancePool(QJSEngine *engine, ScriptHelper *helper, QObject *parent)
+    :
+    QObject{parent},
+    m_runtime{engine, helper, &m_timers, this}
+{
+    // Same thread ==> signals of the runtime are delivered directly
+    connect(&m_runtime, &FsmRuntime::stateEntered, this, &FsmInstancePool::stateEntered);
+    connect(&m_runtime, &FsmRuntime::outputEvent, this, &FsmInstancePool::outputEvent);
+    connect(&m_runtime, &FsmRuntime::instanceError, this, &FsmInstancePool::instanceError);
+}
+
+FsmInstancePool::~FsmInstancePool()
+{
+    this->clear();
+}
+
+/*
+============================
+         DEFINITION
+============================
+*/
+
+bool FsmInstancePool::define(const QHash<QString, ActionState*> &states, ActionState *initial, const VariableRegistry &variables)
+{
+    this->clear();
+
+    QSharedPointer<FsmDefinition> definition{new FsmDefinition};
+    if(!definition->compile(states, initial))
+        return false;
+
+    m_definition = definition;
+    m_runtime.bind(m_definition);
+
+    // Copied on write ==> instances share the values until they change them
+    m_variables = variables;
+    return true;
+}
+
+void FsmInstancePool::clear()
+{
+    // The definition is about to go away; scripts of instances must not be running
+    Q_ASSERT(m_running == 0);
+
+    for(int id = 0; id < m_instances.size(); id++)
+        this->destroy(id);
+
+    m_instances.clear();
+    m_free.clear();
+    m_ready.clear();
+    m_timers.clear();
+
+    m_runtime.bind(QSharedPointer<const FsmDefinition>());
+    m_definition.clear();
+    m_variables.clear();
+}
+
+void FsmInstancePool::setClock(FsmClock *clock)
+{
+    m_runtime.setClock(clock);
+    m_timers.setClock(m_runtime.clock());
+}
+
+FsmClock *FsmInstancePool::clock() const
+{
+    return m_runtime.clock();
+}
+
+bool FsmInstancePool::isDefined() const
+{
+    return !m_definition.isNull();
+}
+
+/*
+============================
+         INSTANCES
+============================
+*/
+
+int FsmInstancePool::spawn()
+{
+    if(m_definition.isNull())
+        return -1;
+
+    auto entry = new Entry;
+    entry->instance.vars = m_variables;
+
+    int id;
+    if(!m_free.isEmpty())
+    {
+        id = m_free.takeLast();
+        m_instances[id] = entry;
+    }
+    else
+    {
+        id = m_instances.size();
+        m_instances.append(entry);
+    }
+    entry->instance.id = id;
+    m_count++;
+
+    this->runFor(id, [this, entry]() { m_runtime.start(entry->instance); });
+
+    // Implicit empty input of the initial state (the instance may have been stopped or destroyed by now)
+    if(this->isRunning(id))
+        this->markReady(id);
+
+    return id;
+}
+
+void FsmInstancePool::destroy(int id)
+{
+    Entry *entry = this->find(id);
+    if(entry == nullptr)
+        return;
+
+    m_runtime.halt(entry->instance);
+    m_count--;
+
+    // Deleted once its scripts return
+    if(entry->busy > 0)
+    {
+        entry->destroyed = true;
+        return;
+    }
+
+    this->remove(id);
+}
+
+void FsmInstancePool::remove(int id)
+{
+    delete m_instances[id];
+    m_instances[id] = nullptr;
+    m_free.append(id);
+}
+
+FsmInstancePool::Entry *FsmInstancePool::find(int id) const
+{
+    if(id < 0 || id >= m_instances.size())
+        return nullptr;
+
+    Entry *entry = m_instances[id];
+    return entry != nullptr && !entry->destroyed ? entry : nullptr;
+}
+
+int FsmInstancePool::count() const
+{
+    return m_count;
+}
+
+bool FsmInstancePool::isRunning(int id) const
+{
+    Entry *entry = this->find(id);
+    return entry != nullptr && entry->instance.current >= 0;
+}
+
+QString FsmInstancePool::activeState(int id) const
+{
+    Entry *entry = this->find(id);
+    if(entry == nullptr || entry->instance.current < 0)
+        return QString();
+
+    return m_definition->stateName(entry->instance.current);
+}
+
+const VariableRegistry *FsmInstancePool::variables(int id) const
+{
+    Entry *entry = this->find(id);
+    return entry != nullptr ? &entry->instance.vars : nullptr;
+}
+
+template <typename Func>
+void FsmInstancePool::runFor(int id, Func &&code)
+{
+    Entry *entry = m_instances[id];
+
+    entry->busy++;
+    m_running++;
+
+    code();
+
+    m_running--;
+    if(--entry->busy == 0 && entry->destroyed)
+        this->remove(id);
+}
+
+/*
+============================
+          DISPATCH
+============================
+*/
+
+void FsmInstancePool::inputEvent(int id, const QString &name, const QString &value)
+{
+    Entry *entry = this->find(id);
+    if(entry == nullptr)
+        return;
+
+    if(m_runtime.queueInput(entry->instance, name, value))
+        this->markReady(id);
+}
+
+void FsmInstancePool::markReady(int id)
+{
+    Entry *entry = m_instances[id];
+    if(!entry->ready)
+    {
+        entry->ready = true;
+        m_ready.append(id);
+    }
+
+    if(m_scheduled)
+        return;
+
+    // Processed from the event loop, same as inputs of a single run
+    m_scheduled = true;
+    QMetaObject::invokeMethod(this, "process", Qt::QueuedConnection);
+}
+
+void FsmInstancePool::process()
+{
+    // Instances that become ready meanwhile are processed in the same pass
+    for(int i = 0; i < m_ready.size(); i++)
+    {
+        int id = m_ready[i];
+        Entry *entry = this->find(id);
+        if(entry == nullptr || !entry->ready)
+            continue;
+
+        entry->ready = false;
+        this->runFor(id, [this, entry]() { m_runtime.run(entry->instance); });
+    }
+
+    m_ready.clear();
+    m_scheduled = false;
+}
+
+void FsmInstancePool::timerExpired(quint64 cookie)
+{
+    int id = static_cast<int>(cookie >> 32);
+    quint32 ticket = static_cast<quint32>(cookie);
+
+    Entry *entry = this->find(id);
+    if(entry == nullptr)
+        return;
+
+    this->runFor(id, [this, entry, ticket]() { m_runtime.timeout(entry->instance, ticket); });
+}
@@ -0,0 +1,218 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file fsm_instance_pool.h
+* @author  xcervia00
+*
+* @brief Many concurrent instances of one FSM sharing a single definition, engine and compiled scripts (interface)
+*
+*/
+
+#ifndef FSM_INSTANCE_POOL_H
+#define FSM_INSTANCE_POOL_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QJSEngine>
+#include <QSharedPointer>
+
+#include "fsm_runtime.h"
+
+class ScriptHelper;
+
+/**
+ * @brief Interprets any number of instances of one machine the same way as FlatEngine does a single run
+ * @note The definition and the initial values of variables are taken once by define(); instances only hold their own
+ * runtime (active state, variables, armed timeouts, entry times). All instances share the engine and the actions/guards
+ * compiled by the runtime; scripts see the variables of the instance they run for (see ScriptHelper::setInstance).
+ * Timeouts of all instances are scheduled on a single wheel of the pool (stopping interpretation of the model
+ * doesn't affect them). Instances are not logged nor traced individually.
+ */
+class FsmInstancePool : public QObject, public TimerWheelClient
+{
+    Q_OBJECT
+
+    private:
+        /**
+         * @brief Instance together with its bookkeeping in the pool
+         */
+        struct Entry
+        {
+            FsmInstance instance; ///< The instance
+            bool ready = false; ///< Is the instance in the ready list of the pool?
+            int busy = 0; ///< Number of nested runs of the pool working with the instance
+            bool destroyed = false; ///< Destroyed while busy; deleted once the runs return
+        };
+
+        TimerWheel m_timers; ///< Scheduler of the timeouts of all instances
+        FsmRuntime m_runtime; ///< Interprets the instances
+
+        QSharedPointer<FsmDefinition> m_definition; ///< The shared machine; nullptr if none is defined
+        VariableRegistry m_variables; ///< Initial values of the variables of every instance
+
+        QVector<Entry*> m_instances; ///< Instances by their id; nullptr for free ids
+        QVector<int> m_free; ///< Ids available for reuse
+        int m_count = 0; ///< Number of existing instances
+
+        QVector<int> m_ready; ///< Instances with queued work
+        bool m_scheduled = false; ///< Is processing of the ready list already scheduled?
+        int m_running = 0; ///< Number of runs in progress (the definition can't change meanwhile)
+
+        /**
+         * @brief Instance by its id
+         * @param id Id of the instance
+         * @return The entry of the instance; nullptr if there is none
+         */
+        Entry *find(int id) const;
+
+        /**
+         * @brief Adds instance to the ready list and schedules processing (once)
+         * @param id Id of the instance
+         */
+        void markReady(int id);
+
+        /**
+         * @brief Runs code of the runtime for an instance; the instance can't be deleted meanwhile
+         * @param id Id of the instance
+         * @param code The code to run
+         */
+        template <typename Func>
+        void runFor(int id, Func &&code);
+
+        /**
+         * @brief Deletes an instance and frees its id
+         * @param id Id of the instance
+         */
+        void remove(int id);
+
+    private slots:
+        /**
+         * @brief Drains every instance of the ready list
+         */
+        void process();
+
+    public:
+        /**
+         * @brief Constructor of the pool
+         * @param engine The engine to evaluate actions/guards by
+         * @param helper Object the scripts access variables through (exposed to the engine as icp)
+         * @param parent The parent object
+         */
+        FsmInstancePool(QJSEngine *engine, ScriptHelper *helper, QObject *parent = nullptr);
+
+        /**
+         * @brief Destructor; destroys all instances
+         */
+        ~FsmInstancePool();
+
+        /**
+         * @brief Compiles the machine every instance will run; destroys all existing instances
+         * @param states All states of the machine
+         * @param initial The initial state
+         * @param variables Initial values of the variables
+         * @return False if the initial state is not among the states
+         */
+        bool define(const QHash<QString, ActionState*> &states, ActionState *initial, const VariableRegistry &variables);
+
+        /**
+         * @brief Destroys all instances and drops the definition (the machine is about to change)
+         */
+        void clear();
+
+        /**
+         * @brief Changes the time seen by the instances
+         * @param clock The clock (not owned); nullptr for FsmClock::system()
+         */
+        void setClock(FsmClock *clock);
+
+        /**
+         * @brief Time seen by the instances
+         * @return The clock
+         */
+        FsmClock *clock() const;
+
+        /**
+         * @brief Was a machine defined?
+         * @return True if instances can be spawned
+         */
+        bool isDefined() const;
+
+        /**
+         * @brief Creates an instance and enters its initial state
+         * @return Id of the instance; -1 if no machine is defined
+         */
+        int spawn();
+
+        /**
+         * @brief Destroys an instance (its id may be reused)
+         * @param id Id of the instance
+         */
+        void destroy(int id);
+
+        /**
+         * @brief Number of existing instances
+         * @return The count
+         */
+        int count() const;
+
+        /**
+         * @brief Is the instance interpreting?
+         * @param id Id of the instance
+         * @return False if stopped (by an error or icp.stop()) or if there is no such instance
+         */
+        bool isRunning(int id) const;
+
+        /**
+         * @brief Sets value of an input variable of an instance and fires the input
+         * @param id Id of the instance
+         * @param name Name of the input
+         * @param value Value of the input
+         */
+        void inputEvent(int id, const QString &name, const QString &value);
+
+        /**
+         * @brief Name of the active state of an instance
+         * @param id Id of the instance
+         * @return The name; empty if stopped
+         */
+        QString activeState(int id) const;
+
+        /**
+         * @brief Variables of an instance
+         * @param id Id of the instance
+         * @return The variables; nullptr if there is no such instance
+         */
+        const VariableRegistry *variables(int id) const;
+
+        /**
+         * @brief Timeout of an armed transition
+         * @param cookie The instance and ticket of the arming
+         */
+        void timerExpired(quint64 cookie) override;
+
+    signals:
+        /**
+         * @brief Emitted after an instance entered a state (and its action was executed)
+         * @param id Id of the instance
+         * @param name The name of the state
+         */
+        void stateEntered(int id, const QString &name);
+
+        /**
+         * @brief Emitted when a script of an instance produced an output
+         * @param id Id of the instance
+         * @param name Name of the output variable
+         * @param value The value
+         */
+        void outputEvent(int id, const QString &name, const QString &value);
+
+        /**
+         * @brief Emitted when an instance was stopped by an error of its script
+         * @param id Id of the instance
+         * @param message Description of the error
+         */
+        void instanceError(int id, const QString &message);
+};
+
+#endif // FSM_INSTANCE_POOL_H
@@ -0,0 +1,353 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file fsm_runtime.cpp
+* @author  xcervia00
+*
+* @brief Interpretation of FSM instances by a single script engine
+*
+*/
+
+#include "fsm_runtime.h"
+#include "script_helper.h"
+
+#include <QDebug>
+#include <QAtomicInteger>
+#include <QMetaObject>
+#include <QtGlobal>
+
+/**
+ * @brief Last ticket handed out; shared by all runtimes, so instances moving between them (and reused ids)
+ * never match stale timers
+ */
+static QAtomicInteger<quint32> s_lastTicket;
+
+FsmRuntime::FsmRuntime(QJSEngine *engine, ScriptHelper *helper, TimerWheel *timers, TimerWheelClient *client, QObject *parent)
+    :
+    QObject{parent},
+    m_engine{engine},
+    m_helper{helper},
+    m_timers{timers},
+    m_client{client}
+{
+}
+
+/*
+============================
+         DEFINITION
+============================
+*/
+
+void FsmRuntime::bind(const QSharedPointer<const FsmDefinition> &definition)
+{
+    // The definition is about to change; scripts of instances must not be running
+    Q_ASSERT(m_running == nullptr);
+
+    m_definition = definition;
+    m_actions.clear();
+    m_conditions.clear();
+
+    if(m_definition.isNull())
+        return;
+
+    // Same wrapping as ActionState; failed compilation is reported on every execution
+    m_actions.resize(m_definition->stateCount());
+    for(int i = 0; i < m_definition->stateCount(); i++)
+    {
+        const QString &action = m_definition->action(i);
+        if(!action.isEmpty())
+            m_actions[i] = m_engine->evaluate(QStringLiteral("(function(){ %1\n })").arg(action));
+    }
+
+    // Compiled into the engine by the first test
+    m_conditions.resize(m_definition->edgeCount());
+    for(int i = 0; i < m_definition->edgeCount(); i++)
+    {
+        const FsmDefinition::Condition &condition = m_definition->condition(i);
+        m_conditions[i].setScripts(condition.guard, condition.timeout);
+    }
+}
+
+const FsmDefinition *FsmRuntime::definition() const
+{
+    return m_definition.data();
+}
+
+void FsmRuntime::setClock(FsmClock *clock)
+{
+    m_clock = clock != nullptr ? clock : FsmClock::system();
+}
+
+FsmClock *FsmRuntime::clock() const
+{
+    return m_clock;
+}
+
+/*
+============================
+        ENTRY POINTS
+============================
+*/
+
+template <typename Func>
+void FsmRuntime::runFor(FsmInstance &instance, Func &&code)
+{
+    FsmInstance *previous = m_running;
+
+    m_running = &instance;
+    m_helper->setInstance(this, &instance);
+
+    code();
+
+    // Runs nest when a slot connected to a signal of one instance drives another one
+    m_running = previous;
+    m_helper->setInstance(previous != nullptr ? this : nullptr, previous);
+}
+
+void FsmRuntime::start(FsmInstance &instance)
+{
+    this->disarmAll(instance);
+    instance.tickets.fill(0, m_definition->edgeCount());
+    instance.timers.fill(FsmInstance::Scheduled(), m_definition->edgeCount());
+    instance.queue.clear();
+    instance.deferred.clear();
+    instance.current = -1;
+
+    this->runFor(instance, [this, &instance]() { this->enter(instance, 0); });
+}
+
+bool FsmRuntime::queueInput(FsmInstance &instance, const QString &name, const QString &value)
+{
+    if(instance.current < 0)
+        return false;
+
+    // Same as the model: undefined input variables are ignored
+    int slot = instance.vars.slot(VAR_SCOPE_INPUT, name);
+    if(slot < 0)
+        return false;
+
+    instance.vars.setString(VAR_SCOPE_INPUT, slot, value);
+
+    // No transition reacts to this input at all
+    int input = m_definition->input(name);
+    if(input < 0)
+        return false;
+
+    instance.queue.append(input);
+    return true;
+}
+
+void FsmRuntime::run(FsmInstance &instance)
+{
+    if(instance.current < 0)
+        return;
+
+    this->runFor(instance, [this, &instance]() { this->drain(instance); });
+}
+
+void FsmRuntime::timeout(FsmInstance &instance, quint32 ticket)
+{
+    if(instance.current < 0)
+        return;
+
+    // Only edges of the active state can be armed; anything else is a timeout disarmed meanwhile
+    int state = instance.current;
+    for(quint32 i = m_definition->stateBegin(state), end = m_definition->stateEnd(state); i < end; i++)
+    {
+        if(instance.tickets[i] != ticket)
+            continue;
+
+        // The timer is released by the wheel once expired
+        instance.timers[i] = FsmInstance::Scheduled();
+
+        // Inputs fired by the entry are processed right away
+        this->runFor(instance, [this, &instance, i, ticket]()
+        {
+            this->fire(instance, i, ticket);
+            this->drain(instance);
+        });
+        return;
+    }
+}
+
+void FsmRuntime::halt(FsmInstance &instance)
+{
+    this->disarmAll(instance);
+    instance.queue.clear();
+    instance.deferred.clear();
+    instance.current = -1;
+}
+
+/*
+============================
+          DISPATCH
+============================
+*/
+
+void FsmRuntime::drain(FsmInstance &instance)
+{
+    int queueHead = 0;
+    int deferredHead = 0;
+
+    // Interpretation may be stopped by any action/guard
+    while(instance.current >= 0)
+    {
+        if(queueHead < instance.queue.size())
+        {
+            this->dispatch(instance, instance.queue[queueHead++]);
+            continue;
+        }
+        instance.queue.clear();
+        queueHead = 0;
+
+        if(deferredHead < instance.deferred.size())
+        {
+            FsmInstance::Armed armed = instance.deferred[deferredHead++];
+            this->fire(instance, armed.edge, armed.ticket);
+            continue;
+        }
+        instance.deferred.clear();
+        deferredHead = 0;
+
+        break;
+    }
+}
+
+void FsmRuntime::dispatch(FsmInstance &instance, int input)
+{
+    int state = instance.current;
+
+    const FsmDefinition::Row row = m_definition->row(state, input);
+    for(quint32 i = row.begin; i < row.end && instance.current >= 0; i++)
+    {
+        // Already waiting for timeout, wait for it instead
+        if(instance.tickets[i] != 0)
+            continue;
+
+        // Guards see variables of this instance (see runFor)
+        int timeoutMs;
+        if(m_conditions[i].test(m_engine, m_helper, timeoutMs))
+            this->arm(instance, i, timeoutMs);
+    }
+}
+
+void FsmRuntime::arm(FsmInstance &instance, quint32 edge, int timeoutMs)
+{
+    quint32 ticket = ++s_lastTicket;
+    if(ticket == 0)
+        ticket = ++s_lastTicket;
+
+    instance.tickets[edge] = ticket;
+
+    if(timeoutMs == 0)
+    {
+        instance.deferred.append({edge, ticket});
+        return;
+    }
+
+    // Edge is found by the ticket among edges of the active state once the timer expires
+    instance.timers[edge].handle = m_timers->schedule(timeoutMs, -1, m_client, (static_cast<quint64>(instance.id) << 32) | ticket);
+    instance.timers[edge].owner = this;
+}
+
+void FsmRuntime::disarm(FsmInstance &instance, quint32 edge)
+{
+    instance.tickets[edge] = 0;
+
+    FsmInstance::Scheduled &scheduled = instance.timers[edge];
+    if(scheduled.handle == TimerWheel::INVALID_HANDLE)
+        return;
+
+    // Wheel belongs to the thread of its runtime
+    if(scheduled.owner == this)
+        m_timers->cancel(scheduled.handle);
+    else
+        QMetaObject::invokeMethod(scheduled.owner, "cancelTimer", Qt::QueuedConnection, Q_ARG(qulonglong, scheduled.handle));
+
+    scheduled = FsmInstance::Scheduled();
+}
+
+void FsmRuntime::disarmAll(FsmInstance &instance)
+{
+    for(int i = 0; i < instance.tickets.size(); i++)
+        this->disarm(instance, static_cast<quint32>(i));
+}
+
+void FsmRuntime::cancelTimer(quint64 handle)
+{
+    // Already expired (or cleared by bind) timers are ignored by the wheel
+    m_timers->cancel(handle);
+}
+
+void FsmRuntime::fire(FsmInstance &instance, quint32 edge, quint32 ticket)
+{
+    // Cancelled (or armed again) in the meantime
+    if(instance.current < 0 || instance.tickets[edge] != ticket)
+        return;
+
+    const FsmDefinition::Edge &taken = m_definition->edge(edge);
+    this->disarm(instance, edge);
+
+    // Don't reset timers on transition to itself
+    if(taken.source != taken.target)
+    {
+        for(quint32 i = m_definition->stateBegin(taken.source), end = m_definition->stateEnd(taken.source); i < end; i++)
+            this->disarm(instance, i);
+    }
+
+    this->enter(instance, static_cast<int>(taken.target));
+}
+
+void FsmRuntime::enter(FsmInstance &instance, int state)
+{
+    qint64 now = m_clock->elapsed();
+
+    // Same as ActionState::enterState, without touching the shared state
+    if(instance.current != state)
+        instance.timeVisited = now;
+    instance.timeSinceEntry = now;
+    instance.current = state;
+
+    QJSValue &action = m_actions[state];
+    if(!action.isUndefined())
+    {
+        auto result = action.isCallable() ? action.call() : action;
+
+        if(result.isError()){
+            qCritical() << "Intepreter: Error during execution of state action";
+        }
+    }
+
+    // Action may have stopped the instance
+    if(instance.current < 0)
+        return;
+
+    emit stateEntered(instance.id, m_definition->stateName(state));
+
+    // Upon entry, implicitly fire 'empty' input
+    instance.queue.append(0);
+}
+
+/*
+============================
+      SCRIPT CALLBACKS
+============================
+*/
+
+void FsmRuntime::reportOutput(const QString &name)
+{
+    emit outputEvent(m_running->id, name, m_running->vars.string(VAR_SCOPE_OUTPUT, name));
+}
+
+void FsmRuntime::reportError(const QString &message)
+{
+    int id = m_running->id;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    m_engine->throwError(message);
+#endif
+
+    qWarning() << "Interpreter: Instance " << id << " stopped: " << message;
+    this->halt(*m_running);
+    emit instanceError(id, message);
+}
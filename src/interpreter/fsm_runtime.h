@@ -0,0 +1,262 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file fsm_runtime.h
+* @author  xcervia00
+*
+* @brief Interpretation of FSM instances by a single script engine (interface)
+*
+*/
+
+#ifndef FSM_RUNTIME_H
+#define FSM_RUNTIME_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QJSEngine>
+#include <QJSValue>
+#include <QSharedPointer>
+
+#include "fsm_definition.h"
+#include "compiled_condition.h"
+#include "fsm_clock.h"
+#include "timer_wheel.h"
+#include "variable_registry.h"
+
+class ScriptHelper;
+class FsmRuntime;
+
+/**
+ * @brief Runtime record of a single instance; everything else is shared through the definition
+ */
+struct FsmInstance
+{
+    /**
+     * @brief Reference to an armed transition (in the zero-delay queue)
+     */
+    struct Armed
+    {
+        quint32 edge; ///< Index of the edge
+        quint32 ticket; ///< Ticket of the arming (stale if it differs)
+    };
+
+    /**
+     * @brief Timeout scheduled in the wheel of the runtime that armed the edge
+     */
+    struct Scheduled
+    {
+        TimerWheel::Handle handle = TimerWheel::INVALID_HANDLE; ///< Handle of the timer; invalid if none
+        FsmRuntime *owner = nullptr; ///< Runtime whose wheel holds the timer
+    };
+
+    int id = -1; ///< Id given by the owner (passed back in timer cookies and signals)
+    int current = -1; ///< Index of the active state; -1 if stopped
+    qint64 timeVisited = 0; ///< Time the active state was entered from another state (see FsmClock)
+    qint64 timeSinceEntry = 0; ///< Time of the last entry of the active state (see FsmClock)
+    VariableRegistry vars; ///< Values of the variables (shared with the definition until first written)
+    QVector<quint32> tickets; ///< Ticket of the arming of each edge of the definition; 0 if not armed
+    QVector<Scheduled> timers; ///< Scheduled timeout of each edge of the definition
+
+    QVector<int> queue; ///< Inputs waiting for dispatch
+    QVector<Armed> deferred; ///< Zero-delay timeouts; fired once the input queue is drained
+};
+
+/**
+ * @brief Interprets instances of one definition the same way as FlatEngine does a single run
+ * @note Scripts of the definition are compiled once into the engine of the runtime and shared by all instances;
+ * while they run, ScriptHelper is bound to the variables of the instance. The runtime, its engine, helper and
+ * wheel belong to one thread, instances can be run by any runtime of the same definition (one at a time).
+ * Timeouts are scheduled with cookie (instance id << 32 | ticket) and cancelled once disarmed; the cancel is posted
+ * to the runtime that scheduled them if the instance moved meanwhile. A timeout that expires before the cancel
+ * arrives doesn't match the ticket of its edge and is ignored.
+ */
+class FsmRuntime : public QObject
+{
+    Q_OBJECT
+
+    friend class ScriptHelper; ///< Scripts of an instance report outputs/errors through the runtime
+
+    private:
+        QJSEngine *m_engine; ///< Engine the actions/guards are evaluated by
+        ScriptHelper *m_helper; ///< Object scripts access variables through (exposed to the engine as icp)
+        TimerWheel *m_timers; ///< Scheduler of the timeouts
+        TimerWheelClient *m_client; ///< Receiver of the timeouts (owner of the instances)
+        FsmClock *m_clock = FsmClock::system(); ///< Time seen by the instances (not owned)
+
+        QSharedPointer<const FsmDefinition> m_definition; ///< The interpreted machine
+        QVector<QJSValue> m_actions; ///< Actions compiled into callable functions (by state); undefined if empty
+        QVector<CompiledCondition> m_conditions; ///< Guards and timeouts (by edge)
+
+        FsmInstance *m_running = nullptr; ///< Instance whose scripts are being executed
+
+        /**
+         * @brief Runs code with scripts bound to the variables of an instance
+         * @param instance The instance
+         * @param code The code to run
+         */
+        template <typename Func>
+        void runFor(FsmInstance &instance, Func &&code);
+
+        /**
+         * @brief Processes queued inputs, then zero-delay timeouts, until both are empty
+         * @param instance The instance
+         */
+        void drain(FsmInstance &instance);
+
+        /**
+         * @brief Arms all matching transitions of the active state
+         * @param instance The instance
+         * @param input Id of the input
+         */
+        void dispatch(FsmInstance &instance, int input);
+
+        /**
+         * @brief Starts timeout of an edge (zero-delay timeouts are deferred instead of using timer)
+         * @param instance The instance
+         * @param edge Index of the edge
+         * @param timeoutMs The timeout
+         */
+        void arm(FsmInstance &instance, quint32 edge, int timeoutMs);
+
+        /**
+         * @brief Disarms an edge; its scheduled timeout is cancelled
+         * @param instance The instance
+         * @param edge Index of the edge
+         */
+        void disarm(FsmInstance &instance, quint32 edge);
+
+        /**
+         * @brief Disarms all edges of an instance
+         * @param instance The instance
+         */
+        void disarmAll(FsmInstance &instance);
+
+        /**
+         * @brief Takes the transition whose timeout elapsed
+         * @param instance The instance
+         * @param edge Index of the edge
+         * @param ticket Ticket of the arming (stale if it differs)
+         */
+        void fire(FsmInstance &instance, quint32 edge, quint32 ticket);
+
+        /**
+         * @brief Enters a state; executes its action and queues the implicit empty input
+         * @param instance The instance
+         * @param state Index of the state
+         */
+        void enter(FsmInstance &instance, int state);
+
+        /**
+         * @brief Output variable was written by a script of the running instance
+         * @param name Name of the output variable
+         */
+        void reportOutput(const QString &name);
+
+        /**
+         * @brief Script of the running instance failed; stops the instance
+         * @param message Description of the error
+         */
+        void reportError(const QString &message);
+
+    private slots:
+        /**
+         * @brief Cancels a timeout scheduled by this runtime (posted by the runtime the instance moved to)
+         * @param handle Handle of the timer
+         */
+        void cancelTimer(quint64 handle);
+
+    public:
+        /**
+         * @brief Constructor of the runtime
+         * @param engine The engine to evaluate actions/guards by
+         * @param helper Object the scripts access variables through (exposed to the engine as icp)
+         * @param timers Scheduler of the timeouts
+         * @param client Receiver of the timeouts (passes them back by timeout())
+         * @param parent The parent object
+         */
+        FsmRuntime(QJSEngine *engine, ScriptHelper *helper, TimerWheel *timers, TimerWheelClient *client, QObject *parent = nullptr);
+
+        /**
+         * @brief Compiles scripts of the machine into the engine
+         * @param definition The machine; nullptr to drop it
+         */
+        void bind(const QSharedPointer<const FsmDefinition> &definition);
+
+        /**
+         * @brief The interpreted machine
+         * @return The definition; nullptr if none is bound
+         */
+        const FsmDefinition *definition() const;
+
+        /**
+         * @brief Changes the time seen by the instances (the wheel has to use the same clock)
+         * @param clock The clock (not owned); nullptr for FsmClock::system()
+         */
+        void setClock(FsmClock *clock);
+
+        /**
+         * @brief Time seen by the instances
+         * @return The clock
+         */
+        FsmClock *clock() const;
+
+        /**
+         * @brief Enters the initial state of a new instance (its id and variables must be set); run() follows
+         * @param instance The instance
+         */
+        void start(FsmInstance &instance);
+
+        /**
+         * @brief Sets value of an input variable and queues the input; run() follows
+         * @param instance The instance
+         * @param name Name of the input
+         * @param value Value of the input
+         * @return True if something has to be run (undefined variables and inputs no transition reacts to are dropped)
+         */
+        bool queueInput(FsmInstance &instance, const QString &name, const QString &value);
+
+        /**
+         * @brief Processes everything queued for an instance
+         * @param instance The instance
+         */
+        void run(FsmInstance &instance);
+
+        /**
+         * @brief Takes the transition whose timeout expired and processes what follows
+         * @param instance The instance (id from the cookie)
+         * @param ticket Ticket from the cookie
+         */
+        void timeout(FsmInstance &instance, quint32 ticket);
+
+        /**
+         * @brief Stops an instance (it keeps its variables, so it can be inspected)
+         * @param instance The instance
+         */
+        void halt(FsmInstance &instance);
+
+    signals:
+        /**
+         * @brief Emitted after an instance entered a state (and its action was executed)
+         * @param id Id of the instance
+         * @param name The name of the state
+         */
+        void stateEntered(int id, const QString &name);
+
+        /**
+         * @brief Emitted when a script of an instance produced an output
+         * @param id Id of the instance
+         * @param name Name of the output variable
+         * @param value The value
+         */
+        void outputEvent(int id, const QString &name, const QString &value);
+
+        /**
+         * @brief Emitted when an instance was stopped by an error of its script
+         * @param id Id of the instance
+         * @param message Description of the error
+         */
+        void instanceError(int id, const QString &message);
+};
+
+#endif // FSM_RUNTIME_H
@@ -0,0 +1,624 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file guard_expression.cpp
+* @author  xcervia00
+*
+* @brief Native evaluation of simple guard conditions (bypassing QJSEngine)
+*
+*/
+
+#include "guard_expression.h"
+
+#include <cmath>
+#include <limits>
+
+/*
+============================
+      JS VALUE SEMANTICS
+============================
+*/
+
+bool GuardValue::fromVariant(const QVariant &variant, GuardValue &out)
+{
+    switch(variant.type())
+    {
+        case QVariant::Bool:
+            out.type = BOOL;
+            out.boolean = variant.toBool();
+            return true;
+        case QVariant::Int:
+        case QVariant::UInt:
+        case QVariant::LongLong:
+        case QVariant::ULongLong:
+        case QVariant::Double:
+            out.type = NUMBER;
+            out.number = variant.toDouble();
+            return true;
+        case QVariant::String:
+            out.type = STRING;
+            out.string = variant.toString();
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief JS ToNumber conversion
+ * @param value The value to convert
+ * @return The number (NaN if not convertible)
+ */
+static double toNumber(const GuardValue &value)
+{
+    switch(value.type)
+    {
+        case GuardValue::BOOL:
+            return value.boolean ? 1 : 0;
+        case GuardValue::NUMBER:
+            return value.number;
+        case GuardValue::STRING: {
+            QString trimmed = value.string.trimmed();
+            if(trimmed.isEmpty())
+                return 0;
+
+            bool ok;
+            double number = trimmed.toDouble(&ok);
+            return ok ? number : std::numeric_limits<double>::quiet_NaN();
+        }
+        default:
+            return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+/**
+ * @brief JS ToBoolean conversion
+ * @param value The value to convert
+ * @return Truthiness of the value
+ */
+static bool toBoolean(const GuardValue &value)
+{
+    switch(value.type)
+    {
+        case GuardValue::BOOL:
+            return value.boolean;
+        case GuardValue::NUMBER:
+            return value.number != 0 && !std::isnan(value.number);
+        case GuardValue::STRING:
+            return !value.string.isEmpty();
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief JS strict equality (===)
+ */
+static bool strictEquals(const GuardValue &a, const GuardValue &b)
+{
+    if(a.type != b.type)
+        return false;
+
+    switch(a.type)
+    {
+        case GuardValue::BOOL:
+            return a.boolean == b.boolean;
+        case GuardValue::NUMBER:
+            return a.number == b.number;
+        case GuardValue::STRING:
+            return a.string == b.string;
+        default:
+            return true;
+    }
+}
+
+/**
+ * @brief JS abstract equality (==)
+ */
+static bool looseEquals(const GuardValue &a, const GuardValue &b)
+{
+    if(a.type == b.type)
+        return strictEquals(a, b);
+
+    // undefined equals only undefined (null is not supported)
+    if(a.type == GuardValue::UNDEFINED || b.type == GuardValue::UNDEFINED)
+        return false;
+
+    // Remaining combinations of bool/number/string are compared as numbers
+    return toNumber(a) == toNumber(b);
+}
+
+/**
+ * @brief JS abstract relational comparison (a < b)
+ * @param a Left operand
+ * @param b Right operand
+ * @param undefinedResult Set if the result is undefined (NaN involved)
+ * @return Result of a < b
+ */
+static bool lessThan(const GuardValue &a, const GuardValue &b, bool &undefinedResult)
+{
+    undefinedResult = false;
+
+    if(a.type == GuardValue::STRING && b.type == GuardValue::STRING)
+        return a.string < b.string;
+
+    double x = toNumber(a);
+    double y = toNumber(b);
+    if(std::isnan(x) || std::isnan(y))
+    {
+        undefinedResult = true;
+        return false;
+    }
+
+    return x < y;
+}
+
+/*
+============================
+           PARSER
+============================
+*/
+
+/**
+ * @brief Recursive descent parser of the supported guard subset
+ */
+class GuardParser
+{
+    private:
+        const QString &m_src; ///< Parsed text
+        int m_pos = 0; ///< Current position within the text
+        GuardExpression &m_expr; ///< Expression being built
+
+        void skipSpaces()
+        {
+            while(m_pos < m_src.size() && m_src.at(m_pos).isSpace())
+                m_pos++;
+        }
+
+        bool atEnd()
+        {
+            skipSpaces();
+            return m_pos >= m_src.size();
+        }
+
+        bool accept(const char *token)
+        {
+            skipSpaces();
+            int len = static_cast<int>(qstrlen(token));
+            if(m_src.midRef(m_pos, len) != QLatin1String(token))
+                return false;
+
+            m_pos += len;
+            return true;
+        }
+
+        int addNode(GuardExpression::Node &&node)
+        {
+            m_expr.m_nodes.append(node);
+            return m_expr.m_nodes.size() - 1;
+        }
+
+        int addBinary(GuardExpression::Op op, int lhs, int rhs)
+        {
+            if(lhs < 0 || rhs < 0)
+                return -1;
+
+            GuardExpression::Node node;
+            node.op = op;
+            node.lhs = lhs;
+            node.rhs = rhs;
+            return addNode(std::move(node));
+        }
+
+        bool parseIdentifier(QString &out)
+        {
+            skipSpaces();
+            int start = m_pos;
+            while(m_pos < m_src.size() && (m_src.at(m_pos).isLetterOrNumber() || m_src.at(m_pos) == '_'))
+                m_pos++;
+
+            out = m_src.mid(start, m_pos - start);
+            return !out.isEmpty();
+        }
+
+        bool parseString(QString &out)
+        {
+            skipSpaces();
+            if(m_pos >= m_src.size())
+                return false;
+
+            QChar quote = m_src.at(m_pos);
+            if(quote != '"' && quote != '\'')
+                return false;
+
+            int end = m_src.indexOf(quote, m_pos + 1);
+            if(end < 0)
+                return false;
+
+            out = m_src.mid(m_pos + 1, end - m_pos - 1);
+
+            // Escape sequences are left to the script engine
+            if(out.contains('\\'))
+                return false;
+
+            m_pos = end + 1;
+            return true;
+        }
+
+        bool parseNumber(double &out)
+        {
+            skipSpaces();
+            int start = m_pos;
+            while(m_pos < m_src.size() && (m_src.at(m_pos).isDigit() || m_src.at(m_pos) == '.'))
+                m_pos++;
+
+            // Exponent
+            if(m_pos < m_src.size() && m_pos > start && (m_src.at(m_pos) == 'e' || m_src.at(m_pos) == 'E'))
+            {
+                m_pos++;
+                if(m_pos < m_src.size() && (m_src.at(m_pos) == '+' || m_src.at(m_pos) == '-'))
+                    m_pos++;
+                while(m_pos < m_src.size() && m_src.at(m_pos).isDigit())
+                    m_pos++;
+            }
+
+            if(m_pos == start)
+                return false;
+
+            // Number directly followed by identifier (e.g. 0x10) is not supported
+            if(m_pos < m_src.size() && (m_src.at(m_pos).isLetter() || m_src.at(m_pos) == '_'))
+                return false;
+
+            bool ok;
+            out = m_src.midRef(start, m_pos - start).toDouble(&ok);
+            return ok;
+        }
+
+        int parseCall()
+        {
+            if(!accept("icp") || !accept("."))
+                return -1;
+
+            QString function;
+            if(!parseIdentifier(function))
+                return -1;
+
+            GuardExpression::Node node;
+            node.op = GuardExpression::VAR;
+
+            if(function == QLatin1String("get") || function == QLatin1String("getInternal"))
+                node.scope = GUARD_INTERNAL;
+            else if(function == QLatin1String("getInput"))
+                node.scope = GUARD_INPUT;
+            else if(function == QLatin1String("getOutput"))
+                node.scope = GUARD_OUTPUT;
+            else if(function == QLatin1String("valueof"))
+                node.scope = GUARD_ANY;
+            else if(function == QLatin1String("defined"))
+                node.op = GuardExpression::DEFINED;
+            else
+                return -1;
+
+            if(!accept("(") || !parseString(node.name) || !accept(")"))
+                return -1;
+
+            return addNode(std::move(node));
+        }
+
+        int parsePrimary()
+        {
+            skipSpaces();
+            if(m_pos >= m_src.size())
+                return -1;
+
+            QChar c = m_src.at(m_pos);
+
+            // Parentheses
+            if(c == '(')
+            {
+                m_pos++;
+                int inner = parseOr();
+                if(inner < 0 || !accept(")"))
+                    return -1;
+                return inner;
+            }
+
+            GuardExpression::Node node;
+            node.op = GuardExpression::CONST;
+
+            // String literal
+            if(c == '"' || c == '\'')
+            {
+                node.constant.type = GuardValue::STRING;
+                if(!parseString(node.constant.string))
+                    return -1;
+                return addNode(std::move(node));
+            }
+
+            // Number literal (optionally negative)
+            if(c.isDigit() || c == '.' || c == '-')
+            {
+                bool negative = false;
+                if(c == '-')
+                {
+                    m_pos++;
+                    negative = true;
+                }
+
+                node.constant.type = GuardValue::NUMBER;
+                if(!parseNumber(node.constant.number))
+                    return -1;
+                if(negative)
+                    node.constant.number = -node.constant.number;
+                return addNode(std::move(node));
+            }
+
+            // Boolean literals or icp.* call
+            int save = m_pos;
+            QString identifier;
+            if(!parseIdentifier(identifier))
+                return -1;
+
+            if(identifier == QLatin1String("true") || identifier == QLatin1String("false"))
+            {
+                node.constant.type = GuardValue::BOOL;
+                node.constant.boolean = identifier == QLatin1String("true");
+                return addNode(std::move(node));
+            }
+
+            m_pos = save;
+            return parseCall();
+        }
+
+        int parseUnary()
+        {
+            skipSpaces();
+            // '!' but not '!='
+            if(m_pos < m_src.size() && m_src.at(m_pos) == '!' && !(m_pos + 1 < m_src.size() && m_src.at(m_pos + 1) == '='))
+            {
+                m_pos++;
+                int operand = parseUnary();
+                if(operand < 0)
+                    return -1;
+
+                GuardExpression::Node node;
+                node.op = GuardExpression::NOT;
+                node.lhs = operand;
+                return addNode(std::move(node));
+            }
+
+            return parsePrimary();
+        }
+
+        int parseRelational()
+        {
+            int lhs = parseUnary();
+            while(lhs >= 0)
+            {
+                // Order matters - longer operators first
+                if(accept("<="))      lhs = addBinary(GuardExpression::LE, lhs, parseUnary());
+                else if(accept(">=")) lhs = addBinary(GuardExpression::GE, lhs, parseUnary());
+                else if(accept("<"))  lhs = addBinary(GuardExpression::LT, lhs, parseUnary());
+                else if(accept(">"))  lhs = addBinary(GuardExpression::GT, lhs, parseUnary());
+                else break;
+            }
+            return lhs;
+        }
+
+        int parseEquality()
+        {
+            int lhs = parseRelational();
+            while(lhs >= 0)
+            {
+                if(accept("==="))      lhs = addBinary(GuardExpression::STRICT_EQ, lhs, parseRelational());
+                else if(accept("!==")) lhs = addBinary(GuardExpression::STRICT_NE, lhs, parseRelational());
+                else if(accept("=="))  lhs = addBinary(GuardExpression::EQ, lhs, parseRelational());
+                else if(accept("!="))  lhs = addBinary(GuardExpression::NE, lhs, parseRelational());
+                else break;
+            }
+            return lhs;
+        }
+
+        int parseAnd()
+        {
+            int lhs = parseEquality();
+            while(lhs >= 0 && accept("&&"))
+                lhs = addBinary(GuardExpression::AND, lhs, parseEquality());
+            return lhs;
+        }
+
+        int parseOr()
+        {
+            int lhs = parseAnd();
+            while(lhs >= 0 && accept("||"))
+                lhs = addBinary(GuardExpression::OR, lhs, parseAnd());
+            return lhs;
+        }
+
+    public:
+        GuardParser(const QString &src, GuardExpression &expr) : m_src{src}, m_expr{expr} {}
+
+        /**
+         * @brief Parses the whole text
+         * @return Index of the root node or -1 on unsupported syntax
+         */
+        int parse()
+        {
+            int root = parseOr();
+
+            // Allow single trailing semicolon
+            accept(";");
+
+            return (root >= 0 && atEnd()) ? root : -1;
+        }
+};
+
+/*
+============================
+      GUARD EXPRESSION
+============================
+*/
+
+bool GuardExpression::compile(const QString &guard)
+{
+    this->clear();
+
+    if(guard.trimmed().isEmpty())
+        return false;
+
+    m_root = GuardParser(guard, *this).parse();
+    if(m_root < 0)
+        this->clear();
+
+    return this->isValid();
+}
+
+void GuardExpression::clear()
+{
+    m_nodes.clear();
+    m_root = -1;
+    m_boundTo = nullptr;
+    m_boundVersion = 0;
+}
+
+void GuardExpression::bind(const GuardVariableSource &vars)
+{
+    for(auto &node : m_nodes)
+    {
+        if(node.op != VAR && node.op != DEFINED)
+            continue;
+
+        for(int scope = GUARD_INTERNAL; scope < GUARD_ANY; scope++)
+        {
+            bool used = node.op == DEFINED || node.scope == GUARD_ANY || node.scope == scope;
+            node.bound[scope] = used ? vars.guardSlot(static_cast<GuardScope>(scope), node.name) : -1;
+        }
+    }
+
+    m_boundTo = &vars;
+    m_boundVersion = vars.guardLayoutVersion();
+}
+
+bool GuardExpression::isValid() const
+{
+    return m_root >= 0;
+}
+
+bool GuardExpression::evaluate(const GuardVariableSource &vars, bool &result)
+{
+    if(!this->isValid())
+        return false;
+
+    // Names are resolved only when variables were added/removed since the last evaluation
+    if(m_boundTo != &vars || m_boundVersion != vars.guardLayoutVersion())
+        this->bind(vars);
+
+    GuardValue value;
+    if(!evalNode(m_root, vars, value))
+        return false;
+
+    // Has to be bool and that is true (same as the script path)
+    result = value.type == GuardValue::BOOL && value.boolean;
+    return true;
+}
+
+bool GuardExpression::evalNode(int index, const GuardVariableSource &vars, GuardValue &out) const
+{
+    const Node &node = m_nodes.at(index);
+
+    switch(node.op)
+    {
+        case CONST:
+            out = node.constant;
+            return true;
+
+        case VAR:
+            // icp.valueof takes the first existing one (internal->input->output)
+            for(int scope = GUARD_INTERNAL; scope < GUARD_ANY; scope++)
+            {
+                if(node.bound[scope] >= 0)
+                    return vars.guardSlotValue(static_cast<GuardScope>(scope), node.bound[scope], out);
+            }
+            // Undefined variable ==> the script has to report the error
+            return false;
+
+        case DEFINED: {
+            // Internal variable is always defined, input/output only if not empty
+            bool defined = node.bound[GUARD_INTERNAL] >= 0;
+            for(int scope = GUARD_INPUT; !defined && scope < GUARD_ANY; scope++)
+            {
+                GuardValue value;
+                if(node.bound[scope] >= 0 && vars.guardSlotValue(static_cast<GuardScope>(scope), node.bound[scope], value))
+                    defined = value.type == GuardValue::STRING && !value.string.isEmpty();
+            }
+
+            out.type = GuardValue::BOOL;
+            out.boolean = defined;
+            return true;
+        }
+
+        case NOT: {
+            GuardValue operand;
+            if(!evalNode(node.lhs, vars, operand))
+                return false;
+            out.type = GuardValue::BOOL;
+            out.boolean = !toBoolean(operand);
+            return true;
+        }
+
+        // JS && and || return one of the operands, not a bool
+        case AND:
+            if(!evalNode(node.lhs, vars, out))
+                return false;
+            return toBoolean(out) ? evalNode(node.rhs, vars, out) : true;
+
+        case OR:
+            if(!evalNode(node.lhs, vars, out))
+                return false;
+            return toBoolean(out) ? true : evalNode(node.rhs, vars, out);
+
+        default:
+            break;
+    }
+
+    // Binary comparisons
+    GuardValue lhs;
+    GuardValue rhs;
+    if(!evalNode(node.lhs, vars, lhs) || !evalNode(node.rhs, vars, rhs))
+        return false;
+
+    bool undefinedResult;
+    out.type = GuardValue::BOOL;
+
+    switch(node.op)
+    {
+        case EQ:
+            out.boolean = looseEquals(lhs, rhs);
+            break;
+        case NE:
+            out.boolean = !looseEquals(lhs, rhs);
+            break;
+        case STRICT_EQ:
+            out.boolean = strictEquals(lhs, rhs);
+            break;
+        case STRICT_NE:
+            out.boolean = !strictEquals(lhs, rhs);
+            break;
+        case LT:
+            out.boolean = lessThan(lhs, rhs, undefinedResult);
+            break;
+        case GT:
+            out.boolean = lessThan(rhs, lhs, undefinedResult);
+            break;
+        case LE:
+            out.boolean = !lessThan(rhs, lhs, undefinedResult) && !undefinedResult;
+            break;
+        case GE:
+            out.boolean = !lessThan(lhs, rhs, undefinedResult) && !undefinedResult;
+            break;
+        default:
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,186 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file guard_expression.h
+* @author  xcervia00
+*
+* @brief Native evaluation of simple guard conditions (bypassing QJSEngine) - interface
+*
+*/
+
+#ifndef GUARD_EXPRESSION_H
+#define GUARD_EXPRESSION_H
+
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * @brief Which variables can a guard access (mirrors the icp.* accessors)
+ */
+enum GuardScope : uint8_t
+{
+    GUARD_INTERNAL, // icp.get, icp.getInternal
+    GUARD_INPUT, // icp.getInput
+    GUARD_OUTPUT, // icp.getOutput
+    GUARD_ANY, // icp.valueof (internal->input->output)
+};
+
+/**
+ * @brief Value of a guard (sub)expression; subset of JS values
+ */
+struct GuardValue
+{
+    /**
+     * @brief JS type of the value
+     */
+    enum Type : uint8_t
+    {
+        UNDEFINED,
+        BOOL,
+        NUMBER,
+        STRING,
+    };
+
+    Type type = UNDEFINED; ///< Type of the value
+    bool boolean = false; ///< Value if type is BOOL
+    double number = 0; ///< Value if type is NUMBER
+    QString string; ///< Value if type is STRING
+
+    /**
+     * @brief Converts QVariant (model representation) to the value the script would see
+     * @param variant The variant to convert
+     * @param out The converted value
+     * @return True on success, false if the type is not supported natively
+     */
+    static bool fromVariant(const QVariant &variant, GuardValue &out);
+};
+
+/**
+ * @brief Native access to model variables used by the guard fast-path
+ * @note Variables are addressed by slots that are bound once and rebound only when the layout version changes
+ */
+class GuardVariableSource
+{
+    public:
+        virtual ~GuardVariableSource() = default;
+
+        /**
+         * @brief Looks up slot of a variable
+         * @param scope Where to look for the variable (GUARD_INTERNAL, GUARD_INPUT or GUARD_OUTPUT)
+         * @param name The name of the variable
+         * @return The slot, or -1 if the variable doesn't exist
+         */
+        virtual int guardSlot(GuardScope scope, const QString &name) const = 0;
+
+        /**
+         * @brief Obtains value of a variable the same way icp.* accessors would
+         * @param scope Scope of the slot (GUARD_INTERNAL, GUARD_INPUT or GUARD_OUTPUT)
+         * @param slot The slot obtained by guardSlot
+         * @param out The value of the variable
+         * @return True on success, false if the value is not supported natively
+         */
+        virtual bool guardSlotValue(GuardScope scope, int slot, GuardValue &out) const = 0;
+
+        /**
+         * @brief Version of the slot layout; bound slots are valid as long as it doesn't change
+         * @return The version
+         */
+        virtual quint64 guardLayoutVersion() const = 0;
+};
+
+/**
+ * @brief Guard condition compiled into a native predicate tree
+ * @note Supported subset: icp.get/getInternal/getInput/getOutput/valueof/defined("NAME"),
+ * number/string/bool literals, comparisons (== != === !== < <= > >=), !, && and || and parentheses
+ */
+class GuardExpression
+{
+    private:
+        /**
+         * @brief Operation of a single node
+         */
+        enum Op : uint8_t
+        {
+            CONST,
+            VAR,
+            DEFINED,
+            NOT,
+            AND,
+            OR,
+            EQ,
+            NE,
+            STRICT_EQ,
+            STRICT_NE,
+            LT,
+            LE,
+            GT,
+            GE,
+        };
+
+        /**
+         * @brief Node of the predicate tree (children are indices into m_nodes)
+         */
+        struct Node
+        {
+            Op op = CONST; ///< Operation of the node
+            GuardScope scope = GUARD_ANY; ///< Scope of the variable (VAR)
+            int lhs = -1; ///< Left (or only) operand
+            int rhs = -1; ///< Right operand
+            GuardValue constant; ///< Literal value (CONST)
+            QString name; ///< Variable name (VAR, DEFINED)
+            int bound[GUARD_ANY] = {-1, -1, -1}; ///< Bound slot of the variable in each scope; -1 if not present
+        };
+
+        QVector<Node> m_nodes; ///< All nodes of the tree
+        int m_root = -1; ///< Root of the tree; -1 if the guard is not supported natively
+
+        const GuardVariableSource *m_boundTo = nullptr; ///< Source the slots were bound to
+        quint64 m_boundVersion = 0; ///< Layout version of the source at the time of binding
+
+        /**
+         * @brief Resolves variable names of all nodes to slots
+         * @param vars Source of variable values
+         */
+        void bind(const GuardVariableSource &vars);
+
+        /**
+         * @brief Evaluates a node
+         * @param index Index of the node
+         * @param vars Source of variable values
+         * @param out The value of the node
+         * @return False if the evaluation can't be done natively
+         */
+        bool evalNode(int index, const GuardVariableSource &vars, GuardValue &out) const;
+
+        friend class GuardParser;
+
+    public:
+        /**
+         * @brief Compiles given guard; on unsupported syntax the expression stays invalid
+         * @param guard The guard condition (JS code)
+         * @return True if the guard can be evaluated natively, otherwise false
+         */
+        bool compile(const QString &guard);
+
+        /**
+         * @brief Drops the compiled tree
+         */
+        void clear();
+
+        /**
+         * @brief Can the guard be evaluated natively?
+         * @return True if compiled successfully
+         */
+        bool isValid() const;
+
+        /**
+         * @brief Evaluates the guard
+         * @param vars Source of variable values
+         * @param result True if the guard passed (result is a bool that is true, same as the script path)
+         * @return False if the result could not be determined natively (fall back to the script engine)
+         */
+        bool evaluate(const GuardVariableSource &vars, bool &result);
+};
+
+#endif // GUARD_EXPRESSION_H
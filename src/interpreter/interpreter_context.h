@@ -0,0 +1,35 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file interpreter_context.h
+* @author  xcervia00
+*
+* @brief Services of the model shared by states and transitions during interpretation
+*
+*/
+
+#ifndef INTERPRETER_CONTEXT_H
+#define INTERPRETER_CONTEXT_H
+
+#include <QPointer>
+
+class ActionState;
+class GuardVariableSource;
+class TimerWheel;
+class TraceRecorder;
+class FsmClock;
+
+/**
+ * @brief Structure holding references to model services that states/transitions may use
+ * @note Owned by the model; any member may be nullptr
+ */
+struct InterpreterContext
+{
+    GuardVariableSource *variables = nullptr; ///< Native access to variables (guard fast-path)
+    TimerWheel *timers = nullptr; ///< Scheduler of transition timeouts
+    TraceRecorder *trace = nullptr; ///< Recorder of the interpretation run
+    FsmClock *clock = nullptr; ///< Time seen by the machine (timeouts, elapsed times, trace)
+    QPointer<ActionState> lastState; ///< Last visited state of the run; nullptr until one is entered
+};
+
+#endif // INTERPRETER_CONTEXT_H
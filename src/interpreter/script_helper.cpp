@@ -11,6 +11,7 @@
 
 #include "script_helper.h"
 #include "action_state.h"
+#include "fsm_runtime.h"
 #include "model.h"
 
 ScriptHelper::ScriptHelper(FsmModel *model, QObject *parent)
@@ -18,7 +19,113 @@ ScriptHelper::ScriptHelper(FsmModel *model, QObject *parent)
     QObject{parent},
     m_model{model}
 {
-    Q_ASSERT(m_model); // Not necessary, but just to be safe
+}
+
+// Guard scopes address the same slot spaces as the registry
+static_assert(static_cast<int>(GUARD_INTERNAL) == static_cast<int>(VAR_SCOPE_INTERNAL)
+              && static_cast<int>(GUARD_INPUT) == static_cast<int>(VAR_SCOPE_INPUT)
+              && static_cast<int>(GUARD_OUTPUT) == static_cast<int>(VAR_SCOPE_OUTPUT), "Guard and variable scopes differ");
+
+void ScriptHelper::setInstance(FsmRuntime *runtime, FsmInstance *instance)
+{
+    m_runtime = runtime;
+    m_instance = instance;
+}
+
+/*
+============================
+          BINDING
+============================
+*/
+
+VariableRegistry &ScriptHelper::vars() const
+{
+    return m_instance != nullptr ? m_instance->vars : m_model->vars;
+}
+
+void ScriptHelper::varUpdated(VariableScope scope, int slot)
+{
+    if(m_instance == nullptr)
+        m_model->notifyVarUpdate(scope, slot);
+}
+
+void ScriptHelper::fireOutput(const QString &name)
+{
+    if(m_instance != nullptr)
+        m_runtime->reportOutput(name);
+    else
+        m_model->outputEvent(name);
+}
+
+void ScriptHelper::fail(FsmErrorType errNum, const QString &errMsg)
+{
+    if(m_instance != nullptr)
+        m_runtime->reportError(errMsg);
+    else
+        m_model->interpretationError(errNum, errMsg);
+}
+
+/*
+============================
+        SLOT HELPERS
+============================
+*/
+
+bool ScriptHelper::checkSlot(VariableScope scope, int slot)
+{
+    if(!this->vars().isValid(scope, slot))
+    {
+        this->fail(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: Access to invalid variable slot: " + QString::number(slot));
+        return false;
+    }
+
+    return true;
+}
+
+QJSValue ScriptHelper::slotToScript(VariableScope scope, int slot)
+{
+    const VariableRegistry &vars = this->vars();
+
+    switch(vars.type(scope, slot))
+    {
+        case VAR_TYPE_INT:
+            return QJSValue(vars.intAt(scope, slot));
+        case VAR_TYPE_FLOAT:
+            return QJSValue(vars.floatAt(scope, slot));
+        case VAR_TYPE_BOOL:
+            return QJSValue(vars.boolAt(scope, slot));
+        case VAR_TYPE_STRING:
+            return QJSValue(vars.stringAt(scope, slot));
+        default:
+            return (m_instance != nullptr ? m_runtime->m_engine : &m_model->engine)->toScriptValue(vars.otherAt(scope, slot));
+    }
+}
+
+void ScriptHelper::scriptToSlot(int slot, const QJSValue &value)
+{
+    VariableRegistry &vars = this->vars();
+
+    if(value.isBool())
+        vars.setBool(VAR_SCOPE_INTERNAL, slot, value.toBool());
+    else if(value.isNumber())
+        vars.setNumber(VAR_SCOPE_INTERNAL, slot, value.toNumber());
+    else if(value.isString())
+        vars.setString(VAR_SCOPE_INTERNAL, slot, value.toString());
+    else
+        vars.setValueAt(VAR_SCOPE_INTERNAL, slot, value.toVariant());
+
+    this->varUpdated(VAR_SCOPE_INTERNAL, slot);
+}
+
+int ScriptHelper::lookupSlot(VariableScope scope, const QString &name)
+{
+    int slot = this->vars().slot(scope, name);
+    if(slot < 0)
+    {
+        this->fail(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: Access to undefined variable: " + name);
+    }
+
+    return slot;
 }
 
 /*
@@ -29,69 +136,70 @@ ScriptHelper::ScriptHelper(FsmModel *model, QObject *parent)
 
 QJSValue ScriptHelper::getInternal(const QString &name)
 {
-    if(!m_model->varsInternal.contains(name))
-    {
-        this->m_model->interpretationError(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: Access to undefined variable: " + name);
+    int slot = this->lookupSlot(VAR_SCOPE_INTERNAL, name);
+    if(slot < 0)
         return QJSValue(QJSValue::UndefinedValue);
-    }
-    
-    return m_model->engine.toScriptValue(m_model->varsInternal.value(name));
+
+    return this->slotToScript(VAR_SCOPE_INTERNAL, slot);
 }
 
 bool ScriptHelper::setInternal(const QString &name, const QVariant &value)
 {
-    if(!m_model->varsInternal.contains(name))
+    int slot = this->vars().slot(VAR_SCOPE_INTERNAL, name);
+    if(slot < 0)
     {
-        this->m_model->interpretationError(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: Attempt to set undefined internal variable: " + name);
+        this->fail(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: Attempt to set undefined internal variable: " + name);
         return false;
     }
-    m_model->updateVarInternal(name, value);
 
+    this->vars().setValueAt(VAR_SCOPE_INTERNAL, slot, value);
+    this->varUpdated(VAR_SCOPE_INTERNAL, slot);
     return true;
 }
 
 QJSValue ScriptHelper::getInput(const QString &name)
 {
-    if(!m_model->varsInput.contains(name))
-    {
-        this->m_model->interpretationError(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: Access to undefined variable: " + name);
+    int slot = this->lookupSlot(VAR_SCOPE_INPUT, name);
+    if(slot < 0)
         return QJSValue(QJSValue::UndefinedValue);
-    }
 
-    return m_model->engine.toScriptValue(m_model->varsInput.value(name));
+    return QJSValue(this->vars().stringAt(VAR_SCOPE_INPUT, slot));
 }
 
 bool ScriptHelper::setInput(const QString &name, const QString &value)
 {
-    if(!m_model->varsInput.contains(name))
+    int slot = this->vars().slot(VAR_SCOPE_INPUT, name);
+    if(slot < 0)
     {
-        this->m_model->interpretationError(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: Attempt to set undefined input: " + name);
+        this->fail(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: Attempt to set undefined input: " + name);
         return false;
     }
-    m_model->updateVarInput(name, value);
+
+    this->vars().setString(VAR_SCOPE_INPUT, slot, value);
+    this->varUpdated(VAR_SCOPE_INPUT, slot);
     return true;
 }
 
 QJSValue ScriptHelper::getOutput(const QString &name)
 {
-    if(!m_model->varsOutput.contains(name))
-    {
-        this->m_model->interpretationError(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: Access to undefined variable: " + name);
+    int slot = this->lookupSlot(VAR_SCOPE_OUTPUT, name);
+    if(slot < 0)
         return QJSValue(QJSValue::UndefinedValue);
-    }
 
-    return m_model->engine.toScriptValue(m_model->varsOutput.value(name));
+    return QJSValue(this->vars().stringAt(VAR_SCOPE_OUTPUT, slot));
 }
 
 bool ScriptHelper::setOutput(const QString &name, const QString &value)
 {
-    if(!m_model->varsOutput.contains(name))
+    int slot = this->vars().slot(VAR_SCOPE_OUTPUT, name);
+    if(slot < 0)
     {
-        this->m_model->interpretationError(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: Attempt to set undefined output: " + name);
+        this->fail(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: Attempt to set undefined output: " + name);
         return false;
     }
 
-    m_model->updateVarOutput(name, value);
+    this->vars().setString(VAR_SCOPE_OUTPUT, slot, value);
+    this->varUpdated(VAR_SCOPE_OUTPUT, slot);
     return true;
 }
 
@@ -104,19 +212,20 @@ bool ScriptHelper::setOutput(const QString &name, const QString &value)
 void ScriptHelper::output(const QString &name, const QJSValue &value)
 {
     if(this->setOutput(name, value.toString())){
-        m_model->outputEvent(name);
+        this->fireOutput(name);
     }
 }
 
 void ScriptHelper::set(const QString &name, const QJSValue &value)
 {
-    if(m_model->varsInternal.contains(name)){
-        this->setInternal(name, value.toVariant());
-    }
-    else{
-        this->m_model->interpretationError(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: set - Access to undefined variable: " + name);
+    int slot = this->vars().slot(VAR_SCOPE_INTERNAL, name);
+    if(slot < 0)
+    {
+        this->fail(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: set - Access to undefined variable: " + name);
         return;
     }
+
+    this->scriptToSlot(slot, value);
 }
 
 QJSValue ScriptHelper::get(const QString &name)
@@ -126,56 +235,127 @@ QJSValue ScriptHelper::get(const QString &name)
 
 QJSValue ScriptHelper::valueof(const QString &name)
 {
-    if(m_model->varsInternal.contains(name)){
-        return m_model->engine.toScriptValue(this->m_model->varsInternal.value(name));
+    const VariableRegistry &vars = this->vars();
+    int slot;
+
+    if((slot = vars.slot(VAR_SCOPE_INTERNAL, name)) >= 0){
+        return this->slotToScript(VAR_SCOPE_INTERNAL, slot);
     }
-    else if (m_model->varsInput.contains(name)){
-        return QJSValue(this->m_model->varsInput.value(name));
+    else if ((slot = vars.slot(VAR_SCOPE_INPUT, name)) >= 0){
+        return QJSValue(vars.stringAt(VAR_SCOPE_INPUT, slot));
     }
-    else if(m_model->varsOutput.contains(name))
+    else if((slot = vars.slot(VAR_SCOPE_OUTPUT, name)) >= 0)
     {
-        return QJSValue(this->m_model->varsOutput.value(name));
+        return QJSValue(vars.stringAt(VAR_SCOPE_OUTPUT, slot));
     }
     else{
-        this->m_model->interpretationError(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: valueof - Access to undefined variable: " + name);
+        this->fail(ERROR_INTERPRETATION_EVALUATION, "INTERPRETER: valueof - Access to undefined variable: " + name);
         return QJSValue(QJSValue::UndefinedValue);
     }
 }
 
 bool ScriptHelper::defined(const QString &name)
 {
+    const VariableRegistry &vars = this->vars();
+
     // Internal variable is considered to be always defined
-    if(m_model->varsInternal.contains(name)){
+    if(vars.contains(VAR_SCOPE_INTERNAL, name)){
         return true;
     }
 
-    // Check if input variable with he name is defined
-    auto it_in = m_model->varsInput.constFind(name);
-    if (it_in != m_model->varsInput.constEnd()) { 
-        if (!it_in.value().isEmpty()) {
-            return true;
-        }
+    // Input/output variable is defined if it has a value
+    int slot = vars.slot(VAR_SCOPE_INPUT, name);
+    if(slot >= 0 && !vars.stringAt(VAR_SCOPE_INPUT, slot).isEmpty()){
+        return true;
     }
 
-    // Check if output variable with he name is defined
-    auto it_out = m_model->varsOutput.constFind(name);
-    if (it_out != m_model->varsOutput.constEnd()) { 
-        if (!it_out.value().isEmpty()) {
-            return true;
-        }
+    slot = vars.slot(VAR_SCOPE_OUTPUT, name);
+    if(slot >= 0 && !vars.stringAt(VAR_SCOPE_OUTPUT, slot).isEmpty()){
+        return true;
     }
 
     return false;
 }
 
+/*
+============================
+     SLOT BASED ACCESS
+============================
+*/
+
+int ScriptHelper::slot(const QString &name)
+{
+    return this->lookupSlot(VAR_SCOPE_INTERNAL, name);
+}
+
+int ScriptHelper::inputSlot(const QString &name)
+{
+    return this->lookupSlot(VAR_SCOPE_INPUT, name);
+}
+
+int ScriptHelper::outputSlot(const QString &name)
+{
+    return this->lookupSlot(VAR_SCOPE_OUTPUT, name);
+}
+
+QJSValue ScriptHelper::getAt(int slot)
+{
+    if(!this->checkSlot(VAR_SCOPE_INTERNAL, slot))
+        return QJSValue(QJSValue::UndefinedValue);
+
+    return this->slotToScript(VAR_SCOPE_INTERNAL, slot);
+}
+
+void ScriptHelper::setAt(int slot, const QJSValue &value)
+{
+    if(!this->checkSlot(VAR_SCOPE_INTERNAL, slot))
+        return;
+
+    this->scriptToSlot(slot, value);
+}
+
+QJSValue ScriptHelper::getInputAt(int slot)
+{
+    if(!this->checkSlot(VAR_SCOPE_INPUT, slot))
+        return QJSValue(QJSValue::UndefinedValue);
+
+    return QJSValue(this->vars().stringAt(VAR_SCOPE_INPUT, slot));
+}
+
+QJSValue ScriptHelper::getOutputAt(int slot)
+{
+    if(!this->checkSlot(VAR_SCOPE_OUTPUT, slot))
+        return QJSValue(QJSValue::UndefinedValue);
+
+    return QJSValue(this->vars().stringAt(VAR_SCOPE_OUTPUT, slot));
+}
+
+void ScriptHelper::outputAt(int slot, const QJSValue &value)
+{
+    if(!this->checkSlot(VAR_SCOPE_OUTPUT, slot))
+        return;
+
+    this->vars().setString(VAR_SCOPE_OUTPUT, slot, value.toString());
+    this->varUpdated(VAR_SCOPE_OUTPUT, slot);
+    this->fireOutput(this->vars().name(VAR_SCOPE_OUTPUT, slot));
+}
+
 qint64 ScriptHelper::elapsed()
 {
-    return static_cast<ActionState*>(ActionState::getLastState())->getElapsed();
+    if(m_instance != nullptr)
+        return m_runtime->clock()->elapsed() - m_instance->timeVisited;
+
+    ActionState *last = m_model->context.lastState;
+    return last != nullptr ? last->getElapsed() : 0;
 }
 
 qint64 ScriptHelper::elapsedEntry()
 {
-    return static_cast<ActionState*>(ActionState::getLastState())->getElapsedSinceEntry();
+    if(m_instance != nullptr)
+        return m_runtime->clock()->elapsed() - m_instance->timeSinceEntry;
+
+    ActionState *last = m_model->context.lastState;
+    return last != nullptr ? last->getElapsedSinceEntry() : 0;
 }
 
 qint32 ScriptHelper::atoi(const QJSValue &value)
@@ -185,10 +365,59 @@ qint32 ScriptHelper::atoi(const QJSValue &value)
 
 void ScriptHelper::engine_error(const QJSValue &errNum, const QString &errMsg)
 {
-    this->m_model->interpretationError(static_cast<FsmErrorType>(errNum.toInt()), errMsg);
+    this->fail(static_cast<FsmErrorType>(errNum.toInt()), errMsg);
 }
 
 void ScriptHelper::stop()
 {
+    if(m_instance != nullptr)
+        return m_runtime->halt(*m_instance);
+
     return this->m_model->view->stopInterpretation();
 }
+
+/*
+============================
+    NATIVE GUARD ACCESS
+============================
+*/
+
+int ScriptHelper::guardSlot(GuardScope scope, const QString &name) const
+{
+    return this->vars().slot(static_cast<VariableScope>(scope), name);
+}
+
+bool ScriptHelper::guardSlotValue(GuardScope scope, int slot, GuardValue &out) const
+{
+    const VariableRegistry &vars = this->vars();
+    auto varScope = static_cast<VariableScope>(scope);
+
+    switch(vars.type(varScope, slot))
+    {
+        case VAR_TYPE_INT:
+            out.type = GuardValue::NUMBER;
+            out.number = vars.intAt(varScope, slot);
+            return true;
+        case VAR_TYPE_FLOAT:
+            out.type = GuardValue::NUMBER;
+            out.number = vars.floatAt(varScope, slot);
+            return true;
+        case VAR_TYPE_BOOL:
+            out.type = GuardValue::BOOL;
+            out.boolean = vars.boolAt(varScope, slot);
+            return true;
+        case VAR_TYPE_STRING:
+            out.type = GuardValue::STRING;
+            out.string = vars.stringAt(varScope, slot);
+            return true;
+        case VAR_TYPE_OTHER:
+            return GuardValue::fromVariant(vars.otherAt(varScope, slot), out);
+        default:
+            return false;
+    }
+}
+
+quint64 ScriptHelper::guardLayoutVersion() const
+{
+    return this->vars().layoutVersion();
+}
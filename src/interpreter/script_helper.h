@@ -17,26 +17,94 @@
 #include <QHash>
 #include <QJSEngine>
 
+#include "mvc_interface.h"
+#include "guard_expression.h"
+#include "variable_registry.h"
+
 // Forward declaration (avoid cyclical include)
 class FsmModel;
+class FsmRuntime;
+struct FsmInstance;
 
 /**
  * @brief Helper class working as interface between model and QJSEngine
+ * @note Also provides native variable access for the guard fast-path. While scripts of an FsmRuntime instance
+ * run, every access goes to the variables of that instance instead of the model. Helpers of runtimes with their
+ * own engine have no model at all (scripts always run for an instance).
  */
-class ScriptHelper : public QObject
+class ScriptHelper : public QObject, public GuardVariableSource
 {
     Q_OBJECT
 
     private:
         FsmModel* m_model;
+        FsmRuntime *m_runtime = nullptr; ///< Runtime of the instance the scripts run for; nullptr if they run for the model
+        FsmInstance *m_instance = nullptr; ///< Instance the scripts run for; nullptr if they run for the model
+
+        /**
+         * @brief Variables the scripts currently work with
+         * @return Variables of the running instance, otherwise of the model
+         */
+        VariableRegistry &vars() const;
+        /**
+         * @brief Propagates a change of variable written through its slot (only variables of the model are shown)
+         * @param scope The scope of the variable
+         * @param slot The slot of the variable
+         */
+        void varUpdated(VariableScope scope, int slot);
+        /**
+         * @brief Reports an output event
+         * @param name The name of the output variable
+         */
+        void fireOutput(const QString &name);
+        /**
+         * @brief Reports an error of the script; stops the model or the running instance
+         * @param errNum The error number
+         * @param errMsg The error message
+         */
+        void fail(FsmErrorType errNum, const QString &errMsg);
+
+        /**
+         * @brief Validates slot coming from a script
+         * @param scope The scope of the slot
+         * @param slot The slot
+         * @return True if valid, otherwise stops interpretation and returns false
+         */
+        bool checkSlot(VariableScope scope, int slot);
+        /**
+         * @brief Converts value of a slot directly to script value (no QVariant in between for typed slots)
+         * @param scope The scope of the slot
+         * @param slot The slot (must be valid)
+         * @return The script value
+         */
+        QJSValue slotToScript(VariableScope scope, int slot);
+        /**
+         * @brief Stores script value into internal variable slot (same typing as QJSValue::toVariant)
+         * @param slot The slot (must be valid)
+         * @param value The value to store
+         */
+        void scriptToSlot(int slot, const QJSValue &value);
+        /**
+         * @brief Looks up slot of a variable, reporting undefined variables
+         * @param scope The scope of the variable
+         * @param name The name of the variable
+         * @return The slot, -1 if undefined (interpretation is stopped)
+         */
+        int lookupSlot(VariableScope scope, const QString &name);
 
     public:
         /**
          * @brief Constructor for the script helper
-         * @param model The parent model that holds the interpreter
+         * @param model The parent model that holds the interpreter; nullptr if owned by an FsmRuntime with its own engine
          * @param parent The parent QObject (owner) - should be the QJSEngine
          */
         explicit ScriptHelper(FsmModel* model, QObject *parent = nullptr); 
+        /**
+         * @brief Binds scripts to the variables of an instance
+         * @param runtime The runtime interpreting the instance; nullptr to bind back to the model
+         * @param instance The instance; nullptr to bind back to the model
+         */
+        void setInstance(FsmRuntime *runtime, FsmInstance *instance);
         /**
          * @brief Interpreter's getter for internal variable
          * @param name Name of the variable to get
@@ -122,6 +190,63 @@ class ScriptHelper : public QObject
          * @return True if it is defined, otherwise false
          */
         Q_INVOKABLE bool defined(const QString &name);
+
+        /*
+        ============================
+             SLOT BASED ACCESS
+        ============================
+        */
+
+        /**
+         * @brief Slot of internal variable; slots stay valid during whole interpretation
+         * @param name The name of the internal variable
+         * @return The slot (-1 if undefined)
+         * @note Intended for hot code, e.g. var s = icp.slot("x"); icp.setAt(s, icp.getAt(s) + 1)
+         */
+        Q_INVOKABLE int slot(const QString &name);
+        /**
+         * @brief Slot of input variable
+         * @param name The name of the input variable
+         * @return The slot (-1 if undefined)
+         */
+        Q_INVOKABLE int inputSlot(const QString &name);
+        /**
+         * @brief Slot of output variable
+         * @param name The name of the output variable
+         * @return The slot (-1 if undefined)
+         */
+        Q_INVOKABLE int outputSlot(const QString &name);
+        /**
+         * @brief Value of internal variable by its slot
+         * @param slot The slot obtained by icp.slot
+         * @return Value of the variable
+         */
+        Q_INVOKABLE QJSValue getAt(int slot);
+        /**
+         * @brief Sets internal variable by its slot
+         * @param slot The slot obtained by icp.slot
+         * @param value The value to set the variable to
+         */
+        Q_INVOKABLE void setAt(int slot, const QJSValue &value);
+        /**
+         * @brief Value of input variable by its slot
+         * @param slot The slot obtained by icp.inputSlot
+         * @return Value of the variable
+         */
+        Q_INVOKABLE QJSValue getInputAt(int slot);
+        /**
+         * @brief Value of output variable by its slot
+         * @param slot The slot obtained by icp.outputSlot
+         * @return Value of the variable
+         */
+        Q_INVOKABLE QJSValue getOutputAt(int slot);
+        /**
+         * @brief Sets output variable by its slot and fires output event
+         * @param slot The slot obtained by icp.outputSlot
+         * @param value The value to set the output variable to
+         */
+        Q_INVOKABLE void outputAt(int slot, const QJSValue &value);
+
         /**
          * @brief Returns the time since last entering the current state (only when a state was changed to another)
          * @return Time in milliseconds
@@ -149,6 +274,16 @@ class ScriptHelper : public QObject
          * @brief Explicitly stops interpretation
          */
         Q_INVOKABLE void stop();
+
+        /*
+        ============================
+            NATIVE GUARD ACCESS
+        ============================
+        */
+
+        int guardSlot(GuardScope scope, const QString &name) const override;
+        bool guardSlotValue(GuardScope scope, int slot, GuardValue &out) const override;
+        quint64 guardLayoutVersion() const override;
 };
 
 #endif
\ No newline at end of file
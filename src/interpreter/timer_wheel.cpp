@@ -0,0 +1,440 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file timer_wheel.cpp
+* @author  xcervia00
+*
+* @brief Hierarchical timer wheel scheduling timeouts of transitions
+*
+*/
+
+#include "timer_wheel.h"
+
+#include <QAbstractEventDispatcher>
+
+#include <algorithm>
+
+TimerWheel::TimerWheel(QObject *parent)
+    :
+    QObject{parent},
+    m_clock{FsmClock::system()}
+{
+    std::fill(std::begin(m_heads), std::end(m_heads), -1);
+    std::fill(std::begin(m_tails), std::end(m_tails), -1);
+
+    m_clockOrigin = m_clock->elapsed();
+
+    m_driver.setSingleShot(true);
+    m_driver.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&m_driver, &QTimer::timeout, this, &TimerWheel::run);
+}
+
+/*
+============================
+           NODES
+============================
+*/
+
+quint64 TimerWheel::currentTick() const
+{
+    return m_tickOrigin + static_cast<quint64>(m_clock->elapsed() - m_clockOrigin);
+}
+
+int TimerWheel::allocate()
+{
+    if(m_freeList < 0)
+    {
+        m_nodes.append(Node());
+        return m_nodes.size() - 1;
+    }
+
+    int node = m_freeList;
+    m_freeList = m_nodes[node].next;
+    return node;
+}
+
+void TimerWheel::release(int node)
+{
+    Node &n = m_nodes[node];
+
+    // Generation 0 would make INVALID_HANDLE valid
+    if(++n.generation == 0)
+        n.generation = 1;
+
+    n.client = nullptr;
+    n.slot = -1;
+    n.prev = -1;
+    n.next = m_freeList;
+    m_freeList = node;
+}
+
+void TimerWheel::link(int node, int slot)
+{
+    Node &n = m_nodes[node];
+    n.slot = slot;
+    n.next = -1;
+    n.prev = m_tails[slot];
+
+    if(n.prev < 0)
+        m_heads[slot] = node;
+    else
+        m_nodes[n.prev].next = node;
+
+    m_tails[slot] = node;
+    m_occupied[slot / SLOTS] |= quint64(1) << (slot % SLOTS);
+}
+
+void TimerWheel::unlink(int node)
+{
+    Node &n = m_nodes[node];
+    int slot = n.slot;
+
+    if(n.prev < 0)
+        m_heads[slot] = n.next;
+    else
+        m_nodes[n.prev].next = n.next;
+
+    if(n.next < 0)
+        m_tails[slot] = n.prev;
+    else
+        m_nodes[n.next].prev = n.prev;
+
+    if(m_heads[slot] < 0)
+        m_occupied[slot / SLOTS] &= ~(quint64(1) << (slot % SLOTS));
+
+    n.slot = -1;
+    n.prev = -1;
+    n.next = -1;
+}
+
+void TimerWheel::place(int node)
+{
+    quint64 due = m_nodes[node].due;
+
+    // The lowest wheel whose slots still reach the due tick
+    int level = 0;
+    while(level < LEVELS - 1 && (due >> (level * SLOT_BITS)) - (m_now >> (level * SLOT_BITS)) >= static_cast<quint64>(SLOTS))
+        level++;
+
+    // Beyond the last wheel ==> park in its furthest slot, it will be cascaded again
+    int shift = level * SLOT_BITS;
+    if((due >> shift) - (m_now >> shift) >= static_cast<quint64>(SLOTS))
+        due = ((m_now >> shift) + SLOTS - 1) << shift;
+
+    this->link(node, level * SLOTS + static_cast<int>((due >> shift) & (SLOTS - 1)));
+}
+
+/*
+============================
+          ADVANCING
+============================
+*/
+
+quint64 TimerWheel::nextTick() const
+{
+    quint64 best = NEVER;
+
+    for(int level = 0; level < LEVELS; level++)
+    {
+        if(m_occupied[level] == 0)
+            continue;
+
+        // Slots of a wheel are processed when the ticks reach the beginning of their block
+        int shift = level * SLOT_BITS;
+        quint64 block = m_now >> shift;
+
+        for(quint64 k = 1; k < static_cast<quint64>(SLOTS); k++)
+        {
+            if(m_occupied[level] & (quint64(1) << ((block + k) & (SLOTS - 1))))
+            {
+                best = std::min(best, (block + k) << shift);
+                break;
+            }
+        }
+    }
+
+    return best;
+}
+
+void TimerWheel::advance(quint64 target, QVector<Expired> &batch)
+{
+    while(true)
+    {
+        quint64 next = this->nextTick();
+        if(next > target)
+            break;
+
+        m_now = next;
+
+        // Cascade timers of the higher wheels whose block begins now (from the top, so they can fall through)
+        for(int level = LEVELS - 1; level > 0; level--)
+        {
+            int shift = level * SLOT_BITS;
+            if((m_now & ((quint64(1) << shift) - 1)) != 0)
+                continue;
+
+            int slot = level * SLOTS + static_cast<int>((m_now >> shift) & (SLOTS - 1));
+            int node = m_heads[slot];
+            while(node >= 0)
+            {
+                int following = m_nodes[node].next;
+                this->unlink(node);
+                this->place(node);
+                node = following;
+            }
+        }
+
+        // Everything in the current slot of the lowest wheel is due
+        int slot = static_cast<int>(m_now & (SLOTS - 1));
+        int node = m_heads[slot];
+        while(node >= 0)
+        {
+            int following = m_nodes[node].next;
+            this->unlink(node);
+            batch.append({node, m_nodes[node].generation});
+            node = following;
+        }
+    }
+
+    m_now = std::max(m_now, target);
+}
+
+void TimerWheel::reschedule()
+{
+    if(!m_ready.isEmpty() && m_clock->realDelay(0) >= 0)
+    {
+        m_driverDue = m_now;
+        m_driver.start(0);
+        return;
+    }
+
+    m_driverDue = this->nextTick();
+    if(m_driverDue == NEVER)
+    {
+        m_driver.stop();
+        return;
+    }
+
+    // Time of the clock converted to the real time
+    quint64 now = this->currentTick();
+    qint64 delay = m_clock->realDelay(m_driverDue > now ? static_cast<qint64>(std::min<quint64>(m_driverDue - now, 1u << 30)) : 0);
+    if(delay < 0)
+        m_driver.stop();
+    else
+        m_driver.start(static_cast<int>(std::min<qint64>(delay, 1 << 30)));
+}
+
+void TimerWheel::run()
+{
+    QVector<Expired> batch;
+    batch.swap(m_ready);
+    this->advance(this->currentTick(), batch);
+
+    for(const auto &expired : batch)
+    {
+        // Cancelled, or cleared by one of the previous timers of the batch
+        Node &n = m_nodes[expired.node];
+        if(n.generation != expired.generation || n.client == nullptr)
+            continue;
+
+        TimerWheelClient *client = n.client;
+        quint64 cookie = n.cookie;
+        bool cancelled = m_groups.value(n.group) != n.groupGeneration;
+        this->release(expired.node);
+
+        if(!cancelled)
+            client->timerExpired(cookie);
+    }
+
+    this->reschedule();
+}
+
+void TimerWheel::idle()
+{
+    // Zero-delay timers are still to be fired by the driver
+    if(!m_ready.isEmpty())
+        return;
+
+    quint64 next = this->nextTick();
+    if(next == NEVER)
+        return;
+
+    // Discrete-event time: nothing happens until the next timer, so jump right to it
+    quint64 now = this->currentTick();
+    if(next > now && !m_clock->skip(static_cast<qint64>(next - now)))
+        return;
+
+    this->run();
+
+    // Another pass delivers what the timers posted (or skips further if they only cascaded)
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(this->thread());
+    if(dispatcher != nullptr)
+        dispatcher->wakeUp();
+}
+
+/*
+============================
+         PUBLIC API
+============================
+*/
+
+int TimerWheel::createGroup()
+{
+    m_groups.append(1);
+    return m_groups.size() - 1;
+}
+
+TimerWheel::Handle TimerWheel::schedule(int delayMs, int group, TimerWheelClient *client, quint64 cookie)
+{
+    int node = this->allocate();
+    Node &n = m_nodes[node];
+    n.group = group;
+    n.groupGeneration = m_groups.value(group);
+    n.client = client;
+    n.cookie = cookie;
+
+    Handle handle = (static_cast<Handle>(node) << 32) | n.generation;
+
+    if(delayMs <= 0)
+    {
+        // Fired on the next pass of the event loop, together with anything else that is due
+        n.due = m_now;
+        m_ready.append({node, n.generation});
+        if(m_clock->realDelay(0) >= 0 && (m_driverDue != m_now || !m_driver.isActive()))
+        {
+            m_driverDue = m_now;
+            m_driver.start(0);
+        }
+        return handle;
+    }
+
+    // Ticks are counted from the last processed one
+    n.due = this->currentTick() + static_cast<quint64>(delayMs);
+    this->place(node);
+
+    // Wake up earlier if needed
+    if(!m_driver.isActive() || this->nextTick() < m_driverDue)
+        this->reschedule();
+
+    return handle;
+}
+
+void TimerWheel::cancel(Handle handle)
+{
+    int node = static_cast<int>(handle >> 32);
+    quint32 generation = static_cast<quint32>(handle);
+
+    if(handle == INVALID_HANDLE || node >= m_nodes.size())
+        return;
+
+    Node &n = m_nodes[node];
+    if(n.generation != generation || n.client == nullptr)
+        return;
+
+    // Timers waiting in the ready list/batch are recognized as stale by their generation
+    if(n.slot >= 0)
+        this->unlink(node);
+    this->release(node);
+}
+
+void TimerWheel::cancelGroup(int group)
+{
+    if(group < 0 || group >= m_groups.size())
+        return;
+
+    // Timers of the old generation are dropped once they come due
+    if(++m_groups[group] == 0)
+        m_groups[group] = 1;
+}
+
+quint32 TimerWheel::groupGeneration(int group) const
+{
+    return m_groups.value(group);
+}
+
+bool TimerWheel::isActive(Handle handle) const
+{
+    int node = static_cast<int>(handle >> 32);
+    quint32 generation = static_cast<quint32>(handle);
+
+    if(handle == INVALID_HANDLE || node >= m_nodes.size())
+        return false;
+
+    const Node &n = m_nodes[node];
+    return n.generation == generation && n.client != nullptr && m_groups.value(n.group) == n.groupGeneration;
+}
+
+void TimerWheel::clear()
+{
+    for(int node = 0; node < m_nodes.size(); node++)
+    {
+        if(m_nodes[node].client != nullptr)
+        {
+            if(m_nodes[node].slot >= 0)
+                this->unlink(node);
+            this->release(node);
+        }
+    }
+
+    m_ready.clear();
+
+    // Pending flags derived from group generations become stale as well
+    for(int group = 0; group < m_groups.size(); group++)
+        this->cancelGroup(group);
+
+    m_driver.stop();
+    m_driverDue = NEVER;
+}
+
+void TimerWheel::reset()
+{
+    this->clear();
+    m_groups.clear();
+}
+
+/*
+============================
+            CLOCK
+============================
+*/
+
+void TimerWheel::setClock(FsmClock *clock)
+{
+    m_tickOrigin = this->currentTick();
+    m_clock = clock != nullptr ? clock : FsmClock::system();
+    m_clockOrigin = m_clock->elapsed();
+
+    // The dispatcher only announces blocking when no events are posted, i.e. the interpreter is idle
+    QObject::disconnect(m_idle);
+    if(m_clock->skipping())
+    {
+        QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(this->thread());
+        if(dispatcher != nullptr)
+            m_idle = QObject::connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &TimerWheel::idle);
+    }
+
+    this->reschedule();
+}
+
+FsmClock *TimerWheel::clock() const
+{
+    return m_clock;
+}
+
+qint64 TimerWheel::remaining() const
+{
+    if(!m_ready.isEmpty())
+        return 0;
+
+    quint64 next = this->nextTick();
+    if(next == NEVER)
+        return -1;
+
+    quint64 now = this->currentTick();
+    return next > now ? static_cast<qint64>(next - now) : 0;
+}
+
+void TimerWheel::poll()
+{
+    this->run();
+}
@@ -0,0 +1,249 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file timer_wheel.h
+* @author  xcervia00
+*
+* @brief Hierarchical timer wheel scheduling timeouts of transitions (interface)
+*
+*/
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <QObject>
+#include <QVector>
+#include <QTimer>
+
+#include "fsm_clock.h"
+
+/**
+ * @brief Receiver of expired timers
+ */
+class TimerWheelClient
+{
+    public:
+        virtual ~TimerWheelClient() = default;
+
+        /**
+         * @brief Called once the timer expired (the timer is already released)
+         * @param cookie The value given to TimerWheel::schedule
+         */
+        virtual void timerExpired(quint64 cookie) = 0;
+};
+
+/**
+ * @brief Schedules all timeouts of the interpreted machine on a single QTimer
+ * @note Four levels of 64 slots with 1 ms resolution (up to ~4.6 hours; longer timeouts are cascaded repeatedly).
+ * Timers belong to groups (one per state) that can be cancelled as a whole in O(1) by bumping their generation;
+ * cancelled timers are dropped lazily once they come due. Timers due at the same time are fired in one batch.
+ * Ticks come from a pluggable FsmClock; with a clock that does not run by itself the wheel never wakes itself up
+ * and its owner calls poll() after moving the time. A skipping clock is moved to the next timeout only once the
+ * event loop of the wheel has nothing left to deliver (inputs and empty inputs are handled before the jump).
+ */
+class TimerWheel : public QObject
+{
+    Q_OBJECT
+
+    public:
+        using Handle = quint64; ///< Identifies a scheduled timer (index and generation of its node)
+        static constexpr Handle INVALID_HANDLE = 0; ///< Handle that never refers to a timer
+
+    private:
+        static constexpr int LEVELS = 4; ///< Number of wheels
+        static constexpr int SLOT_BITS = 6; ///< log2 of the number of slots of a wheel
+        static constexpr int SLOTS = 1 << SLOT_BITS; ///< Number of slots of a wheel
+        static constexpr quint64 NEVER = ~quint64(0); ///< Tick that never comes
+
+        /**
+         * @brief Scheduled timer; nodes are linked into slots of the wheels
+         */
+        struct Node
+        {
+            quint64 due = 0; ///< Tick at which the timer expires
+            int prev = -1; ///< Previous node in the slot
+            int next = -1; ///< Next node in the slot (or in the free list)
+            int slot = -1; ///< Slot the node is linked into; -1 if not linked
+            quint32 generation = 1; ///< Incremented whenever the node is released
+            int group = 0; ///< Group of the timer
+            quint32 groupGeneration = 0; ///< Generation of the group at scheduling
+            TimerWheelClient *client = nullptr; ///< Receiver of the timer; nullptr if the node is free
+            quint64 cookie = 0; ///< Value passed to the receiver
+        };
+
+        /**
+         * @brief Reference to a node waiting to be fired
+         */
+        struct Expired
+        {
+            int node; ///< Index of the node
+            quint32 generation; ///< Generation of the node (stale if it differs)
+        };
+
+        QVector<Node> m_nodes; ///< All nodes
+        int m_freeList = -1; ///< First free node
+        int m_heads[LEVELS * SLOTS]; ///< First node of every slot
+        int m_tails[LEVELS * SLOTS]; ///< Last node of every slot
+        quint64 m_occupied[LEVELS] = {}; ///< Bitmap of non-empty slots of every wheel
+
+        QVector<Expired> m_ready; ///< Timers with zero delay (fired on the next run)
+        QVector<quint32> m_groups; ///< Current generation of every group
+
+        FsmClock *m_clock; ///< Source of ticks
+        quint64 m_tickOrigin = 0; ///< Tick at which the clock was set
+        qint64 m_clockOrigin = 0; ///< Time of the clock at which it was set (milliseconds)
+        quint64 m_now = 0; ///< Last processed tick
+        QTimer m_driver; ///< Wakes the wheel up when the next timer is due
+        quint64 m_driverDue = NEVER; ///< Tick the driver is set to
+        QMetaObject::Connection m_idle; ///< Skips idle time of a skipping clock (event dispatcher about to block)
+
+        /**
+         * @brief Takes a free node (or creates one)
+         * @return Index of the node
+         */
+        int allocate();
+
+        /**
+         * @brief Returns node to the free list; invalidates its handle
+         * @param node Index of the node
+         */
+        void release(int node);
+
+        /**
+         * @brief Links node to the slot that corresponds to its due tick
+         * @param node Index of the node
+         */
+        void place(int node);
+
+        /**
+         * @brief Links node to the end of given slot
+         * @param node Index of the node
+         * @param slot Index of the slot (over all levels)
+         */
+        void link(int node, int slot);
+
+        /**
+         * @brief Unlinks node from its slot
+         * @param node Index of the node
+         */
+        void unlink(int node);
+
+        /**
+         * @brief Finds the next tick at which some slot has to be processed
+         * @return The tick, or NEVER if nothing is scheduled
+         */
+        quint64 nextTick() const;
+
+        /**
+         * @brief Processes all ticks up to given one; expired timers are collected
+         * @param target The tick to advance to
+         * @param batch Collected timers
+         */
+        void advance(quint64 target, QVector<Expired> &batch);
+
+        /**
+         * @brief Starts the driver for the next due timer
+         */
+        void reschedule();
+
+    private slots:
+        /**
+         * @brief Fires everything that is due
+         */
+        void run();
+
+        /**
+         * @brief The event loop is about to wait; skips the idle time of a skipping clock to the next timer
+         */
+        void idle();
+
+    public:
+        /**
+         * @brief Constructor of the wheel
+         * @param parent The parent object
+         */
+        explicit TimerWheel(QObject *parent = nullptr);
+
+        /**
+         * @brief Creates a group of timers (usually one per state)
+         * @return Id of the group
+         */
+        int createGroup();
+
+        /**
+         * @brief Schedules a timer
+         * @param delayMs Delay in milliseconds; zero delay fires on the next pass of the event loop
+         * @param group The group the timer belongs to
+         * @param client Receiver of the timer
+         * @param cookie Value passed to the receiver
+         * @return Handle of the timer
+         */
+        Handle schedule(int delayMs, int group, TimerWheelClient *client, quint64 cookie);
+
+        /**
+         * @brief Cancels a single timer
+         * @param handle Handle of the timer (already expired/cancelled ones are ignored)
+         */
+        void cancel(Handle handle);
+
+        /**
+         * @brief Cancels all timers of a group in O(1)
+         * @param group Id of the group
+         */
+        void cancelGroup(int group);
+
+        /**
+         * @brief Current generation of a group (changes on every cancelGroup)
+         * @param group Id of the group
+         * @return The generation
+         */
+        quint32 groupGeneration(int group) const;
+
+        /**
+         * @brief Checks whether the timer is still scheduled
+         * @param handle Handle of the timer
+         * @return True if the timer will fire
+         */
+        bool isActive(Handle handle) const;
+
+        /**
+         * @brief Cancels all timers (groups are kept)
+         */
+        void clear();
+
+        /**
+         * @brief Cancels all timers and drops all groups
+         */
+        void reset();
+
+        /**
+         * @brief Current tick
+         * @return Milliseconds of the clock since the wheel was created (monotonic across clock changes)
+         */
+        quint64 currentTick() const;
+
+        /**
+         * @brief Changes the source of ticks; the ticks continue from the current one
+         * @param clock The clock (not owned); nullptr for FsmClock::system()
+         */
+        void setClock(FsmClock *clock);
+
+        /**
+         * @brief Source of ticks
+         * @return The clock
+         */
+        FsmClock *clock() const;
+
+        /**
+         * @brief Time until the wheel has to run next
+         * @return Milliseconds of the clock (0 if something is due); -1 if nothing is scheduled
+         */
+        qint64 remaining() const;
+
+        /**
+         * @brief Fires everything that is due at the current time of the clock
+         */
+        void poll();
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,254 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file async_logger.cpp
+* @author  xcervia00
+*
+* @brief Asynchronous logging pipeline; hot path pushes binary records, a background thread formats them
+*
+*/
+
+#include "async_logger.h"
+
+#include <QDateTime>
+
+#include <algorithm>
+#include <chrono>
+
+AsyncLogger &AsyncLogger::instance()
+{
+    static AsyncLogger logger;
+    return logger;
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    this->stop();
+    this->uninstallMessageHandler();
+}
+
+/*
+============================
+         PRODUCERS
+============================
+*/
+
+void AsyncLogger::notify()
+{
+    // Only the first producer after the consumer went to sleep pays for the wake-up
+    if(m_sleeping.load(std::memory_order_relaxed) && m_sleeping.exchange(false))
+        m_wake.notify_one();
+}
+
+void AsyncLogger::push(LogEvent event, const QString &name, const QString &value, qint32 id, QtMsgType level)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    bool pushed = m_ring.push([&](LogRecord &record)
+    {
+        record.timestamp = now;
+        record.event = event;
+        record.level = static_cast<quint8>(level);
+        record.id = id;
+        record.message = nullptr;
+        record.setStrings(name, value);
+    });
+
+    if(!pushed)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    this->notify();
+}
+
+void AsyncLogger::message(QtMsgType level, const QString &text)
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QString *owned = new QString(text);
+
+    bool pushed = m_ring.push([&](LogRecord &record)
+    {
+        record.timestamp = now;
+        record.event = LOG_MESSAGE;
+        record.level = static_cast<quint8>(level);
+        record.id = -1;
+        record.message = owned;
+        record.nameLength = 0;
+        record.valueLength = 0;
+    });
+
+    if(!pushed)
+    {
+        delete owned;
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    this->notify();
+}
+
+/*
+============================
+          CONSUMER
+============================
+*/
+
+void AsyncLogger::start()
+{
+    if(m_running.load())
+        return;
+
+    m_running.store(true);
+    m_consumer = std::thread(&AsyncLogger::run, this);
+}
+
+void AsyncLogger::run()
+{
+    while(true)
+    {
+        if(this->drain() > 0)
+            continue;
+
+        // Stopped ==> write whatever is left
+        if(!m_running.load())
+        {
+            while(this->drain() > 0) {}
+            break;
+        }
+
+        // A wake-up missed between the check and the wait only delays the records by the timeout
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_sleeping.store(true);
+        if(m_ring.pushed() == m_ring.popped() && m_running.load())
+            m_wake.wait_for(lock, std::chrono::milliseconds(10));
+        m_sleeping.store(false);
+    }
+}
+
+int AsyncLogger::drain()
+{
+    QVector<LogEntry> batch;
+    LogRecord record;
+
+    while(batch.size() < BATCH && m_ring.pop(record))
+    {
+        batch.append({record.timestamp, static_cast<QtMsgType>(record.level), record.format(),
+                      static_cast<LogEvent>(record.event), record.id, record.name(), record.value()});
+        delete record.message;
+    }
+
+    if(batch.isEmpty())
+        return 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_sinksMutex);
+        for(auto &sink : m_sinks)
+            sink->write(batch);
+    }
+
+    m_written.fetch_add(static_cast<quint64>(batch.size()), std::memory_order_release);
+    return batch.size();
+}
+
+/*
+============================
+           SINKS
+============================
+*/
+
+LogSink *AsyncLogger::addSink(std::unique_ptr<LogSink> sink)
+{
+    LogSink *added = sink.get();
+
+    {
+        std::lock_guard<std::mutex> lock(m_sinksMutex);
+        m_sinks.push_back(std::move(sink));
+        m_enabled.store(true);
+    }
+
+    this->start();
+    return added;
+}
+
+void AsyncLogger::removeSink(LogSink *sink)
+{
+    std::lock_guard<std::mutex> lock(m_sinksMutex);
+
+    auto it = std::find_if(m_sinks.begin(), m_sinks.end(), [&](const std::unique_ptr<LogSink> &s) { return s.get() == sink; });
+    if(it != m_sinks.end())
+        m_sinks.erase(it);
+
+    m_enabled.store(!m_sinks.empty());
+}
+
+void AsyncLogger::flush()
+{
+    quint64 target = m_ring.pushed();
+
+    while(m_running.load() && m_written.load(std::memory_order_acquire) < target)
+    {
+        m_wake.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void AsyncLogger::stop()
+{
+    if(!m_running.load())
+        return;
+
+    m_running.store(false);
+    m_wake.notify_one();
+
+    if(m_consumer.joinable())
+        m_consumer.join();
+}
+
+quint64 AsyncLogger::dropped() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+/*
+============================
+       QT MESSAGES
+============================
+*/
+
+void AsyncLogger::installMessageHandler()
+{
+    if(m_handlerInstalled)
+        return;
+
+    m_previousHandler = qInstallMessageHandler(AsyncLogger::messageHandler);
+    m_handlerInstalled = true;
+}
+
+void AsyncLogger::uninstallMessageHandler()
+{
+    if(!m_handlerInstalled)
+        return;
+
+    qInstallMessageHandler(m_previousHandler);
+    m_handlerInstalled = false;
+}
+
+void AsyncLogger::messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    AsyncLogger &logger = AsyncLogger::instance();
+
+    if(type != QtFatalMsg && logger.enabled())
+    {
+        logger.message(type, msg);
+        return;
+    }
+
+    // Fatal message aborts ==> write everything logged before it first
+    if(type == QtFatalMsg)
+        logger.flush();
+
+    if(logger.m_previousHandler != nullptr)
+        logger.m_previousHandler(type, context, msg);
+}
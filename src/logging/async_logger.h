@@ -0,0 +1,194 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file async_logger.h
+* @author  xcervia00
+*
+* @brief Asynchronous logging pipeline; hot path pushes binary records, a background thread formats them (interface)
+*
+*/
+
+#ifndef ASYNC_LOGGER_H
+#define ASYNC_LOGGER_H
+
+#include <QString>
+#include <QVariant>
+#include <QMessageLogContext>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "log_record.h"
+#include "log_ring.h"
+#include "log_sink.h"
+
+/**
+ * @brief Process-wide logger; producers (any thread) push fixed-size records into a lock-free ring,
+ * the consumer thread formats them and hands them in batches to the sinks
+ * @note Without sinks the logger is disabled and logging costs a single atomic load.
+ * Records that do not fit into the full ring are dropped (and counted) rather than blocking the interpreter.
+ */
+class AsyncLogger
+{
+    private:
+        static constexpr int CAPACITY = 16384; ///< Number of records in the ring
+        static constexpr int BATCH = 512; ///< Maximal number of records handed to sinks at once
+
+        LogRing m_ring{CAPACITY}; ///< Pending records
+        std::atomic<bool> m_enabled{false}; ///< Is there any sink?
+        std::atomic<quint64> m_dropped{0}; ///< Records dropped because the ring was full
+        std::atomic<quint64> m_written{0}; ///< Records handed to the sinks
+
+        std::mutex m_sinksMutex; ///< Guards m_sinks (held by the consumer while writing a batch)
+        std::vector<std::unique_ptr<LogSink>> m_sinks; ///< Destinations of the log
+
+        std::thread m_consumer; ///< Formats and writes the records
+        std::atomic<bool> m_running{false}; ///< Should the consumer keep running?
+        std::mutex m_wakeMutex; ///< Used by the consumer to sleep
+        std::condition_variable m_wake; ///< Wakes the consumer up
+        std::atomic<bool> m_sleeping{false}; ///< Is the consumer (about to be) sleeping?
+
+        QtMessageHandler m_previousHandler = nullptr; ///< Handler replaced by installMessageHandler
+        bool m_handlerInstalled = false; ///< Is messageHandler installed?
+
+        AsyncLogger() = default;
+
+        /**
+         * @brief Wakes the consumer up if it sleeps
+         */
+        void notify();
+
+        /**
+         * @brief Body of the consumer thread
+         */
+        void run();
+
+        /**
+         * @brief Formats and writes a batch of records
+         * @return Number of records processed
+         */
+        int drain();
+
+        /**
+         * @brief Starts the consumer thread (if not running)
+         */
+        void start();
+
+    public:
+        ~AsyncLogger();
+
+        AsyncLogger(const AsyncLogger&) = delete;
+        AsyncLogger &operator=(const AsyncLogger&) = delete;
+
+        /**
+         * @brief The logger of the process
+         * @return The logger
+         */
+        static AsyncLogger &instance();
+
+        /**
+         * @brief Is anybody listening? (hot path checks this before doing any work)
+         * @return True if there is at least one sink
+         */
+        bool enabled() const
+        {
+            return m_enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Pushes structured record
+         * @param event The event
+         * @param name Name of the state/variable (truncated to fit the record)
+         * @param value Value of the variable/destination state (truncated to fit the record)
+         * @param id Id of the transition or size of a batch
+         * @param level Severity of the record
+         */
+        void push(LogEvent event, const QString &name, const QString &value, qint32 id = -1, QtMsgType level = QtInfoMsg);
+
+        /**
+         * @brief Pushes preformatted message
+         * @param level Severity of the message
+         * @param text The message
+         */
+        void message(QtMsgType level, const QString &text);
+
+        /**
+         * @brief Adds destination of the log; starts the consumer if needed
+         * @param sink The sink (logger takes ownership)
+         * @return The sink (to be removed later)
+         */
+        LogSink *addSink(std::unique_ptr<LogSink> sink);
+
+        /**
+         * @brief Removes and destroys the sink; once it returns, the sink is not used anymore
+         * @param sink The sink to remove
+         */
+        void removeSink(LogSink *sink);
+
+        /**
+         * @brief Blocks until all records pushed so far were written (or dropped)
+         */
+        void flush();
+
+        /**
+         * @brief Writes everything pending and stops the consumer thread
+         */
+        void stop();
+
+        /**
+         * @brief Number of records dropped because the ring was full
+         * @return The count
+         */
+        quint64 dropped() const;
+
+        /**
+         * @brief Routes qInfo/qWarning/... into the logger (keeps their order with the structured records)
+         */
+        void installMessageHandler();
+
+        /**
+         * @brief Restores the message handler replaced by installMessageHandler
+         */
+        void uninstallMessageHandler();
+
+        /**
+         * @brief Handler of Qt messages; fatal messages and messages without sinks go to the previous handler
+         * @param type The type of the message
+         * @param context Context of the message
+         * @param msg The message itself
+         */
+        static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg);
+};
+
+/**
+ * @brief Logs an event of the interpreter (does nothing if there is no sink)
+ * @param event The event
+ * @param name Name of the state/variable
+ * @param value Value of the variable/destination state
+ * @param id Id of the transition or size of a batch
+ */
+inline void logEvent(LogEvent event, const QString &name, const QString &value = QString(), qint32 id = -1)
+{
+    AsyncLogger &logger = AsyncLogger::instance();
+    if(logger.enabled())
+        logger.push(event, name, value, id);
+}
+
+/**
+ * @brief Logs an event whose value has to be converted to text (converted only if there is a sink)
+ * @param event The event
+ * @param name Name of the variable
+ * @param value The value
+ */
+inline void logEvent(LogEvent event, const QString &name, const QVariant &value)
+{
+    AsyncLogger &logger = AsyncLogger::instance();
+    if(logger.enabled())
+        logger.push(event, name, value.toString());
+}
+
+#endif // ASYNC_LOGGER_H
@@ -0,0 +1,144 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file log_record.cpp
+* @author  xcervia00
+*
+* @brief Fixed-size binary record of a logged event
+*
+*/
+
+#include "log_record.h"
+
+#include <cstring>
+
+/**
+ * @brief UTF-8 of the ellipsis (U+2026) that marks a cut string
+ */
+static const char ELLIPSIS[] = "\xE2\x80\xA6";
+static const int ELLIPSIS_SIZE = sizeof(ELLIPSIS) - 1;
+
+/**
+ * @brief Encodes the string as UTF-8 without allocating; stops at the last character that fits
+ * @param text The string to encode
+ * @param dst The destination
+ * @param capacity Size of the destination
+ * @param complete Set to false if the string didn't fit
+ * @return Number of bytes written
+ */
+static int encodeUtf8(const QString &text, char *dst, int capacity, bool &complete)
+{
+    int length = 0;
+    const QChar *c = text.constData();
+    const QChar *end = c + text.size();
+
+    while(c < end)
+    {
+        uint code = c->unicode();
+        const QChar *next = c + 1;
+        if(QChar::isHighSurrogate(code) && next < end && next->isLowSurrogate())
+        {
+            code = QChar::surrogateToUcs4(c->unicode(), next->unicode());
+            next++;
+        }
+
+        int bytes = code < 0x80 ? 1 : code < 0x800 ? 2 : code < 0x10000 ? 3 : 4;
+        if(length + bytes > capacity)
+            break;
+
+        switch(bytes)
+        {
+            case 1:
+                dst[length++] = static_cast<char>(code);
+                break;
+            case 2:
+                dst[length++] = static_cast<char>(0xC0 | (code >> 6));
+                dst[length++] = static_cast<char>(0x80 | (code & 0x3F));
+                break;
+            case 3:
+                dst[length++] = static_cast<char>(0xE0 | (code >> 12));
+                dst[length++] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                dst[length++] = static_cast<char>(0x80 | (code & 0x3F));
+                break;
+            default:
+                dst[length++] = static_cast<char>(0xF0 | (code >> 18));
+                dst[length++] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                dst[length++] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                dst[length++] = static_cast<char>(0x80 | (code & 0x3F));
+                break;
+        }
+
+        c = next;
+    }
+
+    complete = c == end;
+    return length;
+}
+
+/**
+ * @brief Encodes the string as UTF-8 without allocating; a string that doesn't fit is cut and ends with an ellipsis
+ * @param text The string to encode
+ * @param dst The destination
+ * @param capacity Size of the destination
+ * @return Number of bytes written
+ */
+static int encodeMarked(const QString &text, char *dst, int capacity)
+{
+    bool complete;
+    int length = encodeUtf8(text, dst, capacity, complete);
+    if(complete || capacity < ELLIPSIS_SIZE)
+        return length;
+
+    // Cut again to make room for the marker
+    length = encodeUtf8(text, dst, capacity - ELLIPSIS_SIZE, complete);
+    std::memcpy(dst + length, ELLIPSIS, ELLIPSIS_SIZE);
+    return length + ELLIPSIS_SIZE;
+}
+
+void LogRecord::setStrings(const QString &name, const QString &value)
+{
+    // The value gets at least a third of the space (names are usually short)
+    int nameCapacity = value.isEmpty() ? DATA_SIZE : DATA_SIZE * 2 / 3;
+    this->nameLength = static_cast<quint8>(encodeMarked(name, this->data, nameCapacity));
+    this->valueLength = static_cast<quint8>(encodeMarked(value, this->data + this->nameLength, DATA_SIZE - this->nameLength));
+}
+
+QString LogRecord::name() const
+{
+    return QString::fromUtf8(this->data, this->nameLength);
+}
+
+QString LogRecord::value() const
+{
+    return QString::fromUtf8(this->data + this->nameLength, this->valueLength);
+}
+
+QString LogRecord::format() const
+{
+    switch(static_cast<LogEvent>(this->event))
+    {
+        case LOG_MESSAGE:
+            return this->message != nullptr ? *this->message : QString();
+        case LOG_STATE_ENTERED:
+            return QStringLiteral("Interpreter: State entered: %1").arg(this->name());
+        case LOG_TRANSITION_FIRED:
+            return QStringLiteral("Interpreter: Transition of id %1 from state %2 to %3 had been triggered")
+                .arg(this->id).arg(this->name(), this->value());
+        case LOG_INPUT_EVENT:
+            return QStringLiteral("Caught input event %1 of value: %2").arg(this->name(), this->value());
+        case LOG_INPUT_BATCH:
+            return QStringLiteral("Caught %1 input events").arg(this->id);
+        case LOG_OUTPUT_EVENT:
+            return QStringLiteral("Fired output event %1: %2").arg(this->name(), this->value());
+        case LOG_VAR_INPUT:
+            return QStringLiteral("MODEL: Set input variable %1 to %2").arg(this->name(), this->value());
+        case LOG_VAR_INPUTS:
+            return QStringLiteral("MODEL: Set %1 input variables").arg(this->id);
+        case LOG_VAR_OUTPUT:
+            return QStringLiteral("MODEL: Set output variable %1 to %2").arg(this->name(), this->value());
+        case LOG_VAR_INTERNAL:
+            return QStringLiteral("MODEL: Set internal variable %1 to %2").arg(this->name(), this->value());
+    }
+
+    return QString();
+}
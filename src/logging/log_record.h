@@ -0,0 +1,79 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file log_record.h
+* @author  xcervia00
+*
+* @brief Fixed-size binary record of a logged event (interface)
+*
+*/
+
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @brief Events logged by the hot path of the interpreter; the text is formatted only by the consumer
+ */
+enum LogEvent : quint8
+{
+    LOG_MESSAGE, ///< Preformatted message (qInfo etc.); the text is owned by the record
+    LOG_STATE_ENTERED, ///< State was entered (name)
+    LOG_TRANSITION_FIRED, ///< Transition was taken (id, source, destination)
+    LOG_INPUT_EVENT, ///< Input event was accepted (name, value)
+    LOG_INPUT_BATCH, ///< Batch of input events was accepted (id is the size)
+    LOG_OUTPUT_EVENT, ///< Output event was fired (name, value)
+    LOG_VAR_INPUT, ///< Input variable was set (name, value)
+    LOG_VAR_INPUTS, ///< Several input variables were set (id is the count)
+    LOG_VAR_OUTPUT, ///< Output variable was set (name, value)
+    LOG_VAR_INTERNAL, ///< Internal variable was set (name, value)
+};
+
+/**
+ * @brief Record stored in the log ring; strings are copied inline as UTF-8 (cut strings end with an ellipsis),
+ * so pushing a record does not allocate
+ */
+struct LogRecord
+{
+    static constexpr int DATA_SIZE = 96; ///< Space for the name and value
+
+    qint64 timestamp; ///< Milliseconds since epoch
+    quint8 event; ///< LogEvent
+    quint8 level; ///< QtMsgType
+    quint8 nameLength; ///< Bytes of the name in data
+    quint8 valueLength; ///< Bytes of the value in data (follows the name)
+    qint32 id; ///< Id of the transition or size of a batch
+    QString *message; ///< Text of LOG_MESSAGE (deleted by the consumer); nullptr otherwise
+    char data[DATA_SIZE]; ///< Name followed by value
+
+    /**
+     * @brief Copies the strings into the record
+     * @param name The name
+     * @param value The value
+     */
+    void setStrings(const QString &name, const QString &value);
+
+    /**
+     * @brief The name stored in the record
+     * @return Decoded name
+     */
+    QString name() const;
+
+    /**
+     * @brief The value stored in the record
+     * @return Decoded value
+     */
+    QString value() const;
+
+    /**
+     * @brief Formats the record into the text of the log
+     * @return The text (without timestamp)
+     */
+    QString format() const;
+};
+
+static_assert(sizeof(LogRecord) + sizeof(quint64) <= 128, "LogRecord is expected to fit (together with its sequence) a 128 B cell");
+
+#endif // LOG_RECORD_H
@@ -0,0 +1,51 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file log_ring.cpp
+* @author  xcervia00
+*
+* @brief Bounded lock-free ring of log records
+*
+*/
+
+#include "log_ring.h"
+
+LogRing::LogRing(int capacity)
+{
+    quint64 size = 2;
+    while(size < static_cast<quint64>(capacity))
+        size <<= 1;
+
+    m_cells.reset(new Cell[size]);
+    m_mask = size - 1;
+
+    for(quint64 i = 0; i < size; i++)
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+bool LogRing::pop(LogRecord &record)
+{
+    quint64 pos = m_head.load(std::memory_order_relaxed);
+    Cell &cell = m_cells[pos & m_mask];
+
+    // Not filled yet (or the producer is still writing it)
+    if(cell.sequence.load(std::memory_order_acquire) != pos + 1)
+        return false;
+
+    record = cell.record;
+
+    // Free the cell for the producer that wraps around to it
+    cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+    m_head.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+quint64 LogRing::pushed() const
+{
+    return m_tail.load(std::memory_order_acquire);
+}
+
+quint64 LogRing::popped() const
+{
+    return m_head.load(std::memory_order_acquire);
+}
@@ -0,0 +1,109 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file log_ring.h
+* @author  xcervia00
+*
+* @brief Bounded lock-free ring of log records (interface)
+*
+*/
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <atomic>
+#include <memory>
+
+#include "log_record.h"
+
+/**
+ * @brief Bounded multi-producer single-consumer queue of log records
+ * @note Every cell carries a sequence number that tells whether it is free for the producer claiming its
+ * position or filled for the consumer (bounded queue by D. Vyukov). Producers never block: once the ring is full,
+ * push fails and the record is dropped.
+ */
+class LogRing
+{
+    private:
+        /**
+         * @brief Slot of the ring
+         */
+        struct alignas(64) Cell
+        {
+            std::atomic<quint64> sequence; ///< Position the cell is free for (== pos) or filled at (== pos + 1)
+            LogRecord record; ///< The record
+        };
+
+        std::unique_ptr<Cell[]> m_cells; ///< The slots
+        quint64 m_mask; ///< Capacity - 1
+
+        alignas(64) std::atomic<quint64> m_tail{0}; ///< Next position claimed by producers
+        alignas(64) std::atomic<quint64> m_head{0}; ///< Next position read by the consumer
+
+    public:
+        /**
+         * @brief Constructor of the ring
+         * @param capacity Number of records; rounded up to the power of two
+         */
+        explicit LogRing(int capacity);
+
+        /**
+         * @brief Claims a cell and fills it
+         * @tparam Fill Callable (LogRecord&)
+         * @param fill Fills the record (called at most once, only if there was space)
+         * @return False if the ring is full
+         */
+        template<typename Fill>
+        bool push(Fill &&fill)
+        {
+            quint64 pos = m_tail.load(std::memory_order_relaxed);
+
+            while(true)
+            {
+                Cell &cell = m_cells[pos & m_mask];
+                qint64 diff = static_cast<qint64>(cell.sequence.load(std::memory_order_acquire) - pos);
+
+                if(diff == 0)
+                {
+                    // The cell is free; claim it (pos is reloaded on failure)
+                    if(m_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    {
+                        fill(cell.record);
+                        cell.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if(diff < 0)
+                {
+                    // The consumer did not read the cell yet ==> full
+                    return false;
+                }
+                else
+                {
+                    // Claimed by other producer in the meantime
+                    pos = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief Takes the oldest record (consumer only)
+         * @param record The record read
+         * @return False if there is no filled record
+         */
+        bool pop(LogRecord &record);
+
+        /**
+         * @brief Number of positions claimed by producers so far
+         * @return The count
+         */
+        quint64 pushed() const;
+
+        /**
+         * @brief Number of records read by the consumer so far
+         * @return The count
+         */
+        quint64 popped() const;
+};
+
+#endif // LOG_RING_H
@@ -0,0 +1,97 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file log_sink.cpp
+* @author  xcervia00
+*
+* @brief Destinations of the formatted log
+*
+*/
+
+#include "log_sink.h"
+
+#include <QDateTime>
+
+QString LogEntry::time() const
+{
+    return QDateTime::fromMSecsSinceEpoch(this->timestamp).toString("yyyy-MM-dd hh:mm:ss.zzz");
+}
+
+/**
+ * @brief Name of the severity used in files
+ * @param level The severity
+ * @return The name
+ */
+static const char *levelName(QtMsgType level)
+{
+    switch(level)
+    {
+        case QtDebugMsg: return "DEBUG";
+        case QtInfoMsg: return "INFO";
+        case QtWarningMsg: return "WARNING";
+        case QtCriticalMsg: return "CRITICAL";
+        case QtFatalMsg: return "FATAL";
+    }
+
+    return "";
+}
+
+/*
+============================
+        STREAM SINK
+============================
+*/
+
+StreamLogSink::StreamLogSink(FILE *stream)
+    :
+    m_stream{stream}
+{
+
+}
+
+void StreamLogSink::write(const QVector<LogEntry> &batch)
+{
+    for(const auto &entry : batch)
+    {
+        fprintf(m_stream, "%s\n", entry.text.toLocal8Bit().constData());
+    }
+    fflush(m_stream);
+}
+
+/*
+============================
+         FILE SINK
+============================
+*/
+
+FileLogSink::FileLogSink(const QString &filename)
+    :
+    m_file{filename}
+{
+    m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+}
+
+bool FileLogSink::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+void FileLogSink::write(const QVector<LogEntry> &batch)
+{
+    if(!m_file.isOpen())
+        return;
+
+    QByteArray chunk;
+    for(const auto &entry : batch)
+    {
+        chunk += entry.time().toUtf8();
+        chunk += " [";
+        chunk += levelName(entry.level);
+        chunk += "] ";
+        chunk += entry.text.toUtf8();
+        chunk += '\n';
+    }
+
+    m_file.write(chunk);
+    m_file.flush();
+}
@@ -0,0 +1,101 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file log_sink.h
+* @author  xcervia00
+*
+* @brief Destinations of the formatted log (interface)
+*
+*/
+
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <QString>
+#include <QVector>
+#include <QFile>
+#include <QtGlobal>
+
+#include <cstdio>
+
+#include "log_record.h"
+
+/**
+ * @brief Formatted log message
+ */
+struct LogEntry
+{
+    qint64 timestamp = 0; ///< Milliseconds since epoch
+    QtMsgType level = QtInfoMsg; ///< Severity of the message
+    QString text; ///< The message
+    LogEvent event = LOG_MESSAGE; ///< The event the message was formatted from
+    qint32 id = -1; ///< Id of the transition or size of a batch
+    QString name; ///< Name of the state/variable (source state of a transition)
+    QString value; ///< Value of the variable (destination state of a transition)
+
+    /**
+     * @brief Formats the timestamp
+     * @return Time in format yyyy-MM-dd hh:mm:ss.zzz
+     */
+    QString time() const;
+};
+
+/**
+ * @brief Receives batches of formatted messages from the consumer thread of AsyncLogger
+ * @note Batches are delivered by a single thread (not the one the sink was created in)
+ */
+class LogSink
+{
+    public:
+        virtual ~LogSink() = default;
+
+        /**
+         * @brief Writes a batch of messages
+         * @param batch The messages in order they were logged
+         */
+        virtual void write(const QVector<LogEntry> &batch) = 0;
+};
+
+/**
+ * @brief Writes messages to stdout/stderr (just the text, same as the default Qt message handler)
+ */
+class StreamLogSink : public LogSink
+{
+    private:
+        FILE *m_stream; ///< The stream
+
+    public:
+        /**
+         * @brief Constructor of the sink
+         * @param stream The stream to write to
+         */
+        explicit StreamLogSink(FILE *stream);
+
+        void write(const QVector<LogEntry> &batch) override;
+};
+
+/**
+ * @brief Appends messages to a file (with timestamp and severity)
+ */
+class FileLogSink : public LogSink
+{
+    private:
+        QFile m_file; ///< The file
+
+    public:
+        /**
+         * @brief Constructor of the sink; opens the file
+         * @param filename Path to the file
+         */
+        explicit FileLogSink(const QString &filename);
+
+        /**
+         * @brief Was the file opened?
+         * @return True if the messages can be written
+         */
+        bool isOpen() const;
+
+        void write(const QVector<LogEntry> &batch) override;
+};
+
+#endif // LOG_SINK_H
@@ -0,0 +1,73 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file trace_format.h
+* @author  xcervia00
+*
+* @brief Layout of the binary trace of interpretation runs (.fsmt)
+*
+*/
+
+#ifndef TRACE_FORMAT_H
+#define TRACE_FORMAT_H
+
+#include <QtGlobal>
+
+/**
+ * @brief The trace is a header followed by a stream of variable-length records. Every record starts with
+ * its type byte; integers are unsigned LEB128 (signed ones zigzag encoded first), floats are 8 byte little endian.
+ * Timed records carry microseconds elapsed since the previous timed record (clock of the interpretation, see FsmClock).
+ * Names are interned: a RECORD_STRING defines the id before its first use. Variable values are
+ * delta encoded against the previous value of the same variable.
+ * The file is preallocated with zeros, so a trace that was not closed properly ends with RECORD_END.
+ */
+namespace FsmTrace
+{
+    constexpr char MAGIC[4] = {'F', 'S', 'M', 'T'}; ///< File signature
+    constexpr quint16 VERSION = 1; ///< Current version of the format
+
+    /**
+     * @brief Beginning of the file (little endian)
+     */
+    struct Header
+    {
+        char magic[4]; ///< MAGIC
+        quint16 version; ///< VERSION
+        quint16 headerSize; ///< sizeof(Header)
+        qint64 startTime; ///< Wall clock time the trace was opened (milliseconds since epoch)
+        quint64 length; ///< Bytes of records following the header; 0 if the trace was not closed
+    };
+
+    /**
+     * @brief Types of records
+     */
+    enum RecordType : quint8
+    {
+        RECORD_END = 0, ///< End of the records (the rest of the file)
+        RECORD_STRING, ///< id, byte length, UTF-8 bytes
+        RECORD_START, ///< dt, engine (byte); interpretation was started
+        RECORD_STOP, ///< dt; interpretation was stopped
+        RECORD_STATE, ///< dt, state; state was entered
+        RECORD_TRANSITION, ///< dt, transition id (zigzag), source state, destination state; transition was taken
+        RECORD_INPUT, ///< dt, name; input event (its value is the last value of the input variable)
+        RECORD_OUTPUT, ///< dt, name; output event (its value is the last value of the output variable)
+        RECORD_VARIABLE, ///< dt, scope (byte), name, value kind (byte), value; variable was set
+    };
+
+    /**
+     * @brief Encodings of variable values
+     */
+    enum ValueKind : quint8
+    {
+        VALUE_SAME, ///< Same as the previous value
+        VALUE_INT, ///< Integer (zigzag)
+        VALUE_INT_DELTA, ///< Difference from the previous integer (zigzag)
+        VALUE_FLOAT, ///< Double
+        VALUE_TRUE, ///< Boolean true
+        VALUE_FALSE, ///< Boolean false
+        VALUE_STRING, ///< Byte length, UTF-8 bytes
+        VALUE_STRING_SUFFIX, ///< Kept prefix of the previous string (UTF-16 units), byte length, UTF-8 bytes of the rest
+    };
+}
+
+#endif // TRACE_FORMAT_H
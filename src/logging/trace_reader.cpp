@@ -0,0 +1,268 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file trace_reader.cpp
+* @author  xcervia00
+*
+* @brief Decodes the binary trace of interpretation runs
+*
+*/
+
+#include "trace_reader.h"
+
+#include <QFile>
+#include <QtEndian>
+
+#include <cstring>
+
+using namespace FsmTrace;
+
+/**
+ * @brief Inverse of zigzag encoding
+ * @param value Zigzag encoded integer
+ * @return The signed integer
+ */
+static qint64 unzigzag(quint64 value)
+{
+    return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+
+bool TraceReader::open(const QString &filename)
+{
+    QFile file(filename);
+    if(!file.open(QIODevice::ReadOnly))
+        return this->fail(QString("Cannot open %1").arg(filename));
+
+    m_data = file.readAll();
+    m_strings.clear();
+    m_values.clear();
+    m_time = 0;
+    m_error.clear();
+
+    Header header;
+    if(m_data.size() < static_cast<int>(sizeof(Header)))
+        return this->fail("File is too short");
+
+    std::memcpy(&header, m_data.constData(), sizeof(Header));
+    if(std::memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0)
+        return this->fail("Not a trace (bad signature)");
+    if(qFromLittleEndian(header.version) != VERSION)
+        return this->fail(QString("Unsupported version %1").arg(qFromLittleEndian(header.version)));
+
+    quint16 headerSize = qFromLittleEndian(header.headerSize);
+    quint64 length = qFromLittleEndian(header.length);
+    if(headerSize < sizeof(Header) || headerSize > m_data.size())
+        return this->fail("Corrupted header");
+
+    m_startTime = qFromLittleEndian(header.startTime);
+    m_offset = headerSize;
+
+    // Length is written once the trace is closed; otherwise read until RECORD_END
+    m_complete = length != 0 && headerSize + length <= static_cast<quint64>(m_data.size());
+    m_end = m_complete ? static_cast<qint64>(headerSize + length) : m_data.size();
+    return true;
+}
+
+bool TraceReader::fail(const QString &message)
+{
+    m_error = message;
+    m_end = m_offset;
+    return false;
+}
+
+qint64 TraceReader::startTime() const
+{
+    return m_startTime;
+}
+
+bool TraceReader::isComplete() const
+{
+    return m_complete;
+}
+
+QString TraceReader::error() const
+{
+    return m_error;
+}
+
+/*
+============================
+         DECODING
+============================
+*/
+
+bool TraceReader::readByte(quint8 &value)
+{
+    if(m_offset >= m_end)
+        return false;
+
+    value = static_cast<quint8>(m_data.at(static_cast<int>(m_offset++)));
+    return true;
+}
+
+bool TraceReader::readVarint(quint64 &value)
+{
+    value = 0;
+    for(int shift = 0; shift < 64; shift += 7)
+    {
+        quint8 byte;
+        if(!this->readByte(byte))
+            return false;
+
+        value |= static_cast<quint64>(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+bool TraceReader::readString(quint64 size, QString &value)
+{
+    if(size > static_cast<quint64>(m_end - m_offset))
+        return false;
+
+    value = QString::fromUtf8(m_data.constData() + m_offset, static_cast<int>(size));
+    m_offset += static_cast<qint64>(size);
+    return true;
+}
+
+bool TraceReader::readName(QString &value)
+{
+    quint64 id;
+    if(!this->readVarint(id) || id >= static_cast<quint64>(m_strings.size()))
+        return false;
+
+    value = m_strings.at(static_cast<int>(id));
+    return true;
+}
+
+bool TraceReader::readValue(quint8 scope, quint32 name, QVariant &value)
+{
+    quint8 kind;
+    quint64 number;
+    QVariant &last = m_values[(static_cast<quint64>(scope) << 32) | name];
+
+    if(!this->readByte(kind))
+        return false;
+
+    switch(kind)
+    {
+        case VALUE_SAME:
+            break;
+        case VALUE_INT:
+            if(!this->readVarint(number))
+                return false;
+            last = unzigzag(number);
+            break;
+        case VALUE_INT_DELTA:
+            if(!this->readVarint(number))
+                return false;
+            last = last.toLongLong() + unzigzag(number);
+            break;
+        case VALUE_FLOAT: {
+            if(m_end - m_offset < 8)
+                return false;
+            quint64 bits;
+            double real;
+            std::memcpy(&bits, m_data.constData() + m_offset, sizeof(bits));
+            bits = qFromLittleEndian(bits);
+            std::memcpy(&real, &bits, sizeof(real));
+            m_offset += 8;
+            last = real;
+            break;
+        }
+        case VALUE_TRUE:
+            last = true;
+            break;
+        case VALUE_FALSE:
+            last = false;
+            break;
+        case VALUE_STRING: {
+            QString text;
+            if(!this->readVarint(number) || !this->readString(number, text))
+                return false;
+            last = text;
+            break;
+        }
+        case VALUE_STRING_SUFFIX: {
+            quint64 prefix;
+            QString text;
+            if(!this->readVarint(prefix) || !this->readVarint(number) || !this->readString(number, text))
+                return false;
+            last = last.toString().left(static_cast<int>(prefix)) + text;
+            break;
+        }
+        default:
+            return false;
+    }
+
+    value = last;
+    return true;
+}
+
+bool TraceReader::next(TraceEvent &event)
+{
+    while(true)
+    {
+        qint64 start = m_offset;
+        quint8 type;
+        if(!this->readByte(type) || type == RECORD_END)
+            return false;
+
+        // Interned names are resolved here; they are not reported
+        if(type == RECORD_STRING)
+        {
+            quint64 id, size;
+            QString text;
+            if(!this->readVarint(id) || !this->readVarint(size) || !this->readString(size, text) || id != static_cast<quint64>(m_strings.size()))
+                return this->fail(QString("Malformed string at offset %1").arg(start));
+
+            m_strings.append(text);
+            continue;
+        }
+
+        quint64 delta;
+        if(type > RECORD_VARIABLE || !this->readVarint(delta))
+            return this->fail(QString("Malformed record at offset %1").arg(start));
+
+        m_time += static_cast<qint64>(delta);
+        event = TraceEvent();
+        event.type = static_cast<RecordType>(type);
+        event.time = m_time;
+
+        bool ok = true;
+        switch(type)
+        {
+            case RECORD_START:
+                ok = this->readByte(event.engine);
+                break;
+            case RECORD_STOP:
+                break;
+            case RECORD_STATE:
+            case RECORD_INPUT:
+            case RECORD_OUTPUT:
+                ok = this->readName(event.name);
+                break;
+            case RECORD_TRANSITION: {
+                quint64 id;
+                ok = this->readVarint(id) && this->readName(event.name) && this->readName(event.target);
+                event.transition = unzigzag(id);
+                break;
+            }
+            case RECORD_VARIABLE: {
+                quint64 name;
+                ok = this->readByte(event.scope) && this->readVarint(name) && name < static_cast<quint64>(m_strings.size())
+                    && this->readValue(event.scope, static_cast<quint32>(name), event.value);
+                if(ok)
+                    event.name = m_strings.at(static_cast<int>(name));
+                break;
+            }
+        }
+
+        if(!ok)
+            return this->fail(QString("Malformed record at offset %1").arg(start));
+
+        return true;
+    }
+}
@@ -0,0 +1,101 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file trace_reader.h
+* @author  xcervia00
+*
+* @brief Decodes the binary trace of interpretation runs (interface)
+*
+*/
+
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QVariant>
+#include <QByteArray>
+
+#include "trace_format.h"
+
+/**
+ * @brief Single decoded record of the trace
+ */
+struct TraceEvent
+{
+    FsmTrace::RecordType type = FsmTrace::RECORD_END; ///< Type of the record (never RECORD_STRING)
+    qint64 time = 0; ///< Microseconds since the trace was opened
+    quint8 engine = 0; ///< Engine of RECORD_START (FsmEngineType)
+    qint64 transition = -1; ///< Id of the transition of RECORD_TRANSITION
+    quint8 scope = 0; ///< Scope of the variable of RECORD_VARIABLE (VariableScope)
+    QString name; ///< State, input, output or variable name; source state of a transition
+    QString target; ///< Destination state of a transition
+    QVariant value; ///< New value of the variable
+};
+
+/**
+ * @brief Reads the trace record by record; resolves interned names and delta encoded values
+ */
+class TraceReader
+{
+    private:
+        QByteArray m_data; ///< Contents of the file
+        qint64 m_offset = 0; ///< Position of the next record
+        qint64 m_end = 0; ///< End of the records
+        qint64 m_time = 0; ///< Time of the last timed record
+        qint64 m_startTime = 0; ///< Wall clock time the trace was opened
+        bool m_complete = false; ///< Was the trace closed properly?
+
+        QVector<QString> m_strings; ///< Interned names
+        QHash<quint64, QVariant> m_values; ///< Last value of every variable (by scope and name)
+        QString m_error; ///< Description of the last error
+
+        bool readByte(quint8 &value); ///< Reads a byte; false at the end of data
+        bool readVarint(quint64 &value); ///< Reads LEB128 integer; false if malformed
+        bool readString(quint64 size, QString &value); ///< Reads UTF-8 bytes; false if out of data
+        bool readName(QString &value); ///< Reads id of interned name; false if undefined
+        bool readValue(quint8 scope, quint32 name, QVariant &value); ///< Reads value of variable
+
+        /**
+         * @brief Stops reading because of malformed data
+         * @param message Description of the problem
+         * @return False
+         */
+        bool fail(const QString &message);
+
+    public:
+        /**
+         * @brief Loads the trace
+         * @param filename Path to the trace
+         * @return False if the file cannot be read or is not a trace (see error())
+         */
+        bool open(const QString &filename);
+
+        /**
+         * @brief Decodes the next record
+         * @param event The record
+         * @return False at the end of the trace or on malformed data (see error())
+         */
+        bool next(TraceEvent &event);
+
+        /**
+         * @brief Wall clock time the trace was opened
+         * @return Milliseconds since epoch
+         */
+        qint64 startTime() const;
+
+        /**
+         * @brief Was the trace closed properly? (otherwise it ends where the recording stopped)
+         * @return True if complete
+         */
+        bool isComplete() const;
+
+        /**
+         * @brief Description of the last error
+         * @return The error; empty if there was none
+         */
+        QString error() const;
+};
+
+#endif // TRACE_READER_H
@@ -0,0 +1,388 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file trace_recorder.cpp
+* @author  xcervia00
+*
+* @brief Records interpretation runs into a compact binary trace
+*
+*/
+
+#include "trace_recorder.h"
+
+#include <QDateTime>
+#include <QtEndian>
+#include <QDebug>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+using namespace FsmTrace;
+
+/**
+ * @brief Maps signed integer to unsigned so that small magnitudes stay small
+ * @param value The integer
+ * @return Zigzag encoded integer
+ */
+static quint64 zigzag(qint64 value)
+{
+    return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    this->close();
+}
+
+/*
+============================
+          FILE
+============================
+*/
+
+bool TraceRecorder::open(const QString &filename)
+{
+    this->close();
+
+    m_file.setFileName(filename);
+    if(!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+        return false;
+
+    m_capacity = CHUNK;
+    if(!m_file.resize(m_capacity) || (m_map = m_file.map(0, m_capacity)) == nullptr)
+    {
+        m_map = nullptr;
+        m_file.close();
+        return false;
+    }
+
+    Header header;
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.version = qToLittleEndian(VERSION);
+    header.headerSize = qToLittleEndian(static_cast<quint16>(sizeof(Header)));
+    header.startTime = qToLittleEndian(QDateTime::currentMSecsSinceEpoch());
+    header.length = 0;
+    std::memcpy(m_map, &header, sizeof(Header));
+    m_length = sizeof(Header);
+
+    m_strings.clear();
+    m_previous.clear();
+    m_clockStart = m_clock->nsecsElapsed();
+    m_timeBase = 0;
+    m_lastTime = 0;
+    return true;
+}
+
+void TraceRecorder::close()
+{
+    if(m_map == nullptr)
+    {
+        if(m_file.isOpen())
+            m_file.close();
+        return;
+    }
+
+    // Length marks the trace as complete
+    quint64 length = qToLittleEndian(static_cast<quint64>(m_length - sizeof(Header)));
+    std::memcpy(m_map + offsetof(Header, length), &length, sizeof(length));
+
+    m_file.unmap(m_map);
+    m_map = nullptr;
+    m_file.resize(m_length);
+    m_file.close();
+}
+
+qint64 TraceRecorder::size() const
+{
+    return m_length;
+}
+
+qint64 TraceRecorder::currentTime() const
+{
+    return m_timeBase + (m_clock->nsecsElapsed() - m_clockStart) / 1000;
+}
+
+void TraceRecorder::setClock(const FsmClock *clock)
+{
+    m_timeBase = this->currentTime();
+    m_clock = clock != nullptr ? clock : FsmClock::system();
+    m_clockStart = m_clock->nsecsElapsed();
+}
+
+bool TraceRecorder::reserve(qint64 size)
+{
+    if(m_length + size <= m_capacity)
+        return true;
+
+    // Grow the file and map it again
+    m_file.unmap(m_map);
+    m_capacity += std::max(CHUNK, size);
+    m_map = m_file.resize(m_capacity) ? m_file.map(0, m_capacity) : nullptr;
+
+    if(m_map == nullptr)
+    {
+        qWarning() << "TRACE: Failed to grow trace file " << m_file.fileName() << ", recording stopped";
+        m_file.close();
+        return false;
+    }
+
+    return true;
+}
+
+/*
+============================
+         ENCODING
+============================
+*/
+
+void TraceRecorder::putByte(quint8 value)
+{
+    m_map[m_length++] = value;
+}
+
+void TraceRecorder::putVarint(quint64 value)
+{
+    while(value >= 0x80)
+    {
+        m_map[m_length++] = static_cast<uchar>(value | 0x80);
+        value >>= 7;
+    }
+    m_map[m_length++] = static_cast<uchar>(value);
+}
+
+void TraceRecorder::putBytes(const char *data, int size)
+{
+    std::memcpy(m_map + m_length, data, static_cast<size_t>(size));
+    m_length += size;
+}
+
+quint32 TraceRecorder::intern(const QString &name)
+{
+    auto it = m_strings.constFind(name);
+    if(it != m_strings.constEnd())
+        return it.value();
+
+    quint32 id = static_cast<quint32>(m_strings.size());
+    m_strings.insert(name, id);
+
+    QByteArray bytes = name.toUtf8();
+    if(this->reserve(1 + 10 + 10 + bytes.size()))
+    {
+        this->putByte(RECORD_STRING);
+        this->putVarint(id);
+        this->putVarint(static_cast<quint64>(bytes.size()));
+        this->putBytes(bytes.constData(), bytes.size());
+    }
+
+    return id;
+}
+
+bool TraceRecorder::begin(RecordType type, qint64 extra)
+{
+    if(m_map == nullptr || !this->reserve(1 + 10 + extra))
+        return false;
+
+    qint64 now = this->currentTime();
+    this->putByte(type);
+    this->putVarint(static_cast<quint64>(now - m_lastTime));
+    m_lastTime = now;
+    return true;
+}
+
+TraceRecorder::Previous &TraceRecorder::previous(quint8 scope, quint32 id)
+{
+    return m_previous[(static_cast<quint64>(scope) << 32) | id];
+}
+
+bool TraceRecorder::beginVariable(quint8 scope, quint32 id, qint64 extra)
+{
+    if(!this->begin(RECORD_VARIABLE, 1 + 5 + 1 + extra))
+        return false;
+
+    this->putByte(scope);
+    this->putVarint(id);
+    return true;
+}
+
+/*
+============================
+          RECORDS
+============================
+*/
+
+void TraceRecorder::recordStart(quint8 engine)
+{
+    if(this->begin(RECORD_START, 1))
+        this->putByte(engine);
+}
+
+void TraceRecorder::recordStop()
+{
+    this->begin(RECORD_STOP, 0);
+}
+
+void TraceRecorder::recordState(const QString &state)
+{
+    if(m_map == nullptr)
+        return;
+
+    quint32 id = this->intern(state);
+    if(this->begin(RECORD_STATE, 5))
+        this->putVarint(id);
+}
+
+void TraceRecorder::recordTransition(qint64 id, const QString &source, const QString &target)
+{
+    if(m_map == nullptr)
+        return;
+
+    quint32 sourceId = this->intern(source);
+    quint32 targetId = this->intern(target);
+    if(this->begin(RECORD_TRANSITION, 10 + 5 + 5))
+    {
+        this->putVarint(zigzag(id));
+        this->putVarint(sourceId);
+        this->putVarint(targetId);
+    }
+}
+
+void TraceRecorder::recordInput(const QString &name)
+{
+    if(m_map == nullptr)
+        return;
+
+    quint32 id = this->intern(name);
+    if(this->begin(RECORD_INPUT, 5))
+        this->putVarint(id);
+}
+
+void TraceRecorder::recordOutput(const QString &name)
+{
+    if(m_map == nullptr)
+        return;
+
+    quint32 id = this->intern(name);
+    if(this->begin(RECORD_OUTPUT, 5))
+        this->putVarint(id);
+}
+
+void TraceRecorder::recordInt(quint8 scope, const QString &name, qint64 value)
+{
+    if(m_map == nullptr)
+        return;
+
+    quint32 id = this->intern(name);
+    Previous &last = this->previous(scope, id);
+    if(!this->beginVariable(scope, id, 10))
+        return;
+
+    if(last.kind == VALUE_INT && last.integer == value)
+    {
+        this->putByte(VALUE_SAME);
+    }
+    else if(last.kind == VALUE_INT)
+    {
+        this->putByte(VALUE_INT_DELTA);
+        this->putVarint(zigzag(value - last.integer));
+    }
+    else
+    {
+        this->putByte(VALUE_INT);
+        this->putVarint(zigzag(value));
+    }
+
+    last.kind = VALUE_INT;
+    last.integer = value;
+}
+
+void TraceRecorder::recordFloat(quint8 scope, const QString &name, double value)
+{
+    if(m_map == nullptr)
+        return;
+
+    quint32 id = this->intern(name);
+    Previous &last = this->previous(scope, id);
+    if(!this->beginVariable(scope, id, 8))
+        return;
+
+    if(last.kind == VALUE_FLOAT && last.number == value)
+    {
+        this->putByte(VALUE_SAME);
+    }
+    else
+    {
+        quint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bits = qToLittleEndian(bits);
+
+        this->putByte(VALUE_FLOAT);
+        this->putBytes(reinterpret_cast<const char*>(&bits), sizeof(bits));
+    }
+
+    last.kind = VALUE_FLOAT;
+    last.number = value;
+}
+
+void TraceRecorder::recordBool(quint8 scope, const QString &name, bool value)
+{
+    if(m_map == nullptr)
+        return;
+
+    quint32 id = this->intern(name);
+    Previous &last = this->previous(scope, id);
+    if(!this->beginVariable(scope, id, 0))
+        return;
+
+    ValueKind kind = value ? VALUE_TRUE : VALUE_FALSE;
+    this->putByte(last.kind == kind ? VALUE_SAME : kind);
+    last.kind = kind;
+}
+
+void TraceRecorder::recordString(quint8 scope, const QString &name, const QString &value)
+{
+    if(m_map == nullptr)
+        return;
+
+    quint32 id = this->intern(name);
+    Previous &last = this->previous(scope, id);
+
+    if(last.kind == VALUE_STRING && last.string == value)
+    {
+        if(this->beginVariable(scope, id, 0))
+            this->putByte(VALUE_SAME);
+        return;
+    }
+
+    // Keep common prefix of the previous value (counters, growing buffers, ...)
+    int prefix = 0;
+    if(last.kind == VALUE_STRING)
+    {
+        int limit = std::min(last.string.size(), value.size());
+        while(prefix < limit && last.string.at(prefix) == value.at(prefix))
+            prefix++;
+
+        // Never split a surrogate pair
+        if(prefix > 0 && value.at(prefix - 1).isHighSurrogate())
+            prefix--;
+    }
+
+    QByteArray bytes = value.midRef(prefix).toUtf8();
+    if(!this->beginVariable(scope, id, 10 + 10 + bytes.size()))
+        return;
+
+    if(prefix > 0)
+    {
+        this->putByte(VALUE_STRING_SUFFIX);
+        this->putVarint(static_cast<quint64>(prefix));
+    }
+    else
+    {
+        this->putByte(VALUE_STRING);
+    }
+    this->putVarint(static_cast<quint64>(bytes.size()));
+    this->putBytes(bytes.constData(), bytes.size());
+
+    last.kind = VALUE_STRING;
+    last.string = value;
+}
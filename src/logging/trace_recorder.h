@@ -0,0 +1,170 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file trace_recorder.h
+* @author  xcervia00
+*
+* @brief Records interpretation runs into a compact binary trace (interface)
+*
+*/
+
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <QString>
+#include <QHash>
+#include <QFile>
+
+#include "trace_format.h"
+#include "fsm_clock.h"
+
+/**
+ * @brief Writes the binary trace (see FsmTrace) into an append-only memory-mapped file
+ * @note Records are encoded straight into the mapping (the file grows by chunks), so recording costs
+ * a few hash lookups and a copy; the kernel writes the pages out even if the process crashes.
+ * All methods are called from the thread of the model and do nothing unless recording.
+ */
+class TraceRecorder
+{
+    private:
+        static constexpr qint64 CHUNK = 1 << 20; ///< The file grows by this many bytes
+
+        /**
+         * @brief Last recorded value of a variable (for delta encoding)
+         */
+        struct Previous
+        {
+            FsmTrace::ValueKind kind = FsmTrace::VALUE_SAME; ///< Kind of the value; VALUE_SAME if none yet
+            qint64 integer = 0; ///< Integer value
+            double number = 0; ///< Float value
+            QString string; ///< String value
+        };
+
+        QFile m_file; ///< The trace file
+        uchar *m_map = nullptr; ///< Mapping of the whole file; nullptr if not recording
+        qint64 m_capacity = 0; ///< Size of the file (and the mapping)
+        qint64 m_length = 0; ///< Bytes written (including the header)
+
+        const FsmClock *m_clock = FsmClock::system(); ///< Time source of the records
+        qint64 m_clockStart = 0; ///< Time of the clock at m_timeBase (nanoseconds)
+        qint64 m_timeBase = 0; ///< Trace time at which the clock was set (microseconds)
+        qint64 m_lastTime = 0; ///< Time of the last timed record (microseconds)
+
+        /**
+         * @brief Current time of the trace
+         * @return Microseconds since the trace was opened
+         */
+        qint64 currentTime() const;
+
+        QHash<QString, quint32> m_strings; ///< Interned names
+        QHash<quint64, Previous> m_previous; ///< Last value of every variable (by scope and name)
+
+        /**
+         * @brief Makes sure given number of bytes can be written
+         * @param size Number of bytes
+         * @return False if the file could not grow (recording is stopped)
+         */
+        bool reserve(qint64 size);
+
+        /**
+         * @brief Writes a byte (space must be reserved)
+         * @param value The byte
+         */
+        void putByte(quint8 value);
+
+        /**
+         * @brief Writes LEB128 integer (space must be reserved)
+         * @param value The integer
+         */
+        void putVarint(quint64 value);
+
+        /**
+         * @brief Writes bytes (space must be reserved)
+         * @param data The bytes
+         * @param size Number of bytes
+         */
+        void putBytes(const char *data, int size);
+
+        /**
+         * @brief Id of interned name; the name is defined on its first use
+         * @param name The name
+         * @return The id
+         */
+        quint32 intern(const QString &name);
+
+        /**
+         * @brief Starts timed record
+         * @param type Type of the record
+         * @param extra Upper estimate of the bytes following the time
+         * @return False if the record cannot be written
+         */
+        bool begin(FsmTrace::RecordType type, qint64 extra);
+
+        /**
+         * @brief Last recorded value of a variable
+         * @param scope Scope of the variable
+         * @param id Interned name of the variable
+         * @return The value (VALUE_SAME kind if none yet)
+         */
+        Previous &previous(quint8 scope, quint32 id);
+
+        /**
+         * @brief Starts variable record (value kind follows)
+         * @param scope Scope of the variable
+         * @param id Interned name of the variable
+         * @param extra Upper estimate of the bytes of the value
+         * @return False if the record cannot be written
+         */
+        bool beginVariable(quint8 scope, quint32 id, qint64 extra);
+
+    public:
+        TraceRecorder() = default;
+        ~TraceRecorder();
+
+        TraceRecorder(const TraceRecorder&) = delete;
+        TraceRecorder &operator=(const TraceRecorder&) = delete;
+
+        /**
+         * @brief Creates the trace file (an existing one is overwritten)
+         * @param filename Path to the file
+         * @return False if the file cannot be created or mapped
+         */
+        bool open(const QString &filename);
+
+        /**
+         * @brief Finishes the trace; the file is truncated to the written records
+         */
+        void close();
+
+        /**
+         * @brief Is the trace being recorded?
+         * @return True if recording
+         */
+        inline bool isRecording() const {return m_map != nullptr;}
+
+        /**
+         * @brief Number of bytes written so far
+         * @return The size of the trace
+         */
+        qint64 size() const;
+
+        /**
+         * @brief Changes the time source of the records; the time continues from the current one
+         * @param clock The clock (not owned); nullptr for FsmClock::system()
+         */
+        void setClock(const FsmClock *clock);
+
+        void recordStart(quint8 engine); ///< Interpretation was started by given engine
+        void recordStop(); ///< Interpretation was stopped
+        void recordState(const QString &state); ///< State was entered
+        void recordTransition(qint64 id, const QString &source, const QString &target); ///< Transition was taken
+        void recordInput(const QString &name); ///< Input event was accepted
+        void recordOutput(const QString &name); ///< Output event was fired
+
+        void recordInt(quint8 scope, const QString &name, qint64 value); ///< Integer variable was set
+        void recordFloat(quint8 scope, const QString &name, double value); ///< Float variable was set
+        void recordBool(quint8 scope, const QString &name, bool value); ///< Boolean variable was set
+        void recordString(quint8 scope, const QString &name, const QString &value); ///< String variable was set
+};
+
+#endif // TRACE_RECORDER_H
@@ -9,7 +9,7 @@
  */
 
 #include "editorwindow.h"
-#include "model.h"
+#include "model_thread.h"
 
 #include <QApplication>
 
@@ -21,11 +21,11 @@ int main(int argc, char *argv[])
     // QApplication (must be first)
     QApplication a(argc, argv);
 
+    FsmModelThread m; // Create model (interpreted on its own thread)
     EditorWindow w; // Create view/controller
-    FsmModel m; // Create model
 
     // register references
-    w.registerModel(&m);
+    w.registerModel(m.model());
     m.registerView(&w);
     
     w.show();
@@ -0,0 +1,82 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file change_log.cpp
+ * @author xcervia00
+ *
+ * @brief Versioned log of edits of the FSM
+ *
+ */
+
+#include "change_log.h"
+
+#include <random>
+
+QDataStream &operator<<(QDataStream &out, const FsmChange &change)
+{
+    return out << static_cast<quint8>(change.type) << change.id << change.name << change.text << change.value;
+}
+
+QDataStream &operator>>(QDataStream &in, FsmChange &change)
+{
+    quint8 type;
+    in >> type >> change.id >> change.name >> change.text >> change.value;
+
+    // Unknown kinds are reported as malformed data
+    change.type = type < CHANGE_COUNT ? static_cast<ChangeType>(type) : CHANGE_COUNT;
+    if(change.type == CHANGE_COUNT)
+        in.setStatus(QDataStream::ReadCorruptData);
+
+    return in;
+}
+
+ChangeLog::ChangeLog(int capacity)
+    : m_capacity{capacity}
+{
+    std::random_device dev;
+    std::uniform_int_distribution<quint32> dist(1, UINT32_MAX);
+    m_session = dist(dev);
+}
+
+void ChangeLog::append(const FsmChange &change)
+{
+    if(m_changes.size() >= m_capacity)
+    {
+        m_changes.dequeue();
+        m_base++;
+    }
+
+    m_changes.enqueue(change);
+    m_version++;
+}
+
+void ChangeLog::reset()
+{
+    m_changes.clear();
+    m_base = ++m_version;
+}
+
+bool ChangeLog::covers(quint32 session, quint64 since) const
+{
+    return session == m_session && since >= m_base && since <= m_version;
+}
+
+void ChangeLog::write(QDataStream &out, quint64 since) const
+{
+    // Edit i (from the oldest) produced version m_base + i + 1
+    int first = static_cast<int>(since - m_base);
+
+    out << static_cast<quint32>(m_changes.size() - first);
+    for(int i = first; i < m_changes.size(); i++)
+        out << m_changes.at(i);
+}
+
+quint64 ChangeLog::version() const
+{
+    return m_version;
+}
+
+quint32 ChangeLog::session() const
+{
+    return m_session;
+}
@@ -0,0 +1,120 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file change_log.h
+ * @author xcervia00
+ *
+ * @brief Versioned log of edits of the FSM (interface)
+ *
+ */
+
+#ifndef CHANGE_LOG_H_
+#define CHANGE_LOG_H_
+
+#include <QString>
+#include <QVariant>
+#include <QQueue>
+#include <QDataStream>
+
+/**
+ * @brief Kind of edit (one for every update/destroy method of FsmInterface that changes the definition)
+ */
+enum ChangeType : uint8_t
+{
+    CHANGE_STATE, ///< name, value = position
+    CHANGE_STATE_NAME, ///< name = old name, text = new name
+    CHANGE_ACTION, ///< name = state, text = action
+    CHANGE_INITIAL_STATE, ///< name = state
+    CHANGE_TRANSITION, ///< id, name = source state, text = destination state
+    CHANGE_CONDITION, ///< id, text = condition
+    CHANGE_VAR_INPUT, ///< name, text = value
+    CHANGE_VAR_OUTPUT, ///< name, text = value
+    CHANGE_VAR_INTERNAL, ///< name, value
+    CHANGE_FSM_NAME, ///< name
+    CHANGE_DESTROY_STATE, ///< name
+    CHANGE_DESTROY_ACTION, ///< name = state
+    CHANGE_DESTROY_CONDITION, ///< id
+    CHANGE_DESTROY_TRANSITION, ///< id
+    CHANGE_DESTROY_VAR_INPUT, ///< name
+    CHANGE_DESTROY_VAR_OUTPUT, ///< name
+    CHANGE_DESTROY_VAR_INTERNAL, ///< name
+    CHANGE_COUNT ///< Count of all kinds
+};
+
+/**
+ * @brief Single edit of the FSM (arguments of the interface method)
+ */
+struct FsmChange
+{
+    ChangeType type = CHANGE_COUNT; ///< Kind of the edit
+    quint64 id = 0; ///< Id of the transition
+    QString name; ///< Name of the state/variable/machine
+    QString text; ///< Second string argument
+    QVariant value; ///< Position of the state or value of internal variable
+};
+
+QDataStream &operator<<(QDataStream &out, const FsmChange &change);
+QDataStream &operator>>(QDataStream &in, FsmChange &change);
+
+/**
+ * @brief Keeps the latest edits of the FSM, each numbered by the version of the FSM it produced
+ * @note Only a bounded number of edits is kept; a copy of the FSM older than the oldest kept edit
+ * (or older than the last reset) has to be copied whole. Session distinguishes logs of different
+ * processes, so versions are never compared across them.
+ */
+class ChangeLog
+{
+    private:
+        QQueue<FsmChange> m_changes; ///< Kept edits (the last one produced m_version)
+        quint64 m_version = 0; ///< Current version of the FSM
+        quint64 m_base = 0; ///< Oldest version the kept edits follow
+        quint32 m_session; ///< Random id of this log (never 0)
+        int m_capacity; ///< Maximal number of kept edits
+
+    public:
+        /**
+         * @brief Constructor
+         * @param capacity Maximal number of kept edits
+         */
+        explicit ChangeLog(int capacity = 4096);
+
+        /**
+         * @brief Appends an edit (the oldest one is dropped if full)
+         * @param change The edit
+         */
+        void append(const FsmChange &change);
+
+        /**
+         * @brief Drops all edits (the FSM was replaced as a whole)
+         */
+        void reset();
+
+        /**
+         * @brief Checks whether edits since given version are kept
+         * @param session Session the version belongs to
+         * @param since The version
+         * @return True if the FSM of the version can be brought up to date by edits
+         */
+        bool covers(quint32 session, quint64 since) const;
+
+        /**
+         * @brief Writes edits made since given version (must be covered)
+         * @param out The stream to write to
+         * @param since The version
+         */
+        void write(QDataStream &out, quint64 since) const;
+
+        /**
+         * @brief Current version of the FSM
+         * @return The version
+         */
+        quint64 version() const;
+
+        /**
+         * @brief Random id of this log
+         * @return The session
+         */
+        quint32 session() const;
+};
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file fsm_binary_format.h
+ * @author xcervia00
+ *
+ * @brief Layout of the binary snapshot of FSM (.fsmb)
+ *
+ */
+
+#ifndef FSM_BINARY_FORMAT_H_
+#define FSM_BINARY_FORMAT_H_
+
+#include <QtGlobal>
+
+/**
+ * @brief The binary format is a header followed by a table of flat sections; all values are little endian
+ * and every section starts at 8 byte aligned offset, so the mapped file can be read in place.
+ * Strings are interned into a single pool (UTF-16) and referenced by index everywhere else.
+ */
+namespace FsmBinary
+{
+    constexpr char MAGIC[4] = {'F', 'S', 'M', 'B'}; ///< File signature
+    constexpr quint16 VERSION = 1; ///< Current version of the format
+    constexpr quint32 ALIGNMENT = 8; ///< Alignment of sections
+
+    /**
+     * @brief Identifiers of sections
+     */
+    enum SectionId : quint32
+    {
+        SECTION_STRINGS = 1, ///< StringEntry[count] followed by UTF-16 data
+        SECTION_META, ///< Meta[1]
+        SECTION_VARIABLES, ///< Variable[count]
+        SECTION_STATES, ///< State[count]; the first one is the initial state
+        SECTION_TRANSITIONS, ///< Transition[count] ordered by the source state
+    };
+
+    /**
+     * @brief Beginning of the file
+     */
+    struct Header
+    {
+        char magic[4]; ///< MAGIC
+        quint16 version; ///< VERSION
+        quint16 headerSize; ///< sizeof(Header)
+        quint32 sectionCount; ///< Number of entries in the section table (directly follows the header)
+        quint32 reserved; ///< Zero
+    };
+
+    /**
+     * @brief Entry of the section table
+     */
+    struct Section
+    {
+        quint32 id; ///< SectionId
+        quint32 count; ///< Number of records in the section
+        quint32 offset; ///< Offset of the section from the beginning of the file
+        quint32 size; ///< Size of the section in bytes
+    };
+
+    /**
+     * @brief Position of a string within the data of the string pool
+     */
+    struct StringEntry
+    {
+        quint32 offset; ///< Offset in UTF-16 code units
+        quint32 length; ///< Length in UTF-16 code units
+    };
+
+    /**
+     * @brief Global information about the machine
+     */
+    struct Meta
+    {
+        quint32 name; ///< String index of the FSM name
+        quint32 reserved[3]; ///< Zero
+    };
+
+    /**
+     * @brief Variable of any scope (VariableScope/VariableType values of the registry)
+     */
+    struct Variable
+    {
+        quint32 name; ///< String index of the name
+        quint8 scope; ///< VariableScope
+        quint8 type; ///< VariableType
+        quint16 reserved; ///< Zero
+        quint32 text; ///< String index of the value (string variables, inputs, outputs)
+        qint32 integer; ///< Value of int and bool variables
+        double real; ///< Value of float variables
+    };
+
+    /**
+     * @brief State with its outgoing transitions (CSR adjacency)
+     */
+    struct State
+    {
+        quint32 name; ///< String index of the name
+        quint32 action; ///< String index of the action
+        qint32 x; ///< Position in the editor
+        qint32 y; ///< Position in the editor
+        quint32 firstTransition; ///< Index of the first outgoing transition
+        quint32 transitionCount; ///< Number of outgoing transitions
+    };
+
+    /**
+     * @brief Transition with already parsed condition
+     */
+    struct Transition
+    {
+        quint32 source; ///< Index of the source state
+        quint32 target; ///< Index of the destination state
+        quint32 input; ///< String index of the input name
+        quint32 guard; ///< String index of the guard
+        quint32 timeout; ///< String index of the timeout
+        quint32 reserved; ///< Zero
+    };
+
+    static_assert(sizeof(Header) == 16, "Unexpected padding of FsmBinary::Header");
+    static_assert(sizeof(Section) == 16, "Unexpected padding of FsmBinary::Section");
+    static_assert(sizeof(StringEntry) == 8, "Unexpected padding of FsmBinary::StringEntry");
+    static_assert(sizeof(Meta) == 16, "Unexpected padding of FsmBinary::Meta");
+    static_assert(sizeof(Variable) == 24, "Unexpected padding of FsmBinary::Variable");
+    static_assert(sizeof(State) == 24, "Unexpected padding of FsmBinary::State");
+    static_assert(sizeof(Transition) == 24, "Unexpected padding of FsmBinary::Transition");
+}
+
+#endif
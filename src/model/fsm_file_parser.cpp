@@ -0,0 +1,435 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file fsm_file_parser.cpp
+ * @author xcervia00
+ *
+ * @brief Single-pass tokenizer/parser of the .fsm file format
+ *
+ */
+
+#include "fsm_file_parser.h"
+
+#include <QLatin1String>
+
+/**
+ * @brief Same as \w of the original regular expressions (ASCII letters, digits and underscore)
+ * @param c The character to check
+ * @return True if it is a word character
+ */
+static inline bool isWordChar(QChar c)
+{
+    auto u = c.unicode();
+    return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z') || (u >= '0' && u <= '9') || u == '_';
+}
+
+/**
+ * @brief Same as \d of the original regular expressions
+ * @param c The character to check
+ * @return True if it is a digit
+ */
+static inline bool isDigitChar(QChar c)
+{
+    return c.unicode() >= '0' && c.unicode() <= '9';
+}
+
+FsmFileParser::FsmFileParser(const QString &text)
+    :
+    m_text{text}
+{
+}
+
+/*
+============================
+        LINE HANDLING
+============================
+*/
+
+bool FsmFileParser::nextLine()
+{
+    while(m_pos < m_text.size())
+    {
+        int lineEnd = m_text.indexOf('\n', m_pos);
+        if(lineEnd < 0)
+            lineEnd = m_text.size();
+
+        m_lineNumber++;
+        m_lineBegin = m_pos;
+        m_pos = lineEnd + 1;
+
+        // Trim the line (also drops '\r' of CRLF files)
+        int begin = m_lineBegin;
+        int end = lineEnd;
+        while(begin < end && m_text.at(begin).isSpace())
+            begin++;
+        while(end > begin && m_text.at(end - 1).isSpace())
+            end--;
+
+        if(begin == end)
+            continue;
+
+        m_cur = begin;
+        m_end = end;
+        return true;
+    }
+
+    return false;
+}
+
+bool FsmFileParser::sectionHeader()
+{
+    static const struct
+    {
+        QLatin1String header;
+        Section section;
+    } headers[] = {
+        {QLatin1String("Name:"), NAME},
+        {QLatin1String("Comment:"), COMMENT},
+        {QLatin1String("Input:"), INPUT},
+        {QLatin1String("Output:"), OUTPUT},
+        {QLatin1String("Variables:"), VARIABLES},
+        {QLatin1String("States:"), STATES},
+        {QLatin1String("Transitions:"), TRANSITIONS},
+    };
+
+    // Headers always end with ':' ==> cheap rejection of ordinary lines
+    if(m_text.at(m_end - 1) != ':')
+        return false;
+
+    auto line = m_text.midRef(m_cur, m_end - m_cur);
+    for(const auto &entry : headers)
+    {
+        if(line == entry.header)
+        {
+            m_section = entry.section;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool FsmFileParser::fail(const QString &message)
+{
+    QString entity;
+    switch(m_section)
+    {
+        case STATES:
+            entity = QStringLiteral("state");
+            break;
+        case TRANSITIONS:
+            entity = QStringLiteral("transition");
+            break;
+        default:
+            entity = QStringLiteral("variable");
+            break;
+    }
+
+    m_error = QStringLiteral("Failed to parse ") + entity + QStringLiteral(" from file: ") + message;
+    m_errorLine = m_lineNumber;
+    m_errorColumn = m_cur - m_lineBegin + 1;
+    return false;
+}
+
+/*
+============================
+       CURSOR HELPERS
+============================
+*/
+
+void FsmFileParser::skipSpaces()
+{
+    while(m_cur < m_end && m_text.at(m_cur).isSpace())
+        m_cur++;
+}
+
+bool FsmFileParser::atEnd() const
+{
+    return m_cur >= m_end;
+}
+
+bool FsmFileParser::accept(QChar c)
+{
+    if(this->atEnd() || m_text.at(m_cur) != c)
+        return false;
+
+    m_cur++;
+    return true;
+}
+
+bool FsmFileParser::identifier(QString &out, bool allowDash)
+{
+    int start = m_cur;
+    while(m_cur < m_end && (isWordChar(m_text.at(m_cur)) || (allowDash && m_text.at(m_cur) == '-')))
+        m_cur++;
+
+    if(m_cur == start)
+        return false;
+
+    out = m_text.mid(start, m_cur - start);
+    return true;
+}
+
+bool FsmFileParser::number(int &out)
+{
+    int start = m_cur;
+    while(m_cur < m_end && isDigitChar(m_text.at(m_cur)))
+        m_cur++;
+
+    if(m_cur == start)
+        return false;
+
+    bool ok;
+    out = m_text.midRef(start, m_cur - start).toInt(&ok, 10);
+    if(!ok)
+    {
+        // Overflow
+        m_cur = start;
+        return false;
+    }
+
+    return true;
+}
+
+bool FsmFileParser::block(QString &out)
+{
+    if(!this->accept('{'))
+        return this->fail(QStringLiteral("expected '{'"));
+
+    skipSpaces();
+
+    // The block spans up to the last '}' which has to end the line
+    if(this->atEnd() || m_text.at(m_end - 1) != '}')
+    {
+        m_cur = m_end;
+        return this->fail(QStringLiteral("expected '}' at the end of line"));
+    }
+
+    out = m_text.mid(m_cur, m_end - 1 - m_cur);
+    m_cur = m_end;
+    return true;
+}
+
+/*
+============================
+        LINE PARSERS
+============================
+*/
+
+bool FsmFileParser::parseInOut(FsmFileRecord &record)
+{
+    // NAME [= VALUE]
+    if(!this->identifier(record.name, true))
+        return this->fail(QStringLiteral("expected variable name"));
+
+    skipSpaces();
+    if(this->atEnd())
+        return true;
+
+    if(!this->accept('='))
+        return this->fail(QStringLiteral("expected '='"));
+
+    skipSpaces();
+    if(this->atEnd())
+        return this->fail(QStringLiteral("expected value"));
+
+    record.text = m_text.mid(m_cur, m_end - m_cur);
+    m_cur = m_end;
+    return true;
+}
+
+bool FsmFileParser::parseVariable(FsmFileRecord &record)
+{
+    // TYPE NAME = VALUE
+    QString type;
+    if(!this->identifier(type, false))
+        return this->fail(QStringLiteral("expected variable type"));
+
+    if(type != QLatin1String("int") && type != QLatin1String("float") && type != QLatin1String("bool") && type != QLatin1String("string"))
+    {
+        m_cur -= type.size();
+        return this->fail(QStringLiteral("unknown variable type"));
+    }
+
+    if(this->atEnd() || !m_text.at(m_cur).isSpace())
+        return this->fail(QStringLiteral("expected whitespace after variable type"));
+
+    skipSpaces();
+    if(!this->identifier(record.name, true))
+        return this->fail(QStringLiteral("expected variable name"));
+
+    skipSpaces();
+    if(!this->accept('='))
+        return this->fail(QStringLiteral("expected '='"));
+
+    skipSpaces();
+    if(this->atEnd())
+        return this->fail(QStringLiteral("expected value"));
+
+    QString value = m_text.mid(m_cur, m_end - m_cur);
+
+    // Convert value to the correct type
+    bool ok = true;
+    if(type == QLatin1String("int"))
+    {
+        record.value = QVariant(value.toInt(&ok, 10));
+    }
+    else if(type == QLatin1String("float"))
+    {
+        record.value = QVariant(value.toDouble(&ok));
+    }
+    else if(type == QLatin1String("bool"))
+    {
+        ok = value == QLatin1String("true") || value == QLatin1String("false");
+        record.value = QVariant(value == QLatin1String("true"));
+    }
+    else
+    {
+        record.value = QVariant(value);
+    }
+
+    if(!ok)
+        return this->fail(QStringLiteral("invalid ") + type + QStringLiteral(" value"));
+
+    m_cur = m_end;
+    return true;
+}
+
+bool FsmFileParser::parseState(FsmFileRecord &record)
+{
+    // NAME(X, Y): { ACTION }
+    int x;
+    int y;
+
+    if(!this->identifier(record.name, true))
+        return this->fail(QStringLiteral("expected state name"));
+
+    skipSpaces();
+    if(!this->accept('('))
+        return this->fail(QStringLiteral("expected '('"));
+
+    skipSpaces();
+    if(!this->number(x))
+        return this->fail(QStringLiteral("expected x coordinate"));
+
+    skipSpaces();
+    if(!this->accept(','))
+        return this->fail(QStringLiteral("expected ','"));
+
+    skipSpaces();
+    if(!this->number(y))
+        return this->fail(QStringLiteral("expected y coordinate"));
+
+    skipSpaces();
+    if(!this->accept(')'))
+        return this->fail(QStringLiteral("expected ')'"));
+
+    skipSpaces();
+    if(!this->accept(':'))
+        return this->fail(QStringLiteral("expected ':'"));
+
+    skipSpaces();
+    if(!this->block(record.text))
+        return false;
+
+    record.position = QPoint(x, y);
+    return true;
+}
+
+bool FsmFileParser::parseTransition(FsmFileRecord &record)
+{
+    // SOURCE -> DESTINATION: { CONDITION }
+    if(!this->identifier(record.name, false))
+        return this->fail(QStringLiteral("expected source state"));
+
+    skipSpaces();
+    if(!this->accept('-') || !this->accept('>'))
+        return this->fail(QStringLiteral("expected '->'"));
+
+    skipSpaces();
+    if(!this->identifier(record.target, false))
+        return this->fail(QStringLiteral("expected destination state"));
+
+    skipSpaces();
+    if(!this->accept(':'))
+        return this->fail(QStringLiteral("expected ':'"));
+
+    skipSpaces();
+    return this->block(record.text);
+}
+
+/*
+============================
+         PUBLIC API
+============================
+*/
+
+bool FsmFileParser::next(FsmFileRecord &record)
+{
+    while(!this->failed() && this->nextLine())
+    {
+        if(this->sectionHeader())
+            continue;
+
+        record = FsmFileRecord();
+        record.line = m_lineNumber;
+        record.column = m_cur - m_lineBegin + 1;
+
+        switch(m_section)
+        {
+            case NAME:
+                record.kind = FsmFileRecord::NAME;
+                record.name = m_text.mid(m_cur, m_end - m_cur);
+                return true;
+
+            case INPUT:
+                record.kind = FsmFileRecord::INPUT;
+                return this->parseInOut(record);
+
+            case OUTPUT:
+                record.kind = FsmFileRecord::OUTPUT;
+                return this->parseInOut(record);
+
+            case VARIABLES:
+                record.kind = FsmFileRecord::VARIABLE;
+                return this->parseVariable(record);
+
+            case STATES:
+                record.kind = FsmFileRecord::STATE;
+                return this->parseState(record);
+
+            case TRANSITIONS:
+                record.kind = FsmFileRecord::TRANSITION;
+                return this->parseTransition(record);
+
+            default:
+                // Comments and anything before the first section are ignored
+                break;
+        }
+    }
+
+    return false;
+}
+
+bool FsmFileParser::failed() const
+{
+    return !m_error.isEmpty();
+}
+
+QString FsmFileParser::errorString() const
+{
+    if(!this->failed())
+        return QString();
+
+    return QStringLiteral("%1 (line %2, column %3)").arg(m_error).arg(m_errorLine).arg(m_errorColumn);
+}
+
+int FsmFileParser::errorLine() const
+{
+    return m_errorLine;
+}
+
+int FsmFileParser::errorColumn() const
+{
+    return m_errorColumn;
+}
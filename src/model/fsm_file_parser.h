@@ -0,0 +1,154 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file fsm_file_parser.h
+ * @author xcervia00
+ *
+ * @brief Single-pass tokenizer/parser of the .fsm file format (interface)
+ *
+ */
+
+#ifndef FSM_FILE_PARSER_H_
+#define FSM_FILE_PARSER_H_
+
+#include <QString>
+#include <QVariant>
+#include <QPoint>
+
+/**
+ * @brief Single entity read from the file
+ */
+struct FsmFileRecord
+{
+    /**
+     * @brief Kind of the entity (given by the section it was read from)
+     */
+    enum Kind : uint8_t
+    {
+        NAME,
+        INPUT,
+        OUTPUT,
+        VARIABLE,
+        STATE,
+        TRANSITION,
+    };
+
+    Kind kind = NAME; ///< Kind of the entity
+    QString name; ///< Name of the FSM/variable/state, source state of transition
+    QString target; ///< Destination state of transition
+    QString text; ///< Value of input/output, action of state, condition of transition
+    QVariant value; ///< Typed value of internal variable
+    QPoint position; ///< Position of state
+    int line = 0; ///< Line the entity was read from (1-based)
+    int column = 0; ///< Column the entity begins at (1-based)
+};
+
+/**
+ * @brief Reads the .fsm format in a single pass over the text without building any regular expressions
+ * @note Accepts exactly what the original per-line regular expressions did
+ */
+class FsmFileParser
+{
+    public:
+        /**
+         * @brief Sections of the file format
+         */
+        enum Section : uint8_t
+        {
+            NONE,
+            NAME,
+            COMMENT,
+            INPUT,
+            OUTPUT,
+            VARIABLES,
+            STATES,
+            TRANSITIONS
+        };
+
+    private:
+        const QString m_text; ///< The whole file
+        int m_pos = 0; ///< Beginning of the next line
+        int m_lineNumber = 0; ///< Number of the current line
+        int m_lineBegin = 0; ///< Beginning of the current line (untrimmed)
+        int m_cur = 0; ///< Cursor within the current line
+        int m_end = 0; ///< End of the current line (trimmed)
+        Section m_section = NONE; ///< Section being read
+
+        QString m_error; ///< Error message (empty if there was no error)
+        int m_errorLine = 0; ///< Line of the error
+        int m_errorColumn = 0; ///< Column of the error
+
+        /**
+         * @brief Moves to the next line, skipping blank ones
+         * @return False at the end of the text
+         */
+        bool nextLine();
+        /**
+         * @brief Checks whether the current line is a section header (and switches the section)
+         * @return True if it was a header
+         */
+        bool sectionHeader();
+
+        /**
+         * @brief Records an error at the cursor
+         * @param message Description of the error
+         * @return Always false
+         */
+        bool fail(const QString &message);
+
+        // Cursor helpers (all of them work within the current line)
+
+        void skipSpaces();
+        bool atEnd() const;
+        bool accept(QChar c);
+        bool identifier(QString &out, bool allowDash);
+        bool number(int &out);
+        bool block(QString &out);
+
+        // Line parsers for individual sections
+
+        bool parseInOut(FsmFileRecord &record);
+        bool parseVariable(FsmFileRecord &record);
+        bool parseState(FsmFileRecord &record);
+        bool parseTransition(FsmFileRecord &record);
+
+    public:
+        /**
+         * @brief Constructor of the parser
+         * @param text Contents of the whole file
+         */
+        explicit FsmFileParser(const QString &text);
+
+        /**
+         * @brief Reads next entity from the file
+         * @param record The entity read
+         * @return False at the end of the file or on error (see failed())
+         */
+        bool next(FsmFileRecord &record);
+
+        /**
+         * @brief Did the parsing stop because of an error?
+         * @return True on error, otherwise false
+         */
+        bool failed() const;
+
+        /**
+         * @brief Error message including its location
+         * @return The message, or empty string if there was no error
+         */
+        QString errorString() const;
+
+        /**
+         * @brief Line of the error (1-based)
+         * @return The line
+         */
+        int errorLine() const;
+
+        /**
+         * @brief Column of the error (1-based)
+         * @return The column
+         */
+        int errorColumn() const;
+};
+
+#endif
@@ -18,6 +18,7 @@
 #include "mvc_interface.h"
 #include "model.h"
 #include "combined_event.h"
+#include "async_logger.h"
 
 
 /* Templates */
@@ -51,8 +52,11 @@ FsmModel::FsmModel()
     :
     engine{},
     machine{static_cast<QObject*>(&engine)},
+    timers{},
+    flatEngine{&engine, &timers},
     view{nullptr},
     scriptHelper{this, nullptr},
+    instances{&engine, &scriptHelper},
     uniqueTransId{0}
 {
     machine.setGlobalRestorePolicy(QState::RestoreProperties);
@@ -60,6 +64,24 @@ FsmModel::FsmModel()
     // Link model to QJSEngine
     QJSValue helperEngine = engine.newQObject(&this->scriptHelper);
     engine.globalObject().setProperty("icp", helperEngine);
+
+    // Native access to variables for simple guards
+    context.variables = &this->scriptHelper;
+
+    // Timeouts of all transitions are scheduled by a single wheel
+    context.timers = &this->timers;
+
+    // States and transitions record themselves into the trace
+    context.trace = &this->trace;
+
+    // Everything measures time by the same clock
+    context.clock = this->clock;
+
+    // Flat engine reports entered states the same way as states of the machine
+    QObject::connect(&flatEngine, &FlatEngine::stateEntered, this, [this](const QString &name)
+    {
+        this->notifyStateEntered(name);
+    });
 }
 
 FsmModel::~FsmModel()
@@ -83,20 +105,13 @@ void FsmModel::updateState(const QString &name, const QPoint &pos)
             // New
             [&]() -> ActionState* {
                 FORMAT_CHECK_EXCEPTION("MODEL: Invalid state name format", FORMAT_STATE, name);
-                auto tmp = new ActionState("", pos);
-                tmp->setObjectName(name);
-                this->machine.addState(tmp);
-                // When this state changes, update View's active state
-                QObject::connect(tmp, &QState::entered, this, [this]() 
-                {
-                    if(sender()){this->view->updateActiveState(sender()->objectName());}
-                });
-                return tmp;
+                return this->createState(name, pos);
             }
         );
     )
 
     qInfo() << "MODEL: Updated state " << name << " at position (" << pos.x() << ", " << pos.y() << ")";
+    this->recordChange({CHANGE_STATE, 0, name, QString(), pos});
     view->updateState(name, pos);
 
     // Set first state to be initial
@@ -130,6 +145,7 @@ void FsmModel::updateStateName(const QString &oldName, const QString &newName)
     }
 
     qInfo() << "MODEL: Renamed state " << oldName << " to " << newName;
+    this->recordChange({CHANGE_STATE_NAME, 0, oldName, newName, QVariant()});
     view->updateStateName(oldName, newName);
 }
 
@@ -151,6 +167,7 @@ void FsmModel::updateAction(const QString &parentState, const QString &action)
     )
 
     qInfo() << "MODEL: Updated action of state " << parentState;
+    this->recordChange({CHANGE_ACTION, 0, parentState, action, QVariant()});
     view->updateAction(parentState, action);
 }
 
@@ -170,6 +187,7 @@ void FsmModel::updateActiveState(const QString &name)
     )
 
     qInfo() << "MODEL: Set state " << name << " to ACTIVE";
+    this->recordChange({CHANGE_INITIAL_STATE, 0, name, QString(), QVariant()});
     view->updateActiveState(name);
 }
 
@@ -190,6 +208,7 @@ void FsmModel::updateCondition(size_t transitionId, const QString &condition)
     )
 
     qInfo() << "MODEL: Updated condition of transition " << transitionId;
+    this->recordChange({CHANGE_CONDITION, transitionId, QString(), condition, QVariant()});
     view->updateCondition(transitionId, condition);
 }
 
@@ -209,42 +228,79 @@ void FsmModel::updateTransition(size_t transitionId, const QString &srcState, co
             },
             // New
             [&]() -> CombinedTransition* {
-                auto tmp = new CombinedTransition(transitionId);
-                safeGetter(states, srcState, {ERROR_UNDEFINED_STATE, "MODEL: Failed to obtain source state"})->addTransition(tmp);
-                tmp->setTargetState(safeGetter(states, destState, {ERROR_UNDEFINED_STATE, "MODEL: Failed to obtain destination state"}));
-                return tmp;
+                return this->createTransition(transitionId,
+                    safeGetter(states, srcState, {ERROR_UNDEFINED_STATE, "MODEL: Failed to obtain source state"}),
+                    safeGetter(states, destState, {ERROR_UNDEFINED_STATE, "MODEL: Failed to obtain destination state"}));
             }
         );
     )
 
     qInfo() << "MODEL: Updated transition " << transitionId << " from " << srcState << " to " << destState;
+    this->recordChange({CHANGE_TRANSITION, transitionId, srcState, destState, QVariant()});
     view->updateTransition(transitionId, srcState, destState);
 }
 
 void FsmModel::updateVarInput(const QString &name, const QString &value)
 {
-    FORMAT_CHECK("MODEL: Invalid Input variable name", FORMAT_VARIABLE, name);
-    varsInput.insert(name, value);
+    int slot = vars.slot(VAR_SCOPE_INPUT, name);
 
-    qInfo() << "MODEL: Set input variable " << name << " to " << value;
+    // Names of existing variables were already checked
+    if(slot < 0)
+    {
+        FORMAT_CHECK("MODEL: Invalid Input variable name", FORMAT_VARIABLE, name);
+        slot = vars.define(VAR_SCOPE_INPUT, name);
+    }
+    vars.setString(VAR_SCOPE_INPUT, slot, value);
+
+    logEvent(LOG_VAR_INPUT, name, value);
+    this->recordChange({CHANGE_VAR_INPUT, 0, name, value, QVariant()});
     view->updateVarInput(name, value);
 }
 
+void FsmModel::updateVarInputs(const FsmInputBatch &inputs)
+{
+    auto stored = this->storeInputs(inputs);
+    if(stored.isEmpty())
+        return;
+
+    logEvent(LOG_VAR_INPUTS, QString(), QString(), stored.size());
+
+    // Copies of the machine get every value, as with single updates
+    for(const auto &input : stored)
+        this->recordChange({CHANGE_VAR_INPUT, 0, input.first, input.second, QVariant()});
+}
+
 void FsmModel::updateVarOutput(const QString &name, const QString &value)
 {
-    FORMAT_CHECK("MODEL: Invalid Output variable name", FORMAT_VARIABLE, name);
-    varsOutput.insert(name, value);
+    int slot = vars.slot(VAR_SCOPE_OUTPUT, name);
+
+    // Names of existing variables were already checked
+    if(slot < 0)
+    {
+        FORMAT_CHECK("MODEL: Invalid Output variable name", FORMAT_VARIABLE, name);
+        slot = vars.define(VAR_SCOPE_OUTPUT, name);
+    }
+    vars.setString(VAR_SCOPE_OUTPUT, slot, value);
 
-    qInfo() << "MODEL: Set ouput variable " << name << " to " << value;
+    logEvent(LOG_VAR_OUTPUT, name, value);
+    this->recordChange({CHANGE_VAR_OUTPUT, 0, name, value, QVariant()});
     view->updateVarOutput(name, value);
 }
 
 void FsmModel::updateVarInternal(const QString &name, const QVariant &value)
 {
-    FORMAT_CHECK("MODEL: Invalid Internal variable name", FORMAT_VARIABLE, name);
-    varsInternal.insert(name, value);
+    int slot = vars.slot(VAR_SCOPE_INTERNAL, name);
+
+    // Names of existing variables were already checked
+    if(slot < 0)
+    {
+        FORMAT_CHECK("MODEL: Invalid Internal variable name", FORMAT_VARIABLE, name);
+        slot = vars.define(VAR_SCOPE_INTERNAL, name);
+    }
+    vars.setValueAt(VAR_SCOPE_INTERNAL, slot, value);
 
-    qInfo() << "MODEL: Set internal variable " << name << " to " << value.toString();
+    logEvent(LOG_VAR_INTERNAL, name, value);
+    this->recordChange({CHANGE_VAR_INTERNAL, 0, name, QString(), value});
     view->updateVarInternal(name, value);
 }
 
@@ -253,6 +309,13 @@ void FsmModel::destroyState(const QString &name)
     CATCH_MODEL(
         auto it = safeGetter(this->states, name, {ERROR_UNDEFINED_STATE, "MODULE: Failed to obtain state to destroy"});
 
+        // Instances would enter a state that is no longer part of any machine
+        if(this->instances.isDefined())
+        {
+            qWarning() << "MODEL: State of the running instances destroyed, destroying " << this->instances.count() << " instances";
+            this->instances.clear();
+        }
+
         // Destroy all transitions attached to this state
         for (auto &trans : it->transitions()) {
             destroyTransition(static_cast<CombinedTransition*>(trans)->getId());
@@ -277,6 +340,7 @@ void FsmModel::destroyState(const QString &name)
     )
 
     qInfo() << "MODEL: Destroyed state" << name;
+    this->recordChange({CHANGE_DESTROY_STATE, 0, name, QString(), QVariant()});
     view->destroyState(name);
 }
 
@@ -287,6 +351,7 @@ void FsmModel::destroyAction(const QString &parentState)
     )
 
     qInfo() << "MODEL: Destroyed action of state " << parentState;
+    this->recordChange({CHANGE_DESTROY_ACTION, 0, parentState, QString(), QVariant()});
     view->destroyAction(parentState);
 }
 
@@ -299,6 +364,7 @@ void FsmModel::destroyCondition(size_t transitionId)
     )
 
     qInfo() << "MODEL: Destroyed condition of transition " << transitionId;
+    this->recordChange({CHANGE_DESTROY_CONDITION, transitionId, QString(), QString(), QVariant()});
     view->destroyCondition(transitionId);
 }
 
@@ -320,29 +386,110 @@ void FsmModel::destroyTransition(size_t transitionId)
     )
 
     qInfo() << "MODEL: Destroyed transition " << transitionId;
+    this->recordChange({CHANGE_DESTROY_TRANSITION, transitionId, QString(), QString(), QVariant()});
     view->destroyTransition(transitionId);
 }
 
 void FsmModel::destroyVarInput(const QString &name)
 {
-    this->varsInput.remove(name);
+    this->vars.remove(VAR_SCOPE_INPUT, name);
 
     qInfo() << "MODEL: Destroyed input variable " << name;
+    this->recordChange({CHANGE_DESTROY_VAR_INPUT, 0, name, QString(), QVariant()});
     view->destroyVarInput(name);
 }
 
 void FsmModel::destroyVarOutput(const QString &name)
 {
-    this->varsOutput.remove(name);
+    this->vars.remove(VAR_SCOPE_OUTPUT, name);
 
     qInfo() << "MODEL: Destroyed output variable " << name;
+    this->recordChange({CHANGE_DESTROY_VAR_OUTPUT, 0, name, QString(), QVariant()});
     view->destroyVarOutput(name);
 }
 
 void FsmModel::destroyVarInternal(const QString &name)
 {
-    this->varsInternal.remove(name);
+    this->vars.remove(VAR_SCOPE_INTERNAL, name);
 
     qInfo() << "MODEL: Destroyed internal variable " << name;
+    this->recordChange({CHANGE_DESTROY_VAR_INTERNAL, 0, name, QString(), QVariant()});
     view->destroyVarInternal(name);
 }
+
+void FsmModel::notifyVarUpdate(VariableScope scope, int slot)
+{
+    this->traceVariable(scope, slot);
+
+    const QString &name = vars.name(scope, slot);
+
+    switch(scope)
+    {
+        case VAR_SCOPE_INPUT:
+            logEvent(LOG_VAR_INPUT, name, vars.stringAt(scope, slot));
+            break;
+        case VAR_SCOPE_OUTPUT:
+            logEvent(LOG_VAR_OUTPUT, name, vars.stringAt(scope, slot));
+            break;
+        default:
+            logEvent(LOG_VAR_INTERNAL, name, vars.valueAt(scope, slot));
+            break;
+    }
+
+    // Displayed once per flush, however often the script writes it
+    if(this->viewUpdates.markVariable(scope, slot))
+        view->updatesPending();
+}
+
+void FsmModel::notifyStateEntered(const QString &name)
+{
+    if(this->viewUpdates.markState(name))
+        view->updatesPending();
+}
+
+ActionState *FsmModel::createState(const QString &name, const QPoint &pos)
+{
+    auto tmp = new ActionState("", pos);
+    tmp->setObjectName(name);
+    tmp->setTimerGroup(this->timers.createGroup());
+    tmp->setContext(&this->context);
+    this->machine.addState(tmp);
+    // When this state changes, update View's active state
+    QObject::connect(tmp, &QState::entered, this, [this]() 
+    {
+        if(sender()){this->notifyStateEntered(sender()->objectName());}
+    });
+    return tmp;
+}
+
+CombinedTransition *FsmModel::createTransition(size_t transitionId, ActionState *srcState, ActionState *destState)
+{
+    auto tmp = new CombinedTransition(transitionId);
+    tmp->setContext(&this->context);
+    srcState->addTransition(tmp);
+    tmp->setTargetState(destState);
+    return tmp;
+}
+
+FsmInputBatch FsmModel::storeInputs(const FsmInputBatch &inputs)
+{
+    FsmInputBatch stored;
+    stored.reserve(inputs.size());
+
+    for (const auto &input : inputs)
+    {
+        int slot = vars.slot(VAR_SCOPE_INPUT, input.first);
+        if(slot < 0)
+            continue;
+
+        vars.setString(VAR_SCOPE_INPUT, slot, input.second);
+        this->traceVariable(VAR_SCOPE_INPUT, slot);
+        stored.append(input);
+
+        // Displayed once per flush, however many batches arrive until then
+        if(this->viewUpdates.markVariable(VAR_SCOPE_INPUT, slot))
+            view->updatesPending();
+    }
+
+    return stored;
+}
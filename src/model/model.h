@@ -16,6 +16,15 @@
 #include "interpreter/action_state.h"
 #include "interpreter/combined_transition.h"
 #include "interpreter/script_helper.h"
+#include "interpreter/interpreter_context.h"
+#include "interpreter/flat_engine.h"
+#include "interpreter/fsm_instance_pool.h"
+#include "interpreter/fsm_executor.h"
+#include "interpreter/timer_wheel.h"
+#include "logging/trace_recorder.h"
+#include "variable_registry.h"
+#include "change_log.h"
+#include "update_coalescer.h"
 #include "exceptions/fsm_exceptions.h"
 
 #include <QJSEngine>
@@ -57,9 +66,7 @@
  */
 struct ContextBackup
 {
-    QHash<QString,QVariant> vInternal; ///< Internal variable backup
-    QHash<QString,QString> vInput; ///< Input variable backup
-    QHash<QString,QString> vOutput; ///< Output variable backup
+    VariableRegistry vars; ///< Variable backup (all scopes)
     QAbstractState* initialState; ///< Original initial state
 };
 
@@ -75,17 +82,24 @@ class FsmModel : public QObject, public FsmInterface
     protected:
         QJSEngine engine; ///< Native javascript interpreter for evaluating conditions/actions
         QStateMachine machine; ///< Main FSM machine to be interpreted
+        TimerWheel timers; ///< Scheduler of transition timeouts (shared by both engines)
+        FlatEngine flatEngine; ///< Alternative engine interpreting the machine from a compiled flat table
+        FsmEngineType engineType = ENGINE_STATE_MACHINE; ///< Engine used by startInterpretation()
+        FsmClock *clock = FsmClock::system(); ///< Time seen by the interpretation (not owned)
 
         FsmInterface* view = nullptr; ///< Reference to view
 
         QHash<QString,ActionState*> states; ///< HTable of all states used within the FSM
         QHash<size_t,CombinedTransition*> transitions; ///< HTable of all the transitions identified by unique ID
-        QHash<QString,QVariant> varsInternal; ///< Internal variable - may be of variable type
-        QHash<QString,QString> varsInput; ///< Input variable - only string format
-        QHash<QString,QString> varsOutput; ///< Output variable - only string format
+        VariableRegistry vars; ///< All variables (internal - may be of variable type, input/output - only string format)
 
         ContextBackup backup; ///< Backup of machine state prior to interpretation
         ScriptHelper scriptHelper; ///< Separate interface for communication with QJSEngine
+        InterpreterContext context; ///< Model services shared with states/transitions during interpretation
+        TraceRecorder trace; ///< Recorder of the binary trace of interpretation runs
+        ChangeLog changes; ///< Latest edits of the machine (for catching up copies over network)
+        FsmInstancePool instances; ///< Concurrent instances of the machine (independent of the main interpretation)
+        UpdateCoalescer viewUpdates; ///< Updates of interpretation waiting for the view to flush them
 
         size_t uniqueTransId = 0; ///< Automatically generated unique id for transitions
 
@@ -113,6 +127,7 @@ class FsmModel : public QObject, public FsmInterface
         void updateCondition(size_t transitionId, const QString &condition) override;
         void updateTransition(size_t transitionId, const QString &srcState, const QString &destState) override;
         void updateVarInput(const QString &name, const QString &value) override;
+        void updateVarInputs(const FsmInputBatch &inputs) override;
         void updateVarOutput(const QString &name, const QString &value) override;
         void updateVarInternal(const QString &name, const QVariant &value) override;
 
@@ -128,6 +143,8 @@ class FsmModel : public QObject, public FsmInterface
         void saveFile(const QString &filename) override;
         void loadStream(QTextStream &stream) override;
         void saveStream(QTextStream &stream) override;
+        void saveChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
+        bool loadChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
 
         void renameFsm(const QString &name) override;
 
@@ -144,6 +161,9 @@ class FsmModel : public QObject, public FsmInterface
 
         void outputEvent(const QString &outName) override;
         void inputEvent(const QString &name, const QString &value) override;
+        void inputEvents(const FsmInputBatch &inputs) override;
+        void updatesPending() override;
+        void flushUpdates() override;
 
         /* 
          ======================
@@ -151,17 +171,116 @@ class FsmModel : public QObject, public FsmInterface
          ======================
         */
 
+        /**
+         * @brief Starts interpretation by given engine
+         * @param engineType The engine to interpret the machine by
+         */
+        void startInterpretation(FsmEngineType engineType);
+
+        /**
+         * @brief Sets the engine used by startInterpretation()
+         * @param engineType The engine
+         */
+        void setEngineType(FsmEngineType engineType);
+
+        /**
+         * @brief Returns the engine used by startInterpretation()
+         * @return The engine
+         */
+        FsmEngineType getEngineType() const;
+
+        /**
+         * @brief Sets the time source of timeouts, elapsed times and the trace (real, accelerated or simulated)
+         * @param clock The clock (not owned, must outlive its use); nullptr for the real time
+         * @return False if interpretation is running (the clock is kept)
+         */
+        bool setClock(FsmClock *clock);
+
+        /**
+         * @brief Returns the time source of the interpretation
+         * @return The clock
+         */
+        FsmClock *getClock() const;
+
+        /**
+         * @brief Number of updates of the view merged into another one (see flushUpdates())
+         * @return The count since the model was created
+         */
+        quint64 coalescedUpdates() const;
+
+        /**
+         * @brief Compiles the current machine for running many instances of it at once (see FsmInstancePool)
+         * @note Instances spawned before are destroyed. Instances run the machine as it is now (later edits need
+         * another call).
+         * @return False if there is no initial state
+         */
+        bool defineInstances();
+
+        /**
+         * @brief Compiles the current machine for running many instances of it on several threads (see FsmExecutor)
+         * @param executor The executor; instances spawned by it before are destroyed
+         * @return False if there is no initial state
+         */
+        bool defineInstances(FsmExecutor &executor);
+
+        /**
+         * @brief Instances of the machine sharing one definition, engine and compiled scripts
+         * @return The pool (spawn instances after defineInstances())
+         */
+        FsmInstancePool &instancePool();
+
+        /**
+         * @brief Checks whether the machine is being interpreted (by any engine)
+         * @return True if interpretation is running
+         */
+        bool interpreting() const;
+
+        /**
+         * @brief Starts recording interpretation runs into a binary trace (see TraceRecorder)
+         * @param filename The trace file (overwritten)
+         * @return False if the file cannot be created
+         */
+        bool startTrace(const QString &filename);
+
+        /**
+         * @brief Finishes the trace
+         */
+        void stopTrace();
+
+        /**
+         * @brief Interprets the machine with input events of a recorded run, timed by simulated clock
+         * @note Timeouts elapse instantly, so the run takes only as long as the computation; the run ends
+         * at the recorded time of its stop. Only the first run of the trace is replayed.
+         * @param filename The trace (see TraceRecorder)
+         * @return False if the trace cannot be read or contains no run
+         */
+        bool replayTrace(const QString &filename);
+
         /**
          * @brief Loads model internal representation from given stream
          * @param in The stream from which to read
+         * @param transitionIds Ids of the transitions in the order of the stream; nullptr to generate them
          */
-        void loadFromStream(QTextStream &in);
+        void loadFromStream(QTextStream &in, const QVector<quint64> *transitionIds = nullptr);
 
         /**
          * @brief Saves model's state to given stream
          * @param out The stream to save to
+         * @param transitionIds If not nullptr, ids of the transitions are appended in the order of the stream
+         */
+        void saveToStream(QTextStream &out, QVector<quint64> *transitionIds = nullptr);
+
+        /**
+         * @brief Loads model from binary snapshot (.fsmb); the file is mapped and read in place
+         * @param filename The file to load
          */
-        void saveToStream(QTextStream &out);
+        void loadBinary(const QString &filename);
+
+        /**
+         * @brief Saves model to binary snapshot (.fsmb)
+         * @param filename The file to save to
+         */
+        void saveBinary(const QString &filename);
 
         /**
          * @brief Returns the name of the active state
@@ -206,6 +325,88 @@ class FsmModel : public QObject, public FsmInterface
          */
         QStateMachine *getMachine();
 
+        /**
+         * @brief Creates new state and registers it to the machine (does not insert it into states)
+         * @param name The name of the state (must be valid)
+         * @param pos The position of the state
+         * @return The new state
+         */
+        ActionState *createState(const QString &name, const QPoint &pos);
+
+        /**
+         * @brief Creates new transition between two states (does not insert it into transitions)
+         * @param transitionId The unique id of the transition
+         * @param srcState The source state
+         * @param destState The destination state
+         * @return The new transition
+         */
+        CombinedTransition *createTransition(size_t transitionId, ActionState *srcState, ActionState *destState);
+
+        /**
+         * @brief Stores values of existing input variables; the view gets them with the next flush of updates
+         * @param inputs The variables and their values
+         * @return The inputs that were stored (undefined variables are skipped)
+         */
+        FsmInputBatch storeInputs(const FsmInputBatch &inputs);
+
+        /**
+         * @brief Passes input event to the running engine
+         * @param name The name of the input
+         */
+        void postInput(const QString &name);
+
+        /**
+         * @brief Logs a change of variable that was written directly through its slot; the view gets it with the next flush
+         * @param scope The scope of the variable
+         * @param slot The slot of the variable
+         */
+        void notifyVarUpdate(VariableScope scope, int slot);
+
+        /**
+         * @brief A state was entered during interpretation; the view gets it with the next flush
+         * @param name The name of the state
+         */
+        void notifyStateEntered(const QString &name);
+
+        /**
+         * @brief Appends an edit to the change log
+         * @param change The edit
+         */
+        void recordChange(const FsmChange &change);
+
+        /**
+         * @brief Performs an edit of the change log of another model
+         * @param change The edit
+         */
+        void applyChange(const FsmChange &change);
+
+        /**
+         * @brief Records current value of a variable into the trace (if recording)
+         * @param scope The scope of the variable
+         * @param slot The slot of the variable
+         */
+        void traceVariable(VariableScope scope, int slot);
+
+        /**
+         * @brief Records start of interpretation and values of all variables into the trace (if recording)
+         * @param engineType The engine that interprets the machine
+         */
+        void traceStart(FsmEngineType engineType);
+
+        /**
+         * @brief Delivers posted events and zero-delay timers until nothing is left at the current simulated time
+         * @return False if the machine didn't settle within REPLAY_SETTLE_PASSES (cycle of empty inputs or zero
+         * timeouts); the rest is delivered after the clock moves on
+         */
+        bool replaySettle();
+
+        /**
+         * @brief Moves the simulated clock to given time, firing timeouts in order on the way
+         * @param clock The clock of the replay
+         * @param time Milliseconds of the clock
+         */
+        void replayAdvance(SimulatedClock &clock, qint64 time);
+
         // Interpretation error
 
         /**
@@ -269,13 +470,6 @@ class FsmModel : public QObject, public FsmInterface
             }
         }
 
-        /**
-         * @brief Parses given line into its Input and Output variables interpretation
-         * @param line The line to be parsed
-         * @param type The type of the variable to parse(Output or Input)
-         */
-        bool parseInOutVariableLine(const QString &line, int type);
-        
         /**
          * @brief Template that checks if all arguments match given regex
          * @tparam ...Args The type arguments pased
@@ -286,8 +480,16 @@ class FsmModel : public QObject, public FsmInterface
         template<typename... Args>
         bool checkAllValidFormat(const char* regexPattern, const Args&... args)
         {
-            return (QRegularExpression(regexPattern).match(args).hasMatch() && ...);
+            const QRegularExpression &regex = formatRegex(regexPattern);
+            return (regex.match(args).hasMatch() && ...);
         }
+
+        /**
+         * @brief Returns compiled regex for given pattern; every pattern is compiled only once
+         * @param regexPattern The pattern (one of FsmFormats)
+         * @return The compiled regex
+         */
+        static const QRegularExpression &formatRegex(const char* regexPattern);
         
         /**
          * @brief Checks whether the given string is in accordance to the expected regex
@@ -296,22 +498,6 @@ class FsmModel : public QObject, public FsmInterface
          * @return True on match, otherwise false
          */
         bool checkValidFormat(const QString &str, const char* regex);
-
-        /**
-         * @brief Parses given line into its variable interpretation
-         * @param line The line to be parsed
-         */
-        bool parseVariableLine(const QString &line);
-        /**
-         * @brief Parses the given line into its state representation
-         * @param line Input line to be parsed
-         */
-        bool parseStateLine(const QString &line);
-        /**
-         * @brief Parses given line into its transition interpretation
-         * @param line The line to be parsed
-         */
-        bool parseTransitionLine(const QString &line);
 };
 
 #endif
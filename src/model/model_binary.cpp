@@ -0,0 +1,559 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file model_binary.cpp
+ * @author xcervia00
+ *
+ * @brief Implementation of binary snapshot operations (.fsmb) for use in Model class
+ *
+ */
+
+#include <QObject>
+#include <QString>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QByteArray>
+#include <QPoint>
+#include <QDebug>
+
+#include <cstring>
+
+#include "mvc_interface.h"
+#include "model.h"
+#include "fsm_binary_format.h"
+
+namespace
+{
+    /**
+     * @brief Interns strings into a single pool while saving
+     */
+    class StringPool
+    {
+        private:
+            QHash<QString, quint32> m_index; ///< String to its index
+            QVector<FsmBinary::StringEntry> m_entries; ///< Position of each string within m_data
+            QString m_data; ///< All strings one after another
+
+        public:
+            /**
+             * @brief Adds string to the pool (only once)
+             * @param str The string to add
+             * @return Index of the string
+             */
+            quint32 intern(const QString &str)
+            {
+                auto it = m_index.constFind(str);
+                if(it != m_index.constEnd())
+                    return it.value();
+
+                quint32 index = m_entries.size();
+                m_entries.append({static_cast<quint32>(m_data.size()), static_cast<quint32>(str.size())});
+                m_data.append(str);
+                m_index.insert(str, index);
+                return index;
+            }
+
+            const QVector<FsmBinary::StringEntry> &entries() const {return m_entries;}
+            const QString &data() const {return m_data;}
+    };
+
+    /**
+     * @brief Validated read-only view of a snapshot (usually a mapped file)
+     */
+    class SnapshotReader
+    {
+        private:
+            const uchar *m_data; ///< Beginning of the snapshot
+            quint64 m_size; ///< Size of the snapshot
+            const FsmBinary::Section *m_sections[FsmBinary::SECTION_TRANSITIONS + 1] = {}; ///< Sections by their id
+            QString m_error; ///< Reason of rejection; empty if valid
+
+            const FsmBinary::StringEntry *m_strings = nullptr; ///< String table
+            const QChar *m_chars = nullptr; ///< String data
+            mutable QVector<QString> m_copies; ///< Strings already copied out of the snapshot
+            mutable QVector<bool> m_copied; ///< Flags which strings are in m_copies
+
+            /**
+             * @brief Records reason of rejection
+             * @param error The reason
+             * @return Always false
+             */
+            bool fail(const QString &error)
+            {
+                m_error = error;
+                return false;
+            }
+
+            /**
+             * @brief Checks the header, section table and string pool
+             * @return True if valid
+             */
+            bool validate()
+            {
+                using namespace FsmBinary;
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+                return fail(QStringLiteral("big endian hosts are not supported"));
+#endif
+
+                if(m_size < sizeof(Header))
+                    return fail(QStringLiteral("file is too short"));
+
+                auto header = reinterpret_cast<const Header*>(m_data);
+                if(std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0)
+                    return fail(QStringLiteral("missing signature"));
+                if(header->version != VERSION)
+                    return fail(QStringLiteral("unsupported version %1").arg(header->version));
+                if(header->headerSize != sizeof(Header))
+                    return fail(QStringLiteral("unexpected header size"));
+                if(sizeof(Header) + static_cast<quint64>(header->sectionCount) * sizeof(Section) > m_size)
+                    return fail(QStringLiteral("truncated section table"));
+
+                static const quint32 recordSizes[] = {
+                    0,
+                    sizeof(StringEntry),
+                    sizeof(Meta),
+                    sizeof(Variable),
+                    sizeof(State),
+                    sizeof(Transition),
+                };
+
+                auto table = reinterpret_cast<const Section*>(m_data + sizeof(Header));
+                for(quint32 i = 0; i < header->sectionCount; i++)
+                {
+                    const Section &section = table[i];
+
+                    // Unknown sections are skipped (newer minor additions)
+                    if(section.id < SECTION_STRINGS || section.id > SECTION_TRANSITIONS)
+                        continue;
+
+                    if(m_sections[section.id] != nullptr)
+                        return fail(QStringLiteral("duplicate section %1").arg(section.id));
+                    if(section.offset % ALIGNMENT != 0 || static_cast<quint64>(section.offset) + section.size > m_size)
+                        return fail(QStringLiteral("section %1 out of bounds").arg(section.id));
+                    if(static_cast<quint64>(section.count) * recordSizes[section.id] > section.size)
+                        return fail(QStringLiteral("section %1 is truncated").arg(section.id));
+
+                    m_sections[section.id] = &section;
+                }
+
+                for(quint32 id = SECTION_STRINGS; id <= SECTION_TRANSITIONS; id++)
+                {
+                    if(m_sections[id] == nullptr)
+                        return fail(QStringLiteral("missing section %1").arg(id));
+                }
+
+                if(m_sections[SECTION_META]->count != 1)
+                    return fail(QStringLiteral("invalid meta section"));
+
+                // String pool ==> table followed by UTF-16 data
+                const Section &strings = *m_sections[SECTION_STRINGS];
+                quint64 tableBytes = static_cast<quint64>(strings.count) * sizeof(StringEntry);
+                quint64 charCount = (strings.size - tableBytes) / sizeof(QChar);
+
+                m_strings = reinterpret_cast<const StringEntry*>(m_data + strings.offset);
+                m_chars = reinterpret_cast<const QChar*>(m_data + strings.offset + tableBytes);
+
+                for(quint32 i = 0; i < strings.count; i++)
+                {
+                    if(static_cast<quint64>(m_strings[i].offset) + m_strings[i].length > charCount)
+                        return fail(QStringLiteral("string %1 out of bounds").arg(i));
+                }
+
+                m_copies.resize(strings.count);
+                m_copied.fill(false, strings.count);
+                return true;
+            }
+
+        public:
+            /**
+             * @brief Constructor of the reader; validates the snapshot
+             * @param data Beginning of the snapshot (8 byte aligned)
+             * @param size Size of the snapshot
+             */
+            SnapshotReader(const uchar *data, quint64 size)
+                :
+                m_data{data},
+                m_size{size}
+            {
+                this->validate();
+            }
+
+            bool valid() const {return m_error.isEmpty();}
+            const QString &error() const {return m_error;}
+
+            /**
+             * @brief Returns records of a section
+             * @tparam T Type of the record
+             * @param id The section
+             * @param count Number of records
+             * @return Pointer to the first record
+             */
+            template<typename T>
+            const T *records(FsmBinary::SectionId id, quint32 &count) const
+            {
+                count = m_sections[id]->count;
+                return reinterpret_cast<const T*>(m_data + m_sections[id]->offset);
+            }
+
+            /**
+             * @brief Checks whether given string index is valid
+             * @param index The index
+             * @return True if valid
+             */
+            bool hasString(quint32 index) const
+            {
+                return index < m_sections[FsmBinary::SECTION_STRINGS]->count;
+            }
+
+            /**
+             * @brief Zero-copy view of a string; only valid while the snapshot is mapped
+             * @param index Index of the valid string
+             * @return The view
+             */
+            QString view(quint32 index) const
+            {
+                return QString::fromRawData(m_chars + m_strings[index].offset, m_strings[index].length);
+            }
+
+            /**
+             * @brief Copy of a string that can be kept by the model; every string is copied only once
+             * @param index Index of the valid string
+             * @return The string
+             */
+            const QString &string(quint32 index) const
+            {
+                if(!m_copied.at(index))
+                {
+                    m_copies[index] = QString(m_chars + m_strings[index].offset, m_strings[index].length);
+                    m_copied[index] = true;
+                }
+
+                return m_copies.at(index);
+            }
+    };
+
+    /**
+     * @brief Appends section to the snapshot being saved
+     * @param out The snapshot
+     * @param table The section table
+     * @param id The section id
+     * @param count Number of records
+     * @param data The records
+     * @param bytes Size of the records
+     */
+    void appendSection(QByteArray &out, QVector<FsmBinary::Section> &table, FsmBinary::SectionId id, quint32 count, const void *data, int bytes)
+    {
+        // Every section is aligned ==> can be read in place from the mapped file
+        while(out.size() % FsmBinary::ALIGNMENT != 0)
+            out.append('\0');
+
+        table.append({id, count, static_cast<quint32>(out.size()), static_cast<quint32>(bytes)});
+        out.append(static_cast<const char*>(data), bytes);
+    }
+}
+
+void FsmModel::saveBinary(const QString &filename)
+{
+    using namespace FsmBinary;
+
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    throwError(ERROR_GENERIC, "Binary FSM files are not supported on big endian hosts");
+    return;
+#endif
+
+    StringPool pool;
+
+    Meta meta{};
+    meta.name = pool.intern(machine.objectName());
+
+    // Variables
+    QVector<Variable> variables;
+    for (auto scope : {VAR_SCOPE_INPUT, VAR_SCOPE_OUTPUT, VAR_SCOPE_INTERNAL}) {
+        vars.forEach(scope, [&](int slot, const QString &name) {
+            Variable variable{};
+            variable.name = pool.intern(name);
+            variable.scope = scope;
+            variable.type = vars.type(scope, slot);
+
+            switch (vars.type(scope, slot)) {
+                case VAR_TYPE_INT:
+                    variable.integer = vars.intAt(scope, slot);
+                    break;
+                case VAR_TYPE_FLOAT:
+                    variable.real = vars.floatAt(scope, slot);
+                    break;
+                case VAR_TYPE_BOOL:
+                    variable.integer = vars.boolAt(scope, slot);
+                    break;
+                case VAR_TYPE_STRING:
+                    variable.text = pool.intern(vars.stringAt(scope, slot));
+                    break;
+                default:
+                    // Same as the text format ==> unsupported types are not saved
+                    return;
+            }
+
+            variables.append(variable);
+        });
+    }
+
+    // States ==> active state first
+    QVector<ActionState*> order;
+    QHash<const QAbstractState*, quint32> stateIndex;
+    auto activeState = static_cast<ActionState*>(getActiveState());
+
+    if (activeState != nullptr) {
+        stateIndex.insert(activeState, order.size());
+        order.append(activeState);
+    }
+    for (auto state : this->states) {
+        if (state != activeState) {
+            stateIndex.insert(state, order.size());
+            order.append(state);
+        }
+    }
+
+    // Transitions grouped by their source state
+    QVector<State> states;
+    QVector<Transition> transitions;
+    states.reserve(order.size());
+    transitions.reserve(this->transitions.size());
+
+    for (auto state : order) {
+        State record{};
+        record.name = pool.intern(state->objectName());
+        record.action = pool.intern(state->getAction());
+        record.x = state->getPosition().x();
+        record.y = state->getPosition().y();
+        record.firstTransition = transitions.size();
+
+        for (auto abstractTransition : state->transitions()) {
+            auto transition = static_cast<CombinedTransition*>(abstractTransition);
+            auto target = stateIndex.constFind(transition->targetState());
+            if (target == stateIndex.constEnd())
+                continue;
+
+            Transition edge{};
+            edge.source = stateIndex.value(state);
+            edge.target = target.value();
+            edge.input = pool.intern(transition->getName());
+            edge.guard = pool.intern(transition->getGuard());
+            edge.timeout = pool.intern(transition->getTimeout());
+            transitions.append(edge);
+        }
+
+        record.transitionCount = transitions.size() - record.firstTransition;
+        states.append(record);
+    }
+
+    // Assemble the file; header and section table are filled in at the end
+    const int sectionCount = 5;
+    QByteArray out(sizeof(Header) + sectionCount * sizeof(Section), '\0');
+    QVector<Section> table;
+
+    QByteArray strings;
+    strings.append(reinterpret_cast<const char*>(pool.entries().constData()), pool.entries().size() * sizeof(StringEntry));
+    strings.append(reinterpret_cast<const char*>(pool.data().utf16()), pool.data().size() * sizeof(QChar));
+
+    appendSection(out, table, SECTION_STRINGS, pool.entries().size(), strings.constData(), strings.size());
+    appendSection(out, table, SECTION_META, 1, &meta, sizeof(meta));
+    appendSection(out, table, SECTION_VARIABLES, variables.size(), variables.constData(), variables.size() * sizeof(Variable));
+    appendSection(out, table, SECTION_STATES, states.size(), states.constData(), states.size() * sizeof(State));
+    appendSection(out, table, SECTION_TRANSITIONS, transitions.size(), transitions.constData(), transitions.size() * sizeof(Transition));
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.headerSize = sizeof(Header);
+    header.sectionCount = table.size();
+
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + sizeof(Header), table.constData(), table.size() * sizeof(Section));
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly) || file.write(out) != out.size()) {
+        throwError(ERROR_GENERIC, "Couldn't open the file for writing");
+        return;
+    }
+
+    file.close();
+}
+
+void FsmModel::loadBinary(const QString &filename)
+{
+    using namespace FsmBinary;
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        throwError(ERROR_GENERIC, "Couldn't open the file");
+        return;
+    }
+
+    // Map the whole file; read it instead if mapping is not possible
+    QByteArray buffer;
+    uchar *mapped = file.size() > 0 ? file.map(0, file.size()) : nullptr;
+    const uchar *data = mapped;
+    if (data == nullptr) {
+        buffer = file.readAll();
+        data = reinterpret_cast<const uchar*>(buffer.constData());
+    }
+
+    SnapshotReader reader(data, static_cast<quint64>(file.size()));
+    if (!reader.valid()) {
+        throwError(ERROR_FILE_INVALID_FORMAT, "Invalid binary FSM file: " + reader.error());
+        return;
+    }
+
+    // Clear current FSM data before loading a new one
+    this->cleanup();
+
+    QString error;
+    auto build = [&]() -> bool {
+        quint32 count;
+
+        // Name
+        auto meta = reader.records<Meta>(SECTION_META, count);
+        if (!reader.hasString(meta->name)) {
+            error = "invalid string reference";
+            return false;
+        }
+        renameFsm(reader.string(meta->name));
+
+        // Variables (few of them ==> through the regular updates)
+        auto variables = reader.records<Variable>(SECTION_VARIABLES, count);
+        for (quint32 i = 0; i < count; i++) {
+            const Variable &variable = variables[i];
+            if (!reader.hasString(variable.name)) {
+                error = "invalid string reference";
+                return false;
+            }
+
+            // Inputs and outputs are always strings; text of any other record is not read
+            bool isText = variable.scope == VAR_SCOPE_INPUT || variable.scope == VAR_SCOPE_OUTPUT;
+            if (isText && variable.type != VAR_TYPE_STRING) {
+                error = "invalid variable type";
+                return false;
+            }
+            if ((isText || variable.type == VAR_TYPE_STRING) && !reader.hasString(variable.text)) {
+                error = "invalid string reference";
+                return false;
+            }
+
+            const QString &name = reader.string(variable.name);
+            switch (variable.scope) {
+                case VAR_SCOPE_INPUT:
+                    updateVarInput(name, reader.string(variable.text));
+                    break;
+                case VAR_SCOPE_OUTPUT:
+                    updateVarOutput(name, reader.string(variable.text));
+                    break;
+                case VAR_SCOPE_INTERNAL:
+                    switch (variable.type) {
+                        case VAR_TYPE_INT:
+                            updateVarInternal(name, QVariant(variable.integer));
+                            break;
+                        case VAR_TYPE_FLOAT:
+                            updateVarInternal(name, QVariant(variable.real));
+                            break;
+                        case VAR_TYPE_BOOL:
+                            updateVarInternal(name, QVariant(variable.integer != 0));
+                            break;
+                        case VAR_TYPE_STRING:
+                            updateVarInternal(name, QVariant(reader.string(variable.text)));
+                            break;
+                        default:
+                            error = "invalid variable type";
+                            return false;
+                    }
+                    break;
+                default:
+                    error = "invalid variable scope";
+                    return false;
+            }
+        }
+
+        // States ==> created directly; names are checked on the zero-copy views
+        quint32 stateCount;
+        auto states = reader.records<State>(SECTION_STATES, stateCount);
+        quint32 transitionCount;
+        auto transitions = reader.records<Transition>(SECTION_TRANSITIONS, transitionCount);
+
+        QVector<ActionState*> created(stateCount, nullptr);
+        for (quint32 i = 0; i < stateCount; i++) {
+            const State &state = states[i];
+            if (!reader.hasString(state.name) || !reader.hasString(state.action)) {
+                error = "invalid string reference";
+                return false;
+            }
+            if (static_cast<quint64>(state.firstTransition) + state.transitionCount > transitionCount) {
+                error = "invalid transition range";
+                return false;
+            }
+            if (!checkValidFormat(reader.view(state.name), FsmFormats::FORMAT_STATE)) {
+                error = "invalid state name";
+                return false;
+            }
+
+            const QString &name = reader.string(state.name);
+            if (this->states.contains(name)) {
+                error = "duplicate state " + name;
+                return false;
+            }
+
+            QPoint pos(state.x, state.y);
+            auto tmp = this->createState(name, pos);
+            this->states.insert(name, tmp);
+            created[i] = tmp;
+            view->updateState(name, pos);
+
+            const QString &action = reader.string(state.action);
+            if (!action.isEmpty()) {
+                tmp->setAction(action);
+                view->updateAction(name, action);
+            }
+        }
+
+        // The first state is the initial one
+        if (stateCount > 0)
+            updateActiveState(created.first()->objectName());
+
+        // Transitions ==> conditions are already split into their parts
+        for (quint32 i = 0; i < transitionCount; i++) {
+            const Transition &edge = transitions[i];
+            if (edge.source >= stateCount || edge.target >= stateCount) {
+                error = "invalid state reference";
+                return false;
+            }
+            if (!reader.hasString(edge.input) || !reader.hasString(edge.guard) || !reader.hasString(edge.timeout)) {
+                error = "invalid string reference";
+                return false;
+            }
+
+            auto id = this->getUniqueTransitionId();
+            auto tmp = this->createTransition(id, created[edge.source], created[edge.target]);
+            tmp->setConditionParts(reader.string(edge.input), reader.string(edge.guard), reader.string(edge.timeout));
+            this->transitions.insert(id, tmp);
+
+            view->updateTransition(id, created[edge.source]->objectName(), created[edge.target]->objectName());
+            QString condition = tmp->getCondition();
+            if (!condition.isEmpty())
+                view->updateCondition(id, condition);
+        }
+
+        qInfo() << "MODEL: Loaded binary FSM with " << stateCount << " states and " << transitionCount << " transitions";
+        return true;
+    };
+
+    bool ok = build();
+
+    if (mapped != nullptr)
+        file.unmap(mapped);
+    file.close();
+
+    if (!ok) {
+        this->throwError(ERROR_FILE_INVALID_FORMAT, "Invalid binary FSM file: " + error);
+        this->cleanup();
+    }
+}
@@ -12,263 +12,91 @@
 #include <QObject>
 #include <QString>
 #include <QFile>
-#include <QRegularExpression>
+#include <QFileInfo>
 #include <QPoint>
 #include <QDebug>
 
+#include <algorithm>
+
 #include "mvc_interface.h"
 #include "model.h"
+#include "fsm_file_parser.h"
 
-/**
- * @brief Sections of the file format
- */
-enum Section { 
-    NONE, 
-    NAME, 
-    COMMENT, 
-    INPUT, 
-    OUTPUT, 
-    VARIABLES, 
-    STATES, 
-    TRANSITIONS 
-};
-
-// Generic regex for variables ==> datatype, name and value
-#define REGEX_VARIABLE R"(^\s*(int|float|bool|string)\s+([\w-]+)\s*=\s*(.+)\s*$)"
-// Internal variable regex ==> name and value (datatype is string)
-#define REGEX_VARIABLE_INPUT_OUTPUT R"(^([\w-]+)\s*(=\s*(.+)\s*)?$)"
-
-// Regex for states
-#define REGEX_STATE R"(^\s*([A-Za-z0-9_-]+)\s*\(\s*(\d+)\s*,\s*(\d+)\s*\)\s*:\s*\{\s*(.*)\s*\}\s*$)"
-
-// Regex for transitions
-#define REGEX_TRANSITION R"(^\s*(\w+)\s*->\s*(\w+)\s*:\s*\{\s*(.*)\s*\}\s*$)"
-
-
-bool FsmModel::parseInOutVariableLine(const QString &line, int type) {
- 
-    auto match = QRegularExpression(REGEX_VARIABLE_INPUT_OUTPUT).match(line);
-    if (!match.hasMatch()){
-        return false;
-    }
-
-    // Get the values from matched groups 
-    QString name = match.captured(1);
-    QString value = match.captured(3);
-    if (value.isEmpty()) value = "";
-
-    if(type == Section::INPUT)
-        updateVarInput(name, value);
-    else if(type == Section::OUTPUT)
-        updateVarOutput(name, value);
-
-    return true;
-}
-
-
-bool FsmModel::parseVariableLine(const QString &line) {
-
-    auto match = QRegularExpression(REGEX_VARIABLE).match(line);
-    if (!match.hasMatch()){
-        return false;
-    }
-
-    // Extract variable type
-    QString type = match.captured(1);
-    // Extract variable name
-    QString name = match.captured(2);
-    // Extract variable value as string
-    QString value = match.captured(3);
-
-    bool ok;
-    // Convert value to the correct type and update internal variable
-    if (type == "int") {
-        auto t = value.toInt(&ok, 10);
-        if(!ok) 
-        {
-            return false;
-        }
-        
-        updateVarInternal(name, QVariant(t));
-    } 
-    else if (type == "float") {
-        auto t = value.toDouble(&ok);
-        if(!ok) 
-        {
-            return false;
-        }
-        updateVarInternal(name, QVariant(t));
-    } 
-    else if (type == "bool") {
-        if(value != "true" && value != "false")
-        {
-            return false;
-        }
-        updateVarInternal(name, QVariant(value == "true"));
-    } 
-    else if (type == "string") {
-        updateVarInternal(name, QVariant(value));
-    }
-    else{
-        return false;
-    }
-
-    return true;
-}
-
-bool FsmModel::parseStateLine(const QString &line) {
-
-    auto match = QRegularExpression(REGEX_STATE).match(line);
-    if (!match.hasMatch()) return false;
-
-    // State name
-    QString name = match.captured(1);
-
-    bool ok;
-    // X coordinate
-    int x = match.captured(2).toInt(&ok, 10);
-    if(!ok) return false;
-
-    // Y coordinate
-    int y = match.captured(3).toInt(&ok, 10);
-    if(!ok) return false;
-
-    // Action value
-    QString action = match.captured(4);
-    // Set state
-    updateState(name, QPoint(x, y));
-    // Set Action (if not blank)
-    if(!action.isEmpty())
-        updateAction(name, action);
-
-    if (states.size() == 1) {
-        updateActiveState(name);
-    }
-
-    return true;
-}
-
-bool FsmModel::parseTransitionLine(const QString &line) {
-
-    auto match = QRegularExpression(REGEX_TRANSITION).match(line);
-    if (!match.hasMatch()) return false;
-
-    QString src = match.captured(1);
-    QString dst = match.captured(2);
-    QString condition = match.captured(3);
-
-    // Source or destination don't exist
-    if(!this->states.contains(src) || !this->states.contains(dst))
-        return false;
-
-    auto id = this->getUniqueTransitionId();
-
-    // Create transition
-    updateTransition(id, src, dst);
-    // Update condition
-    if(!condition.isEmpty())
-        updateCondition(id, condition);
-
-    return true;
-}
-
-void FsmModel::loadFromStream(QTextStream &in)
+void FsmModel::loadFromStream(QTextStream &in, const QVector<quint64> *transitionIds)
 {
     // Clear current FSM data before loading a new one
     this->cleanup();
 
-    // Section tracking for which part of the file is being parsed
-    QString line;
-
-    Section currentSection = NONE;
+    FsmFileParser parser(in.readAll());
+    FsmFileRecord record;
+    int transitionCount = 0;
 
-    // Read the file line by line
-    while (!in.atEnd()) {
-        line = in.readLine().trimmed();
-        if (line.isEmpty()) continue;
+    while (parser.next(record)) {
+        switch (record.kind) {
+            case FsmFileRecord::NAME:
+                renameFsm(record.name);
+                break;
 
-        if (line == "Name:") {
-            currentSection = NAME;
-            continue;
-        } 
-        else if (line == "Comment:") {
-            currentSection = COMMENT;
-            continue;
-        } 
-        else if (line == "Input:") {
-            currentSection = INPUT;
-            continue;
-        } 
-        else if (line == "Output:") {
-            currentSection = OUTPUT;
-            continue;
-        } 
-        else if (line == "Variables:") {
-            currentSection = VARIABLES;
-            continue;
-        } 
-        else if (line == "States:") {
-            currentSection = STATES;
-            continue;
-        } 
-        else if (line == "Transitions:") {
-            currentSection = TRANSITIONS;
-            continue;
-        }
+            case FsmFileRecord::INPUT:
+                updateVarInput(record.name, record.text);
+                break;
 
-        // Parse the content according to the current section
-        switch (currentSection) {
-            case NAME:
-                renameFsm(line);
+            case FsmFileRecord::OUTPUT:
+                updateVarOutput(record.name, record.text);
                 break;
 
-            case INPUT:
-                if(parseInOutVariableLine(line, currentSection) == false){
-                    this->throwError(ERROR_FILE_INVALID_FORMAT, "Failed to parse variable from file");
-                    this->cleanup();
-                    return;
-                }
-                    break;
-    
-            case OUTPUT:
-                if(parseInOutVariableLine(line, currentSection) == false){
-                    this->throwError(ERROR_FILE_INVALID_FORMAT, "Failed to parse variable from file");
-                    this->cleanup();
-                    return;
-                }
-                    break;
+            case FsmFileRecord::VARIABLE:
+                updateVarInternal(record.name, record.value);
+                break;
 
-            case VARIABLES:
-                if(parseVariableLine(line) == false){
-                    this->throwError(ERROR_FILE_INVALID_FORMAT, "Failed to parse variable from file");
-                    this->cleanup();
-                    return;
-                }
+            case FsmFileRecord::STATE:
+                // Set state (first one becomes the initial)
+                updateState(record.name, record.position);
+                // Set Action (if not blank)
+                if(!record.text.isEmpty())
+                    updateAction(record.name, record.text);
                 break;
 
-            case STATES:
-                if(parseStateLine(line) == false){
-                    this->throwError(ERROR_FILE_INVALID_FORMAT, "Failed to parse state from file");
+            case FsmFileRecord::TRANSITION: {
+                // Source or destination don't exist
+                if(!this->states.contains(record.name) || !this->states.contains(record.target)){
+                    this->throwError(ERROR_FILE_INVALID_FORMAT, QStringLiteral("Failed to parse transition from file: undefined state (line %1, column %2)")
+                                                                .arg(record.line).arg(record.column));
                     this->cleanup();
                     return;
                 }
-                break;
 
-            case TRANSITIONS:
-                if (parseTransitionLine(line) == false){
-                    this->throwError(ERROR_FILE_INVALID_FORMAT, "Failed to parse transition from file");
-                    this->cleanup();
-                    return;
+                // Keep ids of the saved machine if known
+                size_t id;
+                if(transitionIds != nullptr && transitionCount < transitionIds->size())
+                {
+                    id = static_cast<size_t>(transitionIds->at(transitionCount));
+                    this->uniqueTransId = std::max(this->uniqueTransId, id);
                 }
-                break;
+                else
+                {
+                    id = this->getUniqueTransitionId();
+                }
+                transitionCount++;
 
-            default:
+                // Create transition
+                updateTransition(id, record.name, record.target);
+                // Update condition
+                if(!record.text.isEmpty())
+                    updateCondition(id, record.text);
                 break;
+            }
         }
     }
+
+    if (parser.failed()) {
+        this->throwError(ERROR_FILE_INVALID_FORMAT, parser.errorString());
+        this->cleanup();
+        return;
+    }
 }
 
-void FsmModel::saveToStream(QTextStream &out)
+void FsmModel::saveToStream(QTextStream &out, QVector<quint64> *transitionIds)
 {
     // Name
     out << "Name:\n";
@@ -276,46 +104,44 @@ void FsmModel::saveToStream(QTextStream &out)
 
     // Inputs
     out << "Input:\n";
-    for (auto input = varsInput.begin(); input != varsInput.end(); input++) {
-        out << "\t" << input.key() << (input.value().isEmpty() ? "" : QStringLiteral(" = ") + input.value()) << "\n";
-    }
+    vars.forEach(VAR_SCOPE_INPUT, [&](int slot, const QString &name) {
+        const QString &value = vars.stringAt(VAR_SCOPE_INPUT, slot);
+        out << "\t" << name << (value.isEmpty() ? "" : QStringLiteral(" = ") + value) << "\n";
+    });
     out << "\n";
 
     // Outputs
     out << "Output:\n";
-    for (auto output = varsOutput.begin(); output != varsOutput.end(); output++) {
-        out << "\t" << output.key() << (output.value().isEmpty() ? "" : QStringLiteral(" = ") + output.value()) << "\n";
-    }
+    vars.forEach(VAR_SCOPE_OUTPUT, [&](int slot, const QString &name) {
+        const QString &value = vars.stringAt(VAR_SCOPE_OUTPUT, slot);
+        out << "\t" << name << (value.isEmpty() ? "" : QStringLiteral(" = ") + value) << "\n";
+    });
     out << "\n";
 
     // Internal variables
     out << "Variables:\n";
-        for (auto variable = varsInternal.begin(); variable != varsInternal.end(); variable++) {
+    vars.forEach(VAR_SCOPE_INTERNAL, [&](int slot, const QString &name) {
         QString type;
-        const QVariant &val = variable.value();
 
-        switch (val.type()) {
-            case QVariant::Int:
+        switch (vars.type(VAR_SCOPE_INTERNAL, slot)) {
+            case VAR_TYPE_INT:
                 type = "int";
                 break;
-            case QVariant::Double:
+            case VAR_TYPE_FLOAT:
                 type = "float";
                 break;
-            case QVariant::Bool:
+            case VAR_TYPE_BOOL:
                 type = "bool";
                 break;
-            case QVariant::String: {
-                QString str = val.toString();
+            case VAR_TYPE_STRING:
                 type = "string";
                 break;
-            }
             default:
-                continue;
+                return;
         }
-        
-    
-        out << "\t" << type << " " << variable.key() << " = " << val.toString() << "\n";
-    }
+
+        out << "\t" << type << " " << name << " = " << vars.toStringAt(VAR_SCOPE_INTERNAL, slot) << "\n";
+    });
     out << "\n";
 
     // States
@@ -343,21 +169,30 @@ void FsmModel::saveToStream(QTextStream &out)
     out << "Transitions:\n";
     for (auto transition = transitions.begin(); transition != transitions.end(); transition++) {
         CombinedTransition* t = transition.value();
-        QString condition;
-        if (!t->getName().isEmpty())
-            condition += t->getName();
-        if (!t->getGuard().isEmpty())
-            condition += " [" + t->getGuard() + "]";
-        if (!t->getTimeout().isEmpty())
-            condition += " @ " + t->getTimeout();
-
-        out << "\t" << t->sourceState()->objectName() << " -> " << t->targetState()->objectName() << ": {" << condition << "}\n";
+        out << "\t" << t->sourceState()->objectName() << " -> " << t->targetState()->objectName() << ": {" << t->getCondition() << "}\n";
+        if(transitionIds != nullptr)
+            transitionIds->append(transition.key());
     }
 }
 
 
+/**
+ * @brief Checks whether the file is a binary snapshot (by its suffix)
+ * @param filename The file
+ * @return True for .fsmb files
+ */
+static bool isBinaryFile(const QString &filename)
+{
+    return QFileInfo(filename).suffix().compare(QLatin1String("fsmb"), Qt::CaseInsensitive) == 0;
+}
+
 void FsmModel::loadFile(const QString &filename)
 {
+    if (isBinaryFile(filename)) {
+        this->loadBinary(filename);
+        return;
+    }
+
     QFile file(filename);
     if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
         throwError(ERROR_GENERIC, "Couldn't open the file");
@@ -372,6 +207,11 @@ void FsmModel::loadFile(const QString &filename)
 
 void FsmModel::saveFile(const QString &filename)
 {
+    if (isBinaryFile(filename)) {
+        this->saveBinary(filename);
+        return;
+    }
+
     QFile file(filename);
     if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         throwError(ERROR_GENERIC, "Couldn't open the file for writing");
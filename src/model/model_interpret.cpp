@@ -15,6 +15,7 @@
 
 #include "mvc_interface.h"
 #include "model.h"
+#include "async_logger.h"
 
 #include <QtGlobal>
 #include <QCoreApplication>
@@ -30,10 +31,16 @@
 void FsmModel::renameFsm(const QString &name)
 {
     this->machine.setObjectName(name);
+    this->recordChange({CHANGE_FSM_NAME, 0, name, QString(), QVariant()});
     view->renameFsm(name);
 }
 
 void FsmModel::startInterpretation()
+{
+    this->startInterpretation(this->engineType);
+}
+
+void FsmModel::startInterpretation(FsmEngineType engineType)
 {
     // If there are no states or no active state, exit
     if(this->emptyStates()){
@@ -47,18 +54,52 @@ void FsmModel::startInterpretation()
     this->log();
 
     // Backup 
-    backup.vInternal = this->varsInternal;
-    backup.vInput = this->varsInput;
-    backup.vOutput = this->varsOutput;
+    backup.vars = this->vars;
     backup.initialState = this->machine.initialState();
 
     // By default, no state is 'last' until one is entered
-    ActionState::setLastState(nullptr);
+    this->context.lastState = nullptr;
+
+    // Flat engine is compiled from the current machine on every start
+    if(engineType == ENGINE_FLAT && this->flatEngine.compile(this->states, static_cast<ActionState*>(this->machine.initialState())))
+    {
+        this->traceStart(ENGINE_FLAT);
+        this->flatEngine.start();
+        return;
+    }
 
+    this->traceStart(ENGINE_STATE_MACHINE);
     this->machine.start();
     return;
 }
 
+bool FsmModel::defineInstances()
+{
+    if(!this->instances.define(this->states, static_cast<ActionState*>(this->machine.initialState()), this->vars))
+    {
+        qCritical() << "INTERPRETATION: Instances need a machine with an initial state";
+        return false;
+    }
+
+    return true;
+}
+
+bool FsmModel::defineInstances(FsmExecutor &executor)
+{
+    if(!executor.define(this->states, static_cast<ActionState*>(this->machine.initialState()), this->vars))
+    {
+        qCritical() << "INTERPRETATION: Instances need a machine with an initial state";
+        return false;
+    }
+
+    return true;
+}
+
+FsmInstancePool &FsmModel::instancePool()
+{
+    return this->instances;
+}
+
 void FsmModel::interpretationError(FsmErrorType errNum)
 {
     STOP_EVALUATION(this->engine);
@@ -79,36 +120,51 @@ void FsmModel::restoreInterpretationBackup()
     if(backup.initialState == nullptr)
         return;
 
+    // Everything is sent again below; a later flush would show the state entered last instead of the initial one
+    this->viewUpdates.clear();
+
+    // Restoring is not an edit of the machine ==> values go straight to the registry and nothing is recorded
     // Restore internal vars
-    for (const auto &key : backup.vInternal.keys()) 
-    {
-        this->updateVarInternal(key, backup.vInternal.value(key));
-    }
+    backup.vars.forEach(VAR_SCOPE_INTERNAL, [this](int slot, const QString &name) {
+        const QVariant value = backup.vars.valueAt(VAR_SCOPE_INTERNAL, slot);
+        this->vars.insert(VAR_SCOPE_INTERNAL, name, value);
+        logEvent(LOG_VAR_INTERNAL, name, value);
+        view->updateVarInternal(name, value);
+    });
     // Restore input vars
-    for (const auto &key : backup.vInput.keys()) 
-    {
-        this->updateVarInput(key, backup.vInput.value(key));
-    }
+    backup.vars.forEach(VAR_SCOPE_INPUT, [this](int slot, const QString &name) {
+        const QString &value = backup.vars.stringAt(VAR_SCOPE_INPUT, slot);
+        this->vars.insert(VAR_SCOPE_INPUT, name, value);
+        logEvent(LOG_VAR_INPUT, name, value);
+        view->updateVarInput(name, value);
+    });
     // Restore output vars
-    for (const auto &key : backup.vOutput.keys()) 
-    {
-        this->updateVarOutput(key, backup.vOutput.value(key));
-    }
+    backup.vars.forEach(VAR_SCOPE_OUTPUT, [this](int slot, const QString &name) {
+        const QString &value = backup.vars.stringAt(VAR_SCOPE_OUTPUT, slot);
+        this->vars.insert(VAR_SCOPE_OUTPUT, name, value);
+        logEvent(LOG_VAR_OUTPUT, name, value);
+        view->updateVarOutput(name, value);
+    });
 
     // Restore initial state
-    this->updateActiveState(backup.initialState->objectName());
+    backup.initialState->machine()->setInitialState(backup.initialState);
+    view->updateActiveState(backup.initialState->objectName());
 }
 
 void FsmModel::stopInterpretation()
 {
-    if(!machine.isRunning()){
+    if(!this->interpreting()){
         return;
     }
 
-    qInfo() << "Interpretation stopped...";
+    qInfo() << "Interpretation stopped... (" << this->viewUpdates.coalesced() << " view updates coalesced so far)";
+    if(this->trace.isRecording())
+        this->trace.recordStop();
 
     // Stop the machine immediatelly
-    this->machine.stop();
+    if(this->machine.isRunning())
+        this->machine.stop();
+    this->flatEngine.stop();
 
     // On full stop restore original values
     this->restoreInterpretationBackup();
@@ -118,8 +174,77 @@ void FsmModel::stopInterpretation()
     {
         tr->stopTimer();
     }
+    this->timers.clear();
 
     // Request cleanup; optional
     this->engine.collectGarbage();
     return;
 }
+
+bool FsmModel::startTrace(const QString &filename)
+{
+    if(!this->trace.open(filename))
+    {
+        qWarning() << "TRACE: Failed to create trace file " << filename;
+        return false;
+    }
+
+    qInfo() << "TRACE: Recording interpretation into " << filename;
+
+    // Already running ==> the trace starts with the current values
+    if(this->interpreting())
+        this->traceStart(this->flatEngine.isRunning() ? ENGINE_FLAT : ENGINE_STATE_MACHINE);
+
+    return true;
+}
+
+void FsmModel::stopTrace()
+{
+    if(this->trace.isRecording())
+        qInfo() << "TRACE: Recorded " << this->trace.size() << " bytes";
+
+    this->trace.close();
+}
+
+void FsmModel::traceStart(FsmEngineType engineType)
+{
+    if(!this->trace.isRecording())
+        return;
+
+    this->trace.recordStart(engineType);
+    for(int scope = 0; scope < VAR_SCOPE_COUNT; scope++)
+    {
+        this->vars.forEach(static_cast<VariableScope>(scope), [this, scope](int slot, const QString &name) {
+            (void)name;
+            this->traceVariable(static_cast<VariableScope>(scope), slot);
+        });
+    }
+}
+
+void FsmModel::traceVariable(VariableScope scope, int slot)
+{
+    if(!this->trace.isRecording())
+        return;
+
+    const QString &name = this->vars.name(scope, slot);
+    switch(this->vars.type(scope, slot))
+    {
+        case VAR_TYPE_INT:
+            this->trace.recordInt(scope, name, this->vars.intAt(scope, slot));
+            break;
+        case VAR_TYPE_FLOAT:
+            this->trace.recordFloat(scope, name, this->vars.floatAt(scope, slot));
+            break;
+        case VAR_TYPE_BOOL:
+            this->trace.recordBool(scope, name, this->vars.boolAt(scope, slot));
+            break;
+        case VAR_TYPE_STRING:
+            this->trace.recordString(scope, name, this->vars.stringAt(scope, slot));
+            break;
+        case VAR_TYPE_OTHER:
+            this->trace.recordString(scope, name, this->vars.otherAt(scope, slot).toString());
+            break;
+        default:
+            break;
+    }
+}
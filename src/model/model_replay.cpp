@@ -0,0 +1,233 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file model_replay.cpp
+ * @author xcervia00
+ *
+ * @brief Deterministic replay of recorded interpretation runs for use in Model class
+ *
+ */
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <QDebug>
+
+#include "mvc_interface.h"
+#include "model.h"
+#include "trace_reader.h"
+
+// Maximal number of passes over posted events and zero-delay timers at a single instant of a replay
+#define REPLAY_SETTLE_PASSES 1000
+
+namespace
+{
+    /**
+     * @brief Counts events delivered to objects of the main thread while installed on the application
+     */
+    class DeliveryCounter : public QObject
+    {
+        public:
+            int delivered = 0; ///< Events delivered since last reset
+
+            bool eventFilter(QObject *watched, QEvent *event) override
+            {
+                Q_UNUSED(watched);
+                Q_UNUSED(event);
+                this->delivered++;
+                return false;
+            }
+    };
+
+    /**
+     * @brief Inputs accepted by the model at once (single event or a batch)
+     */
+    struct ReplayStep
+    {
+        qint64 time = 0; ///< Milliseconds since the start of the run
+        FsmInputBatch inputs; ///< Names and values of the inputs
+    };
+
+    /**
+     * @brief Extracts the inputs of the first run of the trace
+     * @param filename The trace
+     * @param steps Extracted inputs
+     * @param duration Length of the run in milliseconds
+     * @param error Description of the problem
+     * @return False if the trace cannot be read or contains no run
+     */
+    bool loadReplay(const QString &filename, QVector<ReplayStep> &steps, qint64 &duration, QString &error)
+    {
+        TraceReader reader;
+        if(!reader.open(filename))
+        {
+            error = reader.error();
+            return false;
+        }
+
+        QHash<QString, QString> values; // Last value of every input variable
+        qint64 start = -1;
+        bool batch = false;
+        bool running = true;
+
+        TraceEvent event;
+        while(running && reader.next(event))
+        {
+            if(start < 0)
+            {
+                if(event.type == FsmTrace::RECORD_START)
+                    start = event.time;
+                continue;
+            }
+
+            duration = (event.time - start) / 1000;
+            switch(event.type)
+            {
+                case FsmTrace::RECORD_START:
+                case FsmTrace::RECORD_STOP:
+                    running = false;
+                    break;
+                case FsmTrace::RECORD_VARIABLE:
+                    if(event.scope == VAR_SCOPE_INPUT)
+                        values.insert(event.name, event.value.toString());
+                    batch = false;
+                    break;
+                case FsmTrace::RECORD_INPUT:
+                    // Values of a batch are stored before any of its events is posted
+                    if(!batch)
+                    {
+                        steps.append(ReplayStep());
+                        steps.last().time = duration;
+                    }
+                    steps.last().inputs.append({event.name, values.value(event.name)});
+                    batch = true;
+                    break;
+                default:
+                    batch = false;
+                    break;
+            }
+        }
+
+        if(!reader.error().isEmpty())
+        {
+            error = reader.error();
+            return false;
+        }
+
+        if(start < 0)
+        {
+            error = "No interpretation run was recorded";
+            return false;
+        }
+
+        return true;
+    }
+}
+
+bool FsmModel::replayTrace(const QString &filename)
+{
+    QVector<ReplayStep> steps;
+    qint64 duration = 0;
+    QString error;
+
+    if(!loadReplay(filename, steps, duration, error))
+    {
+        qCritical() << "REPLAY: " << filename << ": " << error;
+        return false;
+    }
+
+    qInfo() << "REPLAY: " << steps.size() << " inputs over " << duration << " ms";
+
+    QElapsedTimer wallClock;
+    wallClock.start();
+
+    // Timeouts are fired by moving the simulated clock, never by waiting
+    FsmClock *previous = this->clock;
+    SimulatedClock simulated(false);
+    if(!this->setClock(&simulated))
+        return false;
+
+    this->startInterpretation();
+    this->replaySettle();
+
+    for(const auto &step : steps)
+    {
+        // Stopped by an error
+        if(!this->interpreting())
+            break;
+
+        this->replayAdvance(simulated, step.time);
+
+        if(step.inputs.size() == 1)
+            this->inputEvent(step.inputs.first().first, step.inputs.first().second);
+        else
+            this->inputEvents(step.inputs);
+
+        this->replaySettle();
+    }
+
+    if(this->interpreting())
+    {
+        this->replayAdvance(simulated, duration);
+        this->stopInterpretation();
+    }
+
+    this->setClock(previous);
+
+    qInfo() << "REPLAY: Finished in " << wallClock.elapsed() << " ms";
+    return true;
+}
+
+bool FsmModel::replaySettle()
+{
+    DeliveryCounter counter;
+    QCoreApplication::instance()->installEventFilter(&counter);
+
+    bool settled = false;
+    for(int pass = 0; pass < REPLAY_SETTLE_PASSES; pass++)
+    {
+        // Events posted while a pass runs wait for the next one; a pass that delivers nothing had nothing posted
+        counter.delivered = 0;
+        QCoreApplication::sendPostedEvents();
+        if(counter.delivered > 0)
+            continue;
+
+        // Zero-delay timeouts may post events again
+        if(this->timers.remaining() != 0)
+        {
+            settled = true;
+            break;
+        }
+
+        this->timers.poll();
+    }
+
+    QCoreApplication::instance()->removeEventFilter(&counter);
+
+    if(!settled)
+        qWarning() << "REPLAY: Machine did not settle at " << this->clock->elapsed() << " ms (cycle of empty inputs or zero timeouts), moving on";
+
+    return settled;
+}
+
+void FsmModel::replayAdvance(SimulatedClock &clock, qint64 time)
+{
+    // Every timeout may schedule further ones
+    while(this->interpreting())
+    {
+        qint64 wait = this->timers.remaining();
+        if(wait < 0 || clock.elapsed() + wait > time)
+            break;
+
+        clock.advance(wait);
+        this->timers.poll();
+
+        // Never settles at this instant ==> continues at the target time
+        if(!this->replaySettle())
+            break;
+    }
+
+    clock.advanceTo(time);
+    this->timers.poll();
+}
@@ -0,0 +1,188 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file model_sync.cpp
+ * @author xcervia00
+ *
+ * @brief Catching up copies of the model by logged edits (see ChangeLog)
+ *
+ */
+
+#include <QTextStream>
+#include <QDebug>
+
+#include <algorithm>
+
+#include "mvc_interface.h"
+#include "model.h"
+
+namespace
+{
+    /**
+     * @brief What follows the header of saved changes
+     */
+    enum SyncKind : quint8
+    {
+        SYNC_DELTA, ///< Version the edits follow, count, edits
+        SYNC_FULL, ///< Whole machine (UTF-8 text of the file format), ids of its transitions
+    };
+}
+
+/*
+ * Saved changes: [u32 session][u64 version][u8 kind] followed by the data of the kind (QDataStream)
+ */
+
+void FsmModel::recordChange(const FsmChange &change)
+{
+    this->changes.append(change);
+}
+
+void FsmModel::applyChange(const FsmChange &change)
+{
+    switch(change.type)
+    {
+        case CHANGE_STATE:
+            this->updateState(change.name, change.value.toPoint());
+            break;
+        case CHANGE_STATE_NAME:
+            this->updateStateName(change.name, change.text);
+            break;
+        case CHANGE_ACTION:
+            this->updateAction(change.name, change.text);
+            break;
+        case CHANGE_INITIAL_STATE:
+            this->updateActiveState(change.name);
+            break;
+        case CHANGE_TRANSITION:
+            // Generated ids must not collide with ids of the other model
+            this->uniqueTransId = std::max(this->uniqueTransId, static_cast<size_t>(change.id));
+            this->updateTransition(static_cast<size_t>(change.id), change.name, change.text);
+            break;
+        case CHANGE_CONDITION:
+            this->updateCondition(static_cast<size_t>(change.id), change.text);
+            break;
+        case CHANGE_VAR_INPUT:
+            this->updateVarInput(change.name, change.text);
+            break;
+        case CHANGE_VAR_OUTPUT:
+            this->updateVarOutput(change.name, change.text);
+            break;
+        case CHANGE_VAR_INTERNAL:
+            this->updateVarInternal(change.name, change.value);
+            break;
+        case CHANGE_FSM_NAME:
+            this->renameFsm(change.name);
+            break;
+        case CHANGE_DESTROY_STATE:
+            this->destroyState(change.name);
+            break;
+        case CHANGE_DESTROY_ACTION:
+            this->destroyAction(change.name);
+            break;
+        case CHANGE_DESTROY_CONDITION:
+            this->destroyCondition(static_cast<size_t>(change.id));
+            break;
+        case CHANGE_DESTROY_TRANSITION:
+            // Already gone with its state
+            if(this->transitions.contains(static_cast<size_t>(change.id)))
+                this->destroyTransition(static_cast<size_t>(change.id));
+            break;
+        case CHANGE_DESTROY_VAR_INPUT:
+            this->destroyVarInput(change.name);
+            break;
+        case CHANGE_DESTROY_VAR_OUTPUT:
+            this->destroyVarOutput(change.name);
+            break;
+        case CHANGE_DESTROY_VAR_INTERNAL:
+            this->destroyVarInternal(change.name);
+            break;
+        default:
+            break;
+    }
+}
+
+void FsmModel::saveChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    stream << changes.session() << changes.version();
+
+    if(changes.covers(session, version))
+    {
+        stream << static_cast<quint8>(SYNC_DELTA) << version;
+        changes.write(stream, version);
+    }
+    else
+    {
+        QString text;
+        QVector<quint64> ids;
+        QTextStream out(&text, QIODevice::WriteOnly);
+        this->saveToStream(out, &ids);
+        out.flush();
+
+        stream << static_cast<quint8>(SYNC_FULL) << text.toUtf8() << ids;
+    }
+
+    session = changes.session();
+    version = changes.version();
+}
+
+bool FsmModel::loadChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    quint32 newSession;
+    quint64 newVersion;
+    quint8 kind;
+    stream >> newSession >> newVersion >> kind;
+
+    if(stream.status() != QDataStream::Ok)
+        return false;
+
+    // Already up to date
+    if(newSession == session && newVersion == version)
+        return true;
+
+    if(kind == SYNC_DELTA)
+    {
+        quint64 since;
+        quint32 count;
+        stream >> since >> count;
+
+        if(stream.status() != QDataStream::Ok || newSession != session || since != version)
+            return false;
+
+        // Everything is read first, so malformed data changes nothing
+        QVector<FsmChange> edits;
+        for(quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+        {
+            FsmChange change;
+            stream >> change;
+            edits.append(change);
+        }
+
+        if(stream.status() != QDataStream::Ok)
+            return false;
+
+        qInfo() << "MODEL: Applying " << edits.size() << " edits (version " << since << " to " << newVersion << ")";
+        for(const FsmChange &change : edits)
+            this->applyChange(change);
+    }
+    else if(kind == SYNC_FULL)
+    {
+        QByteArray text;
+        QVector<quint64> ids;
+        stream >> text >> ids;
+
+        if(stream.status() != QDataStream::Ok)
+            return false;
+
+        QTextStream in(text, QIODevice::ReadOnly);
+        in.setCodec("UTF-8");
+        this->loadFromStream(in, &ids);
+    }
+    else
+    {
+        return false;
+    }
+
+    session = newSession;
+    version = newVersion;
+    return true;
+}
@@ -0,0 +1,569 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file model_thread.cpp
+ * @author xcervia00
+ *
+ * @brief Implementation of the model running on its own thread
+ *
+ */
+
+#include "model_thread.h"
+#include "model.h"
+
+#include <QDebug>
+#include <QMetaObject>
+#include <QSemaphore>
+
+/*
+============================
+         CALL QUEUE
+============================
+*/
+
+FsmCallQueue::FsmCallQueue(QObject *parent)
+    :
+    QObject{parent},
+    m_scheduled{0}
+{
+}
+
+void FsmCallQueue::post(std::function<void()> call)
+{
+    m_calls.push(std::move(call));
+
+    // One scheduled process() drains everything posted until it runs
+    if(m_scheduled.testAndSetOrdered(0, 1))
+        QMetaObject::invokeMethod(this, "process", Qt::QueuedConnection);
+}
+
+void FsmCallQueue::call(const std::function<void()> &call)
+{
+    if(QThread::currentThread() == this->thread())
+    {
+        this->drain();
+        call();
+        return;
+    }
+
+    // Runs after everything posted before; the caller waits without a lock
+    QSemaphore done;
+    this->post([&call, &done]() {
+        call();
+        done.release();
+    });
+    done.acquire();
+}
+
+void FsmCallQueue::process()
+{
+    // Calls posted from now on schedule process() again
+    m_scheduled.storeRelease(0);
+    this->drain();
+}
+
+void FsmCallQueue::drain()
+{
+    std::function<void()> call;
+    while(m_calls.pop(call))
+        call();
+}
+
+/*
+============================
+        MODEL PROXY
+============================
+*/
+
+FsmModelProxy::FsmModelProxy(FsmCallQueue *modelQueue, FsmCallQueue *viewQueue)
+    :
+    m_modelQueue{modelQueue},
+    m_viewQueue{viewQueue}
+{
+}
+
+void FsmModelProxy::setTarget(FsmInterface *model)
+{
+    m_model = model;
+}
+
+void FsmModelProxy::post(std::function<void()> call) const
+{
+    m_modelQueue->post(std::move(call));
+}
+
+void FsmModelProxy::call(const std::function<void()> &call) const
+{
+    m_modelQueue->call(call);
+
+    // The view sees the results before the call returns (same as with the model on this thread)
+    m_viewQueue->drain();
+}
+
+void FsmModelProxy::updateState(const QString &name, const QPoint &pos)
+{
+    this->call([&]() { m_model->updateState(name, pos); });
+}
+
+void FsmModelProxy::updateStateName(const QString &oldName, const QString &newName)
+{
+    this->call([&]() { m_model->updateStateName(oldName, newName); });
+}
+
+void FsmModelProxy::updateAction(const QString &parentState, const QString &action)
+{
+    this->call([&]() { m_model->updateAction(parentState, action); });
+}
+
+void FsmModelProxy::updateActiveState(const QString &name)
+{
+    this->call([&]() { m_model->updateActiveState(name); });
+}
+
+void FsmModelProxy::updateCondition(size_t transitionId, const QString &condition)
+{
+    this->call([&]() { m_model->updateCondition(transitionId, condition); });
+}
+
+void FsmModelProxy::updateTransition(size_t transitionId, const QString &srcState, const QString &destState)
+{
+    this->call([&]() { m_model->updateTransition(transitionId, srcState, destState); });
+}
+
+void FsmModelProxy::updateVarInput(const QString &name, const QString &value)
+{
+    this->call([&]() { m_model->updateVarInput(name, value); });
+}
+
+void FsmModelProxy::updateVarInputs(const FsmInputBatch &inputs)
+{
+    this->call([&]() { m_model->updateVarInputs(inputs); });
+}
+
+void FsmModelProxy::updateVarOutput(const QString &name, const QString &value)
+{
+    this->call([&]() { m_model->updateVarOutput(name, value); });
+}
+
+void FsmModelProxy::updateVarInternal(const QString &name, const QVariant &value)
+{
+    this->call([&]() { m_model->updateVarInternal(name, value); });
+}
+
+void FsmModelProxy::destroyState(const QString &name)
+{
+    this->call([&]() { m_model->destroyState(name); });
+}
+
+void FsmModelProxy::destroyAction(const QString &parentState)
+{
+    this->call([&]() { m_model->destroyAction(parentState); });
+}
+
+void FsmModelProxy::destroyCondition(size_t transitionId)
+{
+    this->call([&]() { m_model->destroyCondition(transitionId); });
+}
+
+void FsmModelProxy::destroyTransition(size_t transitionId)
+{
+    this->call([&]() { m_model->destroyTransition(transitionId); });
+}
+
+void FsmModelProxy::destroyVarInput(const QString &name)
+{
+    this->call([&]() { m_model->destroyVarInput(name); });
+}
+
+void FsmModelProxy::destroyVarOutput(const QString &name)
+{
+    this->call([&]() { m_model->destroyVarOutput(name); });
+}
+
+void FsmModelProxy::destroyVarInternal(const QString &name)
+{
+    this->call([&]() { m_model->destroyVarInternal(name); });
+}
+
+void FsmModelProxy::loadFile(const QString &filename)
+{
+    this->call([&]() { m_model->loadFile(filename); });
+}
+
+void FsmModelProxy::saveFile(const QString &filename)
+{
+    this->call([&]() { m_model->saveFile(filename); });
+}
+
+void FsmModelProxy::loadStream(QTextStream &stream)
+{
+    // Stream stays owned by the caller, who waits for the model meanwhile
+    this->call([&]() { m_model->loadStream(stream); });
+}
+
+void FsmModelProxy::saveStream(QTextStream &stream)
+{
+    this->call([&]() { m_model->saveStream(stream); });
+}
+
+void FsmModelProxy::saveChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    this->call([&]() { m_model->saveChanges(stream, session, version); });
+}
+
+bool FsmModelProxy::loadChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    bool loaded = false;
+    this->call([&]() { loaded = m_model->loadChanges(stream, session, version); });
+    return loaded;
+}
+
+void FsmModelProxy::renameFsm(const QString &name)
+{
+    this->call([&]() { m_model->renameFsm(name); });
+}
+
+void FsmModelProxy::log(const QString &time, const QString &state, const QString &varInputs, const QString &varOutputs, const QString &varInternals) const
+{
+    this->call([&]() { m_model->log(time, state, varInputs, varOutputs, varInternals); });
+}
+
+void FsmModelProxy::log() const
+{
+    this->call([&]() { m_model->log(); });
+}
+
+void FsmModelProxy::startInterpretation()
+{
+    this->post([this]() { m_model->startInterpretation(); });
+}
+
+void FsmModelProxy::stopInterpretation()
+{
+    this->post([this]() { m_model->stopInterpretation(); });
+}
+
+void FsmModelProxy::restoreInterpretationBackup()
+{
+    this->call([&]() { m_model->restoreInterpretationBackup(); });
+}
+
+void FsmModelProxy::cleanup()
+{
+    this->call([&]() { m_model->cleanup(); });
+}
+
+void FsmModelProxy::throwError(FsmErrorType errNum)
+{
+    this->call([&]() { m_model->throwError(errNum); });
+}
+
+void FsmModelProxy::throwError(FsmErrorType errNum, const QString &errMsg)
+{
+    this->call([&]() { m_model->throwError(errNum, errMsg); });
+}
+
+void FsmModelProxy::outputEvent(const QString &outName)
+{
+    this->call([&]() { m_model->outputEvent(outName); });
+}
+
+void FsmModelProxy::inputEvent(const QString &name, const QString &value)
+{
+    this->post([this, name, value]() { m_model->inputEvent(name, value); });
+}
+
+void FsmModelProxy::inputEvents(const FsmInputBatch &inputs)
+{
+    this->post([this, inputs]() { m_model->inputEvents(inputs); });
+}
+
+void FsmModelProxy::updatesPending()
+{
+    this->post([this]() { m_model->updatesPending(); });
+}
+
+void FsmModelProxy::flushUpdates()
+{
+    this->post([this]() { m_model->flushUpdates(); });
+}
+
+/*
+============================
+         VIEW PROXY
+============================
+*/
+
+FsmViewProxy::FsmViewProxy(FsmCallQueue *viewQueue)
+    :
+    m_viewQueue{viewQueue}
+{
+}
+
+void FsmViewProxy::setTarget(FsmInterface *view)
+{
+    m_view = view;
+}
+
+void FsmViewProxy::post(std::function<void()> call) const
+{
+    // The view may have been unregistered before the notification got delivered
+    m_viewQueue->post([this, call]() {
+        if(m_view != nullptr)
+            call();
+    });
+}
+
+void FsmViewProxy::updateState(const QString &name, const QPoint &pos)
+{
+    this->post([this, name, pos]() { m_view->updateState(name, pos); });
+}
+
+void FsmViewProxy::updateStateName(const QString &oldName, const QString &newName)
+{
+    this->post([this, oldName, newName]() { m_view->updateStateName(oldName, newName); });
+}
+
+void FsmViewProxy::updateAction(const QString &parentState, const QString &action)
+{
+    this->post([this, parentState, action]() { m_view->updateAction(parentState, action); });
+}
+
+void FsmViewProxy::updateActiveState(const QString &name)
+{
+    this->post([this, name]() { m_view->updateActiveState(name); });
+}
+
+void FsmViewProxy::updateCondition(size_t transitionId, const QString &condition)
+{
+    this->post([this, transitionId, condition]() { m_view->updateCondition(transitionId, condition); });
+}
+
+void FsmViewProxy::updateTransition(size_t transitionId, const QString &srcState, const QString &destState)
+{
+    this->post([this, transitionId, srcState, destState]() { m_view->updateTransition(transitionId, srcState, destState); });
+}
+
+void FsmViewProxy::updateVarInput(const QString &name, const QString &value)
+{
+    this->post([this, name, value]() { m_view->updateVarInput(name, value); });
+}
+
+void FsmViewProxy::updateVarInputs(const FsmInputBatch &inputs)
+{
+    this->post([this, inputs]() { m_view->updateVarInputs(inputs); });
+}
+
+void FsmViewProxy::updateVarOutput(const QString &name, const QString &value)
+{
+    this->post([this, name, value]() { m_view->updateVarOutput(name, value); });
+}
+
+void FsmViewProxy::updateVarInternal(const QString &name, const QVariant &value)
+{
+    this->post([this, name, value]() { m_view->updateVarInternal(name, value); });
+}
+
+void FsmViewProxy::destroyState(const QString &name)
+{
+    this->post([this, name]() { m_view->destroyState(name); });
+}
+
+void FsmViewProxy::destroyAction(const QString &parentState)
+{
+    this->post([this, parentState]() { m_view->destroyAction(parentState); });
+}
+
+void FsmViewProxy::destroyCondition(size_t transitionId)
+{
+    this->post([this, transitionId]() { m_view->destroyCondition(transitionId); });
+}
+
+void FsmViewProxy::destroyTransition(size_t transitionId)
+{
+    this->post([this, transitionId]() { m_view->destroyTransition(transitionId); });
+}
+
+void FsmViewProxy::destroyVarInput(const QString &name)
+{
+    this->post([this, name]() { m_view->destroyVarInput(name); });
+}
+
+void FsmViewProxy::destroyVarOutput(const QString &name)
+{
+    this->post([this, name]() { m_view->destroyVarOutput(name); });
+}
+
+void FsmViewProxy::destroyVarInternal(const QString &name)
+{
+    this->post([this, name]() { m_view->destroyVarInternal(name); });
+}
+
+void FsmViewProxy::loadFile(const QString &filename)
+{
+    this->post([this, filename]() { m_view->loadFile(filename); });
+}
+
+void FsmViewProxy::saveFile(const QString &filename)
+{
+    this->post([this, filename]() { m_view->saveFile(filename); });
+}
+
+void FsmViewProxy::loadStream(QTextStream &stream)
+{
+    // Streams are owned by the caller ==> can't be handed over to another thread without waiting
+    Q_UNUSED(stream);
+    qWarning() << "Model thread: Stream can't be passed to the view";
+}
+
+void FsmViewProxy::saveStream(QTextStream &stream)
+{
+    Q_UNUSED(stream);
+    qWarning() << "Model thread: Stream can't be passed to the view";
+}
+
+void FsmViewProxy::saveChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    Q_UNUSED(stream);
+    Q_UNUSED(session);
+    Q_UNUSED(version);
+    qWarning() << "Model thread: Stream can't be passed to the view";
+}
+
+bool FsmViewProxy::loadChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    Q_UNUSED(stream);
+    Q_UNUSED(session);
+    Q_UNUSED(version);
+    qWarning() << "Model thread: Stream can't be passed to the view";
+    return false;
+}
+
+void FsmViewProxy::renameFsm(const QString &name)
+{
+    this->post([this, name]() { m_view->renameFsm(name); });
+}
+
+void FsmViewProxy::log(const QString &time, const QString &state, const QString &varInputs, const QString &varOutputs, const QString &varInternals) const
+{
+    this->post([this, time, state, varInputs, varOutputs, varInternals]() {
+        m_view->log(time, state, varInputs, varOutputs, varInternals);
+    });
+}
+
+void FsmViewProxy::log() const
+{
+    this->post([this]() { m_view->log(); });
+}
+
+void FsmViewProxy::startInterpretation()
+{
+    this->post([this]() { m_view->startInterpretation(); });
+}
+
+void FsmViewProxy::stopInterpretation()
+{
+    this->post([this]() { m_view->stopInterpretation(); });
+}
+
+void FsmViewProxy::restoreInterpretationBackup()
+{
+    this->post([this]() { m_view->restoreInterpretationBackup(); });
+}
+
+void FsmViewProxy::cleanup()
+{
+    this->post([this]() { m_view->cleanup(); });
+}
+
+void FsmViewProxy::throwError(FsmErrorType errNum)
+{
+    this->post([this, errNum]() { m_view->throwError(errNum); });
+}
+
+void FsmViewProxy::throwError(FsmErrorType errNum, const QString &errMsg)
+{
+    this->post([this, errNum, errMsg]() { m_view->throwError(errNum, errMsg); });
+}
+
+void FsmViewProxy::outputEvent(const QString &outName)
+{
+    this->post([this, outName]() { m_view->outputEvent(outName); });
+}
+
+void FsmViewProxy::inputEvent(const QString &name, const QString &value)
+{
+    this->post([this, name, value]() { m_view->inputEvent(name, value); });
+}
+
+void FsmViewProxy::inputEvents(const FsmInputBatch &inputs)
+{
+    this->post([this, inputs]() { m_view->inputEvents(inputs); });
+}
+
+void FsmViewProxy::updatesPending()
+{
+    this->post([this]() { m_view->updatesPending(); });
+}
+
+void FsmViewProxy::flushUpdates()
+{
+    this->post([this]() { m_view->flushUpdates(); });
+}
+
+/*
+============================
+        MODEL THREAD
+============================
+*/
+
+FsmModelThread::FsmModelThread()
+    :
+    m_modelQueue{new FsmCallQueue},
+    m_modelProxy{m_modelQueue, &m_viewQueue},
+    m_viewProxy{&m_viewQueue}
+{
+    m_thread.setObjectName("FsmModel");
+    m_modelQueue->moveToThread(&m_thread);
+    m_thread.start();
+
+    // Engine, state machine and timers belong to the thread that creates them
+    m_modelQueue->call([this]() {
+        m_model = new FsmModel;
+        m_model->registerView(&m_viewProxy);
+    });
+    m_modelProxy.setTarget(m_model);
+
+    qInfo() << "Model thread: Started";
+}
+
+FsmModelThread::~FsmModelThread()
+{
+    // Notifications still queued are dropped
+    m_viewProxy.setTarget(nullptr);
+
+    m_modelQueue->call([this]() {
+        delete m_model;
+        m_model = nullptr;
+    });
+
+    m_thread.quit();
+    m_thread.wait();
+    delete m_modelQueue;
+}
+
+FsmInterface *FsmModelThread::model()
+{
+    return &m_modelProxy;
+}
+
+void FsmModelThread::registerView(FsmInterface *view)
+{
+    m_viewProxy.setTarget(view);
+}
+
+void FsmModelThread::access(const std::function<void(FsmModel &)> &code)
+{
+    m_modelQueue->call([&]() { code(*m_model); });
+    m_viewQueue.drain();
+}
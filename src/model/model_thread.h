@@ -0,0 +1,278 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file model_thread.h
+ * @author xcervia00
+ *
+ * @brief Model running on its own thread; calls between the model and the view are marshalled by proxies (interface)
+ *
+ */
+
+#ifndef MODEL_THREAD_H_
+#define MODEL_THREAD_H_
+
+#include <QObject>
+#include <QThread>
+#include <QAtomicInt>
+
+#include <functional>
+
+#include "mvc_interface.h"
+#include "spsc_queue.h"
+
+class FsmModel;
+
+/**
+ * @brief Calls executed on the thread the queue lives on
+ * @note Calls are passed through a lock-free queue; a single queued invocation of process() drains everything
+ * posted until then. Only one thread may post (and call) to a queue.
+ */
+class FsmCallQueue : public QObject
+{
+    Q_OBJECT
+
+    private:
+        SpscQueue<std::function<void()>> m_calls; ///< Posted calls
+        QAtomicInt m_scheduled; ///< Is process() already scheduled?
+
+    private slots:
+        /**
+         * @brief Executes everything posted (from the event loop of the thread)
+         */
+        void process();
+
+    public:
+        /**
+         * @brief Constructor of the queue
+         * @param parent The parent object
+         */
+        explicit FsmCallQueue(QObject *parent = nullptr);
+
+        /**
+         * @brief Posts a call to the thread of the queue
+         * @param call The call
+         */
+        void post(std::function<void()> call);
+
+        /**
+         * @brief Executes a call on the thread of the queue and waits for it (after everything posted before)
+         * @param call The call
+         * @note Executed directly when called from the thread of the queue
+         */
+        void call(const std::function<void()> &call);
+
+        /**
+         * @brief Executes everything posted until now (thread of the queue only)
+         */
+        void drain();
+};
+
+/**
+ * @brief Stands in for the model on the thread of the view
+ * @note Input events, start/stop of interpretation and flushes are only posted, so the view never waits for the
+ * interpreter. Everything else (editing, files) waits for the model and then delivers the notifications it produced,
+ * so the view sees the same order of calls as with the model on its own thread.
+ */
+class FsmModelProxy : public FsmInterface
+{
+    private:
+        FsmInterface *m_model = nullptr; ///< The model (used on its thread only)
+        FsmCallQueue *m_modelQueue; ///< Calls to the thread of the model
+        FsmCallQueue *m_viewQueue; ///< Notifications for the thread of the view
+
+        /**
+         * @brief Posts a call to the model
+         * @param call The call
+         */
+        void post(std::function<void()> call) const;
+
+        /**
+         * @brief Executes a call on the model, then delivers its notifications
+         * @param call The call
+         */
+        void call(const std::function<void()> &call) const;
+
+    public:
+        /**
+         * @brief Constructor of the proxy
+         * @param modelQueue Calls to the thread of the model
+         * @param viewQueue Notifications for the thread of the view
+         */
+        FsmModelProxy(FsmCallQueue *modelQueue, FsmCallQueue *viewQueue);
+
+        /**
+         * @brief Sets the model the calls are passed to
+         * @param model The model
+         */
+        void setTarget(FsmInterface *model);
+
+        void updateState(const QString &name, const QPoint &pos) override;
+        void updateStateName(const QString &oldName, const QString &newName) override;
+        void updateAction(const QString &parentState, const QString &action) override;
+        void updateActiveState(const QString &name) override;
+
+        void updateCondition(size_t transitionId, const QString &condition) override;
+        void updateTransition(size_t transitionId, const QString &srcState, const QString &destState) override;
+        void updateVarInput(const QString &name, const QString &value) override;
+        void updateVarInputs(const FsmInputBatch &inputs) override;
+        void updateVarOutput(const QString &name, const QString &value) override;
+        void updateVarInternal(const QString &name, const QVariant &value) override;
+
+        void destroyState(const QString &name) override;
+        void destroyAction(const QString &parentState) override;
+        void destroyCondition(size_t transitionId) override;
+        void destroyTransition(size_t transitionId) override;
+        void destroyVarInput(const QString &name) override;
+        void destroyVarOutput(const QString &name) override;
+        void destroyVarInternal(const QString &name) override;
+
+        void loadFile(const QString &filename) override;
+        void saveFile(const QString &filename) override;
+        void loadStream(QTextStream &stream) override;
+        void saveStream(QTextStream &stream) override;
+        void saveChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
+        bool loadChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
+
+        void renameFsm(const QString &name) override;
+
+        void log(const QString &time, const QString &state, const QString &varInputs, const QString &varOutputs, const QString &varInternals) const override;
+        void log() const override;
+
+        void startInterpretation() override;
+        void stopInterpretation() override;
+        void restoreInterpretationBackup() override;
+
+        void cleanup() override;
+        void throwError(FsmErrorType errNum) override;
+        void throwError(FsmErrorType errNum, const QString &errMsg) override;
+
+        void outputEvent(const QString &outName) override;
+        void inputEvent(const QString &name, const QString &value) override;
+        void inputEvents(const FsmInputBatch &inputs) override;
+        void updatesPending() override;
+        void flushUpdates() override;
+};
+
+/**
+ * @brief Stands in for the view on the thread of the model
+ * @note Every notification is posted to the thread of the view; the model never waits for the view.
+ */
+class FsmViewProxy : public FsmInterface
+{
+    private:
+        FsmInterface *m_view = nullptr; ///< The view (used on its thread only)
+        FsmCallQueue *m_viewQueue; ///< Notifications for the thread of the view
+
+        /**
+         * @brief Posts a notification to the view
+         * @param call The notification
+         */
+        void post(std::function<void()> call) const;
+
+    public:
+        /**
+         * @brief Constructor of the proxy
+         * @param viewQueue Notifications for the thread of the view
+         */
+        explicit FsmViewProxy(FsmCallQueue *viewQueue);
+
+        /**
+         * @brief Sets the view the notifications are passed to
+         * @param view The view
+         */
+        void setTarget(FsmInterface *view);
+
+        void updateState(const QString &name, const QPoint &pos) override;
+        void updateStateName(const QString &oldName, const QString &newName) override;
+        void updateAction(const QString &parentState, const QString &action) override;
+        void updateActiveState(const QString &name) override;
+
+        void updateCondition(size_t transitionId, const QString &condition) override;
+        void updateTransition(size_t transitionId, const QString &srcState, const QString &destState) override;
+        void updateVarInput(const QString &name, const QString &value) override;
+        void updateVarInputs(const FsmInputBatch &inputs) override;
+        void updateVarOutput(const QString &name, const QString &value) override;
+        void updateVarInternal(const QString &name, const QVariant &value) override;
+
+        void destroyState(const QString &name) override;
+        void destroyAction(const QString &parentState) override;
+        void destroyCondition(size_t transitionId) override;
+        void destroyTransition(size_t transitionId) override;
+        void destroyVarInput(const QString &name) override;
+        void destroyVarOutput(const QString &name) override;
+        void destroyVarInternal(const QString &name) override;
+
+        void loadFile(const QString &filename) override;
+        void saveFile(const QString &filename) override;
+        void loadStream(QTextStream &stream) override;
+        void saveStream(QTextStream &stream) override;
+        void saveChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
+        bool loadChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
+
+        void renameFsm(const QString &name) override;
+
+        void log(const QString &time, const QString &state, const QString &varInputs, const QString &varOutputs, const QString &varInternals) const override;
+        void log() const override;
+
+        void startInterpretation() override;
+        void stopInterpretation() override;
+        void restoreInterpretationBackup() override;
+
+        void cleanup() override;
+        void throwError(FsmErrorType errNum) override;
+        void throwError(FsmErrorType errNum, const QString &errMsg) override;
+
+        void outputEvent(const QString &outName) override;
+        void inputEvent(const QString &name, const QString &value) override;
+        void inputEvents(const FsmInputBatch &inputs) override;
+        void updatesPending() override;
+        void flushUpdates() override;
+};
+
+/**
+ * @brief Model (with its engine, state machine and timers) created on and interpreted by its own thread
+ * @note The view registers model() instead of the model itself; long scripts then don't stall the view and
+ * redrawing of the view doesn't delay inputs or timeouts of the interpretation.
+ */
+class FsmModelThread
+{
+    private:
+        QThread m_thread; ///< Thread of the model
+        FsmCallQueue *m_modelQueue; ///< Calls to the thread of the model (lives on it)
+        FsmCallQueue m_viewQueue; ///< Notifications for the thread of the view
+        FsmModel *m_model = nullptr; ///< The model (created on its thread)
+        FsmModelProxy m_modelProxy; ///< Model as seen by the view
+        FsmViewProxy m_viewProxy; ///< View as seen by the model
+
+    public:
+        /**
+         * @brief Constructor; starts the thread and creates the model on it
+         * @note Has to be constructed on the thread of the view
+         */
+        FsmModelThread();
+
+        /**
+         * @brief Destructor; destroys the model on its thread and stops the thread
+         */
+        ~FsmModelThread();
+
+        /**
+         * @brief The model as seen from the thread of the view
+         * @return The proxy to register with the view
+         */
+        FsmInterface *model();
+
+        /**
+         * @brief Registers the view notified by the model
+         * @param view The view (lives on the thread the model thread was constructed on)
+         */
+        void registerView(FsmInterface *view);
+
+        /**
+         * @brief Runs code with direct access to the model on its thread and waits for it
+         * @param code The code
+         */
+        void access(const std::function<void(FsmModel &)> &code);
+};
+
+#endif
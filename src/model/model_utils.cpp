@@ -18,38 +18,28 @@
 #include "mvc_interface.h"
 #include "model.h"
 #include "combined_event.h"
-
-#include <QtWidgets>
+#include "async_logger.h"
 
 
 /**
- * @brief Converts all elements of a hashmap into strings with their values
- * @tparam Key The key used by the hashmap
- * @tparam Value The value type used by the hashmap
- * @param container The actual hashmap container
+ * @brief Converts all variables of a scope into strings with their values
+ * @param vars The registry holding the variables
+ * @param scope The scope of variables to convert
  * @param out The string to which the result is saved
  */
-template <typename Key, typename Value>
-void hashmapToString(const QHash<Key, Value> &container, QString &out)
+static void variablesToString(const VariableRegistry &vars, VariableScope scope, QString &out)
 {
     QTextStream stream(&out);
-    for (auto it = (container).constBegin(); it != (container).constEnd(); it++)
-    {
-        stream << QStringLiteral("\t") << it.key();
+    vars.forEach(scope, [&](int slot, const QString &name) {
+        stream << QStringLiteral("\t") << name;
 
-        if constexpr (std::is_same_v<Value, QVariant>) {
-            if(!it.value().toString().isEmpty()){
-                stream << QStringLiteral("\t=\t") << it.value().toString();
-            }
+        QString value = vars.toStringAt(scope, slot);
+        if(!value.isEmpty()){
+            stream << QStringLiteral("\t=\t") << value;
         }
-        else {
-            if(!it.value().isEmpty()){
-                stream << QStringLiteral("\t=\t") << it.value();
-            }
-        } 
-        
+
         stream << "\n";
-    }
+    });
 }
 
 void FsmModel::registerView(FsmInterface *view)
@@ -77,6 +67,54 @@ QStateMachine *FsmModel::getMachine()
     return &this->machine;
 }
 
+void FsmModel::setEngineType(FsmEngineType engineType)
+{
+    this->engineType = engineType;
+}
+
+FsmEngineType FsmModel::getEngineType() const
+{
+    return this->engineType;
+}
+
+bool FsmModel::setClock(FsmClock *clock)
+{
+    // Pending timeouts and elapsed times would mix two clocks
+    if(this->interpreting())
+    {
+        qWarning() << "Cannot change the clock while interpreting";
+        return false;
+    }
+
+    this->clock = clock != nullptr ? clock : FsmClock::system();
+    this->context.clock = this->clock;
+    this->timers.setClock(this->clock);
+    this->trace.setClock(this->clock);
+    this->instances.setClock(this->clock);
+    return true;
+}
+
+FsmClock *FsmModel::getClock() const
+{
+    return this->clock;
+}
+
+bool FsmModel::interpreting() const
+{
+    return this->machine.isRunning() || this->flatEngine.isRunning();
+}
+
+void FsmModel::postInput(const QString &name)
+{
+    if(this->trace.isRecording())
+        this->trace.recordInput(name);
+
+    if(this->flatEngine.isRunning())
+        this->flatEngine.postInput(name);
+    else
+        this->machine.postEvent(new FsmInputEvent(name));
+}
+
 void FsmModel::log(const QString &time, const QString &state, const QString &varInputs, const QString &varOutputs, const QString &varInternals) const
 {
     (void)time;
@@ -95,10 +133,10 @@ void FsmModel::log() const
     QString outputs;
     QString internals;
     
-    // Convert hasmaps into string representations
-    hashmapToString(this->varsInput, inputs);
-    hashmapToString(this->varsOutput, outputs);
-    hashmapToString(this->varsInternal, internals);
+    // Convert variables into string representations
+    variablesToString(this->vars, VAR_SCOPE_INPUT, inputs);
+    variablesToString(this->vars, VAR_SCOPE_OUTPUT, outputs);
+    variablesToString(this->vars, VAR_SCOPE_INTERNAL, internals);
 
     this->log("",
             this->getActiveName(),
@@ -116,6 +154,9 @@ void FsmModel::cleanup()
     if (machine.isRunning()) {
         machine.stop();
     }
+    flatEngine.clear();
+    instances.clear();
+    timers.reset();
 
     // Remove transitions first
     for (CombinedTransition* tr : transitions.values()) {
@@ -138,9 +179,7 @@ void FsmModel::cleanup()
     qDeleteAll(transitions.values());
 
     // Clear variables
-    varsInternal.clear();
-    varsInput.clear();
-    varsOutput.clear();
+    vars.clear();
 
     // Reset initial state to nothing
     this->machine.setInitialState(nullptr);
@@ -148,6 +187,9 @@ void FsmModel::cleanup()
     // Reset transition unique id;
     this->uniqueTransId = 0;
 
+    // Copies of the previous machine can't catch up by edits
+    this->changes.reset();
+
     view->cleanup();
 }
 
@@ -163,37 +205,122 @@ void FsmModel::throwError(FsmErrorType errNum, const QString &errMsg)
 
 void FsmModel::outputEvent(const QString &outName)
 {
-    qInfo() << "Fired output event " << outName << ": " << this->varsOutput.value(outName);
-    view->outputEvent(this->varsOutput.value(outName));
+    const QString value = this->vars.string(VAR_SCOPE_OUTPUT, outName);
+    logEvent(LOG_OUTPUT_EVENT, outName, value);
+    if(this->trace.isRecording())
+        this->trace.recordOutput(outName);
+    view->outputEvent(value);
 }
 
 void FsmModel::inputEvent(const QString &name, const QString &value)
 {
     // Accept events only if interpretation is running
-    if(!this->machine.isRunning()){
+    if(!this->interpreting()){
         qWarning() << "Caught input event " << name << " of value: " << value << " while FSM is inactive";
         return;
     }
 
     // Check if given input variable exists
-    auto it = this->varsInput.find(name);
+    int slot = this->vars.slot(VAR_SCOPE_INPUT, name);
     
     // The input variable exits!
-    if(it != this->varsInput.end())
+    if(slot >= 0)
     {
-        qInfo() << "Caught input event " << name << " of value: " << value;
+        logEvent(LOG_INPUT_EVENT, name, value);
 
         // Update value
-        this->updateVarInput(name, value);
+        this->vars.setString(VAR_SCOPE_INPUT, slot, value);
+        this->notifyVarUpdate(VAR_SCOPE_INPUT, slot);
 
         // Fire event
-        this->machine.postEvent(new FsmInputEvent(name));
+        this->postInput(name);
+    }
+}
+
+void FsmModel::inputEvents(const FsmInputBatch &inputs)
+{
+    // Accept events only if interpretation is running
+    if(!this->interpreting()){
+        qWarning() << "Caught " << inputs.size() << " input events while FSM is inactive";
+        return;
+    }
+
+    // Update all values first (unknown inputs are ignored)
+    auto accepted = this->storeInputs(inputs);
+    if(accepted.isEmpty())
+        return;
+
+    logEvent(LOG_INPUT_BATCH, QString(), QString(), accepted.size());
+
+    // Posted events are queued by the engine and processed together in a single pass
+    for (const auto &input : accepted)
+    {
+        this->postInput(input.first);
+    }
+}
+
+void FsmModel::updatesPending()
+{
+    // The model is the one reporting pending updates
+}
+
+void FsmModel::flushUpdates()
+{
+    if(this->viewUpdates.isEmpty())
+        return;
+
+    QVector<DirtyVariable> variables;
+    QString state;
+    this->viewUpdates.take(variables, state);
+
+    // Values are read now; every variable is sent once with its latest value
+    for(const auto &variable : variables)
+    {
+        if(!vars.isValid(variable.scope, variable.slot))
+            continue;
+
+        const QString &name = vars.name(variable.scope, variable.slot);
+        switch(variable.scope)
+        {
+            case VAR_SCOPE_INPUT:
+                view->updateVarInput(name, vars.stringAt(variable.scope, variable.slot));
+                break;
+            case VAR_SCOPE_OUTPUT:
+                view->updateVarOutput(name, vars.stringAt(variable.scope, variable.slot));
+                break;
+            default:
+                view->updateVarInternal(name, vars.valueAt(variable.scope, variable.slot));
+                break;
+        }
+    }
+
+    if(!state.isEmpty() && this->states.contains(state))
+        view->updateActiveState(state);
+}
+
+quint64 FsmModel::coalescedUpdates() const
+{
+    return this->viewUpdates.coalesced();
+}
+
+const QRegularExpression &FsmModel::formatRegex(const char *regexPattern)
+{
+    // Patterns are string constants ==> their address identifies them
+    static QHash<const char*, QRegularExpression> cache;
+
+    auto it = cache.find(regexPattern);
+    if(it == cache.end())
+    {
+        it = cache.insert(regexPattern, QRegularExpression(regexPattern));
+        it->optimize();
     }
+
+    return it.value();
 }
 
 bool FsmModel::checkValidFormat(const QString &str, const char *regex)
 {
-    return QRegularExpression(regex).match(str).hasMatch();
+    return formatRegex(regex).match(str).hasMatch();
 }
 
 const QString FsmModel::getActiveName() const
@@ -0,0 +1,98 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file spsc_queue.h
+ * @author xcervia00
+ *
+ * @brief Unbounded lock-free queue with a single producer and a single consumer thread
+ *
+ */
+
+#ifndef SPSC_QUEUE_H_
+#define SPSC_QUEUE_H_
+
+#include <QAtomicPointer>
+
+#include <utility>
+
+/**
+ * @brief Linked list of nodes; the producer links new nodes behind the tail, the consumer frees the nodes it passed
+ * @note The head is always a consumed (stub) node, so the producer and the consumer never touch the same node except
+ * through its atomic next pointer. Push never blocks nor fails (the queue is unbounded).
+ */
+template <typename T>
+class SpscQueue
+{
+    private:
+        /**
+         * @brief Single queued value
+         */
+        struct Node
+        {
+            T value; ///< The value (moved out once consumed)
+            QAtomicPointer<Node> next; ///< The following node; nullptr at the tail
+        };
+
+        Node *m_head; ///< Last consumed node (consumer only)
+        Node *m_tail; ///< Last pushed node (producer only)
+
+    public:
+        /**
+         * @brief Constructor of an empty queue
+         */
+        SpscQueue()
+            :
+            m_head{new Node},
+            m_tail{m_head}
+        {
+        }
+
+        /**
+         * @brief Destructor; drops values that were not consumed
+         */
+        ~SpscQueue()
+        {
+            while(m_head != nullptr)
+            {
+                Node *next = m_head->next.loadAcquire();
+                delete m_head;
+                m_head = next;
+            }
+        }
+
+        SpscQueue(const SpscQueue &) = delete;
+        SpscQueue &operator=(const SpscQueue &) = delete;
+
+        /**
+         * @brief Appends a value (producer thread only)
+         * @param value The value
+         */
+        void push(T value)
+        {
+            Node *node = new Node;
+            node->value = std::move(value);
+
+            // Publishes the value together with the node
+            m_tail->next.storeRelease(node);
+            m_tail = node;
+        }
+
+        /**
+         * @brief Takes the oldest value (consumer thread only)
+         * @param value The value
+         * @return False if the queue is empty
+         */
+        bool pop(T &value)
+        {
+            Node *next = m_head->next.loadAcquire();
+            if(next == nullptr)
+                return false;
+
+            value = std::move(next->value);
+            delete m_head;
+            m_head = next;
+            return true;
+        }
+};
+
+#endif
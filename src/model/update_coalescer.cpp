@@ -0,0 +1,68 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file update_coalescer.cpp
+ * @author xcervia00
+ *
+ * @brief Updates of interpretation collected for a single delivery to the view
+ *
+ */
+
+#include "update_coalescer.h"
+
+bool UpdateCoalescer::markVariable(VariableScope scope, int slot)
+{
+    bool wasEmpty = this->isEmpty();
+    quint64 key = (static_cast<quint64>(scope) << 32) | static_cast<quint32>(slot);
+
+    if(m_pending.contains(key))
+    {
+        m_coalesced++;
+        return false;
+    }
+
+    m_pending.insert(key);
+    m_variables.append({scope, slot});
+    return wasEmpty;
+}
+
+bool UpdateCoalescer::markState(const QString &name)
+{
+    bool wasEmpty = this->isEmpty();
+
+    if(m_stateChanged)
+        m_coalesced++;
+
+    m_state = name;
+    m_stateChanged = true;
+    return wasEmpty;
+}
+
+bool UpdateCoalescer::isEmpty() const
+{
+    return m_variables.isEmpty() && !m_stateChanged;
+}
+
+void UpdateCoalescer::take(QVector<DirtyVariable> &variables, QString &state)
+{
+    variables.clear();
+    variables.swap(m_variables);
+    m_pending.clear();
+
+    state = m_stateChanged ? m_state : QString();
+    m_state.clear();
+    m_stateChanged = false;
+}
+
+void UpdateCoalescer::clear()
+{
+    m_pending.clear();
+    m_variables.clear();
+    m_state.clear();
+    m_stateChanged = false;
+}
+
+quint64 UpdateCoalescer::coalesced() const
+{
+    return m_coalesced;
+}
@@ -0,0 +1,84 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file update_coalescer.h
+ * @author xcervia00
+ *
+ * @brief Updates of interpretation collected for a single delivery to the view (interface)
+ *
+ */
+
+#ifndef UPDATE_COALESCER_H_
+#define UPDATE_COALESCER_H_
+
+#include <QString>
+#include <QSet>
+#include <QVector>
+
+#include "variable_registry.h"
+
+/**
+ * @brief Variable of the registry changed since the last delivery
+ */
+struct DirtyVariable
+{
+    VariableScope scope; ///< The scope of the variable
+    int slot; ///< The slot of the variable
+};
+
+/**
+ * @brief Set of variables changed and the state entered since the last delivery
+ * @note Every further change of an already pending variable (or state) only increments the counter of coalesced
+ * updates; the value is read from the registry once the updates are taken.
+ */
+class UpdateCoalescer
+{
+    private:
+        QSet<quint64> m_pending; ///< Pending variables, (scope << 32 | slot)
+        QVector<DirtyVariable> m_variables; ///< Pending variables in order of their first change
+        QString m_state; ///< Last entered state
+        bool m_stateChanged = false; ///< Is m_state pending?
+        quint64 m_coalesced = 0; ///< Number of updates merged into a pending one
+
+    public:
+        /**
+         * @brief Marks a variable as changed
+         * @param scope The scope of the variable
+         * @param slot The slot of the variable
+         * @return True if nothing was pending before (the view has to be notified)
+         */
+        bool markVariable(VariableScope scope, int slot);
+
+        /**
+         * @brief Marks a state as entered
+         * @param name The name of the state
+         * @return True if nothing was pending before (the view has to be notified)
+         */
+        bool markState(const QString &name);
+
+        /**
+         * @brief Is anything pending?
+         * @return True if there is nothing to deliver
+         */
+        bool isEmpty() const;
+
+        /**
+         * @brief Takes everything pending
+         * @param variables Changed variables (in order of their first change)
+         * @param state The last entered state; empty if no state was entered
+         */
+        void take(QVector<DirtyVariable> &variables, QString &state);
+
+        /**
+         * @brief Drops everything pending (e.g. slots are about to be reused)
+         */
+        void clear();
+
+        /**
+         * @brief Number of updates merged into a pending one (never delivered on their own)
+         * @return The count
+         */
+        quint64 coalesced() const;
+};
+
+#endif
@@ -0,0 +1,197 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file variable_registry.cpp
+ * @author xcervia00
+ *
+ * @brief Slot-indexed storage of FSM variables
+ *
+ */
+
+#include "variable_registry.h"
+
+#include <cmath>
+#include <limits>
+
+void VariableRegistry::resetSlot(Table &table, int slot)
+{
+    table.strings[slot].clear();
+    table.others[slot].clear();
+}
+
+int VariableRegistry::define(VariableScope scope, const QString &name)
+{
+    Table &table = m_tables[scope];
+
+    auto it = table.index.constFind(name);
+    if(it != table.index.constEnd())
+        return it.value();
+
+    // New variables always get a fresh slot ==> already bound slots never change meaning
+    int slot = table.types.size();
+    table.index.insert(name, slot);
+    table.names.append(name);
+    table.types.append(VAR_TYPE_STRING);
+    table.ints.append(0);
+    table.floats.append(0);
+    table.bools.append(false);
+    table.strings.append(QString());
+    table.others.append(QVariant());
+    table.count++;
+
+    m_layoutVersion++;
+    return slot;
+}
+
+bool VariableRegistry::remove(VariableScope scope, const QString &name)
+{
+    Table &table = m_tables[scope];
+
+    auto it = table.index.find(name);
+    if(it == table.index.end())
+        return false;
+
+    int slot = it.value();
+    table.index.erase(it);
+    table.types[slot] = VAR_TYPE_NONE;
+    table.names[slot].clear();
+    resetSlot(table, slot);
+    table.count--;
+
+    m_layoutVersion++;
+    return true;
+}
+
+void VariableRegistry::clear()
+{
+    for(auto &table : m_tables)
+    {
+        table = Table();
+    }
+
+    m_layoutVersion++;
+}
+
+QVariant VariableRegistry::valueAt(VariableScope scope, int slot) const
+{
+    if(!this->isValid(scope, slot))
+        return QVariant();
+
+    const Table &table = m_tables[scope];
+    switch(table.types.at(slot))
+    {
+        case VAR_TYPE_INT:
+            return QVariant(table.ints.at(slot));
+        case VAR_TYPE_FLOAT:
+            return QVariant(table.floats.at(slot));
+        case VAR_TYPE_BOOL:
+            return QVariant(table.bools.at(slot));
+        case VAR_TYPE_STRING:
+            return QVariant(table.strings.at(slot));
+        case VAR_TYPE_OTHER:
+            return table.others.at(slot);
+        default:
+            return QVariant();
+    }
+}
+
+QString VariableRegistry::toStringAt(VariableScope scope, int slot) const
+{
+    if(!this->isValid(scope, slot))
+        return QString();
+
+    // Strings are the common case (all inputs/outputs) ==> no boxing
+    if(m_tables[scope].types.at(slot) == VAR_TYPE_STRING)
+        return m_tables[scope].strings.at(slot);
+
+    return this->valueAt(scope, slot).toString();
+}
+
+void VariableRegistry::setInt(VariableScope scope, int slot, qint32 value)
+{
+    Table &table = m_tables[scope];
+    resetSlot(table, slot);
+    table.types[slot] = VAR_TYPE_INT;
+    table.ints[slot] = value;
+}
+
+void VariableRegistry::setFloat(VariableScope scope, int slot, double value)
+{
+    Table &table = m_tables[scope];
+    resetSlot(table, slot);
+    table.types[slot] = VAR_TYPE_FLOAT;
+    table.floats[slot] = value;
+}
+
+void VariableRegistry::setBool(VariableScope scope, int slot, bool value)
+{
+    Table &table = m_tables[scope];
+    resetSlot(table, slot);
+    table.types[slot] = VAR_TYPE_BOOL;
+    table.bools[slot] = value;
+}
+
+void VariableRegistry::setString(VariableScope scope, int slot, const QString &value)
+{
+    Table &table = m_tables[scope];
+    table.others[slot].clear();
+    table.types[slot] = VAR_TYPE_STRING;
+    table.strings[slot] = value;
+}
+
+void VariableRegistry::setNumber(VariableScope scope, int slot, double value)
+{
+    // -0 has to stay a double
+    if(value >= std::numeric_limits<qint32>::min() && value <= std::numeric_limits<qint32>::max()
+        && std::trunc(value) == value && !(value == 0 && std::signbit(value)))
+    {
+        this->setInt(scope, slot, static_cast<qint32>(value));
+    }
+    else
+    {
+        this->setFloat(scope, slot, value);
+    }
+}
+
+void VariableRegistry::setValueAt(VariableScope scope, int slot, const QVariant &value)
+{
+    switch(value.type())
+    {
+        case QVariant::Int:
+            this->setInt(scope, slot, value.toInt());
+            break;
+        case QVariant::Double:
+            this->setFloat(scope, slot, value.toDouble());
+            break;
+        case QVariant::Bool:
+            this->setBool(scope, slot, value.toBool());
+            break;
+        case QVariant::String:
+            this->setString(scope, slot, value.toString());
+            break;
+        default: {
+            Table &table = m_tables[scope];
+            table.strings[slot].clear();
+            table.types[slot] = VAR_TYPE_OTHER;
+            table.others[slot] = value;
+            break;
+        }
+    }
+}
+
+QVariant VariableRegistry::value(VariableScope scope, const QString &name) const
+{
+    return this->valueAt(scope, this->slot(scope, name));
+}
+
+QString VariableRegistry::string(VariableScope scope, const QString &name) const
+{
+    return this->toStringAt(scope, this->slot(scope, name));
+}
+
+int VariableRegistry::insert(VariableScope scope, const QString &name, const QVariant &value)
+{
+    int slot = this->define(scope, name);
+    this->setValueAt(scope, slot, value);
+    return slot;
+}
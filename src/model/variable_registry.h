@@ -0,0 +1,265 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file variable_registry.h
+ * @author xcervia00
+ *
+ * @brief Slot-indexed storage of FSM variables (interface)
+ *
+ */
+
+#ifndef VARIABLE_REGISTRY_H_
+#define VARIABLE_REGISTRY_H_
+
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+/**
+ * @brief Kind of the variable (separate slot space for each)
+ */
+enum VariableScope : uint8_t
+{
+    VAR_SCOPE_INTERNAL,
+    VAR_SCOPE_INPUT,
+    VAR_SCOPE_OUTPUT,
+    VAR_SCOPE_COUNT ///< Count of all scopes
+};
+
+/**
+ * @brief Type of the value currently stored in a slot
+ */
+enum VariableType : uint8_t
+{
+    VAR_TYPE_NONE, ///< Slot of a removed variable
+    VAR_TYPE_INT,
+    VAR_TYPE_FLOAT,
+    VAR_TYPE_BOOL,
+    VAR_TYPE_STRING,
+    VAR_TYPE_OTHER, ///< Anything a script may store that has no typed array (kept as QVariant)
+};
+
+/**
+ * @brief Registry assigning every variable a stable integer slot; values are kept in contiguous typed arrays
+ * @note Slots stay valid until the variable is removed (removed slots are not reused until clear()).
+ * Any change of the slot layout increments layoutVersion(), so cached slots can be rebound.
+ */
+class VariableRegistry
+{
+    private:
+        /**
+         * @brief Storage of a single scope (structure of arrays indexed by slot)
+         */
+        struct Table
+        {
+            QHash<QString,int> index; ///< Name to slot lookup (only live variables)
+            QVector<QString> names; ///< Name of the variable in the slot
+            QVector<VariableType> types; ///< Type of the value in the slot
+            QVector<qint32> ints; ///< Values of int variables
+            QVector<double> floats; ///< Values of float variables
+            QVector<bool> bools; ///< Values of bool variables
+            QVector<QString> strings; ///< Values of string variables (inputs/outputs are always strings)
+            QVector<QVariant> others; ///< Values without a typed array
+            int count = 0; ///< Number of live variables
+        };
+
+        Table m_tables[VAR_SCOPE_COUNT]; ///< Storage for each scope
+        quint64 m_layoutVersion = 0; ///< Incremented whenever a slot is added or removed
+
+        /**
+         * @brief Resets value of a slot so no stale data is kept alive
+         * @param table The table of the slot
+         * @param slot The slot to reset
+         */
+        static void resetSlot(Table &table, int slot);
+
+    public:
+        /**
+         * @brief Looks up slot of a variable
+         * @param scope The scope of the variable
+         * @param name The name of the variable
+         * @return The slot, or -1 if there is no such variable
+         */
+        inline int slot(VariableScope scope, const QString &name) const
+        {
+            return m_tables[scope].index.value(name, -1);
+        }
+
+        /**
+         * @brief Checks whether a variable exists
+         * @param scope The scope of the variable
+         * @param name The name of the variable
+         * @return True if it exists, otherwise false
+         */
+        inline bool contains(VariableScope scope, const QString &name) const
+        {
+            return m_tables[scope].index.contains(name);
+        }
+
+        /**
+         * @brief Returns slot of the variable, creating it if it does not exist yet
+         * @param scope The scope of the variable
+         * @param name The name of the variable
+         * @return The slot of the variable
+         */
+        int define(VariableScope scope, const QString &name);
+
+        /**
+         * @brief Removes a variable (its slot becomes invalid)
+         * @param scope The scope of the variable
+         * @param name The name of the variable
+         * @return True if the variable existed, otherwise false
+         */
+        bool remove(VariableScope scope, const QString &name);
+
+        /**
+         * @brief Removes all variables and resets slot numbering
+         */
+        void clear();
+
+        /**
+         * @brief Number of slots of a scope (including removed ones); valid slots are in range <0, slotCount)
+         * @param scope The scope
+         * @return Count of slots
+         */
+        inline int slotCount(VariableScope scope) const
+        {
+            return m_tables[scope].types.size();
+        }
+
+        /**
+         * @brief Number of existing variables of a scope
+         * @param scope The scope
+         * @return Count of variables
+         */
+        inline int size(VariableScope scope) const
+        {
+            return m_tables[scope].count;
+        }
+
+        /**
+         * @brief Version of the slot layout; changes whenever a variable is added or removed
+         * @return The version
+         */
+        inline quint64 layoutVersion() const
+        {
+            return m_layoutVersion;
+        }
+
+        /*
+         ======================
+         =    Slot access
+         ======================
+        */
+
+        /**
+         * @brief Checks whether slot holds an existing variable
+         * @param scope The scope of the slot
+         * @param slot The slot
+         * @return True if the slot is valid, otherwise false
+         */
+        inline bool isValid(VariableScope scope, int slot) const
+        {
+            return slot >= 0 && slot < m_tables[scope].types.size() && m_tables[scope].types.at(slot) != VAR_TYPE_NONE;
+        }
+
+        // Typed getters; the slot must be valid and hold the matching type
+
+        inline VariableType type(VariableScope scope, int slot) const {return m_tables[scope].types.at(slot);}
+        inline const QString &name(VariableScope scope, int slot) const {return m_tables[scope].names.at(slot);}
+        inline qint32 intAt(VariableScope scope, int slot) const {return m_tables[scope].ints.at(slot);}
+        inline double floatAt(VariableScope scope, int slot) const {return m_tables[scope].floats.at(slot);}
+        inline bool boolAt(VariableScope scope, int slot) const {return m_tables[scope].bools.at(slot);}
+        inline const QString &stringAt(VariableScope scope, int slot) const {return m_tables[scope].strings.at(slot);}
+        inline const QVariant &otherAt(VariableScope scope, int slot) const {return m_tables[scope].others.at(slot);}
+
+        /**
+         * @brief Boxes value of the slot into QVariant (used outside of the hot path - view, saving, logs)
+         * @param scope The scope of the slot
+         * @param slot The slot
+         * @return The value; invalid QVariant for invalid slot
+         */
+        QVariant valueAt(VariableScope scope, int slot) const;
+
+        /**
+         * @brief String representation of the value in the slot
+         * @param scope The scope of the slot
+         * @param slot The slot
+         * @return The value converted to string
+         */
+        QString toStringAt(VariableScope scope, int slot) const;
+
+        // Typed setters; the slot must be valid, the type of the slot is changed accordingly
+
+        void setInt(VariableScope scope, int slot, qint32 value);
+        void setFloat(VariableScope scope, int slot, double value);
+        void setBool(VariableScope scope, int slot, bool value);
+        void setString(VariableScope scope, int slot, const QString &value);
+
+        /**
+         * @brief Stores a JS number (integral values that fit are stored as int, the same as QJSValue::toVariant does)
+         * @param scope The scope of the slot
+         * @param slot The slot
+         * @param value The number to store
+         */
+        void setNumber(VariableScope scope, int slot, double value);
+
+        /**
+         * @brief Stores a value of any type into the slot, choosing the typed array by the variant type
+         * @param scope The scope of the slot
+         * @param slot The slot
+         * @param value The value to store
+         */
+        void setValueAt(VariableScope scope, int slot, const QVariant &value);
+
+        /*
+         ======================
+         =  Name based access
+         ======================
+        */
+
+        /**
+         * @brief Boxed value of a variable
+         * @param scope The scope of the variable
+         * @param name The name of the variable
+         * @return The value; invalid QVariant if the variable does not exist
+         */
+        QVariant value(VariableScope scope, const QString &name) const;
+
+        /**
+         * @brief Value of a variable as a string (inputs/outputs)
+         * @param scope The scope of the variable
+         * @param name The name of the variable
+         * @return The value; empty string if the variable does not exist
+         */
+        QString string(VariableScope scope, const QString &name) const;
+
+        /**
+         * @brief Sets the value of a variable, creating it if it does not exist
+         * @param scope The scope of the variable
+         * @param name The name of the variable
+         * @param value The value to set
+         * @return The slot of the variable
+         */
+        int insert(VariableScope scope, const QString &name, const QVariant &value);
+
+        /**
+         * @brief Calls given function for each existing variable of the scope in slot order
+         * @tparam Func Callable accepting (int slot, const QString &name)
+         * @param scope The scope to iterate
+         * @param func The function to call
+         */
+        template<typename Func>
+        void forEach(VariableScope scope, Func &&func) const
+        {
+            const Table &table = m_tables[scope];
+            for(int slot = 0; slot < table.types.size(); slot++)
+            {
+                if(table.types.at(slot) != VAR_TYPE_NONE)
+                    func(slot, table.names.at(slot));
+            }
+        }
+};
+
+#endif
@@ -14,6 +14,9 @@
 #include <QObject>
 #include <QString>
 #include <QTextStream>
+#include <QDataStream>
+#include <QPair>
+#include <QVector>
 
 namespace FsmFormats
 {
@@ -57,6 +60,15 @@ struct FsmError
 };
 
 
+/**
+ * @brief A single input: name of the input variable and its new value
+ */
+using FsmInput = QPair<QString,QString>;
+/**
+ * @brief Ordered burst of inputs
+ */
+using FsmInputBatch = QVector<FsmInput>;
+
 /**
  * @brief Enumeration for type of a state
  */
@@ -123,6 +135,11 @@ class FsmInterface
          * @param value A string value of the variable
          */
         virtual void updateVarInput(const QString &name, const QString &value) = 0;
+        /**
+         * @brief Update multiple existing input variables at once (coalesced notification)
+         * @param inputs The variables and their new values, in order (the last value of a variable wins)
+         */
+        virtual void updateVarInputs(const FsmInputBatch &inputs) = 0;
         /**
          * @brief Create or Update an output variable
          * @param name The name of the variable
@@ -196,6 +213,23 @@ class FsmInterface
          */
         virtual void saveStream(QTextStream &stream) = 0;
 
+        /**
+         * @brief Saves what a copy of the FSM needs to catch up with it: edits since its version, or the whole FSM if they are not known
+         * @param stream Stream to which to save
+         * @param session Session of the version of the copy (0 if none); set to the session after loading
+         * @param version Version of the copy; set to the version after loading
+         */
+        virtual void saveChanges(QDataStream &stream, quint32 &session, quint64 &version) = 0;
+
+        /**
+         * @brief Loads what was saved by saveChanges
+         * @param stream Stream from which to load
+         * @param session Session of the version of the FSM; updated
+         * @param version Version of the FSM; updated
+         * @return False if the edits do not follow the version (nothing is loaded)
+         */
+        virtual bool loadChanges(QDataStream &stream, quint32 &session, quint64 &version) = 0;
+
         /**
          * @brief Renames the entire FSM
          * @param name The new name to use
@@ -246,6 +280,24 @@ class FsmInterface
          * @param value The value associated with the input
          */
         virtual void inputEvent(const QString &name, const QString &value) = 0;
+
+        /**
+         * @brief Executes a burst of input events at once
+         * @param inputs The input events in order of arrival
+         * @note All input variables are updated first, then the events are processed in a single pass of the machine
+         */
+        virtual void inputEvents(const FsmInputBatch &inputs) = 0;
+
+        /**
+         * @brief Notifies that interpretation produced updates waiting for flushUpdates()
+         * @note Sent once; nothing more is sent until the updates are flushed (e.g. once per display frame)
+         */
+        virtual void updatesPending() = 0;
+
+        /**
+         * @brief Delivers the coalesced updates of interpretation (last value of every changed variable, last entered state)
+         */
+        virtual void flushUpdates() = 0;
   
         /**
          * @brief Cleans up and erases the currently loaded fsm
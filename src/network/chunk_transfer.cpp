@@ -0,0 +1,171 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file chunk_transfer.cpp
+ * @author xcervia00
+ *
+ * @brief Splitting of messages larger than a datagram into chunks and their reassembly
+ *
+ */
+
+#include "chunk_transfer.h"
+
+#include <QtEndian>
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+ChunkSender::ChunkSender(int keep)
+    : m_keep{keep}
+{
+    this->seed();
+}
+
+void ChunkSender::seed()
+{
+    std::random_device dev;
+    m_next = static_cast<quint32>(dev());
+}
+
+quint32 ChunkSender::split(quint8 type, const QByteArray &message)
+{
+    // Machines are mostly text ==> usually compresses well
+    quint8 flags = 0;
+    QByteArray data = qCompress(message);
+    if(data.size() < message.size())
+        flags |= CHUNK_COMPRESSED;
+    else
+        data = message;
+
+    int count = (data.size() + UDP_CHUNK_PAYLOAD - 1) / UDP_CHUNK_PAYLOAD;
+    if(count == 0 || count > UINT16_MAX || count > UDP_CHUNK_COUNT_LIMIT)
+        return 0;
+
+    // Zero is not a transfer
+    quint32 transfer = m_next++;
+    if(transfer == 0)
+        transfer = m_next++;
+
+    QVector<QByteArray> chunks;
+    chunks.reserve(count);
+    for(int index = 0; index < count; index++)
+    {
+        int offset = index * UDP_CHUNK_PAYLOAD;
+        int size = qMin(UDP_CHUNK_PAYLOAD, data.size() - offset);
+
+        QByteArray chunk(UDP_CHUNK_HEADER + size, Qt::Uninitialized);
+        uchar *header = reinterpret_cast<uchar*>(chunk.data());
+        header[0] = type;
+        qToLittleEndian<quint32>(transfer, header + 1);
+        qToLittleEndian<quint16>(static_cast<quint16>(index), header + 5);
+        qToLittleEndian<quint16>(static_cast<quint16>(count), header + 7);
+        header[9] = flags;
+        qToLittleEndian<quint16>(qChecksum(data.constData() + offset, static_cast<uint>(size)), header + 10);
+        std::memcpy(chunk.data() + UDP_CHUNK_HEADER, data.constData() + offset, static_cast<size_t>(size));
+
+        chunks.append(chunk);
+    }
+
+    // Only the latest transfers can be retransmitted
+    if(m_order.size() >= m_keep)
+        m_transfers.remove(m_order.dequeue());
+
+    m_transfers.insert(transfer, chunks);
+    m_order.enqueue(transfer);
+    return transfer;
+}
+
+const QVector<QByteArray> *ChunkSender::chunks(quint32 transfer) const
+{
+    auto it = m_transfers.constFind(transfer);
+    return it != m_transfers.constEnd() ? &it.value() : nullptr;
+}
+
+void ChunkSender::clear()
+{
+    m_transfers.clear();
+    m_order.clear();
+    this->seed();
+}
+
+bool ChunkAssembler::parse(const char *data, int size, ChunkHeader &out)
+{
+    if(size < UDP_CHUNK_HEADER)
+        return false;
+
+    const uchar *header = reinterpret_cast<const uchar*>(data);
+    out.transfer = qFromLittleEndian<quint32>(header + 1);
+    out.index = qFromLittleEndian<quint16>(header + 5);
+    out.count = qFromLittleEndian<quint16>(header + 7);
+    out.flags = header[9];
+    out.payload = data + UDP_CHUNK_HEADER;
+    out.payloadSize = size - UDP_CHUNK_HEADER;
+
+    if(out.count == 0 || out.count > UDP_CHUNK_COUNT_LIMIT || out.index >= out.count)
+        return false;
+
+    return qFromLittleEndian<quint16>(header + 10) == qChecksum(out.payload, static_cast<uint>(out.payloadSize));
+}
+
+bool ChunkAssembler::add(const ChunkHeader &chunk)
+{
+    // First chunk defines the transfer
+    if(m_chunks.isEmpty())
+    {
+        m_chunks.resize(chunk.count);
+        m_flags = chunk.flags;
+    }
+
+    if(chunk.count != m_chunks.size() || chunk.flags != m_flags)
+        return false;
+
+    // Duplicates (retransmitted twice) are ignored
+    QByteArray &slot = m_chunks[chunk.index];
+    if(slot.isNull())
+    {
+        slot = QByteArray(chunk.payload, chunk.payloadSize);
+        m_received++;
+    }
+
+    return true;
+}
+
+bool ChunkAssembler::isComplete() const
+{
+    return !m_chunks.isEmpty() && m_received == m_chunks.size();
+}
+
+QByteArray ChunkAssembler::message(int limit) const
+{
+    int size = 0;
+    for(const QByteArray &chunk : m_chunks)
+        size += chunk.size();
+
+    if(size > limit)
+        return QByteArray();
+
+    // qCompress stores the size of the original data first (big endian)
+    if((m_flags & CHUNK_COMPRESSED) && (m_chunks.isEmpty() || m_chunks.first().size() < 4
+        || qFromBigEndian<quint32>(reinterpret_cast<const uchar*>(m_chunks.first().constData())) > static_cast<quint32>(limit)))
+        return QByteArray();
+
+    QByteArray data;
+    data.reserve(size);
+    for(const QByteArray &chunk : m_chunks)
+        data.append(chunk);
+
+    return (m_flags & CHUNK_COMPRESSED) ? qUncompress(data) : data;
+}
+
+QVector<quint16> ChunkAssembler::missing(int limit) const
+{
+    QVector<quint16> indexes;
+    for(int index = 0; index < m_chunks.size() && indexes.size() < limit; index++)
+    {
+        if(m_chunks.at(index).isNull())
+            indexes.append(static_cast<quint16>(index));
+    }
+
+    return indexes;
+}
@@ -0,0 +1,151 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file chunk_transfer.h
+ * @author xcervia00
+ *
+ * @brief Splitting of messages larger than a datagram into chunks and their reassembly (interface)
+ *
+ */
+
+#ifndef CHUNK_TRANSFER_H_
+#define CHUNK_TRANSFER_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QQueue>
+#include <QVector>
+
+/*
+ * Chunk:             [type][u32 transfer][u16 index][u16 count][u8 flags][u16 checksum][payload]
+ * Missing chunks:    [type][u32 transfer] n * [u16 index]
+ * Integers are little endian; checksum is CRC-16 (qChecksum) of the payload. Joined payloads of all
+ * chunks form the message (compressed by qCompress if CHUNK_COMPRESSED is set).
+ */
+
+// Size of the header of a chunk
+#define UDP_CHUNK_HEADER 12
+// Maximal size of the payload of a chunk (datagram fits common MTU)
+#define UDP_CHUNK_PAYLOAD 1388
+// Messages larger than this are sent in chunks
+#define UDP_CHUNK_THRESHOLD (UDP_CHUNK_HEADER + UDP_CHUNK_PAYLOAD)
+// Maximal size of a reassembled message (after decompression)
+#define UDP_CHUNK_MESSAGE_LIMIT (16 * 1024 * 1024)
+// Maximal number of chunks of a transfer
+#define UDP_CHUNK_COUNT_LIMIT ((UDP_CHUNK_MESSAGE_LIMIT + UDP_CHUNK_PAYLOAD - 1) / UDP_CHUNK_PAYLOAD)
+
+/**
+ * @brief Flags of a chunk
+ */
+enum UDP_CHUNK_FLAGS : uint8_t
+{
+    CHUNK_COMPRESSED = 1, // The message is compressed
+};
+
+/**
+ * @brief Header of a received chunk
+ */
+struct ChunkHeader
+{
+    quint32 transfer = 0; ///< Id of the transfer (given by the sender)
+    quint16 index = 0; ///< Position of the chunk
+    quint16 count = 0; ///< Number of chunks of the transfer
+    quint8 flags = 0; ///< UDP_CHUNK_FLAGS
+    const char *payload = nullptr; ///< Payload of the chunk (points into the datagram)
+    int payloadSize = 0; ///< Size of the payload
+};
+
+/**
+ * @brief Splits messages into chunks; keeps the chunks of the latest transfers for retransmission
+ */
+class ChunkSender
+{
+    private:
+        QHash<quint32, QVector<QByteArray>> m_transfers; ///< Datagrams of every kept transfer
+        QQueue<quint32> m_order; ///< Kept transfers from the oldest
+        quint32 m_next = 1; ///< Id of the next transfer (random start per session)
+        int m_keep; ///< Maximal number of kept transfers
+
+        /**
+         * @brief Starts the ids of transfers at a random value, so receivers don't take them for transfers of
+         * an earlier session
+         */
+        void seed();
+
+    public:
+        /**
+         * @brief Constructor
+         * @param keep Maximal number of kept transfers
+         */
+        explicit ChunkSender(int keep = 8);
+
+        /**
+         * @brief Splits message into chunks (compressed if that makes it smaller)
+         * @param type Message type of the chunks
+         * @param message The message
+         * @return Id of the transfer; 0 if the message is empty or too large (see UDP_CHUNK_COUNT_LIMIT)
+         */
+        quint32 split(quint8 type, const QByteArray &message);
+
+        /**
+         * @brief Datagrams of a transfer
+         * @param transfer Id of the transfer
+         * @return The datagrams; nullptr if the transfer is no longer kept
+         */
+        const QVector<QByteArray> *chunks(quint32 transfer) const;
+
+        /**
+         * @brief Forgets all transfers; ids of the next session start at a new random value
+         */
+        void clear();
+};
+
+/**
+ * @brief Collects chunks of a single transfer
+ */
+class ChunkAssembler
+{
+    private:
+        QVector<QByteArray> m_chunks; ///< Payload of every chunk (null if not received)
+        int m_received = 0; ///< Number of received chunks
+        quint8 m_flags = 0; ///< Flags of the transfer
+
+    public:
+        /**
+         * @brief Parses chunk in place and verifies its checksum
+         * @param data The datagram
+         * @param size Size of the datagram
+         * @param out The header (payload points into data)
+         * @return False if the chunk is malformed or corrupted
+         */
+        static bool parse(const char *data, int size, ChunkHeader &out);
+
+        /**
+         * @brief Stores a chunk (the payload is copied)
+         * @param chunk The chunk
+         * @return False if the chunk doesn't belong to the transfer (other count or flags)
+         */
+        bool add(const ChunkHeader &chunk);
+
+        /**
+         * @brief Were all chunks received?
+         * @return True if complete
+         */
+        bool isComplete() const;
+
+        /**
+         * @brief Joins the chunks (transfer must be complete)
+         * @param limit Maximal size of the message (after decompression)
+         * @return The message; empty if it can't be decompressed or is larger than the limit
+         */
+        QByteArray message(int limit = UDP_CHUNK_MESSAGE_LIMIT) const;
+
+        /**
+         * @brief Chunks not received yet
+         * @param limit Maximal number of reported chunks
+         * @return Indexes of the chunks
+         */
+        QVector<quint16> missing(int limit) const;
+};
+
+#endif
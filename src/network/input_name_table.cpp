@@ -0,0 +1,78 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file input_name_table.cpp
+ * @author xcervia00
+ *
+ * @brief Interned names of the input variables of the machine
+ *
+ */
+
+#include "input_name_table.h"
+
+int InputNameTable::add(const QString &name)
+{
+    auto it = m_byName.constFind(name);
+    if(it != m_byName.constEnd())
+        return it.value();
+
+    int id = m_names.size();
+    m_revision++;
+    m_names.append(name);
+    m_byName.insert(name, id);
+    m_byBytes.insert(name.toUtf8(), id);
+    return id;
+}
+
+void InputNameTable::remove(const QString &name)
+{
+    auto it = m_byName.find(name);
+    if(it == m_byName.end())
+        return;
+
+    int id = it.value();
+    m_byName.erase(it);
+    m_byBytes.remove(name.toUtf8());
+    m_names[id] = QString();
+    m_revision++;
+}
+
+void InputNameTable::clear()
+{
+    m_byBytes.clear();
+    m_byName.clear();
+    m_names.clear();
+    m_version++;
+    m_revision++;
+}
+
+int InputNameTable::find(const char *data, int size) const
+{
+    // Raw data ==> the key is not copied
+    return m_byBytes.value(QByteArray::fromRawData(data, size), -1);
+}
+
+int InputNameTable::find(const QString &name) const
+{
+    return m_byName.value(name, -1);
+}
+
+QString InputNameTable::name(int id) const
+{
+    return m_names.value(id);
+}
+
+int InputNameTable::size() const
+{
+    return m_names.size();
+}
+
+quint16 InputNameTable::version() const
+{
+    return m_version;
+}
+
+quint32 InputNameTable::revision() const
+{
+    return m_revision;
+}
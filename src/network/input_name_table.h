@@ -0,0 +1,94 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file input_name_table.h
+ * @author xcervia00
+ *
+ * @brief Interned names of the input variables of the machine (interface)
+ *
+ */
+
+#ifndef INPUT_NAME_TABLE_H_
+#define INPUT_NAME_TABLE_H_
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+/**
+ * @brief Mirror of the input variables of the model, looked up by raw UTF-8 bytes of received messages
+ * @note Every name gets a stable id (ids of removed names are not reused until clear()).
+ * Lookups by bytes do not allocate and return the shared name, so received inputs never build a new QString for it.
+ */
+class InputNameTable
+{
+    private:
+        QHash<QByteArray, int> m_byBytes; ///< Id of every name by its UTF-8 bytes
+        QHash<QString, int> m_byName; ///< Id of every name
+        QVector<QString> m_names; ///< Name of every id (null if removed)
+        quint16 m_version = 0; ///< Incremented whenever the ids are given again (clear())
+        quint32 m_revision = 0; ///< Incremented whenever a name is added or removed
+
+    public:
+        /**
+         * @brief Adds a name (nop if already present)
+         * @param name Name of the input variable
+         * @return Id of the name
+         */
+        int add(const QString &name);
+
+        /**
+         * @brief Removes a name
+         * @param name Name of the input variable
+         */
+        void remove(const QString &name);
+
+        /**
+         * @brief Removes all names; ids start from zero again
+         */
+        void clear();
+
+        /**
+         * @brief Finds name by its UTF-8 bytes
+         * @param data The bytes (not null-terminated)
+         * @param size Number of bytes
+         * @return Id of the name; -1 if unknown
+         */
+        int find(const char *data, int size) const;
+
+        /**
+         * @brief Finds id of a name
+         * @param name The name
+         * @return Id of the name; -1 if unknown
+         */
+        int find(const QString &name) const;
+
+        /**
+         * @brief Name of an id
+         * @param id The id (from find() or add())
+         * @return The name; null string if the id is unknown
+         */
+        QString name(int id) const;
+
+        /**
+         * @brief Number of ids given so far (including removed ones)
+         * @return The count
+         */
+        int size() const;
+
+        /**
+         * @brief Version of the ids (changes only when the ids start from zero again)
+         * @return The version
+         * @note Ids known to a peer of the same version still name the same input (or a removed one)
+         */
+        quint16 version() const;
+
+        /**
+         * @brief Revision of the names (changes whenever a name is added or removed)
+         * @return The revision
+         */
+        quint32 revision() const;
+};
+
+#endif
@@ -0,0 +1,275 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file udp_batch_receiver.cpp
+ * @author xcervia00
+ *
+ * @brief Receives bursts of UDP datagrams with a single system call
+ *
+ */
+
+#include "udp_batch_receiver.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+    #include <arpa/inet.h>
+    #include <net/if.h>
+    #include <unistd.h>
+#endif
+
+#ifdef Q_OS_LINUX
+/**
+ * @brief Converts address to the form used by a socket of given family
+ * @param address The address
+ * @param port The port
+ * @param family Family of the socket (IPv4 receivers of an IPv6 socket are mapped)
+ * @param out The socket address
+ * @return Size of the socket address; 0 if the address can't be used by the socket
+ */
+static socklen_t toSocketAddress(const QHostAddress &address, quint16 port, int family, sockaddr_storage &out)
+{
+    std::memset(&out, 0, sizeof(out));
+
+    if(family == AF_INET)
+    {
+        bool isIPv4 = false;
+        quint32 ipv4 = address.toIPv4Address(&isIPv4);
+        if(!isIPv4)
+            return 0;
+
+        sockaddr_in *target = reinterpret_cast<sockaddr_in*>(&out);
+        target->sin_family = AF_INET;
+        target->sin_port = htons(port);
+        target->sin_addr.s_addr = htonl(ipv4);
+        return sizeof(sockaddr_in);
+    }
+
+    sockaddr_in6 *target = reinterpret_cast<sockaddr_in6*>(&out);
+    target->sin6_family = AF_INET6;
+    target->sin6_port = htons(port);
+
+    if(address.protocol() == QAbstractSocket::IPv4Protocol)
+    {
+        // IPv4-mapped address (::ffff:a.b.c.d)
+        quint32 ipv4 = htonl(address.toIPv4Address());
+        target->sin6_addr.s6_addr[10] = 0xff;
+        target->sin6_addr.s6_addr[11] = 0xff;
+        std::memcpy(&target->sin6_addr.s6_addr[12], &ipv4, sizeof(ipv4));
+    }
+    else if(address.protocol() == QAbstractSocket::IPv6Protocol)
+    {
+        Q_IPV6ADDR ipv6 = address.toIPv6Address();
+        std::memcpy(target->sin6_addr.s6_addr, ipv6.c, sizeof(ipv6.c));
+
+        // Scope is either an index or a name of the interface
+        bool isIndex = false;
+        target->sin6_scope_id = address.scopeId().toUInt(&isIndex);
+        if(!isIndex && !address.scopeId().isEmpty())
+            target->sin6_scope_id = if_nametoindex(address.scopeId().toLatin1().constData());
+    }
+    // Any ==> zeroed
+
+    return sizeof(sockaddr_in6);
+}
+#endif
+
+UdpBatchReceiver::UdpBatchReceiver()
+    :
+    m_pool(BATCH * SLOT_SIZE, Qt::Uninitialized)
+{
+#ifdef Q_OS_LINUX
+    std::memset(m_messages, 0, sizeof(m_messages));
+    for(int i = 0; i < BATCH; i++)
+    {
+        m_vectors[i].iov_base = m_pool.data() + i * SLOT_SIZE;
+        m_vectors[i].iov_len = SLOT_SIZE;
+
+        msghdr &header = m_messages[i].msg_hdr;
+        header.msg_name = &m_addresses[i];
+        header.msg_iov = &m_vectors[i];
+        header.msg_iovlen = 1;
+        header.msg_control = m_control[i];
+    }
+#endif
+}
+
+UdpBatchReceiver::~UdpBatchReceiver()
+{
+#ifdef Q_OS_LINUX
+    if(m_descriptor >= 0)
+        ::close(static_cast<int>(m_descriptor));
+#endif
+}
+
+bool UdpBatchReceiver::isSupported()
+{
+#ifdef Q_OS_LINUX
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool UdpBatchReceiver::bind(const QHostAddress &address, quint16 port, int receiveBuffer)
+{
+#ifdef Q_OS_LINUX
+    if(m_descriptor >= 0)
+        return false;
+
+    // Same as QUdpSocket: Any is a dual-stack IPv6 socket
+    m_family = address.protocol() == QAbstractSocket::IPv4Protocol ? AF_INET : AF_INET6;
+
+    int descriptor = ::socket(m_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(descriptor < 0)
+        return false;
+
+    int enable = 1;
+    int disable = 0;
+    setsockopt(descriptor, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+    setsockopt(descriptor, SOL_SOCKET, SO_RCVBUF, &receiveBuffer, sizeof(receiveBuffer));
+    if(m_family == AF_INET6)
+        setsockopt(descriptor, IPPROTO_IPV6, IPV6_V6ONLY, address == QHostAddress::Any ? &disable : &enable, sizeof(int));
+
+    sockaddr_storage local;
+    socklen_t length = toSocketAddress(address, port, m_family, local);
+    if(length == 0 || ::bind(descriptor, reinterpret_cast<const sockaddr*>(&local), length) != 0)
+    {
+        ::close(descriptor);
+        return false;
+    }
+
+    // Every datagram carries the number of datagrams dropped so far
+    m_dropCounter = setsockopt(descriptor, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) == 0;
+    m_descriptor = descriptor;
+    return true;
+#else
+    (void)address;
+    (void)port;
+    (void)receiveBuffer;
+    return false;
+#endif
+}
+
+qintptr UdpBatchReceiver::descriptor() const
+{
+    return m_descriptor;
+}
+
+qint64 UdpBatchReceiver::send(const QByteArray &data, const QHostAddress &address, quint16 port)
+{
+#ifdef Q_OS_LINUX
+    sockaddr_storage target;
+    socklen_t length = toSocketAddress(address, port, m_family, target);
+    if(m_descriptor < 0 || length == 0)
+        return -1;
+
+    ssize_t sent;
+    do
+    {
+        sent = ::sendto(static_cast<int>(m_descriptor), data.constData(), static_cast<size_t>(data.size()), 0,
+                        reinterpret_cast<const sockaddr*>(&target), length);
+    } while(sent < 0 && errno == EINTR);
+
+    return sent;
+#else
+    (void)data;
+    (void)address;
+    (void)port;
+    return -1;
+#endif
+}
+
+int UdpBatchReceiver::receive()
+{
+    m_count = 0;
+
+#ifdef Q_OS_LINUX
+    // Lengths are overwritten by every call
+    for(int i = 0; i < BATCH; i++)
+    {
+        msghdr &header = m_messages[i].msg_hdr;
+        header.msg_namelen = sizeof(m_addresses[i]);
+        header.msg_controllen = sizeof(m_control[i]);
+        header.msg_flags = 0;
+    }
+
+    int received;
+    do
+    {
+        received = recvmmsg(static_cast<int>(m_descriptor), m_messages, BATCH, MSG_DONTWAIT, nullptr);
+    } while(received < 0 && errno == EINTR);
+
+    // Nothing pending (EAGAIN) or the socket failed
+    if(received <= 0)
+        return 0;
+
+    m_count = received;
+
+    if(m_dropCounter)
+    {
+        // The counter of the newest datagram is the most recent one
+        for(int i = 0; i < m_count; i++)
+        {
+            msghdr &header = m_messages[i].msg_hdr;
+            for(cmsghdr *control = CMSG_FIRSTHDR(&header); control != nullptr; control = CMSG_NXTHDR(&header, control))
+            {
+                if(control->cmsg_level == SOL_SOCKET && control->cmsg_type == SO_RXQ_OVFL)
+                    std::memcpy(&m_kernelDrops, CMSG_DATA(control), sizeof(m_kernelDrops));
+            }
+        }
+    }
+#endif
+
+    return m_count;
+}
+
+int UdpBatchReceiver::count() const
+{
+    return m_count;
+}
+
+QByteArray UdpBatchReceiver::datagram(int index) const
+{
+#ifdef Q_OS_LINUX
+    int size = static_cast<int>(std::min<unsigned int>(m_messages[index].msg_len, SLOT_SIZE));
+    return QByteArray::fromRawData(m_pool.constData() + index * SLOT_SIZE, size);
+#else
+    (void)index;
+    return QByteArray();
+#endif
+}
+
+bool UdpBatchReceiver::truncated(int index) const
+{
+#ifdef Q_OS_LINUX
+    return (m_messages[index].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+#else
+    (void)index;
+    return false;
+#endif
+}
+
+void UdpBatchReceiver::sender(int index, QHostAddress &address, quint16 &port) const
+{
+#ifdef Q_OS_LINUX
+    const sockaddr *source = reinterpret_cast<const sockaddr*>(&m_addresses[index]);
+    address.setAddress(source);
+
+    if(source->sa_family == AF_INET6)
+        port = ntohs(reinterpret_cast<const sockaddr_in6*>(source)->sin6_port);
+    else
+        port = ntohs(reinterpret_cast<const sockaddr_in*>(source)->sin_port);
+#else
+    (void)index;
+    address.clear();
+    port = 0;
+#endif
+}
+
+quint32 UdpBatchReceiver::kernelDrops() const
+{
+    return m_kernelDrops;
+}
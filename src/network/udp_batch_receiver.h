@@ -0,0 +1,135 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file udp_batch_receiver.h
+ * @author xcervia00
+ *
+ * @brief Receives bursts of UDP datagrams with a single system call (interface)
+ *
+ */
+
+#ifndef UDP_BATCH_RECEIVER_H_
+#define UDP_BATCH_RECEIVER_H_
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QHostAddress>
+
+#ifdef Q_OS_LINUX
+    #include <sys/socket.h>
+    #include <netinet/in.h>
+#endif
+
+/**
+ * @brief Drains up to BATCH datagrams per recvmmsg() into a preallocated pool of buffers
+ * @note Datagrams are only valid until the next receive(); they are never copied.
+ * Available on Linux only (see isSupported()). The receiver opens and owns its socket, so no QUdpSocket watches it
+ * (one socket notifier per descriptor); replies are sent through it as well, so they come from the bound port.
+ */
+class UdpBatchReceiver
+{
+    public:
+        static constexpr int BATCH = 32; ///< Maximum number of datagrams per receive()
+        static constexpr int SLOT_SIZE = 65536; ///< Size of a buffer (any UDP payload fits)
+
+    private:
+        qintptr m_descriptor = -1; ///< The socket; -1 if not bound
+        int m_family = 0; ///< Address family of the socket
+        QByteArray m_pool; ///< Buffers of all datagrams (BATCH * SLOT_SIZE)
+        int m_count = 0; ///< Number of datagrams received by the last receive()
+        quint32 m_kernelDrops = 0; ///< Datagrams dropped by the kernel so far (SO_RXQ_OVFL)
+        bool m_dropCounter = false; ///< Does the kernel report dropped datagrams?
+
+#ifdef Q_OS_LINUX
+        mmsghdr m_messages[BATCH]; ///< Headers passed to recvmmsg()
+        iovec m_vectors[BATCH]; ///< Buffer of every datagram
+        sockaddr_storage m_addresses[BATCH]; ///< Sender of every datagram
+        char m_control[BATCH][CMSG_SPACE(sizeof(quint32))]; ///< Ancillary data of every datagram (drop counter)
+#endif
+
+    public:
+        /**
+         * @brief Prepares the buffers
+         */
+        UdpBatchReceiver();
+
+        /**
+         * @brief Closes the socket
+         */
+        ~UdpBatchReceiver();
+
+        UdpBatchReceiver(const UdpBatchReceiver&) = delete;
+        UdpBatchReceiver &operator=(const UdpBatchReceiver&) = delete;
+
+        /**
+         * @brief Is batched receiving available on this platform?
+         * @return True on Linux
+         */
+        static bool isSupported();
+
+        /**
+         * @brief Opens a non-blocking socket bound to an address and enables its drop counter
+         * @param address The address (QHostAddress::Any accepts both IPv4 and IPv6)
+         * @param port The port
+         * @param receiveBuffer Size of the socket receive buffer in bytes
+         * @return False if the socket couldn't be opened or bound
+         */
+        bool bind(const QHostAddress &address, quint16 port, int receiveBuffer);
+
+        /**
+         * @brief The bound socket
+         * @return The descriptor; -1 if not bound
+         */
+        qintptr descriptor() const;
+
+        /**
+         * @brief Sends a datagram from the bound socket
+         * @param data The payload
+         * @param address Address of the receiver
+         * @param port Port of the receiver
+         * @return Number of bytes sent; -1 on error
+         */
+        qint64 send(const QByteArray &data, const QHostAddress &address, quint16 port);
+
+        /**
+         * @brief Receives pending datagrams without blocking
+         * @return Number of received datagrams (0 if none are pending or on error)
+         */
+        int receive();
+
+        /**
+         * @brief Number of datagrams received by the last receive()
+         * @return The count
+         */
+        int count() const;
+
+        /**
+         * @brief Payload of a received datagram (refers to the pool, no copy)
+         * @param index Index of the datagram (less than count())
+         * @return The payload; cut to SLOT_SIZE if truncated
+         */
+        QByteArray datagram(int index) const;
+
+        /**
+         * @brief Was the datagram larger than its buffer?
+         * @param index Index of the datagram (less than count())
+         * @return True if truncated
+         */
+        bool truncated(int index) const;
+
+        /**
+         * @brief Sender of a received datagram
+         * @param index Index of the datagram (less than count())
+         * @param address Address of the sender
+         * @param port Port of the sender
+         */
+        void sender(int index, QHostAddress &address, quint16 &port) const;
+
+        /**
+         * @brief Datagrams dropped by the kernel because the socket buffer was full
+         * @return Total since the receiver was created (0 if the kernel does not report them)
+         */
+        quint32 kernelDrops() const;
+};
+
+#endif
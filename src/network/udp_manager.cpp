@@ -15,47 +15,55 @@
 #include <QHostAddress>
 #include <QAbstractSocket>
 #include <QDataStream>
-#include <QRegularExpression>
+#include <QDebug>
+#include <QtEndian>
 #include <cstdint>
+#include <cstring>
 #include <random>
 
 #include "mvc_interface.h"
-#include "view/editorwindow.h"
+#include "udp_batch_receiver.h"
 
-FsmNetworkManager::FsmNetworkManager(QObject *parent)
-    : QObject(parent)
+FsmNetworkManager::FsmNetworkManager(FsmInterface *owner, QObject *parent)
+    : QObject(parent),
+    ownerObject{owner}
 {
-    if(parent != nullptr)
-    {
-        this->ownerObject = (FsmInterface*)qobject_cast<EditorWindow*>(parent);
-    }
+    Q_ASSERT(ownerObject);
 
     // New Socket
     udpSocket = new QUdpSocket(this);
 
     // Received packet ==> process signal
     connect(udpSocket, &QUdpSocket::readyRead, this, &FsmNetworkManager::processReceivedPacket);
+
+    // Incomplete large messages ==> request what is missing
+    chunkTimer = new QTimer(this);
+    chunkTimer->setInterval(UDP_CHUNK_NACK_INTERVAL);
+    connect(chunkTimer, &QTimer::timeout, this, &FsmNetworkManager::requestMissingChunks);
+    chunkClock.start();
 }
 
-bool FsmNetworkManager::parseInput(const QByteArray &data, QString &outName, QString &outValue)
+bool FsmNetworkManager::parseInput(const char *data, int size, UdpInputView &out)
 {
-    if(data.isEmpty())
+    if(size <= 0)
         return false;
-        
-    auto separatorName = data.indexOf('\0');
-    if(separatorName < 0 || separatorName >= data.size()-1){
+
+    auto separatorName = static_cast<const char*>(std::memchr(data, '\0', static_cast<size_t>(size)));
+    if(separatorName == nullptr || separatorName >= data + size - 1){
         // The input packet has no nulbytes ==> can't parse
         return false;
     }
 
-    auto separatorValue = data.indexOf('\0', separatorName+1);
-    if(separatorValue < 0 || separatorValue >= data.size()){
+    auto separatorValue = static_cast<const char*>(std::memchr(separatorName + 1, '\0', static_cast<size_t>(data + size - separatorName - 1)));
+    if(separatorValue == nullptr){
         // The input packet has no nulbytes ==> can't parse
         return false;
     }
 
-    outName = QString(data.left(separatorName));
-    outValue = QString(data.mid(separatorName+1, separatorValue - separatorName - 1));
+    out.name = data;
+    out.nameSize = static_cast<int>(separatorName - data);
+    out.value = separatorName + 1;
+    out.valueSize = static_cast<int>(separatorValue - separatorName - 1);
 
     return true;
 }
@@ -86,66 +94,216 @@ bool FsmNetworkManager::startListening(const QHostAddress &address, quint16 port
     if(this->isActive())
         return false;
 
+    // Drain bursts with a single system call where possible; the socket is then not opened by Qt at all
+    if(UdpBatchReceiver::isSupported())
+    {
+        batchReceiver = new UdpBatchReceiver;
+        if(!batchReceiver->bind(address, port, UDP_RECEIVE_BUFFER))
+        {
+            delete batchReceiver;
+            batchReceiver = nullptr;
+            return false; // Failed to bind socket
+        }
+
+        batchNotifier = new QSocketNotifier(batchReceiver->descriptor(), QSocketNotifier::Read, this);
+        // String based connection ==> 'activated' is overloaded in newer Qt versions
+        connect(batchNotifier, SIGNAL(activated(int)), this, SLOT(processReceivedBatch()));
+        return true;
+    }
+
     if(!udpSocket->bind(address, port, QAbstractSocket::ReuseAddressHint))
         return false; // Failed to bind socket
 
+    // Room for bursts of chunks of large messages
+    udpSocket->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, UDP_RECEIVE_BUFFER);
+
     // Success!
     return true;
 }
 
+qint64 FsmNetworkManager::writeDatagram(const QByteArray &msg, const QHostAddress &address, quint16 port)
+{
+    // Replies leave from the port the peers know
+    if(batchReceiver != nullptr)
+        return batchReceiver->send(msg, address, port);
+
+    return udpSocket->writeDatagram(msg, address, port);
+}
+
 void FsmNetworkManager::processReceivedPacket()
 {
+    // Datagrams are read by the batched path
+    if(batchReceiver != nullptr)
+        return;
 
+    int count = 0;
     while(this->isActive() && udpSocket->hasPendingDatagrams())
     {
-        QByteArray datagram;
-        datagram.resize(udpSocket->pendingDatagramSize());
+        // The buffer keeps its capacity ==> no allocation per datagram
+        receiveBuffer.resize(static_cast<int>(udpSocket->pendingDatagramSize()));
 
         NetworkEndpoint sender;
 
-        auto bytesRx = udpSocket->readDatagram(datagram.data(), datagram.size(), &sender.address, &sender.port);
+        auto bytesRx = udpSocket->readDatagram(receiveBuffer.data(), receiveBuffer.size(), &sender.address, &sender.port);
         
         // Failed to obtain data ==> ignore
         if(bytesRx <= 0)
             continue;
 
-        // Ignore unknown unregistered clients
-        if(isListening && !clientAddresses.contains(sender) && MSG_TYPE(datagram.data()) != UDP_CONNECT)
-        {
-            continue;
-        }
+        count++;
+        this->processDatagram(sender, receiveBuffer.left(static_cast<int>(bytesRx)));
+    }
+
+    this->flushInputs();
+    stats.addBatch(count);
+}
 
-        qInfo() << "Network: Received input from " << sender.address.toString() << " via " << sender.port << " of type" << MSG_TYPE(datagram.data());
+void FsmNetworkManager::processReceivedBatch()
+{
+    while(this->isActive() && batchReceiver != nullptr)
+    {
+        int count = batchReceiver->receive();
+        if(count == 0)
+            break;
 
-        // Respond depending on message
-        switch(MSG_TYPE(datagram.data()))
+        for(int i = 0; i < count; i++)
         {
-            case UDP_MESSAGE_TYPE::UDP_CONNECT:
-                this->messageConnect(sender, datagram);
-                break;
-            case UDP_MESSAGE_TYPE::UDP_DISCONNECT:
-                this->messageDisconnect(sender, datagram);
-                break;
-            case UDP_MESSAGE_TYPE::UDP_INPUT:
-                this->messageInput(sender, datagram);
-                break;
-            case UDP_MESSAGE_TYPE::UDP_INTER_STATE:
-                this->messageInterState(sender, datagram);
-                break;
-            case UDP_MESSAGE_TYPE::UDP_SYNC_REQUEST:
-                this->messageSyncRequest(sender, datagram);
-                break;
-            case UDP_MESSAGE_TYPE::UDP_SYNC_EXECUTE:
-                this->messageSyncExecute(sender, datagram);
-                break;
-            default:
-                break;
+            // Cut datagrams can't be parsed
+            if(batchReceiver->truncated(i))
+            {
+                stats.truncated++;
+                continue;
+            }
+
+            NetworkEndpoint sender;
+            batchReceiver->sender(i, sender.address, sender.port);
+            this->processDatagram(sender, batchReceiver->datagram(i));
+
+            // The message stopped listening (e.g. server disconnected this client)
+            if(batchReceiver == nullptr)
+                return;
         }
+
+        // Whole burst is passed to the model at once (before the buffers are reused)
+        this->flushInputs();
+        stats.addBatch(count);
+        stats.kernelDrops = batchReceiver->kernelDrops();
+
+        // Buffers weren't filled ==> the socket is drained
+        if(count < UdpBatchReceiver::BATCH)
+            break;
     }
 }
 
+void FsmNetworkManager::processDatagram(const NetworkEndpoint &sender, const QByteArray &data)
+{
+    if(data.isEmpty())
+        return;
+
+    // Ignore unknown unregistered clients
+    if(isListening && !clientAddresses.contains(sender) && MSG_TYPE(data.constData()) != UDP_CONNECT)
+    {
+        stats.rejected++;
+        return;
+    }
+
+    // Inputs received so far come first
+    if(MSG_TYPE(data.constData()) != UDP_MESSAGE_TYPE::UDP_INPUT && MSG_TYPE(data.constData()) != UDP_MESSAGE_TYPE::UDP_INPUT_BINARY)
+        this->flushInputs();
+
+    // Respond depending on message
+    switch(MSG_TYPE(data.constData()))
+    {
+        case UDP_MESSAGE_TYPE::UDP_CONNECT:
+            this->messageConnect(sender, data);
+            break;
+        case UDP_MESSAGE_TYPE::UDP_DISCONNECT:
+            this->messageDisconnect(sender, data);
+            break;
+        case UDP_MESSAGE_TYPE::UDP_INPUT:
+            this->messageInput(sender, data);
+            break;
+        case UDP_MESSAGE_TYPE::UDP_INTER_STATE:
+            this->messageInterState(sender, data);
+            break;
+        case UDP_MESSAGE_TYPE::UDP_SYNC_REQUEST:
+            this->messageSyncRequest(sender, data);
+            break;
+        case UDP_MESSAGE_TYPE::UDP_SYNC_EXECUTE:
+            this->messageSyncExecute(sender, data);
+            break;
+        case UDP_MESSAGE_TYPE::UDP_INPUT_TABLE:
+            this->messageInputTable(sender, data);
+            break;
+        case UDP_MESSAGE_TYPE::UDP_INPUT_BINARY:
+            this->messageInputBinary(sender, data);
+            break;
+        case UDP_MESSAGE_TYPE::UDP_CHUNK:
+            this->messageChunk(sender, data);
+            break;
+        case UDP_MESSAGE_TYPE::UDP_CHUNK_NACK:
+            this->messageChunkNack(sender, data);
+            break;
+        default:
+            break;
+    }
+}
+
+void FsmNetworkManager::flushInputs()
+{
+    if(pendingInputs.isEmpty())
+        return;
+
+    if(pendingInputs.size() == 1)
+        this->ownerObject->inputEvent(pendingInputs.first().first, pendingInputs.first().second);
+    else
+        this->ownerObject->inputEvents(pendingInputs);
+
+    pendingInputs.clear();
+}
+
 void FsmNetworkManager::stopListening()
 {
+    // Notifier must not outlive the socket (it may be the sender of the current slot)
+    if(batchNotifier != nullptr)
+    {
+        batchNotifier->setEnabled(false);
+        batchNotifier->deleteLater();
+        batchNotifier = nullptr;
+    }
+    delete batchReceiver;
+    batchReceiver = nullptr;
+
+    if(stats.datagrams > 0)
+    {
+        qInfo() << "Network: Received " << stats.datagrams << " datagrams in " << stats.batches << " batches; dropped "
+                << stats.kernelDrops << " by kernel, " << stats.truncated << " truncated, " << stats.rejected << " rejected, "
+                << stats.unknownInputs << " unknown inputs, " << stats.staleInputs << " with stale input table";
+    }
+    if(stats.chunks > 0 || stats.resentChunks > 0)
+    {
+        qInfo() << "Network: Received " << stats.chunks << " chunks (" << stats.corruptChunks << " corrupted), sent "
+                << stats.resentChunks << " again; " << stats.lostTransfers << " large messages lost";
+    }
+
+    // Transfers can't continue without the socket
+    chunkTimer->stop();
+    incomingChunks.clear();
+    finishedChunks.clear();
+    finishedOrder.clear();
+    chunkSender.clear();
+
+    // Ids are valid only for the current peers
+    announcedVersion = -1;
+    announcedRevision = -1;
+    announcedSize = 0;
+    remoteVersion = -1;
+    remoteIds.clear();
+    remoteNames.clear();
+    remoteToLocalRevision = -1;
+    syncSession = 0;
+    syncVersion = 0;
+
     if(udpSocket != nullptr && udpSocket->state() != QAbstractSocket::UnconnectedState) 
     {
         udpSocket->close();
@@ -154,7 +312,7 @@ void FsmNetworkManager::stopListening()
 
 bool FsmNetworkManager::isActive()
 {
-    return udpSocket != nullptr && udpSocket->state() == QAbstractSocket::BoundState;
+    return batchReceiver != nullptr || (udpSocket != nullptr && udpSocket->state() == QAbstractSocket::BoundState);
 }
 
 NETWORK_MANAGER_STATE FsmNetworkManager::getState() const
@@ -178,6 +336,26 @@ const NetworkEndpoint &FsmNetworkManager::getServerInfo() const
     return serverAddress;
 }
 
+const UdpReceiveStats &FsmNetworkManager::getStats() const
+{
+    return stats;
+}
+
+void FsmNetworkManager::registerInput(const QString &name)
+{
+    inputNames.add(name);
+}
+
+void FsmNetworkManager::unregisterInput(const QString &name)
+{
+    inputNames.remove(name);
+}
+
+void FsmNetworkManager::clearInputs()
+{
+    inputNames.clear();
+}
+
 void FsmNetworkManager::messageDisconnect(const NetworkEndpoint &sender, const QByteArray &data)
 {
     // Incorrect data size
@@ -187,7 +365,7 @@ void FsmNetworkManager::messageDisconnect(const NetworkEndpoint &sender, const Q
     // Client
     if(isConnected)
     {   
-        static_cast<EditorWindow*>(this->ownerObject)->networkClientStop();
+        emit serverDisconnected();
 
     } // Server
     else if(isListening)
@@ -208,32 +386,32 @@ void FsmNetworkManager::messageConnect(const NetworkEndpoint &sender, const QByt
 
     // Register the sender
     this->clientAddresses.insert(sender);
+
+    // Client may send inputs by ids right away
+    this->actionInputTable(sender);
 }
 
 void FsmNetworkManager::messageSyncRequest(const NetworkEndpoint &sender, const QByteArray &data)
 {
-    if(data.size() != sizeof(UDP_MESSAGE_TYPE::UDP_SYNC_REQUEST))
+    if(data.size() != sizeof(UDP_MESSAGE_TYPE::UDP_SYNC_REQUEST) && data.size() != UDP_SYNC_REQUEST_VERSIONED)
         return;
     
     // Only server may respond
     if(!isListening)
         return;
 
-    // Construct the message
-    QString msg;
-    QTextStream stream(&msg, QIODevice::WriteOnly);
-    stream << static_cast<uint8_t>(UDP_MESSAGE_TYPE::UDP_SYNC_EXECUTE);
-
-    // Load current representation to stream
-    this->ownerObject->saveStream(stream);
-    stream.flush();
-
-    // Remove duplicite whitespaces
-    msg.replace(QRegularExpression("[ \t]+"), " ");
-    MSG_TYPE(msg.data()) = static_cast<uint8_t>(UDP_MESSAGE_TYPE::UDP_SYNC_EXECUTE);
+    // Version the client has (none ==> whole machine)
+    quint32 session = 0;
+    quint64 version = 0;
+    if(data.size() == UDP_SYNC_REQUEST_VERSIONED)
+    {
+        QDataStream stream(data);
+        quint8 type;
+        stream >> type >> session >> version;
+    }
 
-    // Send the representation back to sender (without duplicite whitespaces)
-    this->udpSocket->writeDatagram(msg.toLocal8Bit(), sender.address, sender.port);
+    // Send the edits (or representation) back to sender
+    this->sendLarge(this->buildSync(session, version), &sender);
 }
 
 void FsmNetworkManager::messageSyncExecute(const NetworkEndpoint &sender, const QByteArray &data)
@@ -252,11 +430,12 @@ void FsmNetworkManager::messageSyncExecute(const NetworkEndpoint &sender, const
         return;
 
     // Ignore message type byte
-    QTextStream stream(data.mid(sizeof(UDP_MESSAGE_TYPE::UDP_SYNC_EXECUTE)), QIODevice::ReadOnly);
-    stream.flush();
+    QDataStream stream(data);
+    stream.skipRawData(sizeof(UDP_MESSAGE_TYPE::UDP_SYNC_EXECUTE));
 
-    // Load the representation from the packet
-    this->ownerObject->loadStream(stream);
+    // Edits of other version ==> ask for the ones following ours
+    if(!this->ownerObject->loadChanges(stream, syncSession, syncVersion))
+        this->actionSyncRequest();
 }
 
 void FsmNetworkManager::messageInput(const NetworkEndpoint &sender, const QByteArray &data)
@@ -265,41 +444,41 @@ void FsmNetworkManager::messageInput(const NetworkEndpoint &sender, const QByteA
     if((unsigned long)data.size() < sizeof(UDP_MESSAGE_TYPE::UDP_INPUT)+4)
         return;
 
-    QString eventName;
-    QString eventValue;
+    UdpInputView input;
 
-    // Parse into event
-    if(!parseInput(data.mid(sizeof(UDP_MESSAGE_TYPE::UDP_INPUT)), eventName, eventValue))
+    // Parse into event (in place)
+    if(!parseInput(data.constData() + sizeof(UDP_MESSAGE_TYPE::UDP_INPUT), data.size() - static_cast<int>(sizeof(UDP_MESSAGE_TYPE::UDP_INPUT)), input))
     {
         return;
     }    
 
-    // Client
-    if(isConnected)
-    {
-        this->ownerObject->inputEvent(eventName, eventValue);
+    // Must be client or server
+    if(!isConnected && !isListening)
+        return;
 
-    } // Server
-    else if(isListening)
+    // Server forwards the received bytes as they are
+    if(isListening)
     {
-        QByteArray msg;
-        msg.append(static_cast<int>(UDP_MESSAGE_TYPE::UDP_INPUT));
-        msg.append(eventName.toLocal8Bit());
-        msg.append('\0');
-        msg.append(eventValue.toLocal8Bit());
-        msg.append('\0');
-        
         // Send message to all clients
         SERVER_FOR_ALL(
             // Don't resend back to the sender
             if(client != sender)
             {
-                this->udpSocket->writeDatagram(msg, client.address, client.port);
+                this->writeDatagram(data, client.address, client.port);
             }
         );
+    }
 
-        this->ownerObject->inputEvent(eventName, eventValue);
+    // The machine has no such input ==> the model would ignore it anyway
+    int id = inputNames.find(input.name, input.nameSize);
+    if(id < 0)
+    {
+        stats.unknownInputs++;
+        return;
     }
+
+    // Name is shared with the table; only the value is decoded
+    pendingInputs.append(FsmInput(inputNames.name(id), QString::fromUtf8(input.value, input.valueSize)));
 }
 
 void FsmNetworkManager::messageInterState(const NetworkEndpoint &sender, const QByteArray &data)
@@ -334,6 +513,309 @@ void FsmNetworkManager::messageInterState(const NetworkEndpoint &sender, const Q
     }
 }
 
+void FsmNetworkManager::messageInputTable(const NetworkEndpoint &sender, const QByteArray &data)
+{
+    // Server ==> request for the table
+    if(isListening)
+    {
+        if(data.size() == sizeof(UDP_MESSAGE_TYPE::UDP_INPUT_TABLE))
+            this->actionInputTable(sender);
+        return;
+    }
+
+    // Client accepts only table of its server
+    if(!isConnected || sender != serverAddress)
+        return;
+
+    const char *msg = data.constData();
+    int size = data.size();
+    if(size < 5)
+        return;
+
+    quint16 version = qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(msg + 1));
+    int count = qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(msg + 3));
+
+    QHash<QString, quint16> ids;
+    QVector<QByteArray> names;
+    names.reserve(count);
+
+    int offset = 5;
+    for(int id = 0; id < count; id++)
+    {
+        if(offset + 2 > size)
+            return; // Malformed
+
+        int length = qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(msg + offset));
+        offset += 2;
+        if(offset + length > size)
+            return; // Malformed
+
+        names.append(QByteArray(msg + offset, length));
+        if(length > 0)
+            ids.insert(QString::fromUtf8(msg + offset, length), static_cast<quint16>(id));
+        offset += length;
+    }
+
+    remoteVersion = version;
+    remoteIds.swap(ids);
+    remoteNames.swap(names);
+    remoteToLocalRevision = -1;
+}
+
+void FsmNetworkManager::messageInputBinary(const NetworkEndpoint &sender, const QByteArray &data)
+{
+    if(data.size() < UDP_INPUT_BINARY_HEADER)
+        return;
+
+    const char *msg = data.constData();
+    quint16 version = qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(msg + 1));
+    const QVector<int> *translation = nullptr;
+    int known = 0;
+
+    // Server ==> ids are its own
+    if(isListening)
+    {
+        // Sender has table of cleared ids ==> they may name other inputs now; drop, send the current table
+        if(version != inputNames.version())
+        {
+            stats.staleInputs++;
+            this->actionInputTable(sender);
+            return;
+        }
+
+        // Other clients read the forwarded bytes by the table they know
+        known = this->announceInputTable();
+    } // Client ==> ids of the server have to be translated
+    else if(isConnected)
+    {
+        if(sender != serverAddress)
+            return;
+
+        if(version != remoteVersion)
+        {
+            stats.staleInputs++;
+            CONSTRUCT_DATAGRAM(request, UDP_INPUT_TABLE);
+            this->writeDatagram(request, serverAddress.address, serverAddress.port);
+            return;
+        }
+
+        // Local inputs changed since the last translation
+        if(remoteToLocalRevision != inputNames.revision())
+        {
+            remoteToLocal.resize(remoteNames.size());
+            for(int id = 0; id < remoteNames.size(); id++)
+                remoteToLocal[id] = remoteNames.at(id).isEmpty() ? -1 : inputNames.find(remoteNames.at(id).constData(), remoteNames.at(id).size());
+            remoteToLocalRevision = inputNames.revision();
+        }
+        translation = &remoteToLocal;
+    }
+    else
+    {
+        return;
+    }
+
+    // Records are read in place
+    int received = pendingInputs.size();
+    int newest = -1;
+    bool missingTable = false;
+    int offset = UDP_INPUT_BINARY_HEADER;
+    while(offset + UDP_INPUT_RECORD_HEADER <= data.size())
+    {
+        int id = qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(msg + offset));
+        int length = qFromLittleEndian<quint16>(reinterpret_cast<const uchar*>(msg + offset + 2));
+        offset += UDP_INPUT_RECORD_HEADER;
+
+        if(offset + length > data.size())
+            break; // Malformed
+
+        newest = qMax(newest, id);
+        if(translation != nullptr)
+        {
+            // Server added inputs since the table of this client
+            missingTable |= id >= translation->size();
+            id = translation->value(id, -1);
+        }
+
+        QString name = inputNames.name(id);
+        if(name.isNull())
+            stats.unknownInputs++;
+        else
+            pendingInputs.append(FsmInput(name, QString::fromUtf8(msg + offset, length)));
+
+        offset += length;
+    }
+
+    if(missingTable)
+    {
+        CONSTRUCT_DATAGRAM(request, UDP_INPUT_TABLE);
+        this->writeDatagram(request, serverAddress.address, serverAddress.port);
+        return;
+    }
+
+    if(!isListening)
+        return;
+
+    // Forwarded as they are unless some client may not know the ids yet
+    if(newest < known)
+    {
+        this->sendToPeers(data, &sender);
+        return;
+    }
+
+    for(int i = received; i < pendingInputs.size(); i++)
+        this->sendTextInput(pendingInputs.at(i).first, pendingInputs.at(i).second, &sender);
+}
+
+void FsmNetworkManager::messageChunk(const NetworkEndpoint &sender, const QByteArray &data)
+{
+    // Client accepts only messages of its server
+    if(isConnected && sender != serverAddress)
+        return;
+
+    // Corrupted chunk ==> requested again as missing
+    ChunkHeader chunk;
+    if(!ChunkAssembler::parse(data.constData(), data.size(), chunk))
+    {
+        stats.corruptChunks++;
+        return;
+    }
+    stats.chunks++;
+
+    // Late duplicate of a completed transfer
+    ChunkTransferKey key(sender, chunk.transfer);
+    if(finishedChunks.contains(key))
+        return;
+
+    // Sender has too many transfers in progress ==> the least active one is given up
+    if(!incomingChunks.contains(key))
+    {
+        int active = 0;
+        auto stalest = incomingChunks.end();
+        for(auto it = incomingChunks.begin(); it != incomingChunks.end(); ++it)
+        {
+            if(it.key().first != sender)
+                continue;
+
+            active++;
+            if(stalest == incomingChunks.end() || it.value().lastActivity < stalest.value().lastActivity)
+                stalest = it;
+        }
+
+        if(active >= UDP_CHUNK_INCOMING_LIMIT)
+        {
+            stats.lostTransfers++;
+            incomingChunks.erase(stalest);
+        }
+    }
+
+    IncomingChunks &incoming = incomingChunks[key];
+    if(!incoming.assembler.add(chunk))
+    {
+        stats.corruptChunks++;
+        return;
+    }
+    incoming.lastActivity = chunkClock.elapsed();
+    incoming.requests = 0;
+
+    if(!incoming.assembler.isComplete())
+    {
+        // The last chunk came ==> the rest was lost, no need to wait
+        if(chunk.index == chunk.count - 1)
+            this->requestChunks(key, incoming);
+
+        if(!chunkTimer->isActive())
+            chunkTimer->start();
+        return;
+    }
+
+    QByteArray message = incoming.assembler.message();
+    incomingChunks.remove(key);
+
+    if(finishedOrder.size() >= UDP_CHUNK_FINISHED_KEEP)
+        finishedChunks.remove(finishedOrder.dequeue());
+    finishedChunks.insert(key);
+    finishedOrder.enqueue(key);
+
+    // Chunks never carry chunks
+    if(message.isEmpty() || MSG_TYPE(message.constData()) == UDP_CHUNK || MSG_TYPE(message.constData()) == UDP_CHUNK_NACK)
+    {
+        stats.corruptChunks++;
+        return;
+    }
+
+    this->processDatagram(sender, message);
+}
+
+void FsmNetworkManager::messageChunkNack(const NetworkEndpoint &sender, const QByteArray &data)
+{
+    if(data.size() < 5 || (data.size() - 5) % 2 != 0)
+        return;
+
+    const uchar *msg = reinterpret_cast<const uchar*>(data.constData());
+    quint32 transfer = qFromLittleEndian<quint32>(msg + 1);
+
+    // Too old ==> the receiver gives up (and may ask for the message again)
+    const QVector<QByteArray> *chunks = chunkSender.chunks(transfer);
+    if(chunks == nullptr)
+        return;
+
+    for(int offset = 5; offset < data.size(); offset += 2)
+    {
+        int index = qFromLittleEndian<quint16>(msg + offset);
+        if(index >= chunks->size())
+            continue;
+
+        this->writeDatagram(chunks->at(index), sender.address, sender.port);
+        stats.resentChunks++;
+    }
+}
+
+void FsmNetworkManager::requestMissingChunks()
+{
+    qint64 now = chunkClock.elapsed();
+
+    for(auto it = incomingChunks.begin(); it != incomingChunks.end();)
+    {
+        // Chunks are still coming
+        if(now - it->lastActivity < UDP_CHUNK_NACK_INTERVAL)
+        {
+            ++it;
+            continue;
+        }
+
+        if(it->requests >= UDP_CHUNK_NACK_RETRIES)
+        {
+            qWarning() << "Network: Large message from " << it.key().first.address.toString() << " via " << it.key().first.port << " was lost";
+            stats.lostTransfers++;
+            it = incomingChunks.erase(it);
+            continue;
+        }
+
+        this->requestChunks(it.key(), it.value());
+        ++it;
+    }
+
+    if(incomingChunks.isEmpty())
+        chunkTimer->stop();
+}
+
+void FsmNetworkManager::requestChunks(const ChunkTransferKey &key, IncomingChunks &incoming)
+{
+    QVector<quint16> missing = incoming.assembler.missing(UDP_CHUNK_NACK_LIMIT);
+
+    QByteArray msg(5 + 2 * missing.size(), Qt::Uninitialized);
+    uchar *out = reinterpret_cast<uchar*>(msg.data());
+    out[0] = UDP_MESSAGE_TYPE::UDP_CHUNK_NACK;
+    qToLittleEndian<quint32>(key.second, out + 1);
+    for(int i = 0; i < missing.size(); i++)
+        qToLittleEndian<quint16>(missing.at(i), out + 5 + 2 * i);
+
+    this->writeDatagram(msg, key.first.address, key.first.port);
+
+    incoming.requests++;
+    incoming.lastActivity = chunkClock.elapsed();
+}
+
 void FsmNetworkManager::actionInterState(bool interpret)
 {
     uint8_t udp_bool = interpret ? UDP_BOOL::TRUE : UDP_BOOL::FALSE;
@@ -343,7 +825,7 @@ void FsmNetworkManager::actionInterState(bool interpret)
     if(isConnected)
     {
         this->startedExternally = false;
-        this->udpSocket->writeDatagram(msg, serverAddress.address, serverAddress.port);
+        this->writeDatagram(msg, serverAddress.address, serverAddress.port);
 
     } // Server
     else if(isListening)
@@ -351,35 +833,195 @@ void FsmNetworkManager::actionInterState(bool interpret)
         this->actionSyncExecute();
 
         SERVER_FOR_ALL(
-            this->udpSocket->writeDatagram(msg, client.address, client.port);
+            this->writeDatagram(msg, client.address, client.port);
         );
     }
 }
 
 void FsmNetworkManager::actionInput(const QString &name, const QString &value)
 {
+    this->actionInputs(FsmInputBatch{FsmInput(name, value)});
+}
+
+void FsmNetworkManager::actionInputs(const FsmInputBatch &inputs)
+{
+    if(!isConnected && !isListening)
+        return;
+
+    // Server owns the ids; clients use the last table they received
+    int version;
+    int known = 0;
+    if(isListening)
+    {
+        known = this->announceInputTable();
+        version = inputNames.version();
+    }
+    else
+    {
+        version = remoteVersion;
+    }
+
     QByteArray msg;
-    msg.append(static_cast<int>(UDP_MESSAGE_TYPE::UDP_INPUT));
-    msg.append(name.toLocal8Bit());
-    msg.append('\0');
-    msg.append(value.toLocal8Bit());
-    msg.append('\0');
+    msg.reserve(UDP_INPUT_BINARY_LIMIT);
+
+    auto startMessage = [&msg, version]() {
+        msg.resize(UDP_INPUT_BINARY_HEADER);
+        msg[0] = static_cast<char>(UDP_MESSAGE_TYPE::UDP_INPUT_BINARY);
+        qToLittleEndian<quint16>(static_cast<quint16>(version), reinterpret_cast<uchar*>(msg.data() + 1));
+    };
+    auto flushMessage = [this, &msg, &startMessage]() {
+        if(msg.size() > UDP_INPUT_BINARY_HEADER)
+            this->sendToPeers(msg);
+        startMessage();
+    };
+
+    startMessage();
+    for(const FsmInput &input : inputs)
+    {
+        int id = -1;
+        if(isListening)
+        {
+            // Clients may not have the table with the id yet
+            id = inputNames.find(input.first);
+            if(id >= known)
+                id = -1;
+        }
+        else if(remoteVersion >= 0)
+            id = remoteIds.value(input.first, -1);
+
+        const QByteArray value = input.second.toUtf8();
+
+        // Unknown to the other side (or too long) ==> text message, in order
+        if(id < 0 || value.size() > UDP_INPUT_BINARY_LIMIT - UDP_INPUT_BINARY_HEADER - UDP_INPUT_RECORD_HEADER)
+        {
+            flushMessage();
+            this->sendTextInput(input.first, input.second);
+            continue;
+        }
+
+        if(msg.size() + UDP_INPUT_RECORD_HEADER + value.size() > UDP_INPUT_BINARY_LIMIT)
+            flushMessage();
+
+        int offset = msg.size();
+        msg.resize(offset + UDP_INPUT_RECORD_HEADER);
+        qToLittleEndian<quint16>(static_cast<quint16>(id), reinterpret_cast<uchar*>(msg.data() + offset));
+        qToLittleEndian<quint16>(static_cast<quint16>(value.size()), reinterpret_cast<uchar*>(msg.data() + offset + 2));
+        msg.append(value);
+    }
+    flushMessage();
+}
+
+void FsmNetworkManager::actionInputTable(const NetworkEndpoint &target)
+{
+    if(!isListening)
+        return;
+
+    this->sendLarge(this->buildInputTable(), &target);
+}
+
+QByteArray FsmNetworkManager::buildInputTable() const
+{
+    QByteArray msg(5, '\0');
+    msg[0] = static_cast<char>(UDP_MESSAGE_TYPE::UDP_INPUT_TABLE);
+    qToLittleEndian<quint16>(inputNames.version(), reinterpret_cast<uchar*>(msg.data() + 1));
+    qToLittleEndian<quint16>(static_cast<quint16>(inputNames.size()), reinterpret_cast<uchar*>(msg.data() + 3));
+
+    // Removed inputs keep their ids (empty names)
+    for(int id = 0; id < inputNames.size(); id++)
+    {
+        const QByteArray name = inputNames.name(id).toUtf8();
+        int offset = msg.size();
+        msg.resize(offset + 2);
+        qToLittleEndian<quint16>(static_cast<quint16>(name.size()), reinterpret_cast<uchar*>(msg.data() + offset));
+        msg.append(name);
+    }
+
+    return msg;
+}
+
+int FsmNetworkManager::announceInputTable()
+{
+    if(!isListening)
+        return 0;
 
+    // Ids of a table of the same version are still valid
+    int known = announcedVersion == inputNames.version() ? announcedSize : 0;
+    if(announcedRevision == inputNames.revision())
+        return known;
+
+    announcedVersion = inputNames.version();
+    announcedRevision = inputNames.revision();
+    announcedSize = inputNames.size();
+    if(!this->clientAddresses.isEmpty())
+        this->sendLarge(this->buildInputTable());
+
+    return known;
+}
+
+void FsmNetworkManager::sendLarge(const QByteArray &msg, const NetworkEndpoint *target)
+{
+    QVector<QByteArray> single;
+    const QVector<QByteArray> *datagrams = &single;
+
+    if(msg.size() <= UDP_CHUNK_THRESHOLD)
+    {
+        single.append(msg);
+    }
+    else
+    {
+        // Chunks are kept until a newer transfer replaces them (for retransmission)
+        quint32 transfer = chunkSender.split(UDP_MESSAGE_TYPE::UDP_CHUNK, msg);
+        if(transfer == 0)
+        {
+            qWarning() << "Network: Message of " << msg.size() << " bytes is too large to send";
+            return;
+        }
+        datagrams = chunkSender.chunks(transfer);
+    }
+
+    for(const QByteArray &datagram : *datagrams)
+    {
+        if(target != nullptr)
+            this->writeDatagram(datagram, target->address, target->port);
+        else
+            this->sendToPeers(datagram);
+    }
+}
+
+void FsmNetworkManager::sendToPeers(const QByteArray &msg, const NetworkEndpoint *except)
+{
     // Client
     if(isConnected)
-    {   
-        this->udpSocket->writeDatagram(msg, serverAddress.address, serverAddress.port);
+    {
+        this->writeDatagram(msg, serverAddress.address, serverAddress.port);
 
     } // Server
     else if(isListening)
-    {       
-        // Send message to all clients
+    {
         SERVER_FOR_ALL(
-            this->udpSocket->writeDatagram(msg, client.address, client.port);
+            if(except == nullptr || client != *except)
+                this->writeDatagram(msg, client.address, client.port);
         );
     }
 }
 
+void FsmNetworkManager::sendTextInput(const QString &name, const QString &value, const NetworkEndpoint *except)
+{
+    // Received inputs are decoded as UTF-8
+    const QByteArray nameBytes = name.toUtf8();
+    const QByteArray valueBytes = value.toUtf8();
+
+    QByteArray msg;
+    msg.reserve(1 + nameBytes.size() + 1 + valueBytes.size() + 1);
+    msg.append(static_cast<char>(UDP_MESSAGE_TYPE::UDP_INPUT));
+    msg.append(nameBytes);
+    msg.append('\0');
+    msg.append(valueBytes);
+    msg.append('\0');
+
+    this->sendToPeers(msg, except);
+}
+
 void FsmNetworkManager::actionForceDisconnect(const NetworkEndpoint &target)
 {
     if(isListening || isConnected)
@@ -387,7 +1029,7 @@ void FsmNetworkManager::actionForceDisconnect(const NetworkEndpoint &target)
         CONSTRUCT_DATAGRAM(msg, UDP_DISCONNECT);
 
         // Send the disconnect message
-        this->udpSocket->writeDatagram(msg, target.address, target.port);
+        this->writeDatagram(msg, target.address, target.port);
 
         // if(isListening){
         //     // Unlink target from set
@@ -402,8 +1044,15 @@ void FsmNetworkManager::actionSyncRequest()
     if(!isConnected)
         return;
 
-    CONSTRUCT_DATAGRAM(msg, UDP_SYNC_REQUEST);
-    this->udpSocket->writeDatagram(msg, serverAddress.address, serverAddress.port);
+    QByteArray msg;
+    QDataStream stream(&msg, QIODevice::WriteOnly);
+    stream << static_cast<quint8>(UDP_MESSAGE_TYPE::UDP_SYNC_REQUEST);
+
+    // Only edits since the version we have
+    if(syncSession != 0)
+        stream << syncSession << syncVersion;
+
+    this->writeDatagram(msg, serverAddress.address, serverAddress.port);
 }
 
 void FsmNetworkManager::actionSyncExecute()
@@ -416,23 +1065,18 @@ void FsmNetworkManager::actionSyncExecute()
     if(this->clientAddresses.isEmpty())
         return;
 
-    QString msg;
-    QTextStream stream(&msg, QIODevice::WriteOnly);
-    stream << static_cast<uint8_t>(UDP_MESSAGE_TYPE::UDP_SYNC_EXECUTE);
-
-    // Load current representation to stream
-    this->ownerObject->saveStream(stream);
-    stream.flush();
+    // Edits since the last sync of all clients (others ask for theirs)
+    this->sendLarge(this->buildSync(syncSession, syncVersion));
+}
 
-    // Remove duplicite whitespaces
-    msg.replace(QRegularExpression("[ \t]+"), " ");
-    MSG_TYPE(msg.data()) = static_cast<uint8_t>(UDP_MESSAGE_TYPE::UDP_SYNC_EXECUTE);
-    auto bytes = msg.toLocal8Bit();
+QByteArray FsmNetworkManager::buildSync(quint32 &session, quint64 &version)
+{
+    QByteArray msg;
+    QDataStream stream(&msg, QIODevice::WriteOnly);
+    stream << static_cast<quint8>(UDP_MESSAGE_TYPE::UDP_SYNC_EXECUTE);
 
-    // Send the representation back to all clients (without duplicite whitespaces)
-    SERVER_FOR_ALL(
-        this->udpSocket->writeDatagram(bytes, client.address, client.port);
-    );
+    this->ownerObject->saveChanges(stream, session, version);
+    return msg;
 }
 
 void FsmNetworkManager::actionConnect()
@@ -443,11 +1087,11 @@ void FsmNetworkManager::actionConnect()
 
     CONSTRUCT_DATAGRAM(msgConnect, UDP_CONNECT);
     // Send the connect message
-    this->udpSocket->writeDatagram(msgConnect, serverAddress.address, serverAddress.port);
+    this->writeDatagram(msgConnect, serverAddress.address, serverAddress.port);
 
     CONSTRUCT_DATAGRAM(msgSync, UDP_SYNC_REQUEST);
     // Send the sync request
-    this->udpSocket->writeDatagram(msgSync, serverAddress.address, serverAddress.port);
+    this->writeDatagram(msgSync, serverAddress.address, serverAddress.port);
 }
 
 void FsmNetworkManager::enableClient()
@@ -17,8 +17,17 @@
 #include <QUdpSocket>
 #include <QHostAddress>
 #include <QAbstractSocket>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPair>
+#include <QQueue>
 
 #include "mvc_interface.h"
+#include "input_name_table.h"
+#include "chunk_transfer.h"
+
+class UdpBatchReceiver;
 
 // Extract parameter from byte array
 #define MSG_EXTRACT_PARAM(msg, param) (((uint8_t*)(msg))[UDP_PARAM_POSITIONS::param])
@@ -65,10 +74,49 @@ enum UDP_MESSAGE_TYPE : uint8_t
     UDP_DISCONNECT, // Client wants to disconnect from server
     UDP_INPUT, // Input event
     UDP_INTER_STATE, // Interpretation state
-    UDP_SYNC_REQUEST, // Request for sync
-    UDP_SYNC_EXECUTE, // Synchronize the client
+    UDP_SYNC_REQUEST, // Request for sync (with the version the client has, if any)
+    UDP_SYNC_EXECUTE, // Synchronize the client (edits since its version or the whole machine)
+    UDP_INPUT_TABLE, // Ids of input variables of the server (empty message from client requests it)
+    UDP_INPUT_BINARY, // Input events encoded by ids of the input table
+    UDP_CHUNK, // Part of a message larger than a datagram (see chunk_transfer.h)
+    UDP_CHUNK_NACK, // Request to send chunks of a transfer again
 };
 
+/*
+ * UDP_INPUT_TABLE:  [type][u16 version][u16 count] count * ([u16 length][name])
+ * UDP_INPUT_BINARY: [type][u16 version] n * ([u16 id][u16 length][value])
+ * Integers are little endian; names and values are UTF-8. Ids are given by the server (InputNameTable) and stay
+ * valid until the version changes (table cleared); a message with other version is dropped and the table is sent
+ * (or requested) again. Inputs added since the table was last announced are sent as text (UDP_INPUT).
+ *
+ * UDP_SYNC_REQUEST: [type] or [type][u32 session][u64 version] (big endian)
+ * UDP_SYNC_EXECUTE: [type] followed by FsmInterface::saveChanges (edits since the version, or the whole machine)
+ * A client that can't apply the edits (other version) requests sync with its version again.
+ */
+
+// Size of sync request carrying the version of the client
+#define UDP_SYNC_REQUEST_VERSIONED (1 + 4 + 8)
+
+// Missing chunks of a transfer are requested after this many milliseconds of silence
+#define UDP_CHUNK_NACK_INTERVAL 50
+// Transfer is given up after this many requests without any new chunk
+#define UDP_CHUNK_NACK_RETRIES 20
+// Maximal number of chunks requested by a single message
+#define UDP_CHUNK_NACK_LIMIT ((UDP_INPUT_BINARY_LIMIT - 5) / 2)
+// Number of completed transfers remembered (late duplicates of their chunks are ignored)
+#define UDP_CHUNK_FINISHED_KEEP 64
+// Maximal number of transfers reassembled at once for a single sender (the least active one is given up)
+#define UDP_CHUNK_INCOMING_LIMIT 4
+// Size of the receive buffer of the socket (bursts of chunks)
+#define UDP_RECEIVE_BUFFER (4 * 1024 * 1024)
+
+// Size of the header of binary input message
+#define UDP_INPUT_BINARY_HEADER 3
+// Size of the header of a record of binary input message
+#define UDP_INPUT_RECORD_HEADER 4
+// Binary input messages are split to fit this size (common MTU)
+#define UDP_INPUT_BINARY_LIMIT 1400
+
 // Default port used by UDP manager
 #define DEFAULT_UDP_PORT 60000
 // Default address used by UDP manager
@@ -112,6 +160,69 @@ inline uint qHash(const NetworkEndpoint& endpoint, uint seed = 0) {
     return qHash(endpoint.address, seed) ^ qHash(endpoint.port, seed << 1);
 };
 
+/**
+ * @brief Input event parsed in place (views into the received datagram)
+ */
+struct UdpInputView
+{
+    const char *name = nullptr; ///< UTF-8 name of the input (not null-terminated)
+    int nameSize = 0; ///< Bytes of the name
+    const char *value = nullptr; ///< UTF-8 value of the input (not null-terminated)
+    int valueSize = 0; ///< Bytes of the value
+};
+
+/**
+ * @brief Large message being received
+ */
+struct IncomingChunks
+{
+    ChunkAssembler assembler; ///< Received chunks
+    qint64 lastActivity = 0; ///< When a chunk was received or missing ones requested (chunkClock)
+    int requests = 0; ///< Requests for missing chunks since the last received chunk
+};
+
+// Transfer identified by its sender
+typedef QPair<NetworkEndpoint, quint32> ChunkTransferKey;
+
+/**
+ * @brief Counters of the receive path
+ */
+struct UdpReceiveStats
+{
+    static constexpr int BUCKETS = 6; ///< Batch sizes 1, 2-3, 4-7, 8-15, 16-31, 32+
+
+    quint64 datagrams = 0; ///< Received datagrams
+    quint64 batches = 0; ///< Bursts of datagrams processed at once
+    quint64 kernelDrops = 0; ///< Datagrams dropped by the kernel (full socket buffer); Linux only
+    quint64 truncated = 0; ///< Datagrams larger than a receive buffer (dropped)
+    quint64 rejected = 0; ///< Datagrams of unregistered clients (dropped)
+    quint64 unknownInputs = 0; ///< Inputs of names that are not input variables of the machine (not dispatched)
+    quint64 staleInputs = 0; ///< Binary input messages encoded by other version of the input table (dropped)
+    quint64 chunks = 0; ///< Received chunks of large messages
+    quint64 corruptChunks = 0; ///< Chunks with wrong checksum or not matching their transfer (dropped)
+    quint64 resentChunks = 0; ///< Chunks sent again on request of the receiver
+    quint64 lostTransfers = 0; ///< Large messages given up (chunks not received after all requests, or too many transfers of a sender)
+    quint64 batchSizes[BUCKETS] = {}; ///< Histogram of batch sizes
+
+    /**
+     * @brief Counts a burst of datagrams
+     * @param size Number of datagrams of the burst
+     */
+    inline void addBatch(int size)
+    {
+        if(size <= 0)
+            return;
+
+        int bucket = 0;
+        while(bucket < BUCKETS - 1 && (size >> (bucket + 1)) != 0)
+            bucket++;
+
+        batches++;
+        datagrams += static_cast<quint64>(size);
+        batchSizes[bucket]++;
+    }
+};
+
 /**
  * @brief Class for listening to input from network and converting it to format that FsmModel (interpreter) understands
  */
@@ -134,12 +245,39 @@ class FsmNetworkManager: public QObject
 
         FsmInterface * ownerObject = nullptr; ///< Pointer to the owning interface
 
+        UdpBatchReceiver *batchReceiver = nullptr; ///< Batched receive path (Linux; owns the socket); nullptr if udpSocket is used
+        QSocketNotifier *batchNotifier = nullptr; ///< Wakes up the batched receive path
+        QByteArray receiveBuffer; ///< Reused buffer of the Qt receive path
+        FsmInputBatch pendingInputs; ///< Inputs of the current burst (dispatched to the owner at once)
+        UdpReceiveStats stats; ///< Counters of the receive path
+        InputNameTable inputNames; ///< Input variables of the machine (mirrored by the owner)
+
+        int announcedVersion = -1; ///< Server: version of the input table last sent to all clients; -1 if none
+        qint64 announcedRevision = -1; ///< Server: revision of the input table last sent to all clients; -1 if none
+        int announcedSize = 0; ///< Server: number of ids of the input table last sent to all clients
+        int remoteVersion = -1; ///< Client: version of the input table of the server; -1 if not received
+        QHash<QString, quint16> remoteIds; ///< Client: id of every input in the table of the server
+        QVector<QByteArray> remoteNames; ///< Client: name of every id of the table of the server
+        QVector<int> remoteToLocal; ///< Client: id in inputNames of every id of the server; -1 if unknown
+        qint64 remoteToLocalRevision = -1; ///< Client: revision of inputNames remoteToLocal was built for
+
+        ChunkSender chunkSender; ///< Latest large messages sent in chunks (for retransmission)
+        QHash<ChunkTransferKey, IncomingChunks> incomingChunks; ///< Large messages being received
+        QSet<ChunkTransferKey> finishedChunks; ///< Recently completed transfers
+        QQueue<ChunkTransferKey> finishedOrder; ///< Recently completed transfers from the oldest
+        QTimer *chunkTimer = nullptr; ///< Requests missing chunks while any transfer is incomplete
+        QElapsedTimer chunkClock; ///< Time of chunk activity
+
+        quint32 syncSession = 0; ///< Client: session of the version of the server it has; Server: of the version last sent to all clients (0 if none)
+        quint64 syncVersion = 0; ///< Client: version of the server it has; Server: version last sent to all clients
+
     public:
         /**
          * @brief Constructor for UDP message receiver
-         * @param parent The parent object ==> must be set
+         * @param owner The interface that receives the network events (view or console front-end) ==> must be set
+         * @param parent The parent object
          */
-        FsmNetworkManager(QObject *parent = nullptr);
+        FsmNetworkManager(FsmInterface *owner, QObject *parent = nullptr);
 
         /**
          * @brief Destructor of UDP message receiver
@@ -192,6 +330,29 @@ class FsmNetworkManager: public QObject
          */
         const NetworkEndpoint &getServerInfo() const;
 
+        /**
+         * @brief Returns counters of the receive path (since the manager was created)
+         * @return The counters
+         */
+        const UdpReceiveStats &getStats() const;
+
+        /**
+         * @brief Registers input variable of the machine (received inputs of other names are not dispatched)
+         * @param name Name of the input variable
+         */
+        void registerInput(const QString &name);
+
+        /**
+         * @brief Unregisters input variable of the machine
+         * @param name Name of the input variable
+         */
+        void unregisterInput(const QString &name);
+
+        /**
+         * @brief Unregisters all input variables
+         */
+        void clearInputs();
+
         /* 
          =======================
          =   Received message
@@ -237,6 +398,34 @@ class FsmNetworkManager: public QObject
          */
         void messageInterState(const NetworkEndpoint &sender, const QByteArray &data);
 
+        /**
+         * @brief Input table of the server (client) or request for it (server)
+         * @param sender Who send this message
+         * @param data Data of the message
+         */
+        void messageInputTable(const NetworkEndpoint &sender, const QByteArray &data);
+
+        /**
+         * @brief Input events encoded by ids of the input table
+         * @param sender Who send this message
+         * @param data Data of the message
+         */
+        void messageInputBinary(const NetworkEndpoint &sender, const QByteArray &data);
+
+        /**
+         * @brief Part of a large message; the message is processed once complete
+         * @param sender Who send this message
+         * @param data Data of the message
+         */
+        void messageChunk(const NetworkEndpoint &sender, const QByteArray &data);
+
+        /**
+         * @brief Request to send chunks of a transfer again
+         * @param sender Who send this message
+         * @param data Data of the message
+         */
+        void messageChunkNack(const NetworkEndpoint &sender, const QByteArray &data);
+
         /* 
          ======================
          =   Network Actions
@@ -255,18 +444,30 @@ class FsmNetworkManager: public QObject
          */
         void actionInput(const QString &name, const QString &value);
 
+        /**
+         * @brief Sends input events to given server/all clients (packed by ids of the input table where possible)
+         * @param inputs Names and values of the inputs
+         */
+        void actionInputs(const FsmInputBatch &inputs);
+
+        /**
+         * @brief Sends the input table to a client (server only)
+         * @param target The client
+         */
+        void actionInputTable(const NetworkEndpoint &target);
+
         /**
          * @brief Force disconnects a client
          */
         void actionForceDisconnect(const NetworkEndpoint &target);
 
         /**
-         * @brief Requests sync from server
+         * @brief Requests sync from server (only edits since the version it has, if any)
          */
         void actionSyncRequest();
 
         /**
-         * @brief Explicitly syncs all the clients
+         * @brief Explicitly syncs all the clients (by edits since the last sync of all clients)
          */
         void actionSyncExecute();
 
@@ -303,19 +504,95 @@ class FsmNetworkManager: public QObject
     signals:
         // Signal fired when a message was successfully received
         void udpMessageReceived(const QString &name, const QString &value);
+        // Signal fired when the server disconnected this client
+        void serverDisconnected();
     private slots:
         // Processed received packets
         void processReceivedPacket();
+        // Processes received packets in batches (recvmmsg)
+        void processReceivedBatch();
+        // Requests missing chunks of stalled transfers
+        void requestMissingChunks();
 
     protected:
         /**
-         * @brief Parses input packet into two output strings
-         * @param data The data of the packet
-         * @param outName The name of the event sent through network (first string)
-         * @param outValue The string value of the event sent through network (second string)
+         * @brief Dispatches single received datagram by its type
+         * @param sender Who send this message
+         * @param data Data of the message
+         */
+        void processDatagram(const NetworkEndpoint &sender, const QByteArray &data);
+
+        /**
+         * @brief Passes inputs of the current burst to the owner in a single batch
+         */
+        void flushInputs();
+
+        /**
+         * @brief Sends input event as text (UDP_INPUT) to given server/all clients
+         * @param name The name of the input event
+         * @param value The value of the input
+         * @param except Client that doesn't get the input (server only)
+         */
+        void sendTextInput(const QString &name, const QString &value, const NetworkEndpoint *except = nullptr);
+
+        /**
+         * @brief Sends message of any size to a peer or to all peers; split into chunks if it doesn't fit a datagram
+         * @param msg The message
+         * @param target The receiver; nullptr for the server (client) or all clients (server)
+         */
+        void sendLarge(const QByteArray &msg, const NetworkEndpoint *target = nullptr);
+
+        /**
+         * @brief Requests missing chunks of a transfer
+         * @param key The transfer
+         * @param incoming Received chunks of the transfer
+         */
+        void requestChunks(const ChunkTransferKey &key, IncomingChunks &incoming);
+
+        /**
+         * @brief Sends a single datagram through the bound socket (batched receiver or udpSocket)
+         * @param msg The datagram
+         * @param address Address of the receiver
+         * @param port Port of the receiver
+         * @return Number of bytes sent; -1 on error
+         */
+        qint64 writeDatagram(const QByteArray &msg, const QHostAddress &address, quint16 port);
+
+        /**
+         * @brief Sends message to the server (client) or to all clients except one (server)
+         * @param msg The message
+         * @param except Client that doesn't get the message (server only)
+         */
+        void sendToPeers(const QByteArray &msg, const NetworkEndpoint *except = nullptr);
+
+        /**
+         * @brief Encodes sync of a copy of the machine (server only)
+         * @param session Session of the version of the copy (0 if none); set to the session after the sync
+         * @param version Version of the copy; set to the version after the sync
+         * @return The UDP_SYNC_EXECUTE message
+         */
+        QByteArray buildSync(quint32 &session, quint64 &version);
+
+        /**
+         * @brief Encodes the input table (server only)
+         * @return The UDP_INPUT_TABLE message
+         */
+        QByteArray buildInputTable() const;
+
+        /**
+         * @brief Sends the input table to all clients unless they already have the current revision (server only)
+         * @return Number of ids the clients knew before; inputs with higher ids are sent as text until the next call
+         */
+        int announceInputTable();
+
+        /**
+         * @brief Parses input packet in place (no copies)
+         * @param data The payload of the packet (without the type)
+         * @param size Bytes of the payload
+         * @param out Views of the name and the value (valid as long as the data)
          * @return Returns true if parsing was successful, otherwise false
          */
-        bool parseInput(const QByteArray &data, QString &outName, QString &outValue);
+        static bool parseInput(const char *data, int size, UdpInputView &out);
 
 };
 
@@ -0,0 +1,334 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file console_interface.cpp
+ * @author xcervia00
+ *
+ * @brief Console front-end standing in for the view in the headless runtime
+ *
+ */
+
+#include "console_interface.h"
+
+#include <QObject>
+#include <QString>
+#include <QVariant>
+#include <QPoint>
+#include <QDebug>
+
+#include <cstdio>
+#include <unistd.h>
+
+ConsoleInterface::ConsoleInterface(QObject *parent)
+    :
+    QObject{parent},
+    out{stdout},
+    err{stderr}
+{
+    networkManager = new FsmNetworkManager(this, this);
+    connect(networkManager, &FsmNetworkManager::serverDisconnected, this, &ConsoleInterface::networkClientStop);
+}
+
+ConsoleInterface::~ConsoleInterface()
+{
+}
+
+void ConsoleInterface::registerModel(FsmInterface *model)
+{
+    this->model = model;
+}
+
+void ConsoleInterface::enableStdin()
+{
+    if(stdinNotifier != nullptr)
+        return;
+
+    stdinNotifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+    // String based connection ==> 'activated' is overloaded in newer Qt versions
+    connect(stdinNotifier, SIGNAL(activated(int)), this, SLOT(readStdin()));
+}
+
+void ConsoleInterface::readStdin()
+{
+    char buffer[4096];
+    auto bytesRx = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+
+    // End of input ==> stop watching stdin, the machine keeps running
+    if(bytesRx <= 0)
+    {
+        stdinNotifier->setEnabled(false);
+        return;
+    }
+
+    stdinBuffer.append(buffer, static_cast<int>(bytesRx));
+
+    // Process all finished lines; everything that arrived at once is passed as a single burst
+    FsmInputBatch inputs;
+    int lineEnd;
+    while((lineEnd = stdinBuffer.indexOf('\n')) >= 0)
+    {
+        QString line = QString::fromLocal8Bit(stdinBuffer.left(lineEnd)).trimmed();
+        stdinBuffer.remove(0, lineEnd + 1);
+
+        if(line.isEmpty())
+            continue;
+
+        // Format: NAME = VALUE (value is optional)
+        auto separator = line.indexOf('=');
+        if(separator < 0)
+        {
+            inputs.append({line, ""});
+        }
+        else
+        {
+            inputs.append({line.left(separator).trimmed(), line.mid(separator + 1).trimmed()});
+        }
+    }
+
+    if(!inputs.isEmpty())
+        this->submitInputs(inputs);
+}
+
+void ConsoleInterface::submitInputs(const FsmInputBatch &inputs)
+{
+    if(!isInterpreting)
+    {
+        err << inputs.size() << " inputs ignored: FSM is not being interpreted" << "\n";
+        err.flush();
+        return;
+    }
+
+    this->model->inputEvents(inputs);
+
+    if(isNetworking)
+        this->networkManager->actionInputs(inputs);
+}
+
+void ConsoleInterface::submitInput(const QString &name, const QString &value)
+{
+    if(!isInterpreting)
+    {
+        err << "Input " << name << " ignored: FSM is not being interpreted" << "\n";
+        err.flush();
+        return;
+    }
+
+    this->model->inputEvent(name, value);
+
+    if(isNetworking)
+        this->networkManager->actionInput(name, value);
+}
+
+/*
+===========================
+     NETWORK RELATED
+===========================
+*/
+
+void ConsoleInterface::networkServerStart(const QHostAddress &address, quint16 port)
+{
+    qInfo() << "Network: Starting a server on " << address.toString() << " via " << port;
+
+    isNetworking = true;
+    networkManager->setAddress(address, port);
+    networkManager->enableServer();
+}
+
+void ConsoleInterface::networkClientStart(const QHostAddress &address, quint16 port)
+{
+    qInfo() << "Network: Connecting to server " << address.toString() << " via " << port;
+
+    isNetworking = true;
+    networkManager->setAddress(address, port);
+    networkManager->enableClient();
+}
+
+void ConsoleInterface::networkClientStop()
+{
+    qInfo() << "Network: Disconnected from server " << networkManager->getServerInfo().address.toString()
+            << " via " << networkManager->getServerInfo().port;
+
+    networkManager->cancelClient();
+    isNetworking = false;
+
+    // Nothing else can start the interpretation now
+    if(!isInterpreting)
+        emit interpretationStopped();
+}
+
+bool ConsoleInterface::networking() const
+{
+    return isNetworking;
+}
+
+/*
+===========================
+      MVC INTERFACE
+===========================
+*/
+
+// Structural changes are not displayed anywhere
+
+void ConsoleInterface::updateState(const QString &name, const QPoint &pos) { (void)name; (void)pos; }
+void ConsoleInterface::updateStateName(const QString &oldName, const QString &newName) { (void)oldName; (void)newName; }
+void ConsoleInterface::updateAction(const QString &parentState, const QString &action) { (void)parentState; (void)action; }
+void ConsoleInterface::updateActiveState(const QString &name) { (void)name; }
+void ConsoleInterface::updateCondition(size_t transitionId, const QString &condition) { (void)transitionId; (void)condition; }
+void ConsoleInterface::updateTransition(size_t transitionId, const QString &srcState, const QString &destState) { (void)transitionId; (void)srcState; (void)destState; }
+void ConsoleInterface::updateVarInput(const QString &name, const QString &value)
+{
+    (void)value;
+
+    // Network dispatches only inputs of the machine
+    networkManager->registerInput(name);
+}
+
+void ConsoleInterface::updateVarInputs(const FsmInputBatch &inputs) { (void)inputs; }
+void ConsoleInterface::updateVarOutput(const QString &name, const QString &value) { (void)name; (void)value; }
+void ConsoleInterface::updateVarInternal(const QString &name, const QVariant &value) { (void)name; (void)value; }
+
+void ConsoleInterface::destroyState(const QString &name) { (void)name; }
+void ConsoleInterface::destroyAction(const QString &parentState) { (void)parentState; }
+void ConsoleInterface::destroyCondition(size_t transitionId) { (void)transitionId; }
+void ConsoleInterface::destroyTransition(size_t transitionId) { (void)transitionId; }
+void ConsoleInterface::destroyVarInput(const QString &name)
+{
+    networkManager->unregisterInput(name);
+}
+
+void ConsoleInterface::destroyVarOutput(const QString &name) { (void)name; }
+void ConsoleInterface::destroyVarInternal(const QString &name) { (void)name; }
+
+void ConsoleInterface::loadFile(const QString &filename)
+{
+    // Nop
+    (void)filename;
+}
+
+void ConsoleInterface::saveFile(const QString &filename)
+{
+    // Nop
+    (void)filename;
+}
+
+void ConsoleInterface::loadStream(QTextStream &stream)
+{
+    this->model->loadStream(stream);
+}
+
+void ConsoleInterface::saveStream(QTextStream &stream)
+{
+    this->model->saveStream(stream);
+}
+
+void ConsoleInterface::saveChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    this->model->saveChanges(stream, session, version);
+}
+
+bool ConsoleInterface::loadChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    return this->model->loadChanges(stream, session, version);
+}
+
+void ConsoleInterface::renameFsm(const QString &name)
+{
+    (void)name;
+}
+
+void ConsoleInterface::log(const QString &time, const QString &state, const QString &varInputs, const QString &varOutputs, const QString &varInternals) const
+{
+    (void)time;
+    (void)state;
+    (void)varInputs;
+    (void)varOutputs;
+    (void)varInternals;
+}
+
+void ConsoleInterface::log() const
+{
+    // Nop
+}
+
+void ConsoleInterface::startInterpretation()
+{
+    if(isInterpreting)
+        return;
+
+    if(isNetworking)
+    {
+        // The start came locally ==> let others know
+        if(networkManager->getInitiation() == false)
+            networkManager->actionInterState(true);
+
+        // Client waits for the server to start the interpretation
+        if(networkManager->getState() == CLIENT && !networkManager->getInitiation())
+            return;
+    }
+
+    isInterpreting = true;
+    this->model->startInterpretation();
+}
+
+void ConsoleInterface::stopInterpretation()
+{
+    if(!isInterpreting)
+        return;
+
+    isInterpreting = false;
+    this->model->stopInterpretation();
+
+    if(isNetworking)
+        networkManager->actionInterState(false);
+
+    emit interpretationStopped();
+}
+
+void ConsoleInterface::restoreInterpretationBackup()
+{
+    // Nop
+}
+
+void ConsoleInterface::cleanup()
+{
+    networkManager->clearInputs();
+}
+
+void ConsoleInterface::throwError(FsmErrorType errNum)
+{
+    err << "Error " << errNum << " occured" << "\n";
+    err.flush();
+    this->stopInterpretation();
+}
+
+void ConsoleInterface::throwError(FsmErrorType errNum, const QString &errMsg)
+{
+    err << "Error " << errNum << ": " << errMsg << "\n";
+    err.flush();
+    this->stopInterpretation();
+}
+
+void ConsoleInterface::outputEvent(const QString &outName)
+{
+    // Output events are the only thing printed to stdout
+    out << outName << "\n";
+    out.flush();
+}
+
+void ConsoleInterface::inputEvent(const QString &name, const QString &value)
+{
+    this->model->inputEvent(name, value);
+}
+
+void ConsoleInterface::inputEvents(const FsmInputBatch &inputs)
+{
+    this->model->inputEvents(inputs);
+}
+
+void ConsoleInterface::updatesPending()
+{
+    // Nothing is displayed; inputs are registered with the network right away
+    this->model->flushUpdates();
+}
+
+void ConsoleInterface::flushUpdates() {}
@@ -0,0 +1,158 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file console_interface.h
+ * @author xcervia00
+ *
+ * @brief Console front-end standing in for the view in the headless runtime (interface)
+ *
+ */
+
+#ifndef CONSOLE_INTERFACE_H_
+#define CONSOLE_INTERFACE_H_
+
+#include <QObject>
+#include <QString>
+#include <QTextStream>
+#include <QSocketNotifier>
+#include <QHostAddress>
+#include <QByteArray>
+
+#include "mvc_interface.h"
+#include "network/udp_manager.h"
+
+/**
+ * @brief Minimal implementation of the view part of MVC for running FSM without any widgets
+ * @note Outputs are printed to stdout, errors to stderr; inputs are read from stdin as "name = value" lines
+ */
+class ConsoleInterface : public QObject, public FsmInterface
+{
+    Q_OBJECT
+
+    protected:
+        FsmInterface *model = nullptr; ///< Reference to model
+        FsmNetworkManager *networkManager = nullptr; ///< Object handling network actions
+        QSocketNotifier *stdinNotifier = nullptr; ///< Notifier of new input on stdin
+
+        QTextStream out; ///< Standard output stream
+        QTextStream err; ///< Standard error stream
+        QByteArray stdinBuffer; ///< Unfinished line read from stdin
+
+        bool isNetworking = false; ///< Is runtime connected as client/server?
+        bool isInterpreting = false; ///< Is the fsm being interpreted?
+
+    public:
+        /**
+         * @brief Constructor of the console front-end
+         * @param parent The parent object
+         */
+        explicit ConsoleInterface(QObject *parent = nullptr);
+        /**
+         * @brief Destructor of the console front-end
+         */
+        virtual ~ConsoleInterface();
+
+        /**
+         * @brief Related to MVC interface communication; registers a model to use
+         * @param model The model to use
+         */
+        void registerModel(FsmInterface *model);
+
+        /**
+         * @brief Begins reading input events from stdin
+         */
+        void enableStdin();
+
+        /**
+         * @brief Begins listening to network input as a server
+         * @param address The address to listen on
+         * @param port The port to listen on
+         */
+        void networkServerStart(const QHostAddress &address, quint16 port);
+        /**
+         * @brief Connects to server as client
+         * @param address The address of the server
+         * @param port The port of the server
+         */
+        void networkClientStart(const QHostAddress &address, quint16 port);
+
+        /**
+         * @brief Is runtime connected as client/server?
+         * @return True if networking is enabled, otherwise false
+         */
+        bool networking() const;
+
+        /**
+         * @brief Local input event (from stdin); passed to model and to the network
+         * @param name The name of the input event
+         * @param value The value associated with the input
+         */
+        void submitInput(const QString &name, const QString &value);
+        /**
+         * @brief Burst of local input events; passed to model at once and to the network
+         * @param inputs The input events in order of arrival
+         */
+        void submitInputs(const FsmInputBatch &inputs);
+
+        // ========================
+        //       MVC INTERFACE
+        // ========================
+
+        void updateState(const QString &name, const QPoint &pos) override;
+        void updateStateName(const QString &oldName, const QString &newName) override;
+        void updateAction(const QString &parentState, const QString &action) override;
+        void updateActiveState(const QString &name) override;
+
+        void updateCondition(size_t transitionId, const QString &condition) override;
+        void updateTransition(size_t transitionId, const QString &srcState, const QString &destState) override;
+        void updateVarInput(const QString &name, const QString &value) override;
+        void updateVarInputs(const FsmInputBatch &inputs) override;
+        void updateVarOutput(const QString &name, const QString &value) override;
+        void updateVarInternal(const QString &name, const QVariant &value) override;
+
+        void destroyState(const QString &name) override;
+        void destroyAction(const QString &parentState) override;
+        void destroyCondition(size_t transitionId) override;
+        void destroyTransition(size_t transitionId) override;
+        void destroyVarInput(const QString &name) override;
+        void destroyVarOutput(const QString &name) override;
+        void destroyVarInternal(const QString &name) override;
+
+        void loadFile(const QString &filename) override;
+        void saveFile(const QString &filename) override;
+        void loadStream(QTextStream &stream) override;
+        void saveStream(QTextStream &stream) override;
+        void saveChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
+        bool loadChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
+
+        void renameFsm(const QString &name) override;
+
+        void log(const QString &time, const QString &state, const QString &varInputs, const QString &varOutputs, const QString &varInternals) const override;
+        void log() const override;
+
+        void startInterpretation() override;
+        void stopInterpretation() override;
+        void restoreInterpretationBackup() override;
+
+        void cleanup() override;
+        void throwError(FsmErrorType errNum) override;
+        void throwError(FsmErrorType errNum, const QString &errMsg) override;
+
+        void outputEvent(const QString &outName) override;
+        void inputEvent(const QString &name, const QString &value) override;
+        void inputEvents(const FsmInputBatch &inputs) override;
+        void updatesPending() override;
+        void flushUpdates() override;
+
+    signals:
+        // Signal fired when the interpretation was stopped
+        void interpretationStopped();
+
+    private slots:
+        // Reads all available lines from stdin
+        void readStdin();
+        // Server disconnected this client
+        void networkClientStop();
+};
+
+#endif
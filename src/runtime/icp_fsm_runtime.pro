@@ -0,0 +1,19 @@
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
+TARGET = icp_fsm_runtime
+
+# Interpreter core without any widgets
+include(../fsm_core.pri)
+
+SOURCES += $$files($$PWD/*.cpp, true)
+
+HEADERS += $$files($$PWD/*.h, true)
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
@@ -0,0 +1,233 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file main_runtime.cpp
+ * @author xcervia00
+ *
+ * @brief Initiates the headless (widget-free) interpreter
+ *
+ */
+
+#include "console_interface.h"
+#include "model.h"
+#include "async_logger.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QHostAddress>
+#include <QDebug>
+
+#include <cstdio>
+
+/**
+ * @brief Message handler that drops informational messages (used with --quiet)
+ * @param type The type of the message
+ * @param context Context of the message
+ * @param msg The message itself
+ */
+static void quietMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    (void)context;
+
+    if(type == QtInfoMsg || type == QtDebugMsg)
+        return;
+
+    fprintf(stderr, "%s\n", qUtf8Printable(msg));
+}
+
+/**
+ * @brief Parses endpoint in format ADDRESS:PORT (or just ADDRESS)
+ * @param text The text to parse
+ * @param address Parsed address
+ * @param port Parsed port (left unchanged if not present)
+ * @return True on success, otherwise false
+ */
+static bool parseEndpoint(const QString &text, QHostAddress &address, quint16 &port)
+{
+    auto separator = text.lastIndexOf(':');
+    QString host = separator < 0 ? text : text.left(separator);
+
+    if(separator >= 0)
+    {
+        bool ok;
+        port = text.mid(separator + 1).toUShort(&ok);
+        if(!ok) return false;
+    }
+
+    if(host.isEmpty())
+        address = DEFAULT_ADDRESS;
+    else if(host == "Any")
+        address = QHostAddress::AnyIPv4;
+    else if(!address.setAddress(host))
+        return false;
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    // QCoreApplication (must be first)
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("icp_fsm_runtime");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless FSM interpreter; inputs are read from stdin as 'NAME = VALUE' lines, outputs are written to stdout");
+    parser.addHelpOption();
+    parser.addPositionalArgument("file", "The .fsm file to interpret");
+
+    QCommandLineOption serverOption({"s", "server"}, "Listen for network input as server on ADDRESS:PORT", "endpoint");
+    QCommandLineOption clientOption({"c", "client"}, "Connect to server at ADDRESS:PORT (interpretation is started by the server)", "endpoint");
+    QCommandLineOption quietOption({"q", "quiet"}, "Do not print interpretation log");
+    QCommandLineOption noStdinOption("no-stdin", "Do not read input events from stdin");
+    QCommandLineOption engineOption({"e", "engine"}, "Interpret by 'statemachine' (default) or compiled 'flat' transition table", "engine", "statemachine");
+    QCommandLineOption logFileOption("log-file", "Append the log to FILE (also with --quiet)", "file");
+    QCommandLineOption traceOption("trace", "Record interpretation into binary trace FILE (see icp_trace_decode)", "file");
+    QCommandLineOption replayOption("replay", "Replay inputs recorded in trace FILE on a virtual clock and exit", "file");
+    QCommandLineOption speedOption("speed", "Run the clock of the machine N times faster than the real time", "N");
+    QCommandLineOption simulateOption("simulate", "Simulated time: skip straight to the next timeout whenever idle");
+    parser.addOptions({serverOption, clientOption, quietOption, noStdinOption, engineOption, logFileOption, traceOption, replayOption,
+                       speedOption, simulateOption});
+
+    parser.process(a);
+
+    const QStringList args = parser.positionalArguments();
+    if(args.size() != 1 && !parser.isSet(clientOption))
+    {
+        parser.showHelp(1);
+    }
+
+    // Log is formatted and written by a background thread
+    AsyncLogger &logger = AsyncLogger::instance();
+    if(parser.isSet(logFileOption))
+    {
+        std::unique_ptr<FileLogSink> file(new FileLogSink(parser.value(logFileOption)));
+        if(!file->isOpen())
+        {
+            fprintf(stderr, "Cannot open log file %s\n", qUtf8Printable(parser.value(logFileOption)));
+            return 1;
+        }
+        logger.addSink(std::move(file));
+    }
+
+    if(parser.isSet(quietOption))
+    {
+        qInstallMessageHandler(quietMessageHandler);
+    }
+    else
+    {
+        logger.addSink(std::unique_ptr<LogSink>(new StreamLogSink(stderr)));
+    }
+
+    // Keep qInfo etc. in order with the interpretation events (unless nobody listens)
+    if(logger.enabled())
+    {
+        logger.installMessageHandler();
+    }
+
+    // Clock of the interpretation (must outlive the model)
+    std::unique_ptr<FsmClock> clock;
+    if(parser.isSet(simulateOption))
+    {
+        clock.reset(new SimulatedClock());
+    }
+    else if(parser.isSet(speedOption))
+    {
+        bool ok;
+        double speed = parser.value(speedOption).toDouble(&ok);
+        if(!ok || speed <= 0)
+        {
+            fprintf(stderr, "Invalid speed %s\n", qUtf8Printable(parser.value(speedOption)));
+            return 1;
+        }
+        clock.reset(new RealTimeClock(speed));
+    }
+
+    ConsoleInterface v; // Create console front-end
+    FsmModel m; // Create model
+    m.setClock(clock.get());
+
+    // register references
+    v.registerModel(&m);
+    m.registerView(&v);
+
+    if(parser.value(engineOption) == "flat")
+    {
+        m.setEngineType(ENGINE_FLAT);
+    }
+    else if(parser.value(engineOption) != "statemachine")
+    {
+        fprintf(stderr, "Unknown engine %s\n", qUtf8Printable(parser.value(engineOption)));
+        return 1;
+    }
+
+    if(parser.isSet(traceOption) && !m.startTrace(parser.value(traceOption)))
+    {
+        fprintf(stderr, "Cannot create trace file %s\n", qUtf8Printable(parser.value(traceOption)));
+        return 1;
+    }
+
+    // Client receives the machine from the server
+    if(!args.isEmpty())
+    {
+        m.loadFile(args.first());
+        if(m.emptyStates())
+        {
+            fprintf(stderr, "Failed to load FSM from %s\n", qUtf8Printable(args.first()));
+            return 1;
+        }
+    }
+
+    // Replay runs without the event loop; timeouts do not wait for the real time
+    if(parser.isSet(replayOption))
+    {
+        bool replayed = m.replayTrace(parser.value(replayOption));
+        m.stopTrace();
+        logger.stop();
+        return replayed ? 0 : 1;
+    }
+
+    // Quit once interpretation ends (unless there is network that might restart it)
+    QObject::connect(&v, &ConsoleInterface::interpretationStopped, &a, [&]()
+    {
+        if(!v.networking()) {a.quit();}
+    });
+
+    if(!parser.isSet(noStdinOption))
+    {
+        v.enableStdin();
+    }
+
+    QHostAddress address = DEFAULT_ADDRESS;
+    quint16 port = DEFAULT_UDP_PORT;
+
+    if(parser.isSet(clientOption))
+    {
+        if(!parseEndpoint(parser.value(clientOption), address, port))
+        {
+            fprintf(stderr, "Invalid endpoint %s\n", qUtf8Printable(parser.value(clientOption)));
+            return 1;
+        }
+        v.networkClientStart(address, port);
+    }
+    else
+    {
+        if(parser.isSet(serverOption))
+        {
+            if(!parseEndpoint(parser.value(serverOption), address, port))
+            {
+                fprintf(stderr, "Invalid endpoint %s\n", qUtf8Printable(parser.value(serverOption)));
+                return 1;
+            }
+            v.networkServerStart(address, port);
+        }
+
+        v.startInterpretation();
+    }
+
+    int result = a.exec();
+
+    // Finish the trace and write out the rest of the log
+    m.stopTrace();
+    logger.stop();
+    return result;
+}
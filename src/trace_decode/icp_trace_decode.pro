@@ -0,0 +1,21 @@
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+TARGET = icp_trace_decode
+
+# Only the trace reader is needed
+INCLUDEPATH += $$PWD/../logging
+
+SOURCES += $$files($$PWD/*.cpp, true) \
+    $$PWD/../logging/trace_reader.cpp
+
+HEADERS += $$files($$PWD/*.h, true) \
+    $$PWD/../logging/trace_format.h \
+    $$PWD/../logging/trace_reader.h
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
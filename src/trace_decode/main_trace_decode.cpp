@@ -0,0 +1,127 @@
+/**
+* Project name: ICP Project 2024/2025
+*
+* @file main_trace_decode.cpp
+* @author  xcervia00
+*
+* @brief Prints the binary trace of interpretation runs as text
+*
+*/
+
+#include "trace_reader.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+
+#include <cstdio>
+
+using namespace FsmTrace;
+
+/**
+ * @brief Name of variable scope as written in the .fsm files
+ * @param scope The scope (VariableScope)
+ * @return The name
+ */
+static const char *scopeName(quint8 scope)
+{
+    switch(scope)
+    {
+        case 0: return "internal";
+        case 1: return "input";
+        case 2: return "output";
+        default: return "?";
+    }
+}
+
+/**
+ * @brief Formats time of the record
+ * @param reader The trace
+ * @param time Microseconds since the trace was opened
+ * @param absolute Print wall clock time instead?
+ * @return The time
+ */
+static QString formatTime(const TraceReader &reader, qint64 time, bool absolute)
+{
+    if(absolute)
+        return QDateTime::fromMSecsSinceEpoch(reader.startTime() + time / 1000).toString("yyyy-MM-dd hh:mm:ss.zzz");
+
+    return QString("%1.%2").arg(time / 1000000).arg(time % 1000000, 6, 10, QChar('0'));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("icp_trace_decode");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Prints binary trace recorded by icp_fsm_runtime --trace");
+    parser.addHelpOption();
+    parser.addPositionalArgument("trace", "Trace file to print");
+
+    QCommandLineOption absoluteOption({"a", "absolute"}, "Print wall clock time instead of seconds since the start of recording");
+    parser.addOption(absoluteOption);
+
+    parser.process(a);
+
+    const QStringList args = parser.positionalArguments();
+    if(args.size() != 1)
+    {
+        parser.showHelp(1);
+    }
+
+    TraceReader reader;
+    if(!reader.open(args.first()))
+    {
+        fprintf(stderr, "%s: %s\n", qUtf8Printable(args.first()), qUtf8Printable(reader.error()));
+        return 1;
+    }
+
+    const bool absolute = parser.isSet(absoluteOption);
+    printf("# Recorded %s\n", qUtf8Printable(QDateTime::fromMSecsSinceEpoch(reader.startTime()).toString(Qt::ISODate)));
+
+    TraceEvent event;
+    qint64 count = 0;
+    while(reader.next(event))
+    {
+        QString line = formatTime(reader, event.time, absolute) + "  ";
+        switch(event.type)
+        {
+            case RECORD_START:
+                line += QString("START %1").arg(event.engine == 1 ? "flat" : "statemachine");
+                break;
+            case RECORD_STOP:
+                line += "STOP";
+                break;
+            case RECORD_STATE:
+                line += QString("STATE %1").arg(event.name);
+                break;
+            case RECORD_TRANSITION:
+                line += QString("TRANSITION %1 -> %2 (%3)").arg(event.name, event.target).arg(event.transition);
+                break;
+            case RECORD_INPUT:
+                line += QString("INPUT %1").arg(event.name);
+                break;
+            case RECORD_OUTPUT:
+                line += QString("OUTPUT %1").arg(event.name);
+                break;
+            case RECORD_VARIABLE:
+                line += QString("VAR %1 %2 = %3").arg(scopeName(event.scope), event.name, event.value.toString());
+                break;
+            default:
+                continue;
+        }
+
+        printf("%s\n", qUtf8Printable(line));
+        count++;
+    }
+
+    if(!reader.error().isEmpty())
+    {
+        fprintf(stderr, "%s: %s\n", qUtf8Printable(args.first()), qUtf8Printable(reader.error()));
+        return 1;
+    }
+
+    printf("# %lld records%s\n", count, reader.isComplete() ? "" : " (incomplete trace, recording was not finished)");
+    return 0;
+}
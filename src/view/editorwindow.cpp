@@ -26,6 +26,7 @@
 #include <QFileDialog>
 #include <QTextEdit>
 #include <QScreen>
+#include <QGuiApplication>
 #include <cstdint>
 
 EditorWindow::EditorWindow(QWidget *parent)
@@ -35,7 +36,8 @@ EditorWindow::EditorWindow(QWidget *parent)
     ui->setupUi(this);
 
     // Network enabled?
-    networkManager = new FsmNetworkManager(this);
+    networkManager = new FsmNetworkManager(this, this);
+    connect(networkManager, &FsmNetworkManager::serverDisconnected, this, &EditorWindow::networkClientStop);
 
     statusBarLabel = new QLabel("");
     statusBar()->addWidget(statusBarLabel);
@@ -93,6 +95,15 @@ EditorWindow::EditorWindow(QWidget *parent)
     // React to combox name changes
     connect(inputEventCombox, &QComboBox::currentTextChanged, this, &EditorWindow::inputComboxChanged);
 
+    // Values written by scripts are coalesced by the model and displayed at most once per frame
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setTimerType(Qt::PreciseTimer);
+    QScreen *screen = QGuiApplication::primaryScreen();
+    qreal refreshRate = (screen != nullptr && screen->refreshRate() > 1) ? screen->refreshRate() : 60;
+    flushTimer->setInterval(qMax(1, qRound(1000 / refreshRate)));
+    connect(flushTimer, &QTimer::timeout, this, [this]() { this->model->flushUpdates(); });
+
     // Don't enable buttons with space by default and handle it manually
     stopButton->setFocusPolicy(Qt::NoFocus);
     startButton->setFocusPolicy(Qt::NoFocus);
@@ -339,7 +350,7 @@ void EditorWindow::handleActionSaveAs()
     dialog.setFileMode(QFileDialog::AnyFile);
     dialog.setAcceptMode(QFileDialog::AcceptSave);
     dialog.setDirectory(startDirectory);
-    dialog.setNameFilter(tr("FSM Files (*.fsm);;All Files (*)"));
+    dialog.setNameFilter(tr("FSM Files (*.fsm);;Compiled FSM Files (*.fsmb);;All Files (*)"));
     dialog.setDefaultSuffix("fsm");    
 
     // Was the dialogue accepted?
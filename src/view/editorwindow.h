@@ -21,6 +21,7 @@
 #include <QTextEdit>
 #include <QComboBox>
 #include <QPlainTextEdit>
+#include <QTimer>
 
 #include "view/work_area/workarea.h"
 #include "view/input_event_edit/input_event_line_edit.h"
@@ -336,6 +337,7 @@ private:
     void updateTransition(size_t transitionId, const QString &srcState, const QString &destState) override;
 
     void updateVarInput(const QString &name, const QString &value) override;
+    void updateVarInputs(const FsmInputBatch &inputs) override;
     void updateVarOutput(const QString &name, const QString &value) override;
     void updateVarInternal(const QString &name, const QVariant &value) override;
     /**
@@ -365,6 +367,8 @@ private:
     void saveFile(const QString &filename) override;
     void loadStream(QTextStream &stream) override;
     void saveStream(QTextStream &stream) override;
+    void saveChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
+    bool loadChanges(QDataStream &stream, quint32 &session, quint64 &version) override;
 
     void renameFsm(const QString &name) override;
 
@@ -381,6 +385,9 @@ private:
 
     void outputEvent(const QString &outName) override;
     void inputEvent(const QString &name, const QString &value) override;
+    void inputEvents(const FsmInputBatch &inputs) override;
+    void updatesPending() override;
+    void flushUpdates() override;
 
     // ========================
     //       Hotkeys 
@@ -443,6 +450,7 @@ private:
     bool isStateConnecting = false;///< whether or not is any state connecting to another -- via transition
 
     bool isInterpreting = false;///< the system is running
+    QTimer* flushTimer = nullptr;///< Fetches coalesced updates of interpretation at most once per display frame
 
     // Model-link
     FsmInterface* model = nullptr; ///< Reference to model
@@ -19,6 +19,7 @@
 #include <QTimer>
 #include <QDebug>
 #include <QMessageBox>
+#include <QSet>
 
 void EditorWindow::updateState(const QString &name, const QPoint &pos)
 {
@@ -109,10 +110,10 @@ void EditorWindow::updateActiveState(const QString &name)
     }
 
     if(activeState != nullptr){
-        activeState->recolor("#b3d1ff","navy","");
+        activeState->setActive(false);
     }
     activeState = allStates[name];
-    activeState->recolor("navy","white","w");
+    activeState->setActive(true);
 
     if(!isInterpreting){
         this->startButton->setEnabled(true);
@@ -153,9 +154,31 @@ void EditorWindow::updateVarInput(const QString &name, const QString &value)
 {
     fileModified = true;
 
+    // Network dispatches only inputs of the machine
+    if(this->networkManager != nullptr && !allVars[INPUTV].contains(name))
+        this->networkManager->registerInput(name);
+
     updateVar(INPUTV, name, value);
 }
 
+void EditorWindow::updateVarInputs(const FsmInputBatch &inputs)
+{
+    fileModified = true;
+
+    // Only the last value of each variable is displayed
+    QSet<QString> updated;
+    for (auto it = inputs.crbegin(); it != inputs.crend(); it++)
+    {
+        if(updated.contains(it->first) || !allVars[INPUTV].contains(it->first))
+            continue;
+
+        updated.insert(it->first);
+        allVars[INPUTV][it->first].value->setText(it->second);
+    }
+
+    statusBarLabel->setText("changed value of " + QString::number(updated.size()) + " input variables");
+}
+
 void EditorWindow::updateVarOutput(const QString &name, const QString &value)
 {
     fileModified = true;
@@ -250,6 +273,9 @@ void EditorWindow::destroyVarInput(const QString &name)
 {
     fileModified = true;
 
+    if(this->networkManager != nullptr)
+        this->networkManager->unregisterInput(name);
+
     destroyVar(INPUTV,name);
 }
 
@@ -312,6 +338,16 @@ void EditorWindow::saveStream(QTextStream &stream)
     return;
 }
 
+void EditorWindow::saveChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    this->model->saveChanges(stream, session, version);
+}
+
+bool EditorWindow::loadChanges(QDataStream &stream, quint32 &session, quint64 &version)
+{
+    return this->model->loadChanges(stream, session, version);
+}
+
 void EditorWindow::renameFsm(const QString &name)
 {
     setWindowTitle(name);
@@ -373,6 +409,9 @@ void EditorWindow::cleanup(){
         }
         allVars[i].clear();
     }
+
+    if(this->networkManager != nullptr)
+        this->networkManager->clearInputs();
 } 
 
 void EditorWindow::throwError(FsmErrorType errNum)
@@ -417,6 +456,24 @@ void EditorWindow::inputEvent(const QString &name, const QString &value)
     return;
 }
 
+void EditorWindow::inputEvents(const FsmInputBatch &inputs)
+{
+    this->model->inputEvents(inputs);
+    return;
+}
+
+void EditorWindow::updatesPending()
+{
+    // Everything changed until the timeout is displayed at once
+    if(!flushTimer->isActive())
+        flushTimer->start();
+}
+
+void EditorWindow::flushUpdates()
+{
+    // Updates are flushed by the model
+}
+
 void EditorWindow::log(const QString &time, const QString &state, const QString &varInputs, const QString &varOutputs, const QString &varInternals) const
 {
     (void)time;
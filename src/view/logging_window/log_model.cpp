@@ -0,0 +1,200 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file log_model.cpp
+ * @author  xcervia00
+ *
+ * @brief Bounded model of the log and its filter
+ *
+ */
+
+#include "log_model.h"
+
+#include <QBrush>
+#include <QColor>
+
+#include <algorithm>
+
+/*
+============================
+          LOG MODEL
+============================
+*/
+
+LogModel::LogModel(int capacity, QObject *parent)
+    :
+    QAbstractListModel(parent),
+    m_entries(std::max(1, capacity))
+{
+
+}
+
+int LogModel::capacity() const
+{
+    return m_entries.size();
+}
+
+LogSeverity LogModel::severity(QtMsgType level)
+{
+    switch (level) {
+        case QtDebugMsg:
+            return SEVERITY_DEBUG;
+        case QtWarningMsg:
+            return SEVERITY_WARNING;
+        case QtCriticalMsg:
+        case QtFatalMsg:
+            return SEVERITY_CRITICAL;
+        default:
+            return SEVERITY_INFO;
+    }
+}
+
+const LogEntry &LogModel::at(int row) const
+{
+    return m_entries[(m_first + row) % m_entries.size()];
+}
+
+int LogModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_count;
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= m_count)
+        return QVariant();
+
+    const LogEntry &entry = this->at(index.row());
+
+    switch (role) {
+        case Qt::DisplayRole:
+            return entry.time() + " - " + entry.text;
+        case Qt::ForegroundRole:
+            switch (severity(entry.level)) {
+                case SEVERITY_WARNING:
+                    return QBrush(QColor(Qt::darkYellow));
+                case SEVERITY_CRITICAL:
+                    return QBrush(QColor(Qt::red));
+                default:
+                    return QVariant();
+            }
+        case SeverityRole:
+            return static_cast<int>(severity(entry.level));
+        case EventRole:
+            return static_cast<int>(entry.event);
+        case IdRole:
+            return entry.id;
+        case NameRole:
+            return entry.name;
+        case ValueRole:
+            return entry.value;
+        default:
+            return QVariant();
+    }
+}
+
+void LogModel::append(const QVector<LogEntry> &entries)
+{
+    int capacity = m_entries.size();
+    int added = entries.size();
+    if(added == 0)
+        return;
+
+    // Everything gets replaced ==> keep just the newest entries
+    if(added >= capacity)
+    {
+        this->beginResetModel();
+        std::copy(entries.end() - capacity, entries.end(), m_entries.begin());
+        m_first = 0;
+        m_count = capacity;
+        this->endResetModel();
+        return;
+    }
+
+    // Make room by dropping the oldest entries
+    int overflow = m_count + added - capacity;
+    if(overflow > 0)
+    {
+        this->beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        for(int i = 0; i < overflow; i++)
+            m_entries[(m_first + i) % capacity] = LogEntry();
+        m_first = (m_first + overflow) % capacity;
+        m_count -= overflow;
+        this->endRemoveRows();
+    }
+
+    this->beginInsertRows(QModelIndex(), m_count, m_count + added - 1);
+    for(int i = 0; i < added; i++)
+        m_entries[(m_first + m_count + i) % capacity] = entries[i];
+    m_count += added;
+    this->endInsertRows();
+}
+
+void LogModel::clear()
+{
+    this->beginResetModel();
+    std::fill(m_entries.begin(), m_entries.end(), LogEntry());
+    m_first = 0;
+    m_count = 0;
+    this->endResetModel();
+}
+
+/*
+============================
+         LOG FILTER
+============================
+*/
+
+LogFilterModel::LogFilterModel(QObject *parent)
+    :
+    QSortFilterProxyModel(parent)
+{
+
+}
+
+void LogFilterModel::setMinimumSeverity(LogSeverity severity)
+{
+    m_minimumSeverity = severity;
+    this->invalidateFilter();
+}
+
+void LogFilterModel::setStateFilter(const QString &state)
+{
+    m_state = state;
+    this->invalidateFilter();
+}
+
+void LogFilterModel::setTransitionFilter(int id)
+{
+    m_transition = id;
+    this->invalidateFilter();
+}
+
+bool LogFilterModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
+{
+    QModelIndex index = this->sourceModel()->index(sourceRow, 0, sourceParent);
+
+    if(index.data(LogModel::SeverityRole).toInt() < m_minimumSeverity)
+        return false;
+
+    // Nothing else to filter by
+    if(m_state.isEmpty() && m_transition < 0)
+        return true;
+
+    LogEvent event = static_cast<LogEvent>(index.data(LogModel::EventRole).toInt());
+
+    if(m_transition >= 0 && (event != LOG_TRANSITION_FIRED || index.data(LogModel::IdRole).toInt() != m_transition))
+        return false;
+
+    if(!m_state.isEmpty())
+    {
+        if(event == LOG_STATE_ENTERED)
+            return index.data(LogModel::NameRole).toString().contains(m_state, Qt::CaseInsensitive);
+        if(event == LOG_TRANSITION_FIRED)
+            return index.data(LogModel::NameRole).toString().contains(m_state, Qt::CaseInsensitive)
+                || index.data(LogModel::ValueRole).toString().contains(m_state, Qt::CaseInsensitive);
+        return false;
+    }
+
+    return true;
+}
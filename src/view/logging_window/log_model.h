@@ -0,0 +1,142 @@
+/**
+ * Project name: ICP Project 2024/2025
+ *
+ * @file log_model.h
+ * @author  xcervia00
+ *
+ * @brief Bounded model of the log and its filter (header)
+ *
+ */
+
+#ifndef LOG_MODEL_H
+#define LOG_MODEL_H
+
+#include <QAbstractListModel>
+#include <QSortFilterProxyModel>
+#include <QVector>
+
+#include "log_sink.h"
+
+/**
+ * @brief Severity rank of messages (QtMsgType values are not ordered)
+ */
+enum LogSeverity : int
+{
+    SEVERITY_DEBUG,
+    SEVERITY_INFO,
+    SEVERITY_WARNING,
+    SEVERITY_CRITICAL,
+};
+
+/**
+ * @brief Log entries kept in a ring of fixed capacity; the oldest entries are dropped once it is full
+ * @note Memory stays constant however long the machine runs; the text of a row is composed only when displayed
+ */
+class LogModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_CAPACITY = 20000; ///< Default number of kept entries
+
+    /**
+     * @brief Data roles besides the display ones
+     */
+    enum Roles
+    {
+        SeverityRole = Qt::UserRole + 1, ///< LogSeverity of the entry
+        EventRole, ///< LogEvent of the entry
+        IdRole, ///< Id of the transition (-1 if none)
+        NameRole, ///< Name of the state/variable (source state of a transition)
+        ValueRole, ///< Value of the variable (destination state of a transition)
+    };
+
+    /**
+     * @brief Constructor of the model
+     * @param capacity Maximal number of entries
+     * @param parent The parent object
+     */
+    explicit LogModel(int capacity = DEFAULT_CAPACITY, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief Appends entries; drops the oldest ones if the capacity is exceeded
+     * @param entries The entries
+     */
+    void append(const QVector<LogEntry> &entries);
+
+    /**
+     * @brief Removes all entries
+     */
+    void clear();
+
+    /**
+     * @brief Maximal number of entries
+     * @return The capacity
+     */
+    int capacity() const;
+
+    /**
+     * @brief Severity rank of the message type
+     * @param level The message type
+     * @return The rank
+     */
+    static LogSeverity severity(QtMsgType level);
+
+private:
+    QVector<LogEntry> m_entries; ///< Storage of the ring
+    int m_first = 0; ///< Index of the oldest entry in m_entries
+    int m_count = 0; ///< Number of entries
+
+    /**
+     * @brief Entry of given row
+     * @param row The row (0 is the oldest entry)
+     * @return The entry
+     */
+    const LogEntry &at(int row) const;
+};
+
+/**
+ * @brief Filters the log by severity, state and transition
+ */
+class LogFilterModel : public QSortFilterProxyModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Constructor of the filter (shows everything)
+     * @param parent The parent object
+     */
+    explicit LogFilterModel(QObject *parent = nullptr);
+
+    /**
+     * @brief Shows only entries of given severity or higher
+     * @param severity The lowest shown severity
+     */
+    void setMinimumSeverity(LogSeverity severity);
+
+    /**
+     * @brief Shows only state entries and transitions concerning the state
+     * @param state Part of the state name; empty to show all entries
+     */
+    void setStateFilter(const QString &state);
+
+    /**
+     * @brief Shows only firing of given transition
+     * @param id Id of the transition; negative to show all entries
+     */
+    void setTransitionFilter(int id);
+
+protected:
+    bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const override;
+
+private:
+    LogSeverity m_minimumSeverity = SEVERITY_DEBUG; ///< The lowest shown severity
+    QString m_state; ///< Part of the state name; empty if not filtered
+    int m_transition = -1; ///< Id of the transition; negative if not filtered
+};
+
+#endif // LOG_MODEL_H
@@ -12,22 +12,47 @@
 #include "ui_loggingwindow.h"
 #include "loggingwindow.h"
 
-#include <QTextStream>
 #include <QDateTime>
 #include <QObject>
+#include <QMetaObject>
+#include <QScrollBar>
 #include <QtGlobal>
 
+#include <algorithm>
+
+LoggingWindowSink::LoggingWindowSink(LoggingWindow *window)
+    :
+    m_window{window}
+{
+
+}
+
+void LoggingWindowSink::write(const QVector<LogEntry> &batch)
+{
+    m_window->enqueueEntries(batch);
+}
+
 LoggingWindow::LoggingWindow(QWidget *parent)
     :
     QWidget(parent),
-    originalHandler(qInstallMessageHandler(0)),
     ui(new Ui::LoggingWindow)
 {
     ui->setupUi(this);
 
+    // Bounded model behind a filter; the view renders only the visible rows
+    model = new LogModel(LogModel::DEFAULT_CAPACITY, this);
+    filter = new LogFilterModel(this);
+    filter->setSourceModel(model);
+    ui->logView->setModel(filter);
+
     // Connect Clear button
     connect(ui->logClear, &QPushButton::clicked,this, &LoggingWindow::clearLog);
 
+    // Connect filters
+    connect(ui->logSeverity, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &LoggingWindow::updateFilter);
+    connect(ui->logStateFilter, &QLineEdit::textChanged, this, &LoggingWindow::updateFilter);
+    connect(ui->logTransitionFilter, &QLineEdit::textChanged, this, &LoggingWindow::updateFilter);
+
     // Start logging
     this->startLogging();
 }
@@ -35,54 +60,112 @@ LoggingWindow::LoggingWindow(QWidget *parent)
 
 LoggingWindow::~LoggingWindow()
 {
+    // The sink must not be used once the window is gone
+    this->stopLogging();
     delete ui;
 }
 
-void LoggingWindow::loggingMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+void LoggingWindow::enqueueEntries(const QVector<LogEntry> &batch)
+{
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        pending += batch;
+
+        // The display is far behind ==> the model would drop the older entries anyway
+        int excess = pending.size() - model->capacity();
+        if(excess > 0)
+        {
+            pending.erase(pending.begin(), pending.begin() + excess);
+            skipped += excess;
+        }
+
+        if(flushScheduled)
+            return;
+        flushScheduled = true;
+    }
+
+    QMetaObject::invokeMethod(this, "flushPending", Qt::QueuedConnection);
+}
+
+void LoggingWindow::flushPending()
 {
-    switch (type) {
-        case QtInfoMsg:
-            loggingInstance->logMessage(msg, Qt::black);
-            break;
-        case QtWarningMsg:
-            loggingInstance->logMessage(msg, Qt::darkYellow);
-            break;
-        case QtCriticalMsg:
-            loggingInstance->logMessage(msg, Qt::red);
-            break;
-        default:
-            loggingInstance->originalHandler(type, context, msg);
-            break;
+    QVector<LogEntry> entries;
+    int dropped;
+
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        entries.swap(pending);
+        dropped = skipped;
+        skipped = 0;
+        flushScheduled = false;
+    }
+
+    if(dropped > 0)
+    {
+        LogEntry note;
+        note.timestamp = QDateTime::currentMSecsSinceEpoch();
+        note.level = QtWarningMsg;
+        note.text = QString("... %1 messages skipped").arg(dropped);
+        entries.prepend(note);
     }
+
+    // Follow the end of the log only if the user did not scroll away
+    QScrollBar *scroll = ui->logView->verticalScrollBar();
+    bool atBottom = scroll->value() == scroll->maximum();
+
+    model->append(entries);
+
+    if(atBottom)
+        ui->logView->scrollToBottom();
+}
+
+void LoggingWindow::updateFilter()
+{
+    static const LogSeverity severities[] = {SEVERITY_DEBUG, SEVERITY_WARNING, SEVERITY_CRITICAL};
+    int index = std::max(0, std::min(ui->logSeverity->currentIndex(), 2));
+    filter->setMinimumSeverity(severities[index]);
+
+    filter->setStateFilter(ui->logStateFilter->text().trimmed());
+
+    bool ok;
+    int id = ui->logTransitionFilter->text().trimmed().toInt(&ok);
+    filter->setTransitionFilter(ok ? id : -1);
 }
 
 void LoggingWindow::startLogging()
 {
     if(loggingInstance != nullptr) return; 
     loggingInstance = this;
-    qInstallMessageHandler(loggingMessageHandler);
+
+    AsyncLogger &logger = AsyncLogger::instance();
+    sink = logger.addSink(std::unique_ptr<LogSink>(new LoggingWindowSink(this)));
+    logger.installMessageHandler();
 }
 
 void LoggingWindow::stopLogging()
 {
+    if(loggingInstance != this) return;
     loggingInstance = nullptr;
-    qInstallMessageHandler(0);
+
+    AsyncLogger &logger = AsyncLogger::instance();
+    logger.uninstallMessageHandler();
+    logger.removeSink(sink);
+    sink = nullptr;
 }
 
 void LoggingWindow::clearLog()
 {
-    ui->logDisplay->clear();
+    model->clear();
 }
 
-void LoggingWindow::logMessage(const QString &msg, Qt::GlobalColor color)
+void LoggingWindow::logMessage(const QString &msg, QtMsgType level)
 {
-    QColor textColor = color;
-    QString htmlMessage = QStringLiteral("<font color=\"%1\">%2</font>")
-        .arg(textColor.name())
-        .arg(Qt::convertFromPlainText(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz") + " - " + msg));
-
-    this->ui->logDisplay->appendHtml(htmlMessage);
+    LogEntry entry;
+    entry.timestamp = QDateTime::currentMSecsSinceEpoch();
+    entry.level = level;
+    entry.text = msg;
+    model->append({entry});
 }
 
 // By default there is no logging instance
-LoggingWindow* LoggingWindow::loggingInstance = nullptr;
\ No newline at end of file
+LoggingWindow* LoggingWindow::loggingInstance = nullptr;
@@ -12,13 +12,42 @@
 #define LOGGINGWINDOW_H
 
 #include <QWidget>
-#include <QMessageLogContext>
+#include <QVector>
+
+#include <mutex>
+
+#include "async_logger.h"
+#include "log_model.h"
 
 namespace Ui {
 class LoggingWindow;
 }
+
+class LoggingWindow;
+
+/**
+ * @brief Sink of AsyncLogger that forwards the messages to the logging window
+ */
+class LoggingWindowSink : public LogSink
+{
+    private:
+        LoggingWindow *m_window; ///< The window
+
+    public:
+        /**
+         * @brief Constructor of the sink
+         * @param window The window (has to remove the sink before it is destroyed)
+         */
+        explicit LoggingWindowSink(LoggingWindow *window);
+
+        void write(const QVector<LogEntry> &batch) override;
+};
+
 /**
  * @brief The logger window
+ * @note Messages are formatted by the consumer thread of AsyncLogger and appended to a bounded LogModel
+ * in one batch per pass of the event loop, so the interpretation never waits for the widget.
+ * The list view renders only the visible rows; memory stays constant however long the machine runs.
  */
 class LoggingWindow : public QWidget
 {
@@ -26,18 +55,15 @@ class LoggingWindow : public QWidget
 
 public:
     static LoggingWindow * loggingInstance; ///< What is the current logger object
-    QtMessageHandler originalHandler; ///< The default handler of messages
 
     explicit LoggingWindow(QWidget *parent = nullptr);
     virtual ~LoggingWindow();
 
     /**
-     * @brief Handler for all qMessages ==> redirects them to logger 
-     * @param type The type of the message
-     * @param context Context of the message
-     * @param msg The message itself
+     * @brief Queues messages for display; called by the consumer thread of the logger
+     * @param batch The messages
      */
-    static void loggingMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg);
+    void enqueueEntries(const QVector<LogEntry> &batch);
 
     /**
      * @brief Starts logging
@@ -55,13 +81,31 @@ public:
     /**
      * @brief Prints message to the logging window
      * @param msg The log message
-     * @param color The color of the message
+     * @param level The severity of the message
      */
-    void logMessage(const QString &msg, Qt::GlobalColor color);
+    void logMessage(const QString &msg, QtMsgType level);
 
+private slots:
+    /**
+     * @brief Appends all queued messages to the model at once
+     */
+    void flushPending();
+
+    /**
+     * @brief Applies the filters entered by the user
+     */
+    void updateFilter();
 
 private:
     Ui::LoggingWindow *ui; ///< The UI element
+    LogSink *sink = nullptr; ///< The sink registered in the logger
+    LogModel *model = nullptr; ///< Kept entries of the log
+    LogFilterModel *filter = nullptr; ///< Entries shown by the view
+
+    std::mutex pendingMutex; ///< Guards the fields below (shared with the consumer thread)
+    QVector<LogEntry> pending; ///< Entries waiting for display (at most the capacity of the model)
+    int skipped = 0; ///< Entries dropped since the last flush
+    bool flushScheduled = false; ///< Is flushPending already queued?
 };
 
 #endif // LOGGINGWINDOW_H
@@ -11,6 +11,10 @@
 #include "view/state_fsm_widget/statefsmwidget.h"
 #include "ui_statefsmwidget.h"
 #include <QMouseEvent>
+#include <QPainter>
+
+static const QColor BODY_COLOR[2] = {QColor("#b3d1ff"), QColor("navy")}; ///< body of normal and active state
+static const QColor TEXT_COLOR[2] = {QColor("navy"), QColor("white")}; ///< text of normal and active state
 
 StateFSMWidget::StateFSMWidget(QPoint pos, QWidget *parent)
     : QWidget(parent)
@@ -33,6 +37,16 @@ StateFSMWidget::StateFSMWidget(QPoint pos, QWidget *parent)
     ui->output->setFocusPolicy(Qt::NoFocus);
     ui->output->viewport()->installEventFilter(this);
 
+    // Looks are prepared once (on top of the style sheet), switching them is just a repaint
+    ensurePolished();
+    for (int look = 0; look < 2; look++) {
+        namePalette[look] = ui->name->palette();
+        namePalette[look].setColor(QPalette::WindowText, TEXT_COLOR[look]);
+        outputPalette[look] = ui->output->palette();
+        outputPalette[look].setColor(QPalette::Text, TEXT_COLOR[look]);
+    }
+    ui->name->setPalette(namePalette[0]);
+    ui->output->setPalette(outputPalette[0]);
 }
 
 StateFSMWidget::~StateFSMWidget()
@@ -99,43 +113,28 @@ void StateFSMWidget::setPosition(QPoint pos){
     } 
 }
 
-void StateFSMWidget::recolor(const QString& c1, const QString& c2, const QString& ar) {
-    QString style = QString(
-                        "QWidget { background: %1; }"
-                        "QTextEdit { color: %2; font: 14px \"Nimbus Mono PS\"; "
-                        "   padding: 5px 5px 5px 5px;}"
-                        "QLabel { color: %2; font: 14px \"Nimbus Mono PS\"; }"
-                        "QScrollArea { border: 5px solid %1; }"
-                        "QScrollArea::corner { background: transparent; }"
-
-                        "QScrollBar::vertical"
-                        "{background-color:  lightgray;width: 15px;margin: 15px 3px 15px 3px;border:0px;}"
-                        "QScrollBar::horizontal"
-                        "{background-color:  lightgray;height: 15px;margin: 3px 15px 3px 15px;border:0px;}"
-
-                        "QScrollBar::handle{background-color: %2;min-height: 5px;}"
-
-                        "QScrollBar::sub-line:vertical"
-                        "{margin: 0px 0px 3px 0px;border-image: url(:/arrows/img/up%3.svg);"
-                        "border-width:0px;background-color:transparent;height: 10px;"
-                        "width: 9px;subcontrol-position: top;subcontrol-origin: margin;}"
-
-                        "QScrollBar::add-line:vertical"
-                        "{margin: 3px 0px 0px 0px;border-image: url(:/arrows/img/down%3.svg);"
-                        "border-width:0px;background-color:transparent;height: 10px;"
-                        "width: 9px;subcontrol-position: bottom;subcontrol-origin: margin;}"
-
-                        "QScrollBar::sub-line:horizontal"
-                        "{margin: 0px 3px 0px 0px;border-image: url(:/arrows/img/left%3.svg);"
-                        "border-width:0px;background-color:transparent;height: 9px;"
-                        "width: 10px;subcontrol-position: left;subcontrol-origin: margin;}"
-
-                        "QScrollBar::add-line:horizontal"
-                        "{margin: 0px 0px 0px 3px;border-image: url(:/arrows/img/right%3.svg);"
-                        "border-width:0px;background-color:transparent;height: 9px;"
-                        "width: 10px;subcontrol-position: right;subcontrol-origin: margin;}"
-
-                        "QTextEdit, QListView {background-attachment: scroll;}"
-                        ).arg(c1, c2, ar);
-    setStyleSheet(style);
+void StateFSMWidget::setActive(bool active) {
+    if (this->active == active){
+        return;
+    }
+    this->active = active;
+
+    ui->name->setPalette(namePalette[active]);
+    ui->output->setPalette(outputPalette[active]);
+    update();
+}
+
+bool StateFSMWidget::isActive() const{
+    return active;
+}
+
+void StateFSMWidget::paintEvent(QPaintEvent *event){
+    Q_UNUSED(event);
+    QPainter p(this);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.setPen(Qt::NoPen);
+    p.setBrush(BODY_COLOR[active]);
+
+    // the whole body (gaps and margins included) is the base, transparent name and output are drawn on top of it
+    p.drawRoundedRect(rect(), 5, 5);
 }
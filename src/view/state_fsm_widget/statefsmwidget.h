@@ -14,6 +14,7 @@
 #include <QTextEdit>
 #include <QWidget>
 #include <QLabel>
+#include <QPalette>
 
 namespace Ui {
 class StateFSMWidget;
@@ -77,12 +78,16 @@ public:
      */
     QString getOutput();
     /**
-     * @brief recolors the state
-     * @param c1 primary color (of body)
-     * @param c2 secondary color (of text)
-     * @param ar arrow suffix
+     * @brief highlights the state as active (or returns it to normal look)
+     * @param active is the state active
+     * @note only swaps precomputed palettes and repaints; the style sheet is not touched
      */
-    void recolor(const QString& c1, const QString& c2, const QString& ar);
+    void setActive(bool active);
+    /**
+     * @brief is the state highlighted as active
+     * @return true if active
+     */
+    bool isActive() const;
 signals:
     /**
      * @brief rightClick onto state
@@ -92,10 +97,18 @@ signals:
      * @brief leftClick onto state
      */
     void leftClick();
+protected:
+    /**
+     * @brief paints the whole body of the state (behind name and output)
+     */
+    void paintEvent(QPaintEvent *event) override;
 private:
     Ui::StateFSMWidget *ui; ///< The ui element
     QPoint position; ///< position of state within workArea
     QPoint size; ///< size of state
+    bool active = false; ///< is the state highlighted as active
+    QPalette namePalette[2]; ///< palettes of name (normal, active)
+    QPalette outputPalette[2]; ///< palettes of output (normal, active)
 };
 
 #endif // STATEFSMWIDGET_H